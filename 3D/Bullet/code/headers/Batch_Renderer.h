@@ -0,0 +1,154 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Batch_Renderer
+  * \brief Draws the scene models grouped by mesh, with their per-object data in a uniform buffer
+  *
+  * All the models share one shader program. What used to be a Material per entity (just its
+  * color) is now stored, together with the model matrix, in the Object_Block uniform buffer.
+  * Every frame the visible objects go into a Render_Queue keyed by mesh and depth, and the
+  * sorted queue is cut into batches of at most OBJECTS_PER_BLOCK objects that use the same
+  * mesh. The buffer is filled once per frame, after the physics transforms have been applied. Each batch is one instanced draw call whose instances read their data by
+  * gl_InstanceID, so the draw call count grows with the number of meshes, not of objects.
+  *
+  * Before batching, the objects are culled against the camera frustum with a btDbvt holding
+  * their world bounding boxes. The boxes are refitted every frame from the rendered transforms
+  * (which come from the physics bodies) with a small margin, so slow objects rarely change the
+  * tree; objects whose transformation has not changed, like walls, are not refitted at all.
+  * btDbvt::collideKDOP only visits the branches that touch the frustum. The objects
+  * marked as occluders are then rasterized by an Occlusion_Culler and the rest of the objects
+  * in the frustum are skipped if they are hidden behind them.
+  */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <Node.hpp>
+#include <Camera.hpp>
+#include <BulletCollision/BroadphaseCollision/btDbvt.h>
+#include "Mesh_Asset_Cache.h"
+#include "Occlusion_Culler.h"
+#include "Render_Queue.h"
+
+class Batch_Renderer
+{
+public:
+    static const GLsizei OBJECTS_PER_BLOCK = 200;     ///< 200 * 80 bytes fits the 16 KB every GL 3.2 driver allows per block.
+
+    struct Cull_Statistics
+    {
+        size_t objects = 0;                           ///< Objects with a loaded mesh.
+        size_t visible = 0;                           ///< Objects inside the frustum.
+        size_t culled = 0;                            ///< Objects skipped because they are outside the frustum.
+    };
+
+private:
+    /// Layout of one element of the Object_Block array (std140).
+    struct Object_Data
+    {
+        GLfloat model_matrix[16];
+        GLfloat color[4];
+    };
+
+    struct Object
+    {
+        std::shared_ptr< glt::Node >   node;
+        std::shared_ptr< Shared_Mesh > mesh;
+        uint32_t                       meshId;         ///< Mesh field of the sort key.
+        glt::Vector4                   color;
+        btDbvtNode*                    leaf = nullptr; ///< Node of the culling tree, created when the mesh is loaded.
+        bool                           occluder = false;
+        glt::Matrix44                  worldMatrix;    ///< Total transformation of the node, read once per frame.
+        glt::Vector3                   boundsMin;      ///< World bounding box, without the tree margin.
+        glt::Vector3                   boundsMax;
+    };
+
+    /// Run of objects that share a mesh and one range of the uniform buffer.
+    struct Batch
+    {
+        Shared_Mesh* mesh;
+        GLintptr     offset;                           ///< Byte offset of the range in the uniform buffer.
+        GLsizei      count;
+    };
+
+    GLuint programId = 0;
+    GLint  viewMatrixLocation;
+    GLint  projectionMatrixLocation;
+    GLint  lightPositionLocation;
+
+    GLuint    uniformBuffer = 0;
+    GLintptr  blockStride = 0;                         ///< Size of a block rounded up to the buffer offset alignment.
+
+    std::vector< Object >      objects;
+    std::vector< Shared_Mesh* > meshIds;               ///< Mesh of each identifier used in the sort keys, null if free.
+    Render_Queue               renderQueue;
+    std::vector< Batch >       batches;
+    std::vector< GLubyte >     bufferData;
+
+    btDbvt                     cullingTree;            ///< Leaves store the index of their object.
+    std::vector< int >         visibleObjects;         ///< Indices of the objects that passed the culling.
+    bool                       frustumCulling = true;
+
+    Occlusion_Culler           occlusionCuller;
+    bool                       occlusionCulling = true;
+
+    size_t          drawCalls = 0;
+    Cull_Statistics cullStatistics;
+
+public:
+    Batch_Renderer() = default;
+    ~Batch_Renderer();
+
+    /**
+ * \brief Compiles the shaders and creates the uniform buffer. Needs a current GL context.
+ * \return False if the shader program cannot be built.
+ */
+    bool initialize();
+    /**
+ * \brief Registers a model to be drawn every frame while it is visible.
+ * \param[in] node Node whose total transformation places the mesh.
+ * \param[in] mesh Mesh drawn for the node.
+ * \param[in] color Color of the object.
+ */
+    void add(std::shared_ptr< glt::Node > node, std::shared_ptr< Shared_Mesh > mesh, const glt::Vector3& color);
+    /**
+ * \brief Stops drawing the objects of a node and releases the references to the node and its mesh.
+ * \param[in] node The node given to add().
+ */
+    void remove(const glt::Node* node);
+    /**
+ * \brief Draws all the visible objects.
+ * \param[in] camera Camera the scene is seen from.
+ * \param[in] lightPosition Position of the light in world space.
+ */
+    void render(const glt::Camera& camera, const glt::Vector3& lightPosition);
+
+    /**
+ * \brief Marks the object of a node as an occluder. Occluders should be large boxes, such as walls and floors.
+ */
+    void setOccluder(const glt::Node* node);
+
+    void setFrustumCulling(bool enabled) { frustumCulling = enabled; }
+    void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+
+    size_t getObjectCount() const { return objects.size(); }
+    size_t getDrawCallCount() const { return drawCalls; }         ///< Draw calls issued by the last render().
+    const Cull_Statistics& getCullStatistics() const { return cullStatistics; }   ///< Frustum culling results of the last render().
+    const Occlusion_Culler::Statistics& getOcclusionStatistics() const { return occlusionCuller.getStatistics(); }
+
+private:
+    void updateBounds();
+    void cullObjects(const glt::Matrix44& viewProjection);
+    void cullOccludedObjects(const glt::Matrix44& viewProjection);
+    void buildBatches(const glt::Vector3& cameraPosition, float farDistance);
+};
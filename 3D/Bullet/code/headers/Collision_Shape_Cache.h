@@ -0,0 +1,109 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Collision_Shape_Cache
+  * \brief Builds collision shapes from the same OBJ files that are used for rendering
+  *
+  * The hull of a mesh is computed with btConvexHullComputer, simplified with btShapeHull down to a
+  * vertex budget, and its polyhedral features (the btConvexPolyhedron used by the SAT narrowphase)
+  * are extracted once. Concave meshes can instead be split into several such hulls by Convex_Decomposition.
+  * The result is stored next to the OBJ file in a binary ".hull" (or ".hulls") file keyed by a hash of
+  * the OBJ contents and the build parameters, so later runs only read the cache and never recompute hulls.
+  */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <btBulletDynamicsCommon.h>
+
+/**
+ * \class Convex_Compound_Shape
+ * \brief Compound of convex hulls that keeps its child shapes alive
+ */
+class Convex_Compound_Shape : public btCompoundShape
+{
+private:
+    std::vector< std::shared_ptr< btConvexHullShape > > hulls;
+public:
+    void addHull(const btTransform& localTransform, std::shared_ptr< btConvexHullShape > hull)
+    {
+        hulls.push_back(hull);
+        addChildShape(localTransform, hull.get());
+    }
+};
+
+class Collision_Shape_Cache
+{
+public:
+    static const int DEFAULT_VERTEX_BUDGET = 32;
+    static const int DEFAULT_MAX_HULLS = 8;
+    static constexpr btScalar DEFAULT_MAX_VOLUME_ERROR = btScalar(0.1);
+
+private:
+    struct Hull_Data
+    {
+        std::vector< btVector3 >          vertices;
+        std::vector< std::vector< int > > faces;      ///< Vertex indices of each planar face.
+    };
+
+    struct Build_Parameters
+    {
+        int32_t vertexBudget;
+        int32_t maxHulls;                             ///< 1 builds a single hull of the whole mesh.
+        float   maxVolumeError;
+    };
+
+    typedef std::vector< Hull_Data > Hull_Set;
+
+    std::map< std::string, Hull_Set > loadedHulls;    ///< Hulls already read this run, keyed by path and parameters.
+
+public:
+    /**
+ * \brief Creates a convex hull shape for an OBJ file.
+ * \param[in] objPath Path of the OBJ file.
+ * \param[in] scale Scale baked into the hull vertices and its polyhedral features.
+ * \param[in] vertexBudget Maximum number of hull vertices kept after simplification.
+ * \return The shape with its btConvexPolyhedron already set, or nullptr if the OBJ cannot be read.
+ */
+    std::shared_ptr<btConvexHullShape> getConvexHull(const std::string& objPath, const btVector3& scale,
+        int vertexBudget = DEFAULT_VERTEX_BUDGET);
+    /**
+ * \brief Creates a compound of convex hulls approximating a concave OBJ mesh.
+ * \param[in] objPath Path of the OBJ file. The mesh should be closed.
+ * \param[in] scale Scale baked into the hulls.
+ * \param[in] maxHulls Maximum number of hulls.
+ * \param[in] maxVolumeError Relative excess of the hulls' volume over the mesh volume that is accepted.
+ * \param[in] vertexBudget Maximum number of vertices of each hull.
+ * \return The compound shape, or nullptr if the OBJ cannot be read.
+ */
+    std::shared_ptr<Convex_Compound_Shape> getConvexDecomposition(const std::string& objPath, const btVector3& scale,
+        int maxHulls = DEFAULT_MAX_HULLS, btScalar maxVolumeError = DEFAULT_MAX_VOLUME_ERROR,
+        int vertexBudget = DEFAULT_VERTEX_BUDGET);
+    /**
+ * \brief Gets the radius of the sphere centred at the mesh origin that encloses the mesh hull.
+ * \return The radius, or 0 if the OBJ cannot be read.
+ */
+    btScalar getBoundingRadius(const std::string& objPath, int vertexBudget = DEFAULT_VERTEX_BUDGET);
+
+private:
+    const Hull_Set* findHulls(const std::string& objPath, const Build_Parameters& parameters);
+
+    static std::shared_ptr<btConvexHullShape> createHullShape(const Hull_Data& hull, const btVector3& scale, const btVector3& offset);
+    static bool buildHull(const btAlignedObjectArray<btVector3>& points, int vertexBudget, Hull_Data& hull);
+    static bool readCache(const std::string& cachePath, uint64_t hash, const Build_Parameters& parameters, Hull_Set& hulls);
+    static void writeCache(const std::string& cachePath, uint64_t hash, const Build_Parameters& parameters, const Hull_Set& hulls);
+    static bool hashFile(const std::string& path, uint64_t& hash);
+};
@@ -54,12 +54,12 @@ public:
     void addTank(std::shared_ptr<Tank> newTank)
     {
         tank = newTank;
-        door->getBody()->setIgnoreCollisionCheck(tank->leftTrack->getBody(), true);
-        door->getBody()->setIgnoreCollisionCheck(tank->rightTrack->getBody(), true);
-        door->getBody()->setIgnoreCollisionCheck(tank->chasis->getBody(), true);
-        tank->leftTrack->getBody()->setIgnoreCollisionCheck(door->getBody(), true);
-        tank->rightTrack->getBody()->setIgnoreCollisionCheck(door->getBody(), true);
-        tank->chasis->getBody()->setIgnoreCollisionCheck(door->getBody(), true);
+        door->getBody()->setIgnoreCollisionCheck(tank->leftTrack->getCollisionObject(), true);
+        door->getBody()->setIgnoreCollisionCheck(tank->rightTrack->getCollisionObject(), true);
+        door->getBody()->setIgnoreCollisionCheck(tank->chasis->getCollisionObject(), true);
+        tank->leftTrack->getCollisionObject()->setIgnoreCollisionCheck(door->getBody(), true);
+        tank->rightTrack->getCollisionObject()->setIgnoreCollisionCheck(door->getBody(), true);
+        tank->chasis->getCollisionObject()->setIgnoreCollisionCheck(door->getBody(), true);
     }
     void addDoor(std::shared_ptr<Entity> newDoor)
     {
@@ -91,9 +91,9 @@ public:
  */
     void RunContacts(btDynamicsWorld& dynamicsWorld)
     {
-        btCollisionObject& collisionTankLeftTrack = *tank->leftTrack->getBody();
-        btCollisionObject& collisionTankRightTrack = *tank->rightTrack->getBody();
-        btCollisionObject& collisionTankChassis = *tank->chasis->getBody();
+        btCollisionObject& collisionTankLeftTrack = *tank->leftTrack->getCollisionObject();
+        btCollisionObject& collisionTankRightTrack = *tank->rightTrack->getCollisionObject();
+        btCollisionObject& collisionTankChassis = *tank->chasis->getCollisionObject();
         btCollisionObject& collisionKey = *key->getBody();
 
         int manifold_count = dynamicsWorld.getDispatcher()->getNumManifolds();
@@ -0,0 +1,49 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Convex_Decomposition
+  * \brief Splits a concave mesh into a small set of convex pieces
+  *
+  * The mesh is cut recursively by axis-aligned planes. At every step the cut that removes the most
+  * empty hull volume is applied, until the summed volume of the piece hulls is within the allowed
+  * error of the mesh volume or the hull count limit is reached. Triangles crossing a cut are clipped,
+  * so the pieces still cover the whole surface. Hull volumes come from btConvexHullComputer.
+  */
+
+#pragma once
+
+#include <vector>
+
+#include <btBulletDynamicsCommon.h>
+
+struct Obj_Mesh_Data;
+
+class Convex_Decomposition
+{
+public:
+    typedef std::vector< btVector3 > Point_Cloud;
+
+public:
+    /**
+ * \brief Decomposes a mesh into convex pieces.
+ * \param[in] mesh The geometry to decompose. It should be closed for the volume error to be meaningful.
+ * \param[in] maxHulls Maximum number of pieces.
+ * \param[in] maxVolumeError Relative excess of the summed hull volume over the mesh volume at which splitting stops.
+ * \param[out] pieces Receives the points of every piece; the convex hull of each one is a part of the decomposition.
+ * \return False if the mesh has no volume.
+ */
+    static bool decompose(const Obj_Mesh_Data& mesh, int maxHulls, btScalar maxVolumeError, std::vector< Point_Cloud >& pieces);
+
+    /**
+ * \brief Computes the volume of the convex hull of a set of points.
+ */
+    static btScalar hullVolume(const Point_Cloud& points);
+};
@@ -0,0 +1,101 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Debug_Drawer
+  * \brief btIDebugDraw that batches all the debug geometry of a frame into one line list
+  *
+  * Lines, contact markers and AABBs reported by the world during debugDrawWorld() are appended to
+  * a single CPU-side vertex array, which render() uploads and draws with one glDrawArrays call.
+  * The categories are the btIDebugDraw::DebugDrawModes bits given to setDebugMode(), plus
+  * DRAW_BROADPHASE for the boxes of the broadphase tree. With a dump file set, every frame is also
+  * written as text, which needs no GL context and so works in headless runs.
+  *
+  * The drawer costs nothing while it is not attached to a world: Physics_3D_System only calls
+  * debugDrawWorld() when a drawer with a non-zero mode is set.
+  */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <btBulletDynamicsCommon.h>
+#include <OpenGL.hpp>
+#include <Math.hpp>
+
+class btDbvtBroadphase;
+
+class Debug_Drawer : public btIDebugDraw
+{
+public:
+    /// Extra category, outside the range of the Bullet modes.
+    static const int DRAW_BROADPHASE = 1 << 16;
+
+private:
+    struct Vertex
+    {
+        GLfloat position[3];
+        GLfloat color[3];
+    };
+
+    int                    debugMode = DBG_NoDebug;
+    std::vector< Vertex >  vertices;                  ///< Two per line.
+    btDbvtBroadphase*      broadphase = nullptr;
+
+    std::ofstream          dumpFile;
+    unsigned               frame = 0;
+
+    GLuint programId = 0;
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+    GLint  viewProjectionLocation = -1;
+
+public:
+    Debug_Drawer() = default;
+    ~Debug_Drawer();
+
+    /**
+ * \brief Sets the broadphase whose tree is drawn with DRAW_BROADPHASE.
+ */
+    void setBroadphase(btDbvtBroadphase* newBroadphase) { broadphase = newBroadphase; }
+    /**
+ * \brief Writes the geometry of every following frame to a text file. An empty path stops dumping.
+ * \return False if the file cannot be created.
+ */
+    bool setDumpFile(const std::string& path);
+
+    /**
+ * \brief Draws the lines collected in the last frame with a single draw call. Needs a current GL context.
+ * \param[in] viewProjection Product of the projection and view matrices of the camera.
+ */
+    void render(const glt::Matrix44& viewProjection);
+
+    size_t getLineCount() const { return vertices.size() / 2; }
+
+    // btIDebugDraw
+
+    void drawLine(const btVector3& from, const btVector3& to, const btVector3& color) override;
+    void drawLine(const btVector3& from, const btVector3& to, const btVector3& fromColor, const btVector3& toColor) override;
+    void drawContactPoint(const btVector3& pointOnB, const btVector3& normalOnB, btScalar distance, int lifeTime, const btVector3& color) override;
+    void reportErrorWarning(const char* warningString) override;
+    void draw3dText(const btVector3& location, const char* textString) override;
+    void setDebugMode(int newDebugMode) override { debugMode = newDebugMode; }
+    int  getDebugMode() const override { return debugMode; }
+    void clearLines() override;
+    void flushLines() override;
+
+private:
+    void addVertex(const btVector3& position, const btVector3& color);
+    void drawBroadphase();
+    bool initializeRendering();
+    void writeFrame();
+};
@@ -43,6 +43,18 @@ public:
     btRigidBody* getBody() const;
     std::shared_ptr<btRigidBody> getSharedBody() const;
     /**
+ * \brief Gets the collision object of the entity: its rigid body, or its collider when it is a part of a btMultiBody.
+ */
+    btCollisionObject* getCollisionObject() const;
+    /**
+ * \brief Gets the world transform of the entity as it is rendered, whichever body it has.
+ */
+    btTransform getWorldTransform() const;
+    /**
+ * \brief Applies a force through the center of mass of the entity's body or link.
+ */
+    void applyCentralForce(const btVector3& force);
+    /**
  * \brief Gets the transform component of the entity.
  * \param[out] mat4 Gets the transform matrix in a mat4 class of glm.
  */
@@ -14,12 +14,17 @@
 #include <memory>
 #include "Render_Node.hpp"
 #include "Scene.h"
+#include "Mesh_Asset_Cache.h"
+#include "Batch_Renderer.h"
 
 class Entity;
+class Debug_Drawer;
 
 class Graphics_3D_System {
 private:
     std::shared_ptr<glt::Render_Node> sceneGraph;
+    Mesh_Asset_Cache meshCache;
+    Batch_Renderer batchRenderer;
 public:
 
     Graphics_3D_System();
@@ -32,10 +37,15 @@ public:
     void add_Component(const std::string& name, Entity& entity, btVector3 scale, btVector3 color);
     void add_ComponentKey(const std::string& name, Entity& entity, btVector3 scaleObject, btVector3 color);
     void add_ComponentSphere(const std::string& name, Entity& entity, btVector3 scaleObject, btVector3 color);
+    void removeComponent(Entity& entity);
+    void setOccluder(Entity& entity);
     void render();
+    void renderDebug(Debug_Drawer& drawer);
     void resetViewport(const sf::Window& window);
     void configure_scene_basics_glt(glt::Render_Node& scene);
     std::shared_ptr<glt::Render_Node> getSceneGraph() const;
+    const Batch_Renderer::Cull_Statistics& getCullStatistics() const;
+    const Occlusion_Culler::Statistics& getOcclusionStatistics() const;
     std::shared_ptr < glt:: Shader_Program > shader_program_shared; // Utiliza un shared_ptr para mantener una referencia al Shader_Program
 
 };
\ No newline at end of file
@@ -0,0 +1,110 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Mesh_Asset_Cache
+  * \brief Reference-counted cache of render meshes keyed by model path
+  *
+  * Every model path is parsed once, on a worker thread, and uploaded once, as a single
+  * Vertex_Array_Object, on the render thread. All the models that use the same path share the
+  * same Drawable, so adding more projectiles or props does not add parsing time or GPU memory.
+  * A mesh is released when the last model that uses it is removed, and its entry is dropped by
+  * the next get() of a new path. A file that cannot be loaded is not kept: the next get() of its
+  * path tries to load it again.
+  */
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Mesh.hpp>
+
+/**
+ * \class Shared_Mesh
+ * \brief Mesh whose geometry is uploaded after construction, once its file has been parsed
+ *
+ * Until the upload happens the mesh has no VAO and draws nothing.
+ */
+class Shared_Mesh : public glt::Mesh
+{
+public:
+    struct Vertex_Data
+    {
+        std::vector< GLfloat > coordinates;     ///< Three per vertex.
+        std::vector< GLfloat > normals;         ///< Three per vertex.
+        std::vector< GLuint  > indices;         ///< Three per triangle.
+    };
+
+public:
+    Shared_Mesh() : glt::Mesh(GL_TRIANGLES) {}
+
+    /**
+ * \brief Creates the GPU buffers of the mesh. Must be called on the thread that owns the GL context.
+ */
+    void upload(const Vertex_Data& data);
+
+    /**
+ * \brief Draws several instances of the mesh with a single draw call. The shader tells them apart by gl_InstanceID.
+ */
+    void draw_instances(GLsizei count);
+
+    bool is_loaded() const { return vao.get() != nullptr; }
+
+    const glm::vec3& get_bounds_min() const { return boundsMin; }       ///< Local bounding box, valid once loaded.
+    const glm::vec3& get_bounds_max() const { return boundsMax; }
+
+private:
+    glm::vec3 boundsMin = glm::vec3(0.f);
+    glm::vec3 boundsMax = glm::vec3(0.f);
+};
+
+class Mesh_Asset_Cache
+{
+private:
+    struct Pending_Upload
+    {
+        std::weak_ptr< Shared_Mesh >                 mesh;
+        std::future< Shared_Mesh::Vertex_Data >      data;
+        std::string                                  path;
+    };
+
+    std::map< std::string, std::weak_ptr< Shared_Mesh > > meshes;
+    std::list< Pending_Upload >                           pendingUploads;
+    std::shared_ptr< Shared_Mesh >                        cube;
+
+public:
+    /**
+ * \brief Gets the shared mesh of a model file, starting to load it in the background if needed.
+ * \param[in] path Path of the OBJ file.
+ * \return The shared mesh. It draws nothing until update() has uploaded it.
+ */
+    std::shared_ptr< Shared_Mesh > get(const std::string& path);
+    /**
+ * \brief Gets the unit cube shared by all the box-shaped entities.
+ */
+    std::shared_ptr< Shared_Mesh > getCube();
+    /**
+ * \brief Uploads the meshes whose files have finished loading. Call it once per frame on the render thread.
+ */
+    void update();
+    /**
+ * \brief Waits for all pending loads and uploads them.
+ */
+    void finishLoading();
+
+private:
+    static Shared_Mesh::Vertex_Data loadVertexData(const std::string& path);
+    static Shared_Mesh::Vertex_Data createCubeData();
+};
@@ -0,0 +1,48 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Obj_Loader
+  * \brief Reads the geometry of a Wavefront OBJ file into plain CPU arrays
+  *
+  * Only positions, normals and faces are read. Faces are fan-triangulated so every three
+  * entries of the index arrays form one triangle. Nothing here touches OpenGL or Bullet,
+  * so the result can be used to build collision shapes as well as render meshes.
+  */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct Obj_Mesh_Data
+{
+    std::vector< glm::vec3 > positions;         ///< "v" records in file order.
+    std::vector< glm::vec3 > normals;           ///< "vn" records in file order.
+    std::vector< int >       positionIndices;   ///< Three per triangle, indexing positions.
+    std::vector< int >       normalIndices;     ///< Parallel to positionIndices, -1 when the face has no normal.
+
+    size_t triangleCount() const { return positionIndices.size() / 3; }
+};
+
+class Obj_Loader
+{
+public:
+    /**
+ * \brief Parses an OBJ file.
+ * \param[in] path Path of the OBJ file.
+ * \param[out] data Receives the geometry. Left empty on failure.
+ * \param[out] error Receives a description of the problem on failure.
+ * \return True if the file could be read and contains at least one triangle.
+ */
+    static bool load(const std::string& path, Obj_Mesh_Data& data, std::string& error);
+};
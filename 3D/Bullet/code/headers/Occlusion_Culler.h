@@ -0,0 +1,100 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Occlusion_Culler
+  * \brief Software occlusion test of bounding boxes against a few large occluders
+  *
+  * The boxes of the occluders (walls, floors, other static boxes) are rasterized on the CPU into
+  * a small depth buffer, four pixels at a time with SSE. Then the screen rectangle of every other
+  * object's bounding box is compared with its nearest depth: if no pixel of the rectangle is
+  * farther than the object, the object is hidden and does not need to be drawn. The test is
+  * conservative: boxes that cross the near plane are not rasterized and are always visible, the
+  * outline of an occluder only covers the pixels that are entirely inside it and it stores the
+  * farthest depth of each pixel, so an object seen through a pixel at the edge of a wall is never
+  * hidden.
+  *
+  * Nothing here uses OpenGL, so the culler can be run and checked without a window. Building with
+  * OCCLUSION_CULLER_ENABLE_CHECK set to 1 adds check(), which moves boxes across the edges of walls
+  * and counts the ones that are hidden while part of them can be seen.
+  */
+
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#ifndef OCCLUSION_CULLER_ENABLE_CHECK
+#define OCCLUSION_CULLER_ENABLE_CHECK 0
+#endif
+
+class Occlusion_Culler
+{
+public:
+    static const int DEFAULT_WIDTH = 256;               ///< Must be a multiple of 4.
+    static const int DEFAULT_HEIGHT = 128;
+
+    struct Statistics
+    {
+        size_t occluders = 0;
+        size_t triangles = 0;                          ///< Occluder triangles rasterized.
+        size_t tested = 0;
+        size_t visible = 0;
+        size_t occluded = 0;
+    };
+
+private:
+    int width;
+    int height;
+    std::vector< float > depthBuffer;                  ///< Depth in [0, 1], row by row, 1 being the far plane.
+    glm::mat4 viewProjection;
+    glm::vec4 eye;                                     ///< Camera position in world space, w = 0 for an orthographic camera.
+    Statistics statistics;
+
+public:
+    Occlusion_Culler(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    /**
+ * \brief Clears the depth buffer and the statistics for a new frame.
+ * \param[in] viewProjection Product of the projection and view matrices of the camera.
+ */
+    void beginFrame(const glm::mat4& viewProjection);
+    /**
+ * \brief Rasterizes a box into the depth buffer.
+ * \param[in] transformation Transformation from the box space to world space.
+ * \param[in] boxMin Minimum corner of the box in its own space.
+ * \param[in] boxMax Maximum corner of the box in its own space.
+ */
+    void addOccluder(const glm::mat4& transformation, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    /**
+ * \brief Tests whether a world-space box can be seen past the occluders added this frame.
+ * \return False only if the box is certainly hidden.
+ */
+    bool isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+    const Statistics& getStatistics() const { return statistics; }
+    const std::vector< float >& getDepthBuffer() const { return depthBuffer; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+#if OCCLUSION_CULLER_ENABLE_CHECK
+    static int check();
+#else
+    static int check()
+    {
+        return 0;
+    }
+#endif
+
+private:
+    bool projectCorners(const glm::mat4& transformation, const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3 corners[8]) const;
+    void rasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, int outlineEdges);
+};
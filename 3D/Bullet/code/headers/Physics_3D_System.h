@@ -15,9 +15,20 @@
 #include <SFML/Window.hpp>
 #include "Render_Node.hpp"
 #include "Scene.h"
+#include "Collision_Shape_Cache.h"
+#include <BulletDynamics/ConstraintSolver/btTGSConstraintSolver.h>
+#include <BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h>
+
+#ifndef TRANSFORM_EXPORT_ENABLE_BENCHMARK
+#define TRANSFORM_EXPORT_ENABLE_BENCHMARK 0
+#endif
 
 class btGhostObject;
+class Debug_Drawer;
 class btCollisionObject;
+class btMultiBody;
+class btMultiBodyDynamicsWorld;
+class btMultiBodyLinkCollider;
 class Entity;
 
 class Physics_3D_System
@@ -33,21 +44,39 @@ class Physics_3D_System
 
         btDbvtBroadphase overlappingPairCache;
 
-        // The default constraint solver. For parallel processing you can use a different solver (see Extras/BulletMultiThreaded).
+        // Sequential impulse solver run over a few substeps per step: keeps the tank joints rigid when it fires
+        // with fewer iterations than one step would need. For parallel processing you can use a different solver (see Extras/BulletMultiThreaded).
+
+        btTGSConstraintSolver constraintSolver;
+
+        // Solver of an articulated world. Joints inside a btMultiBody are exact in its reduced coordinates,
+        // so it only has rows for the contacts and for joints between separate bodies.
 
-        btSequentialImpulseConstraintSolver constraintSolver;
+        btMultiBodyConstraintSolver multiBodySolver;
 
         std::unique_ptr< btDiscreteDynamicsWorld > dynamicsWorld;
+        btMultiBodyDynamicsWorld* multiBodyWorld;                  ///< dynamicsWorld when articulated, else nullptr.
 
         std::vector< std::shared_ptr< btRigidBody          > > rigidBodies;
         std::vector< std::shared_ptr< btDefaultMotionState > > motionStates;
         std::vector< std::shared_ptr< btCollisionShape     > > collisionShapes;
         std::vector< std::shared_ptr< btGhostObject        > > sensorObjects;
         std::vector< std::shared_ptr< btCollisionObject    > > collisionObjects;
+        std::vector< std::shared_ptr< btMultiBody          > > multiBodies;
+        std::vector< std::shared_ptr< btMultiBodyLinkCollider > > linkColliders;
+
+        Collision_Shape_Cache shapeCache;
+
+        btAlignedObjectArray< btTransform > exportedTransforms;    ///< Scratch space of exportTransforms().
 
     public:
 
-        Physics_3D_System();
+        /**
+ * \brief Creates the world.
+ * \param[in] articulated True for a btMultiBodyDynamicsWorld, which also simulates the btMultiBody vehicles
+ * built with add_MultiBody(). Otherwise the rigid bodies are solved with substeps.
+ */
+        explicit Physics_3D_System(bool articulated = false);
 
         ~Physics_3D_System();
 
@@ -61,8 +90,93 @@ class Physics_3D_System
             const btVector3& origin, const btVector3& shapeSize, btScalar mass);
         void add_ComponentSphere(Entity& entity,
             const btVector3& origin, const btVector3& shapeSize, btScalar mass);
+        void add_ComponentProjectile(Entity& entity,
+            const btVector3& origin, const btVector3& shapeSize, btScalar mass);
+        void add_ComponentHull(Entity& entity,
+            const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass);
+        void add_ComponentHullSensor(Entity& entity,
+            const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass);
+        void add_ComponentDecomposed(Entity& entity,
+            const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass,
+            int maxHulls = Collision_Shape_Cache::DEFAULT_MAX_HULLS,
+            btScalar maxVolumeError = Collision_Shape_Cache::DEFAULT_MAX_VOLUME_ERROR);
+        void add_ComponentDecomposedSensor(Entity& entity,
+            const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass,
+            int maxHulls = Collision_Shape_Cache::DEFAULT_MAX_HULLS,
+            btScalar maxVolumeError = Collision_Shape_Cache::DEFAULT_MAX_VOLUME_ERROR);
         std::shared_ptr<btRigidBody> createRigidBody(const btVector3& origin, const btVector3& shapeSize, btScalar mass);
         btDynamicsWorld* getDynamicsWorld() const;
+        bool isArticulated() const { return multiBodyWorld != nullptr; }
+        /**
+ * \brief Counts and times of impact of the continuous collision sweeps of the projectiles during the last step.
+ */
+        const btContinuousCollisionStats& getContinuousCollisionStats() const;
+
+        /**
+ * \brief Starts a btMultiBody whose base is a box given to the entity. Only in an articulated world.
+ * \param[in] numLinks Number of links, to be set up with add_MultiBodyRevoluteLink() and add_MultiBodyFixedLink()
+ * before finalize_MultiBody(). A mass of 0 fixes the base.
+ */
+        std::shared_ptr<btMultiBody> add_MultiBody(Entity& entity,
+            const btVector3& origin, const btVector3& shapeSize, btScalar mass, int numLinks);
+        /**
+ * \brief Sets up a link that turns around an axis through a pivot on its parent, and gives its box to the entity.
+ * \param[in] parent Index of the parent link, -1 for the base.
+ * \param[in] parentPivot Position of the pivot, and of the link's center, from the center of the parent in its frame.
+ * \param[in] axis Axis of rotation in the frames of both.
+ */
+        void add_MultiBodyRevoluteLink(btMultiBody& multiBody, int link, int parent, Entity& entity,
+            const btVector3& parentPivot, const btVector3& axis, const btVector3& shapeSize, btScalar mass);
+        /**
+ * \brief Sets up a link welded to its parent, and gives its box to the entity.
+ * \param[in] parent Index of the parent link, -1 for the base.
+ * \param[in] parentOffset Position of the link's center from the center of the parent, in its frame.
+ */
+        void add_MultiBodyFixedLink(btMultiBody& multiBody, int link, int parent, Entity& entity,
+            const btVector3& parentOffset, const btVector3& shapeSize, btScalar mass);
+        /**
+ * \brief Places the colliders of a btMultiBody whose links are all set up and adds it to the world.
+ */
+        void finalize_MultiBody(btMultiBody& multiBody);
+
+        /**
+ * \brief Attaches a debug drawer to the world, or detaches it with nullptr.
+ */
+        void setDebugDrawer(Debug_Drawer* drawer);
+        /**
+ * \brief Has the attached debug drawer collect the world's geometry. Does nothing without a drawer or with its mode at 0.
+ */
+        void debugDraw();
+
+        /**
+ * \brief Writes the render matrices of a set of bodies, with the scale of each model folded in.
+ * \param[in] bodies Bodies to export. The transform of the motion state of rigid bodies is used, as for rendering,
+ * and the world transform of the colliders of multibody links.
+ * \param[in] scales Scale of the model of each body.
+ * \param[in] count Number of bodies.
+ * \param[out] matrices Receives one column-major 4x4 float matrix per body, ready for glm::mat4 or a uniform buffer.
+ * \param[in] stride Distance in floats between the starts of consecutive matrices, at least 16.
+ */
+        void exportTransforms(const btCollisionObject* const* bodies, const btVector3* scales, size_t count, float* matrices, size_t stride = 16);
+        /**
+ * \brief Batch kernel of exportTransforms(): converts transforms to scaled column-major matrices, with SSE when available.
+ */
+        static void convertTransforms(const btTransform* transforms, const btVector3* scales, size_t count, float* matrices, size_t stride = 16);
+
+#if TRANSFORM_EXPORT_ENABLE_BENCHMARK
+        static void benchmark();
+#else
+        static void benchmark()
+        {
+        }
+#endif
+
+    private:
+
+        void addRigidBody(Entity& entity, std::shared_ptr< btCollisionShape > collisionShape,
+            const btVector3& origin, btScalar mass);
+        void addSensor(Entity& entity);
+        void addLinkCollider(Entity& entity, btMultiBody& multiBody, int link, std::shared_ptr< btCollisionShape > collisionShape);
 
    
 };
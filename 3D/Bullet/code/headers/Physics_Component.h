@@ -12,6 +12,7 @@
 
 #include <memory>
 #include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Featherstone/btMultiBodyLinkCollider.h>
 #include <glm/glm.hpp>
 #include <Render_Node.hpp>
 
@@ -24,6 +25,7 @@ private:
     std::shared_ptr<btCollisionShape> collisionShape;
     std::shared_ptr<btDefaultMotionState> motionState;
     std::shared_ptr<btRigidBody> rigidBody;
+    std::shared_ptr<btMultiBodyLinkCollider> linkCollider;     ///< Set instead of the rigid body for a part of a btMultiBody.
 
 
 public:
@@ -35,6 +37,15 @@ public:
         motionState = newmotionState;
         rigidBody = newrigidBody;
     }
+    /**
+ * \brief Component of the base or a link of a btMultiBody, which has no rigid body nor motion state.
+ */
+    Physics_Component(std::shared_ptr<btCollisionShape> newcollisionShape,
+    std::shared_ptr<btMultiBodyLinkCollider> newlinkCollider)
+    {
+        collisionShape = newcollisionShape;
+        linkCollider = newlinkCollider;
+    }
     ~Physics_Component() = default;
 
     btRigidBody* getRigidbody()
@@ -45,9 +56,38 @@ public:
     {
         return rigidBody;
     }
-    glm::mat4 getTransform() const {
+    btCollisionObject* getCollisionObject()
+    {
+        if (rigidBody)
+            return rigidBody.get();
+        return linkCollider.get();
+    }
+    /**
+ * \brief Transform to render with: the motion state of a rigid body, or the collider of a link, which the
+ * multibody world moves with its links.
+ */
+    btTransform getWorldTransform() const {
         btTransform transform;
-        rigidBody->getMotionState()->getWorldTransform(transform);
+        if (rigidBody)
+            rigidBody->getMotionState()->getWorldTransform(transform);
+        else
+            transform = linkCollider->getWorldTransform();
+        return transform;
+    }
+    /**
+ * \brief Pushes the body through its center of mass until the next step. For a link the force goes to its btMultiBody.
+ */
+    void applyCentralForce(const btVector3& force)
+    {
+        if (rigidBody)
+            rigidBody->applyCentralForce(force);
+        else if (linkCollider->m_link < 0)
+            linkCollider->m_multiBody->addBaseForce(force);
+        else
+            linkCollider->m_multiBody->addLinkForce(linkCollider->m_link, force);
+    }
+    glm::mat4 getTransform() const {
+        btTransform transform = getWorldTransform();
 
         glm::mat4 graphics_transform;
         transform.getOpenGLMatrix(glm::value_ptr(graphics_transform));
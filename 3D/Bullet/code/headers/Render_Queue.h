@@ -0,0 +1,84 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+ /**
+  * \class Render_Queue
+  * \brief Flat list of draws ordered by a 64-bit sort key
+  *
+  * Each draw is a key and the index of the object it draws, stored in one contiguous array that
+  * keeps its capacity from frame to frame. The key packs, from the most significant bits, the
+  * shader, the material, the mesh and a quantized depth, so after sorting the draws that share
+  * render state are adjacent and closer objects come first within them. Sorting is an LSD radix
+  * sort on bytes that skips the bytes all the keys have in common.
+  *
+  * Building with RENDER_QUEUE_ENABLE_BENCHMARK set to 1 adds benchmark(), which times filling
+  * and sorting queues of 10000 and 100000 draws.
+  */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef RENDER_QUEUE_ENABLE_BENCHMARK
+#define RENDER_QUEUE_ENABLE_BENCHMARK 0
+#endif
+
+class Render_Queue
+{
+public:
+    static const int SHADER_BITS = 8;
+    static const int MATERIAL_BITS = 12;
+    static const int MESH_BITS = 20;
+    static const int DEPTH_BITS = 24;
+
+    struct Item
+    {
+        uint64_t key;
+        uint32_t index;                                ///< Object drawn, as given to push().
+    };
+
+private:
+    std::vector< Item > items;
+    std::vector< Item > scratch;                       ///< Second buffer of the radix sort.
+
+public:
+    /**
+ * \brief Packs the render state and depth of a draw into a sort key.
+ * \param[in] depth Distance to the camera normalized to [0, 1]; values outside are clamped.
+ */
+    static uint64_t makeKey(uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+
+    /// Part of a key that identifies the render state, without the depth.
+    static uint64_t stateOf(uint64_t key) { return key >> DEPTH_BITS; }
+    static uint32_t meshOf(uint64_t key) { return uint32_t(stateOf(key) & ((1u << MESH_BITS) - 1)); }
+
+    void clear() { items.clear(); }
+    void reserve(size_t count) { items.reserve(count); scratch.reserve(count); }
+    void push(uint64_t key, uint32_t index) { items.push_back({ key, index }); }
+
+    /**
+ * \brief Sorts the draws by key. Draws with equal keys keep the order in which they were pushed.
+ */
+    void sort();
+
+    const std::vector< Item >& getItems() const { return items; }
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+
+#if RENDER_QUEUE_ENABLE_BENCHMARK
+    static void benchmark();
+#else
+    static void benchmark()
+    {
+    }
+#endif
+};
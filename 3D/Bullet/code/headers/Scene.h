@@ -18,6 +18,7 @@
 #include "Graphics_3D_System.h"
 #include <Physics_3D_System.h>
 #include <Platform.h>
+#include "Debug_Drawer.h"
 
 class Physics_3D_System;
 class Graphics_3D_System;
@@ -42,6 +43,15 @@ private:
     bool running = true;
     int  frame = 0;
 
+    Debug_Drawer debugDrawer;                   ///< Attached to the world only while debug drawing is on.
+    bool         debugDrawing = false;
+
+    // Per-frame lists of updateGraphicsTransforms, kept to reuse their memory
+    std::vector< const btCollisionObject* > syncBodies;
+    btAlignedObjectArray< btVector3 >      syncScales;
+    std::vector< glt::Node* >              syncModels;
+    std::vector< glm::mat4 >               syncMatrices;
+
 public:
 
     Scene();
@@ -52,7 +62,7 @@ public:
     void addDoor(const std::string& name, std::shared_ptr<Entity> entity, const btVector3& origin,
         const btVector3& shapeSize, btScalar mass, btVector3 scale, btVector3 color);
     void addKey(const std::string& name, std::shared_ptr<Entity> entity, const btVector3& origin,
-        const btVector3& shapeSize, btScalar mass, btVector3 scale, btVector3 color);
+        btScalar mass, btVector3 scale, btVector3 color);
     void addPlatform(const std::string& name, std::shared_ptr<Platform> entity, const btVector3& origin,
         const btVector3& shapeSize, btScalar mass, btVector3 scale, btVector3 color);
     void addTank(const std::string& name, std::shared_ptr<Tank> tank);
@@ -62,5 +72,7 @@ public:
     void applyTankTurningForce(const btVector3& leftForce, const btVector3& rightForce, const btMatrix3x3& rotation);
     void updateGraphicsTransforms();
     void resetDynamicsWorld(); // new mehtod for resetting the dynamicsword
+    void setDebugDrawing(bool enabled);
+    void setDebugDrawMode(int mode, const std::string& dumpPath = "");
 
 };
\ No newline at end of file
@@ -22,9 +22,14 @@
 #include "Physics_3D_System.h"
 #include "Entity.h"
 
+#ifndef TANK_ENABLE_BENCHMARK
+#define TANK_ENABLE_BENCHMARK 0
+#endif
+
 using namespace std;
 using namespace glt;
 
+class btMultiBody;
 class Projectile;
 class Graphics_3D_System;
 class Physics_3D_System;
@@ -37,6 +42,14 @@ class Tank : public Entity{
         Tank();
         ~Tank();
 
+        /**
+ * \brief Creates the bodies of the tank parts around a point, and sets their position and scale.
+ * In an articulated physics system the tank is one btMultiBody: the chassis is its base, the tracks turn on
+ * revolute links and the turret and cannon are fixed links. Otherwise every part is a rigid body and they are
+ * held together by hinge and fixed constraints.
+ */
+        void addPhysics(Physics_3D_System& physicsSystem, const btVector3& origin);
+
         void shootProjectile(shared_ptr<Graphics_3D_System> graphicsSystem, shared_ptr<Physics_3D_System> physicsSystem,
             std::map<std::string, std::shared_ptr<Entity>> entities);
 
@@ -50,8 +63,18 @@ class Tank : public Entity{
         shared_ptr<btHingeConstraint> rightTrackConstraint;
         shared_ptr<btFixedConstraint> turretConstraint;
         shared_ptr<btFixedConstraint> canyonConstraint;
+        shared_ptr<btMultiBody> multiBody;                     ///< Set instead of the constraints in an articulated system.
         std::shared_ptr<Projectile> projectile;
         vector< shared_ptr< Projectile > > projectiles;
         size_t nextProjectileIndex; // index of the next projectile available
 
+        /// Step cost of many driving tanks built from constrained rigid bodies and as multibodies.
+#if TANK_ENABLE_BENCHMARK
+        static void benchmark();
+#else
+        static void benchmark()
+        {
+        }
+#endif
+
 };
\ No newline at end of file
@@ -108,7 +108,7 @@ int main ()
     btVector3 scaleKey(1.f, 1.f, 1.f);
     btVector3 colorKey(0.5f, .5f, .5f);
 
-    newScene->addKey("key", key, btVector3(positionKey.getX(), positionKey.getY(), positionKey.getZ()), btVector3(scaleKey.getX(), scaleKey.getY(), scaleKey.getZ()),
+    newScene->addKey("key", key, btVector3(positionKey.getX(), positionKey.getY(), positionKey.getZ()),
         1.f, scaleKey, colorKey);
 
     shared_ptr<Tank> tank = make_shared<Tank>();
@@ -0,0 +1,416 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <glm/gtc/matrix_access.hpp>
+
+#include <Vertex_Shader.hpp>
+#include <Fragment_Shader.hpp>
+#include "Batch_Renderer.h"
+
+using namespace std;
+using namespace glt;
+
+namespace
+{
+    const GLuint OBJECT_BLOCK_BINDING = 0;
+
+    /// Margin added around the boxes in the culling tree, so that small movements do not update it.
+    const btScalar BOUNDS_MARGIN = btScalar(0.1);
+
+    /// Collects the objects of the leaves that the frustum query reaches.
+    struct Visible_Collector : btDbvt::ICollide
+    {
+        std::vector< int >& visible;
+
+        Visible_Collector(std::vector< int >& visible) : visible(visible) {}
+
+        void Process(const btDbvtNode* leaf) { visible.push_back(leaf->dataAsInt); }
+    };
+
+    // The version line and the OBJECTS_PER_BLOCK definition are prepended when the shaders are compiled
+    const char* const VERTEX_SHADER_CODE =
+        "struct Object_Data\n"
+        "{\n"
+        "    mat4 model_matrix;\n"
+        "    vec4 color;\n"
+        "};\n"
+        "\n"
+        "layout(std140) uniform Object_Block\n"
+        "{\n"
+        "    Object_Data objects[OBJECTS_PER_BLOCK];\n"
+        "};\n"
+        "\n"
+        "uniform mat4 view_matrix;\n"
+        "uniform mat4 projection_matrix;\n"
+        "uniform vec3 light_position;\n"
+        "\n"
+        "in  vec3 vertex_coordinates;\n"
+        "in  vec3 vertex_normal;\n"
+        "out vec3 front_color;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    Object_Data object = objects[gl_InstanceID];\n"
+        "\n"
+        "    vec4  world_position = object.model_matrix * vec4(vertex_coordinates, 1.0);\n"
+        "    vec3  normal         = normalize(transpose(inverse(mat3(object.model_matrix))) * vertex_normal);\n"
+        "    float intensity      = max(dot(normal, normalize(light_position - world_position.xyz)), 0.0);\n"
+        "\n"
+        "    front_color = object.color.rgb * (0.3 + 0.7 * intensity);\n"
+        "    gl_Position = projection_matrix * view_matrix * world_position;\n"
+        "}\n";
+
+    const char* const FRAGMENT_SHADER_CODE =
+        "in  vec3 front_color;\n"
+        "out vec4 fragment_color;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    fragment_color = vec4(front_color, 1.0);\n"
+        "}\n";
+}
+
+/**
+ * Release the GL objects.
+ */
+Batch_Renderer::~Batch_Renderer()
+{
+    if (uniformBuffer) glDeleteBuffers(1, &uniformBuffer);
+    if (programId) glDeleteProgram(programId);
+}
+
+/**
+ * Build the shader program and the uniform buffer.
+ * @return False if the shader program cannot be built.
+ */
+bool Batch_Renderer::initialize()
+{
+    std::string header = "#version 150 core\n#define OBJECTS_PER_BLOCK " + std::to_string(OBJECTS_PER_BLOCK) + "\n\n";
+
+    Vertex_Shader vertexShader(Shader::Source_Code::from_string(header + VERTEX_SHADER_CODE));
+    Fragment_Shader fragmentShader(Shader::Source_Code::from_string(header + FRAGMENT_SHADER_CODE));
+
+    if (vertexShader.compilation_failed() || fragmentShader.compilation_failed()) {
+        std::cerr << "Error compiling the batch shaders: " << vertexShader.log() << fragmentShader.log() << std::endl;
+        return false;
+    }
+
+    // The program is built by hand so that the attribute locations match the ones the meshes use
+    programId = glCreateProgram();
+    glAttachShader(programId, vertexShader);
+    glAttachShader(programId, fragmentShader);
+    glBindAttribLocation(programId, Mesh::COORDINATES, "vertex_coordinates");
+    glBindAttribLocation(programId, Mesh::NORMALS, "vertex_normal");
+    glLinkProgram(programId);
+    glDetachShader(programId, vertexShader);
+    glDetachShader(programId, fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        GLchar log[1024];
+        glGetProgramInfoLog(programId, sizeof(log), nullptr, log);
+        std::cerr << "Error linking the batch shaders: " << log << std::endl;
+        return false;
+    }
+
+    viewMatrixLocation = glGetUniformLocation(programId, "view_matrix");
+    projectionMatrixLocation = glGetUniformLocation(programId, "projection_matrix");
+    lightPositionLocation = glGetUniformLocation(programId, "light_position");
+    glUniformBlockBinding(programId, glGetUniformBlockIndex(programId, "Object_Block"), OBJECT_BLOCK_BINDING);
+
+    // Every batch starts at a multiple of the offset alignment so it can be bound as its own range
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    GLintptr blockSize = GLintptr(sizeof(Object_Data)) * OBJECTS_PER_BLOCK;
+    blockStride = (blockSize + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &uniformBuffer);
+    return true;
+}
+
+/**
+ * Register a model to be drawn every frame while it is visible.
+ * @param node Node whose total transformation places the mesh.
+ * @param mesh Mesh drawn for the node.
+ * @param color Color of the object.
+ */
+void Batch_Renderer::add(std::shared_ptr<glt::Node> node, std::shared_ptr<Shared_Mesh> mesh, const glt::Vector3& color)
+{
+    auto meshId = find(meshIds.begin(), meshIds.end(), mesh.get());
+    if (meshId == meshIds.end()) {
+        meshId = find(meshIds.begin(), meshIds.end(), nullptr);
+        if (meshId == meshIds.end()) {
+            meshId = meshIds.insert(meshIds.end(), nullptr);
+        }
+        *meshId = mesh.get();
+    }
+
+    Object object;
+    object.node   = node;
+    object.mesh   = mesh;
+    object.meshId = uint32_t(meshId - meshIds.begin());
+    object.color  = Vector4(color, 1.f);
+    objects.push_back(object);
+}
+
+/**
+ * Stop drawing the objects of a node. The last object takes the place of each removed one, and the identifier of a
+ * mesh that no object uses anymore is freed for the next mesh added.
+ * @param node The node given to add().
+ */
+void Batch_Renderer::remove(const glt::Node* node)
+{
+    for (size_t i = 0; i < objects.size(); )
+    {
+        if (objects[i].node.get() != node) {
+            ++i;
+            continue;
+        }
+
+        if (objects[i].leaf) {
+            cullingTree.remove(objects[i].leaf);
+        }
+        uint32_t meshId = objects[i].meshId;
+
+        if (i + 1 < objects.size()) {
+            objects[i] = std::move(objects.back());
+            if (objects[i].leaf) {
+                objects[i].leaf->dataAsInt = int(i);
+            }
+        }
+        objects.pop_back();
+
+        if (none_of(objects.begin(), objects.end(), [meshId](const Object& object) { return object.meshId == meshId; })) {
+            meshIds[meshId] = nullptr;
+        }
+    }
+}
+
+/**
+ * Mark the object drawn for a node as an occluder.
+ * @param node The node given to add().
+ */
+void Batch_Renderer::setOccluder(const glt::Node* node)
+{
+    for (auto& object : objects) {
+        if (object.node.get() == node) {
+            object.occluder = true;
+        }
+    }
+}
+
+/**
+ * Read the total transformation of every object once for the frame and refit the boxes of the culling
+ * tree of the objects that moved. The box of each mesh is transformed as a center and extents, which
+ * keeps it tight under rotation.
+ */
+void Batch_Renderer::updateBounds()
+{
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        Object& object = objects[i];
+        if (!object.mesh->is_loaded())
+            continue;
+
+        const Matrix44 transformation = object.node->get_total_transformation();
+        if (object.leaf && transformation == object.worldMatrix)
+            continue;                                   // Still where it was: bounds and leaf are up to date
+
+        object.worldMatrix = transformation;
+        Vector3 localCenter = (object.mesh->get_bounds_min() + object.mesh->get_bounds_max()) * 0.5f;
+        Vector3 localExtents = (object.mesh->get_bounds_max() - object.mesh->get_bounds_min()) * 0.5f;
+
+        Vector3 center = Vector3(transformation * Vector4(localCenter, 1.f));
+        Vector3 extents;
+        for (int axis = 0; axis < 3; ++axis) {
+            extents[axis] = abs(transformation[0][axis]) * localExtents.x
+                          + abs(transformation[1][axis]) * localExtents.y
+                          + abs(transformation[2][axis]) * localExtents.z;
+        }
+
+        object.boundsMin = center - extents;
+        object.boundsMax = center + extents;
+
+        btDbvtVolume volume = btDbvtVolume::FromCE(btVector3(center.x, center.y, center.z), btVector3(extents.x, extents.y, extents.z));
+
+        if (!object.leaf) {
+            volume.Expand(btVector3(BOUNDS_MARGIN, BOUNDS_MARGIN, BOUNDS_MARGIN));
+            object.leaf = cullingTree.insert(volume, nullptr);
+            object.leaf->dataAsInt = int(i);
+        }
+        else {
+            cullingTree.update(object.leaf, volume, BOUNDS_MARGIN);
+        }
+    }
+}
+
+/**
+ * Find the objects whose boxes touch the view frustum.
+ * @param viewProjection Product of the projection and view matrices.
+ */
+void Batch_Renderer::cullObjects(const glt::Matrix44& viewProjection)
+{
+    visibleObjects.clear();
+    updateBounds();
+
+    if (frustumCulling)
+    {
+        // Frustum planes from the rows of the clip matrix, with normals pointing inside
+        btVector3 normals[6];
+        btScalar offsets[6];
+        for (int i = 0; i < 6; ++i)
+        {
+            int row = i / 2;
+            float sign = i % 2 == 0 ? 1.f : -1.f;
+            Vector4 plane = glm::row(viewProjection, 3) + sign * glm::row(viewProjection, row);
+            normals[i].setValue(plane.x, plane.y, plane.z);
+            offsets[i] = plane.w;
+        }
+
+        Visible_Collector collector(visibleObjects);
+        btDbvt::collideKDOP(cullingTree.m_root, normals, offsets, 6, collector);
+    }
+    else
+    {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            if (objects[i].leaf) visibleObjects.push_back(int(i));
+        }
+    }
+
+    cullStatistics.objects = size_t(cullingTree.m_leaves);
+    cullStatistics.visible = visibleObjects.size();
+    cullStatistics.culled = cullStatistics.objects - cullStatistics.visible;
+
+    // Hidden nodes are neither drawn nor used as occluders
+    visibleObjects.erase(remove_if(visibleObjects.begin(), visibleObjects.end(),
+        [this](int index) { return objects[index].node->is_not_visible(); }), visibleObjects.end());
+
+    if (occlusionCulling) {
+        cullOccludedObjects(viewProjection);
+    }
+}
+
+/**
+ * Rasterize the occluders in the frustum and drop the objects they hide from the visible list.
+ * @param viewProjection Product of the projection and view matrices.
+ */
+void Batch_Renderer::cullOccludedObjects(const glt::Matrix44& viewProjection)
+{
+    occlusionCuller.beginFrame(viewProjection);
+
+    for (int index : visibleObjects)
+    {
+        const Object& object = objects[index];
+        if (object.occluder) {
+            occlusionCuller.addOccluder(object.worldMatrix, object.mesh->get_bounds_min(), object.mesh->get_bounds_max());
+        }
+    }
+
+    if (occlusionCuller.getStatistics().occluders == 0) {
+        return;
+    }
+
+    visibleObjects.erase(remove_if(visibleObjects.begin(), visibleObjects.end(),
+        [this](int index) {
+            const Object& object = objects[index];
+            return !object.occluder && !occlusionCuller.isVisible(object.boundsMin, object.boundsMax);
+        }), visibleObjects.end());
+}
+
+/**
+ * Sort the objects that passed the culling by mesh and depth, split them into batches of the same mesh
+ * and write their data for the uniform buffer.
+ * @param cameraPosition Position the depth of the objects is measured from.
+ * @param farDistance Distance that maps to the largest depth in the sort keys.
+ */
+void Batch_Renderer::buildBatches(const glt::Vector3& cameraPosition, float farDistance)
+{
+    float inverseFar = 1.f / farDistance;
+
+    renderQueue.clear();
+    for (int index : visibleObjects)
+    {
+        const Object& object = objects[index];
+        float depth = glm::length((object.boundsMin + object.boundsMax) * 0.5f - cameraPosition) * inverseFar;
+
+        // There is a single shader and no separate materials, so only the mesh and depth vary
+        renderQueue.push(Render_Queue::makeKey(0, 0, object.meshId, depth), uint32_t(index));
+    }
+    renderQueue.sort();
+
+    batches.clear();
+    uint64_t batchState = 0;
+
+    for (const auto& item : renderQueue.getItems())
+    {
+        const Object& object = objects[item.index];
+        uint64_t state = Render_Queue::stateOf(item.key);
+
+        if (batches.empty() || state != batchState || batches.back().count == OBJECTS_PER_BLOCK)
+        {
+            batches.push_back({ object.mesh.get(), GLintptr(batches.size()) * blockStride, 0 });
+            bufferData.resize(size_t(batches.size() * blockStride));
+            batchState = state;
+        }
+
+        Batch& batch = batches.back();
+        Object_Data& data = reinterpret_cast<Object_Data&>(bufferData[size_t(batch.offset) + batch.count * sizeof(Object_Data)]);
+
+        memcpy(data.model_matrix, get_values(object.worldMatrix), sizeof(data.model_matrix));
+        memcpy(data.color, get_values(object.color), sizeof(data.color));
+        ++batch.count;
+    }
+}
+
+/**
+ * Draw all the visible objects. The uniform buffer is refilled once and every batch is drawn
+ * as the instances of a single draw call.
+ * @param camera Camera the scene is seen from.
+ * @param lightPosition Position of the light in world space.
+ */
+void Batch_Renderer::render(const glt::Camera& camera, const glt::Vector3& lightPosition)
+{
+    drawCalls = 0;
+
+    // The camera transformation is read and inverted once for the whole frame
+    Matrix44 cameraMatrix = camera.get_total_transformation();
+    Matrix44 viewMatrix = glt::inverse(cameraMatrix);
+    cullObjects(camera.get_projection_matrix() * viewMatrix);
+    buildBatches(extract_translation(cameraMatrix), camera.get_far());
+    if (batches.empty()) {
+        return;
+    }
+
+    GLsizeiptr size = GLsizeiptr(batches.size()) * blockStride;
+    glBindBuffer(GL_UNIFORM_BUFFER, uniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);        // Orphan last frame's storage
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, bufferData.data());
+
+    glUseProgram(programId);
+    glUniformMatrix4fv(viewMatrixLocation, 1, GL_FALSE, get_values(viewMatrix));
+    glUniformMatrix4fv(projectionMatrixLocation, 1, GL_FALSE, get_values(camera.get_projection_matrix()));
+    glUniform3fv(lightPositionLocation, 1, get_values(lightPosition));
+
+    for (const auto& batch : batches)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, uniformBuffer, batch.offset, sizeof(Object_Data) * OBJECTS_PER_BLOCK);
+
+        batch.mesh->draw_instances(batch.count);
+        ++drawCalls;
+    }
+
+    glUseProgram(0);
+}
@@ -0,0 +1,488 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <LinearMath/btConvexHullComputer.h>
+#include <LinearMath/btGeometryUtil.h>
+#include <BulletCollision/CollisionShapes/btShapeHull.h>
+#include <BulletCollision/CollisionShapes/btConvexPolyhedron.h>
+#include "Collision_Shape_Cache.h"
+#include "Convex_Decomposition.h"
+#include "Obj_Loader.h"
+
+using namespace std;
+
+namespace
+{
+    const char     CACHE_MAGIC[4] = { 'H', 'U', 'L', 'L' };
+    const uint32_t CACHE_VERSION  = 2;
+
+    template< typename TYPE >
+    void writeValue(ofstream& file, const TYPE& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(TYPE));
+    }
+
+    template< typename TYPE >
+    bool readValue(ifstream& file, TYPE& value)
+    {
+        return bool(file.read(reinterpret_cast<char*>(&value), sizeof(TYPE)));
+    }
+
+    /**
+     * Get the collision margin of a hull: Bullet's default, or half the distance from the centre of its vertices to
+     * the nearest face for hulls too thin to be shrunk by it.
+     */
+    btScalar hullMargin(const btConvexPolyhedron& polyhedron)
+    {
+        btVector3 center(0, 0, 0);
+        for (int i = 0; i < polyhedron.m_vertices.size(); ++i) {
+            center += polyhedron.m_vertices[i];
+        }
+        center /= btScalar(polyhedron.m_vertices.size());
+
+        btScalar margin = CONVEX_DISTANCE_MARGIN;
+        for (int i = 0; i < polyhedron.m_faces.size(); ++i) {
+            const btScalar* plane = polyhedron.m_faces[i].m_plane;
+            margin = btMin(margin, -(plane[0] * center.getX() + plane[1] * center.getY() + plane[2] * center.getZ() + plane[3]) / 2);
+        }
+        return btMax(margin, btScalar(0));
+    }
+}
+
+/**
+ * Create a convex hull shape for an OBJ file, reading the hull from the on-disk cache when possible.
+ * @param objPath Path of the OBJ file.
+ * @param scale Scale of the shape.
+ * @param vertexBudget Maximum number of hull vertices.
+ * @return The convex hull shape, or nullptr on failure.
+ */
+std::shared_ptr<btConvexHullShape> Collision_Shape_Cache::getConvexHull(const std::string& objPath, const btVector3& scale, int vertexBudget)
+{
+    const Hull_Set* hulls = findHulls(objPath, { vertexBudget, 1, 0.f });
+    if (!hulls) {
+        return nullptr;
+    }
+
+    return createHullShape(hulls->front(), scale, btVector3(0, 0, 0));
+}
+
+/**
+ * Create a compound of convex hulls approximating a concave OBJ mesh, reading the pieces from the
+ * on-disk cache when possible. Every hull is recentred on its own vertices and placed with its child
+ * transform, which keeps the child bounding volumes tight.
+ * @param objPath Path of the OBJ file.
+ * @param scale Scale of the shape.
+ * @param maxHulls Maximum number of hulls.
+ * @param maxVolumeError Relative excess of the hulls' volume over the mesh volume that is accepted.
+ * @param vertexBudget Maximum number of vertices of each hull.
+ * @return The compound shape, or nullptr on failure.
+ */
+std::shared_ptr<Convex_Compound_Shape> Collision_Shape_Cache::getConvexDecomposition(const std::string& objPath, const btVector3& scale,
+    int maxHulls, btScalar maxVolumeError, int vertexBudget)
+{
+    const Hull_Set* hulls = findHulls(objPath, { vertexBudget, btMax(maxHulls, 1), float(maxVolumeError) });
+    if (!hulls) {
+        return nullptr;
+    }
+
+    auto compound = std::make_shared<Convex_Compound_Shape>();
+    for (const auto& hull : *hulls)
+    {
+        btVector3 center(0, 0, 0);
+        for (const auto& vertex : hull.vertices) {
+            center += vertex * scale;
+        }
+        center /= btScalar(hull.vertices.size());
+
+        btTransform localTransform;
+        localTransform.setIdentity();
+        localTransform.setOrigin(center);
+        compound->addHull(localTransform, createHullShape(hull, scale, center));
+    }
+    return compound;
+}
+
+/**
+ * Get the radius of the sphere centred at the mesh origin that encloses the hull of the mesh.
+ * @param objPath Path of the OBJ file.
+ * @param vertexBudget Maximum number of hull vertices.
+ * @return The radius, or 0 on failure.
+ */
+btScalar Collision_Shape_Cache::getBoundingRadius(const std::string& objPath, int vertexBudget)
+{
+    const Hull_Set* hulls = findHulls(objPath, { vertexBudget, 1, 0.f });
+    if (!hulls) {
+        return 0;
+    }
+
+    btScalar radius2 = 0;
+    for (const auto& vertex : hulls->front().vertices) {
+        radius2 = btMax(radius2, vertex.length2());
+    }
+    return btSqrt(radius2);
+}
+
+/**
+ * Find the hulls of an OBJ file: first in memory, then in the on-disk cache, and only if both miss
+ * by parsing the OBJ and computing the hulls (which are then written back to the cache).
+ * @param objPath Path of the OBJ file.
+ * @param parameters How the hulls are built; a single hull of the whole mesh when maxHulls is 1.
+ * @return The hulls, or nullptr if the OBJ cannot be read.
+ */
+const Collision_Shape_Cache::Hull_Set* Collision_Shape_Cache::findHulls(const std::string& objPath, const Build_Parameters& parameters)
+{
+    const std::string key = objPath + "#" + std::to_string(parameters.vertexBudget) + "#" +
+        std::to_string(parameters.maxHulls) + "#" + std::to_string(parameters.maxVolumeError);
+
+    auto loaded = loadedHulls.find(key);
+    if (loaded != loadedHulls.end()) {
+        return &loaded->second;
+    }
+
+    uint64_t hash;
+    if (!hashFile(objPath, hash)) {
+        std::cerr << "Error: Cannot read " << objPath << std::endl;
+        return nullptr;
+    }
+
+    const std::string cachePath = objPath + (parameters.maxHulls == 1 ? ".hull" : ".hulls");
+    Hull_Set hulls;
+
+    if (!readCache(cachePath, hash, parameters, hulls))
+    {
+        Obj_Mesh_Data mesh;
+        std::string error;
+        if (!Obj_Loader::load(objPath, mesh, error)) {
+            std::cerr << "Error: Cannot build the collision hulls of " << objPath << ". " << error << std::endl;
+            return nullptr;
+        }
+
+        std::vector< Convex_Decomposition::Point_Cloud > pieces;
+        if (parameters.maxHulls == 1 || !Convex_Decomposition::decompose(mesh, parameters.maxHulls, parameters.maxVolumeError, pieces))
+        {
+            pieces.assign(1, Convex_Decomposition::Point_Cloud());
+            for (const auto& position : mesh.positions) {
+                pieces.front().push_back(btVector3(position.x, position.y, position.z));
+            }
+        }
+
+        for (const auto& piece : pieces)
+        {
+            btAlignedObjectArray<btVector3> points;
+            points.reserve(int(piece.size()));
+            for (const auto& point : piece) {
+                points.push_back(point);
+            }
+
+            Hull_Data hull;
+            if (buildHull(points, parameters.vertexBudget, hull)) {
+                hulls.push_back(std::move(hull));
+            }
+        }
+
+        if (hulls.empty()) {
+            std::cerr << "Error: Cannot build the collision hulls of " << objPath << "." << std::endl;
+            return nullptr;
+        }
+        writeCache(cachePath, hash, parameters, hulls);
+    }
+
+    return &(loadedHulls[key] = std::move(hulls));
+}
+
+/**
+ * Create a convex hull shape from cached hull data.
+ * The scale is applied to the vertices and the face planes are rebuilt from them, which only costs a
+ * pass over the (few) hull faces. The points of the shape are the corners of the hull moved inwards by the
+ * collision margin, so that the shape with its margin, which GJK and EPA use, matches the model. The
+ * polyhedral features, which the SAT narrowphase uses without a margin, keep the hull itself.
+ * @param hull The cached hull.
+ * @param scale Scale of the shape.
+ * @param offset Subtracted from the scaled vertices, to centre the hull on a child transform.
+ * @return The convex hull shape with its polyhedral features set.
+ */
+std::shared_ptr<btConvexHullShape> Collision_Shape_Cache::createHullShape(const Hull_Data& hull, const btVector3& scale, const btVector3& offset)
+{
+    btConvexPolyhedron polyhedron;
+    polyhedron.m_vertices.resize(static_cast<int>(hull.vertices.size()));
+    for (size_t i = 0; i < hull.vertices.size(); ++i) {
+        polyhedron.m_vertices[static_cast<int>(i)] = hull.vertices[i] * scale - offset;
+    }
+
+    for (const auto& indices : hull.faces)
+    {
+        btFace face;
+        btVector3 normal(0, 0, 0);
+
+        // Newell's method keeps the winding of the cached face, so normals still point outwards
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            const btVector3& current = polyhedron.m_vertices[indices[i]];
+            const btVector3& next = polyhedron.m_vertices[indices[(i + 1) % indices.size()]];
+            normal += btVector3(
+                (current.getY() - next.getY()) * (current.getZ() + next.getZ()),
+                (current.getZ() - next.getZ()) * (current.getX() + next.getX()),
+                (current.getX() - next.getX()) * (current.getY() + next.getY()));
+            face.m_indices.push_back(indices[i]);
+        }
+        normal.normalize();
+
+        btScalar planeEq = BT_LARGE_FLOAT;
+        for (int index : indices) {
+            planeEq = btMin(planeEq, polyhedron.m_vertices[index].dot(normal));
+        }
+
+        face.m_plane[0] = normal.getX();
+        face.m_plane[1] = normal.getY();
+        face.m_plane[2] = normal.getZ();
+        face.m_plane[3] = -planeEq;
+        polyhedron.m_faces.push_back(face);
+    }
+
+    polyhedron.initialize();
+
+    // Shrink the hull by its margin as Bullet recommends: move the face planes inwards and take their corners
+    btScalar margin = hullMargin(polyhedron);
+    btAlignedObjectArray<btVector3> planes;
+    for (int i = 0; i < polyhedron.m_faces.size(); ++i) {
+        const btScalar* plane = polyhedron.m_faces[i].m_plane;
+        btVector3 shiftedPlane(plane[0], plane[1], plane[2]);
+        shiftedPlane[3] = plane[3] + margin;
+        planes.push_back(shiftedPlane);
+    }
+
+    // Every triple of planes meeting at a corner gives a point, so keep only the corners of their hull
+    btAlignedObjectArray<btVector3> shrunk;
+    btGeometryUtil::getVerticesFromPlaneEquations(planes, shrunk);
+    if (shrunk.size() >= 4) {
+        btConvexHullComputer computer;
+        computer.compute(&shrunk[0].getX(), sizeof(btVector3), shrunk.size(), 0, 0);
+        shrunk = computer.vertices;
+    }
+    if (shrunk.size() < 4) {
+        shrunk = polyhedron.m_vertices;
+        margin = 0;
+    }
+
+    auto shape = std::make_shared<btConvexHullShape>(&shrunk[0].getX(), shrunk.size());
+    shape->setMargin(margin);
+    shape->setPolyhedralFeatures(polyhedron);
+    return shape;
+}
+
+/**
+ * Compute the simplified hull of a set of points and extract its planar faces.
+ * @param points The points, usually the vertices of a mesh or of a piece of it.
+ * @param vertexBudget Maximum number of hull vertices.
+ * @param hull Receives the hull vertices and faces.
+ * @return True on success.
+ */
+bool Collision_Shape_Cache::buildHull(const btAlignedObjectArray<btVector3>& points, int vertexBudget, Hull_Data& hull)
+{
+    if (points.size() < 4) {
+        return false;
+    }
+
+    btConvexHullComputer computer;
+    computer.compute(&points[0].getX(), sizeof(btVector3), points.size(), 0, 0);
+    if (computer.vertices.size() < 4) {
+        return false;
+    }
+
+    // Keep only the support points along a fixed set of directions if the exact hull is too detailed. btShapeHull
+    // samples the supporting vertices with the margin, so this temporary shape has none
+    btConvexHullShape exactHull(&computer.vertices[0].getX(), computer.vertices.size());
+    exactHull.setMargin(0);
+
+    btAlignedObjectArray<btVector3> simplified;
+    if (computer.vertices.size() > vertexBudget)
+    {
+        btShapeHull shapeHull(&exactHull);
+        shapeHull.buildHull(0, vertexBudget > 42 ? 1 : 0);   // btShapeHull samples 42 or 256 directions
+        for (int i = 0; i < shapeHull.numVertices(); ++i) {
+            simplified.push_back(shapeHull.getVertexPointer()[i]);
+        }
+    }
+    else
+    {
+        simplified = computer.vertices;
+    }
+
+    // btShapeHull only offers 42 or 256 directions, so thin smaller budgets down with evenly spread directions
+    if (simplified.size() > vertexBudget)
+    {
+        btConvexHullShape coarseHull(&simplified[0].getX(), simplified.size());
+
+        btAlignedObjectArray<btVector3> thinned;
+        const btScalar goldenAngle = SIMD_PI * (3 - btSqrt(btScalar(5)));
+        for (int i = 0; i < vertexBudget; ++i)
+        {
+            btScalar y = 1 - (i + btScalar(0.5)) * 2 / vertexBudget;
+            btScalar radius = btSqrt(1 - y * y);
+            btVector3 direction(btCos(goldenAngle * i) * radius, y, btSin(goldenAngle * i) * radius);
+            btVector3 support = coarseHull.localGetSupportingVertexWithoutMargin(direction);
+            if (thinned.findLinearSearch(support) == thinned.size()) {
+                thinned.push_back(support);
+            }
+        }
+        simplified = thinned;
+    }
+
+    // Merge coplanar triangles into polygons exactly as the SAT narrowphase expects them
+    btConvexHullShape finalHull(&simplified[0].getX(), simplified.size());
+    if (!finalHull.initializePolyhedralFeatures()) {
+        return false;
+    }
+
+    const btConvexPolyhedron* polyhedron = finalHull.getConvexPolyhedron();
+    for (int i = 0; i < polyhedron->m_vertices.size(); ++i) {
+        hull.vertices.push_back(polyhedron->m_vertices[i]);
+    }
+    for (int i = 0; i < polyhedron->m_faces.size(); ++i) {
+        const auto& indices = polyhedron->m_faces[i].m_indices;
+        hull.faces.emplace_back(&indices[0], &indices[0] + indices.size());
+    }
+    return true;
+}
+
+/**
+ * Read hulls from a cache file.
+ * @return True if the file exists, is valid and matches the hash of the OBJ and the build parameters.
+ */
+bool Collision_Shape_Cache::readCache(const std::string& cachePath, uint64_t hash, const Build_Parameters& parameters, Hull_Set& hulls)
+{
+    ifstream file(cachePath, ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version;
+    uint64_t cachedHash;
+    Build_Parameters cached;
+    int32_t hullCount;
+
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 ||
+        !readValue(file, version) || version != CACHE_VERSION ||
+        !readValue(file, cachedHash) || cachedHash != hash ||
+        !readValue(file, cached.vertexBudget) || cached.vertexBudget != parameters.vertexBudget ||
+        !readValue(file, cached.maxHulls) || cached.maxHulls != parameters.maxHulls ||
+        !readValue(file, cached.maxVolumeError) || cached.maxVolumeError != parameters.maxVolumeError ||
+        !readValue(file, hullCount) || hullCount < 1 || hullCount > parameters.maxHulls) {
+        return false;
+    }
+
+    hulls.resize(hullCount);
+    for (auto& hull : hulls)
+    {
+        int32_t vertexCount, faceCount;
+        if (!readValue(file, vertexCount) || vertexCount < 4) {
+            return false;
+        }
+
+        hull.vertices.resize(vertexCount);
+        for (auto& vertex : hull.vertices)
+        {
+            float x, y, z;
+            if (!readValue(file, x) || !readValue(file, y) || !readValue(file, z)) {
+                return false;
+            }
+            vertex.setValue(x, y, z);
+        }
+
+        if (!readValue(file, faceCount) || faceCount < 4) {
+            return false;
+        }
+
+        hull.faces.resize(faceCount);
+        for (auto& face : hull.faces)
+        {
+            int32_t indexCount;
+            if (!readValue(file, indexCount) || indexCount < 3) {
+                return false;
+            }
+            face.resize(indexCount);
+            for (int& index : face)
+            {
+                int32_t value;
+                if (!readValue(file, value) || value < 0 || value >= vertexCount) {
+                    return false;
+                }
+                index = value;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Write hulls to a cache file. Failing to write is not an error: the hulls are simply rebuilt next run.
+ */
+void Collision_Shape_Cache::writeCache(const std::string& cachePath, uint64_t hash, const Build_Parameters& parameters, const Hull_Set& hulls)
+{
+    ofstream file(cachePath, ios::binary | ios::trunc);
+    if (!file) {
+        std::cerr << "Warning: Cannot write the collision cache " << cachePath << std::endl;
+        return;
+    }
+
+    file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    writeValue(file, CACHE_VERSION);
+    writeValue(file, hash);
+    writeValue(file, parameters.vertexBudget);
+    writeValue(file, parameters.maxHulls);
+    writeValue(file, parameters.maxVolumeError);
+
+    writeValue(file, int32_t(hulls.size()));
+    for (const auto& hull : hulls)
+    {
+        writeValue(file, int32_t(hull.vertices.size()));
+        for (const auto& vertex : hull.vertices) {
+            writeValue(file, float(vertex.getX()));
+            writeValue(file, float(vertex.getY()));
+            writeValue(file, float(vertex.getZ()));
+        }
+
+        writeValue(file, int32_t(hull.faces.size()));
+        for (const auto& face : hull.faces) {
+            writeValue(file, int32_t(face.size()));
+            for (int index : face) {
+                writeValue(file, int32_t(index));
+            }
+        }
+    }
+}
+
+/**
+ * Compute the 64-bit FNV-1a hash of a file's contents.
+ * @return False if the file cannot be read.
+ */
+bool Collision_Shape_Cache::hashFile(const std::string& path, uint64_t& hash)
+{
+    ifstream file(path, ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    hash = 14695981039346656037ull;
+    char buffer[4096];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+    {
+        for (std::streamsize i = 0; i < file.gcount(); ++i) {
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ull;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,256 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <LinearMath/btConvexHullComputer.h>
+#include "Convex_Decomposition.h"
+#include "Obj_Loader.h"
+
+using namespace std;
+
+namespace
+{
+    struct Triangle
+    {
+        btVector3 corners[3];
+    };
+
+    struct Piece
+    {
+        vector< Triangle > triangles;
+        btScalar           volume;          ///< Volume of the convex hull of the piece.
+
+        // Best cut found for this piece, evaluated once when the piece is created
+        bool               splittable = false;
+        int                cutAxis;
+        btScalar           cutValue;
+        btScalar           cutGain;         ///< Hull volume removed by the cut.
+    };
+
+    // Candidate cut positions, as fractions of the piece extent along each axis
+    const btScalar CUT_FRACTIONS[] = { btScalar(0.25), btScalar(0.5), btScalar(0.75) };
+
+    Convex_Decomposition::Point_Cloud collectPoints(const vector< Triangle >& triangles)
+    {
+        Convex_Decomposition::Point_Cloud points;
+        points.reserve(triangles.size() * 3);
+        for (const auto& triangle : triangles) {
+            points.insert(points.end(), triangle.corners, triangle.corners + 3);
+        }
+        return points;
+    }
+
+    /**
+     * Clips a polygon against the half space where the coordinate along the axis is below (or above) the value.
+     */
+    void clipPolygon(const vector< btVector3 >& polygon, int axis, btScalar value, bool keepBelow, vector< btVector3 >& clipped)
+    {
+        clipped.clear();
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            const btVector3& current = polygon[i];
+            const btVector3& next = polygon[(i + 1) % polygon.size()];
+            btScalar currentDistance = keepBelow ? value - current[axis] : current[axis] - value;
+            btScalar nextDistance = keepBelow ? value - next[axis] : next[axis] - value;
+
+            if (currentDistance >= 0)
+                clipped.push_back(current);
+
+            if ((currentDistance >= 0) != (nextDistance >= 0))
+                clipped.push_back(current.lerp(next, currentDistance / (currentDistance - nextDistance)));
+        }
+    }
+
+    /**
+     * Splits a set of triangles by an axis-aligned plane. Crossing triangles are clipped and fan-triangulated.
+     */
+    void splitTriangles(const vector< Triangle >& triangles, int axis, btScalar value, vector< Triangle >& below, vector< Triangle >& above)
+    {
+        vector< btVector3 > polygon(3), clipped;
+
+        for (const auto& triangle : triangles)
+        {
+            btScalar minimum = btMin(triangle.corners[0][axis], btMin(triangle.corners[1][axis], triangle.corners[2][axis]));
+            btScalar maximum = btMax(triangle.corners[0][axis], btMax(triangle.corners[1][axis], triangle.corners[2][axis]));
+
+            if (maximum <= value) {
+                below.push_back(triangle);
+                continue;
+            }
+            if (minimum >= value) {
+                above.push_back(triangle);
+                continue;
+            }
+
+            polygon.assign(triangle.corners, triangle.corners + 3);
+            for (int side = 0; side < 2; ++side)
+            {
+                clipPolygon(polygon, axis, value, side == 0, clipped);
+                vector< Triangle >& output = side == 0 ? below : above;
+                for (size_t i = 2; i < clipped.size(); ++i) {
+                    output.push_back({ { clipped[0], clipped[i - 1], clipped[i] } });
+                }
+            }
+        }
+    }
+
+    /**
+     * Tries the candidate cuts of a piece and remembers the one that removes the most hull volume.
+     */
+    void evaluateCuts(Piece& piece)
+    {
+        btVector3 minimum(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+        btVector3 maximum(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+        for (const auto& triangle : piece.triangles) {
+            for (const auto& corner : triangle.corners) {
+                minimum.setMin(corner);
+                maximum.setMax(corner);
+            }
+        }
+
+        piece.splittable = false;
+        piece.cutGain = 0;
+
+        vector< Triangle > below, above;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (btScalar fraction : CUT_FRACTIONS)
+            {
+                btScalar value = minimum[axis] + (maximum[axis] - minimum[axis]) * fraction;
+
+                below.clear();
+                above.clear();
+                splitTriangles(piece.triangles, axis, value, below, above);
+                if (below.empty() || above.empty())
+                    continue;
+
+                btScalar gain = piece.volume
+                    - Convex_Decomposition::hullVolume(collectPoints(below))
+                    - Convex_Decomposition::hullVolume(collectPoints(above));
+
+                if (gain > piece.cutGain) {
+                    piece.splittable = true;
+                    piece.cutAxis = axis;
+                    piece.cutValue = value;
+                    piece.cutGain = gain;
+                }
+            }
+        }
+    }
+
+    Piece makePiece(vector< Triangle >&& triangles)
+    {
+        Piece piece;
+        piece.triangles = std::move(triangles);
+        piece.volume = Convex_Decomposition::hullVolume(collectPoints(piece.triangles));
+        evaluateCuts(piece);
+        return piece;
+    }
+}
+
+/**
+ * Decompose a mesh into convex pieces by greedy axis-aligned cuts.
+ * @param mesh The geometry to decompose.
+ * @param maxHulls Maximum number of pieces.
+ * @param maxVolumeError Relative excess of the summed hull volume over the mesh volume at which splitting stops.
+ * @param pieces Receives the points of every piece.
+ * @return False if the mesh has no volume.
+ */
+bool Convex_Decomposition::decompose(const Obj_Mesh_Data& mesh, int maxHulls, btScalar maxVolumeError, std::vector< Point_Cloud >& pieces)
+{
+    vector< Triangle > triangles(mesh.triangleCount());
+    btScalar meshVolume = 0;
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        for (int corner = 0; corner < 3; ++corner) {
+            const auto& position = mesh.positions[mesh.positionIndices[i * 3 + corner]];
+            triangles[i].corners[corner].setValue(position.x, position.y, position.z);
+        }
+        // Divergence theorem: the signed tetrahedra against the origin add up to the enclosed volume
+        meshVolume += triangles[i].corners[0].dot(triangles[i].corners[1].cross(triangles[i].corners[2])) / 6;
+    }
+
+    meshVolume = btFabs(meshVolume);
+    if (meshVolume <= SIMD_EPSILON) {
+        return false;
+    }
+
+    vector< Piece > working;
+    working.push_back(makePiece(std::move(triangles)));
+    btScalar totalVolume = working.front().volume;
+
+    while (int(working.size()) < maxHulls && totalVolume - meshVolume > maxVolumeError * meshVolume)
+    {
+        size_t best = working.size();
+        for (size_t i = 0; i < working.size(); ++i) {
+            if (working[i].splittable && (best == working.size() || working[i].cutGain > working[best].cutGain))
+                best = i;
+        }
+
+        if (best == working.size())
+            break;                                      // No cut reduces the hull volume any further
+
+        Piece piece = std::move(working[best]);
+        working.erase(working.begin() + best);
+
+        vector< Triangle > below, above;
+        splitTriangles(piece.triangles, piece.cutAxis, piece.cutValue, below, above);
+        working.push_back(makePiece(std::move(below)));
+        working.push_back(makePiece(std::move(above)));
+
+        totalVolume -= piece.cutGain;
+    }
+
+    pieces.clear();
+    for (const auto& piece : working) {
+        pieces.push_back(collectPoints(piece.triangles));
+    }
+    return true;
+}
+
+/**
+ * Compute the volume of the convex hull of a set of points.
+ * @param points The points.
+ * @return The hull volume, 0 for degenerate sets.
+ */
+btScalar Convex_Decomposition::hullVolume(const Point_Cloud& points)
+{
+    if (points.size() < 4) {
+        return 0;
+    }
+
+    btConvexHullComputer computer;
+    computer.compute(&points[0].getX(), sizeof(btVector3), int(points.size()), 0, 0);
+    if (computer.vertices.size() < 4) {
+        return 0;
+    }
+
+    // Sum the tetrahedra formed by every face fan and an interior point
+    btVector3 center(0, 0, 0);
+    for (int i = 0; i < computer.vertices.size(); ++i) {
+        center += computer.vertices[i];
+    }
+    center /= btScalar(computer.vertices.size());
+
+    btScalar volume = 0;
+    for (int i = 0; i < computer.faces.size(); ++i)
+    {
+        const btConvexHullComputer::Edge* first = &computer.edges[computer.faces[i]];
+        const btVector3& origin = computer.vertices[first->getSourceVertex()];
+
+        for (const btConvexHullComputer::Edge* edge = first->getNextEdgeOfFace(); edge->getTargetVertex() != first->getSourceVertex(); edge = edge->getNextEdgeOfFace())
+        {
+            const btVector3& a = computer.vertices[edge->getSourceVertex()];
+            const btVector3& b = computer.vertices[edge->getTargetVertex()];
+            volume += btFabs((origin - center).dot((a - center).cross(b - center))) / 6;
+        }
+    }
+    return volume;
+}
@@ -0,0 +1,271 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <cstddef>
+#include <iostream>
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <Vertex_Shader.hpp>
+#include <Fragment_Shader.hpp>
+#include "Debug_Drawer.h"
+
+using namespace std;
+using namespace glt;
+
+namespace
+{
+    /// Length of the normal drawn at each contact point, and half size of the cross marking it.
+    const btScalar CONTACT_NORMAL_LENGTH = btScalar(0.3);
+    const btScalar CONTACT_MARKER_SIZE = btScalar(0.05);
+
+    const char* const VERTEX_SHADER_CODE =
+        "#version 150 core\n"
+        "\n"
+        "uniform mat4 view_projection_matrix;\n"
+        "\n"
+        "in  vec3 vertex_coordinates;\n"
+        "in  vec3 vertex_color;\n"
+        "out vec3 front_color;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    front_color = vertex_color;\n"
+        "    gl_Position = view_projection_matrix * vec4(vertex_coordinates, 1.0);\n"
+        "}\n";
+
+    const char* const FRAGMENT_SHADER_CODE =
+        "#version 150 core\n"
+        "\n"
+        "in  vec3 front_color;\n"
+        "out vec4 fragment_color;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    fragment_color = vec4(front_color, 1.0);\n"
+        "}\n";
+
+    /// Draws the volume of every node of a broadphase tree, leaves in one color and branches in another.
+    struct Tree_Drawer : btDbvt::ICollide
+    {
+        btIDebugDraw* drawer;
+        btVector3     leafColor;
+        btVector3     branchColor;
+
+        Tree_Drawer(btIDebugDraw* drawer, const btVector3& leafColor, const btVector3& branchColor)
+            : drawer(drawer), leafColor(leafColor), branchColor(branchColor) {}
+
+        void Process(const btDbvtNode* node)
+        {
+            drawer->drawAabb(node->volume.Mins(), node->volume.Maxs(), node->isleaf() ? leafColor : branchColor);
+        }
+    };
+}
+
+/**
+ * Release the GL objects, if they were ever created.
+ */
+Debug_Drawer::~Debug_Drawer()
+{
+    if (vertexBuffer) glDeleteBuffers(1, &vertexBuffer);
+    if (vertexArray) glDeleteVertexArrays(1, &vertexArray);
+    if (programId) glDeleteProgram(programId);
+}
+
+/**
+ * Start writing the geometry of every frame to a text file.
+ * Each frame is a "frame <n>" line followed by one "line x0 y0 z0 x1 y1 z1 r g b" line per segment.
+ * @param path Path of the file, or an empty string to stop dumping.
+ * @return False if the file cannot be created.
+ */
+bool Debug_Drawer::setDumpFile(const std::string& path)
+{
+    dumpFile.close();
+    frame = 0;
+
+    if (path.empty()) {
+        return true;
+    }
+
+    dumpFile.open(path, ios::out | ios::trunc);
+    if (!dumpFile) {
+        std::cerr << "Error: Cannot create the debug dump file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Append one vertex to the line list.
+ */
+void Debug_Drawer::addVertex(const btVector3& position, const btVector3& color)
+{
+    vertices.push_back({
+        { GLfloat(position.x()), GLfloat(position.y()), GLfloat(position.z()) },
+        { GLfloat(color.x()), GLfloat(color.y()), GLfloat(color.z()) } });
+}
+
+void Debug_Drawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& color)
+{
+    addVertex(from, color);
+    addVertex(to, color);
+}
+
+void Debug_Drawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& fromColor, const btVector3& toColor)
+{
+    addVertex(from, fromColor);
+    addVertex(to, toColor);
+}
+
+/**
+ * Mark a contact with a small cross and a segment along its normal.
+ */
+void Debug_Drawer::drawContactPoint(const btVector3& pointOnB, const btVector3& normalOnB, btScalar /*distance*/, int /*lifeTime*/, const btVector3& color)
+{
+    drawLine(pointOnB, pointOnB + normalOnB * CONTACT_NORMAL_LENGTH, color);
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        btVector3 offset(0, 0, 0);
+        offset[axis] = CONTACT_MARKER_SIZE;
+        drawLine(pointOnB - offset, pointOnB + offset, color);
+    }
+}
+
+void Debug_Drawer::reportErrorWarning(const char* warningString)
+{
+    std::cerr << "Bullet: " << warningString << std::endl;
+}
+
+void Debug_Drawer::draw3dText(const btVector3& /*location*/, const char* /*textString*/)
+{
+    // There is no text rendering in the scene, so text is not drawn
+}
+
+/**
+ * Called by the world before it draws a frame: forgets the previous frame's lines.
+ */
+void Debug_Drawer::clearLines()
+{
+    vertices.clear();
+}
+
+/**
+ * Called by the world after it has drawn a frame: adds the broadphase tree and dumps the frame if requested.
+ */
+void Debug_Drawer::flushLines()
+{
+    if ((debugMode & DRAW_BROADPHASE) && broadphase) {
+        drawBroadphase();
+    }
+    if (dumpFile.is_open()) {
+        writeFrame();
+    }
+}
+
+/**
+ * Draw the nodes of both trees of the broadphase: dynamic proxies in set 0, static ones in set 1.
+ */
+void Debug_Drawer::drawBroadphase()
+{
+    Tree_Drawer dynamicTree(this, btVector3(1, 0.5, 0), btVector3(0.5, 0.25, 0));
+    Tree_Drawer staticTree(this, btVector3(0, 0.5, 1), btVector3(0, 0.25, 0.5));
+
+    btDbvt::enumNodes(broadphase->m_sets[0].m_root, dynamicTree);
+    btDbvt::enumNodes(broadphase->m_sets[1].m_root, staticTree);
+}
+
+/**
+ * Write the lines of the current frame to the dump file.
+ */
+void Debug_Drawer::writeFrame()
+{
+    dumpFile << "frame " << frame++ << '\n';
+    for (size_t i = 0; i + 1 < vertices.size(); i += 2)
+    {
+        const Vertex& from = vertices[i];
+        const Vertex& to = vertices[i + 1];
+        dumpFile << "line "
+            << from.position[0] << ' ' << from.position[1] << ' ' << from.position[2] << ' '
+            << to.position[0] << ' ' << to.position[1] << ' ' << to.position[2] << ' '
+            << from.color[0] << ' ' << from.color[1] << ' ' << from.color[2] << '\n';
+    }
+    dumpFile.flush();
+}
+
+/**
+ * Create the shader program, the vertex array and the streaming vertex buffer.
+ * @return False if the shader program cannot be built.
+ */
+bool Debug_Drawer::initializeRendering()
+{
+    Vertex_Shader vertexShader(Shader::Source_Code::from_string(VERTEX_SHADER_CODE));
+    Fragment_Shader fragmentShader(Shader::Source_Code::from_string(FRAGMENT_SHADER_CODE));
+
+    if (vertexShader.compilation_failed() || fragmentShader.compilation_failed()) {
+        std::cerr << "Error compiling the debug shaders: " << vertexShader.log() << fragmentShader.log() << std::endl;
+        return false;
+    }
+
+    programId = glCreateProgram();
+    glAttachShader(programId, vertexShader);
+    glAttachShader(programId, fragmentShader);
+    glBindAttribLocation(programId, 0, "vertex_coordinates");
+    glBindAttribLocation(programId, 1, "vertex_color");
+    glLinkProgram(programId);
+    glDetachShader(programId, vertexShader);
+    glDetachShader(programId, fragmentShader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        std::cerr << "Error linking the debug shaders." << std::endl;
+        glDeleteProgram(programId);
+        programId = 0;
+        return false;
+    }
+    viewProjectionLocation = glGetUniformLocation(programId, "view_projection_matrix");
+
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, color)));
+    glBindVertexArray(0);
+    return true;
+}
+
+/**
+ * Upload the lines of the last frame and draw them with a single call.
+ * @param viewProjection Product of the projection and view matrices of the camera.
+ */
+void Debug_Drawer::render(const glt::Matrix44& viewProjection)
+{
+    if (vertices.empty()) {
+        return;
+    }
+    if (!programId && !initializeRendering()) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
+
+    glUseProgram(programId);
+    glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, get_values(viewProjection));
+
+    glBindVertexArray(vertexArray);
+    glDrawArrays(GL_LINES, 0, GLsizei(vertices.size()));
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
@@ -43,6 +43,40 @@ std::shared_ptr<btRigidBody> Entity::getSharedBody() const {
     }
     return physicsComponent->getSharedRigidbody();
 }
+/**
+ * Get the collision object of this entity's physics component. Parts of a btMultiBody have no rigid body,
+ * only this collider.
+ * @return A pointer to the collision object, or nullptr if the physics component is not set.
+ */
+btCollisionObject* Entity::getCollisionObject() const {
+    if (!physicsComponent) {
+        std::cerr << "Error: Physics component is null." << std::endl;
+        return nullptr;
+    }
+    return physicsComponent->getCollisionObject();
+}
+/**
+ * Get the world transform of this entity, as it is rendered.
+ * @return The transform, or the identity if the physics component is not set.
+ */
+btTransform Entity::getWorldTransform() const {
+    if (!physicsComponent) {
+        std::cerr << "Error: Physics component is null, returning identity transform." << std::endl;
+        return btTransform::getIdentity();
+    }
+    return physicsComponent->getWorldTransform();
+}
+/**
+ * Apply a force through the center of mass of this entity's body until the next simulation step.
+ * @param force The force in world coordinates.
+ */
+void Entity::applyCentralForce(const btVector3& force) {
+    if (!physicsComponent) {
+        std::cerr << "Error: Physics component is null." << std::endl;
+        return;
+    }
+    physicsComponent->applyCentralForce(force);
+}
 /**
  * Get the graphic model associated with this entity's graphic component.
  * @return A pointer to the graphic model, or nullptr if the graphic component is not set.
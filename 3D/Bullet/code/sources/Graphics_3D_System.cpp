@@ -12,10 +12,9 @@
 #include "Scene.h"
 #include <Light.hpp>
 #include <Model.hpp>
-#include <Cube.hpp>
 #include "Entity.h"
+#include "Debug_Drawer.h"
 #include <OpenGL.hpp>
-#include <Model_Obj.hpp>
 #include <Render_Node.hpp>
 #include "Graphic_Component.h"
 #include <Material.hpp>
@@ -42,12 +41,17 @@ void Graphics_3D_System::initialize(const sf::Window& window) {
         std::cerr << "Error initializing OpenGL extensions." << std::endl;
         exit(-1); // Handle this more gracefully in production code
     }
+    if (!batchRenderer.initialize()) {
+        std::cerr << "Error initializing the batch renderer." << std::endl;
+        exit(-1);
+    }
     create_scene_basics_glt();
     configure_scene_basics_glt(*sceneGraph);
     resetViewport(window);
 
     // Set the background color for OpenGL
     glClearColor(0.2f, 0.2f, 0.2f, 1.f);
+    glEnable(GL_DEPTH_TEST);
 }
 
 /**
@@ -63,25 +67,16 @@ void Graphics_3D_System::create_scene_basics_glt() {
 
 /**
  * Helper function to simplify the creation of components.
+ * Meshes come from the asset cache, so every model of the same file shares one Drawable, and the
+ * color goes to the batch renderer's per-object data instead of a Material of its own.
  */
 void Graphics_3D_System::addComponent(const std::string& name, Entity& entity, const std::string& modelPath, btVector3 scaleObject, btVector3 color) {
     
-    auto newModel = modelPath.empty() ? std::make_shared<Model>() : std::make_shared<Model_Obj>(modelPath);
-
-    //auto default_material = Material::default_material();
-    //std::shared_ptr<Shader_Program> shader_program_shared = Material::default_material()->get_shader_program_pointer();
+    auto newModel = std::make_shared<Model>();
 
-    //auto material = std::make_shared<Material>("instance_" + name, shader_program_shared);
-    //material->set("material_color", Vector3(color.getX(), color.getY(), color.getZ()));
-    std::shared_ptr<Shader_Program> shader_program_shared = Material::default_material()->get_shader_program_pointer();
-
-    auto material = std::make_shared<Material>("instance_" + name, shader_program_shared);
-    material->set("material_color", Vector3(color.getX(), color.getY(), color.getZ()));
-
-    if (modelPath.empty()) {
-        // Default to a cube if no model path is provided
-        newModel->add(std::make_shared<Cube>(), material);
-    }
+    // Default to a cube if no model path is provided
+    std::shared_ptr<Shared_Mesh> mesh = modelPath.empty() ? meshCache.getCube() : meshCache.get(modelPath);
+    batchRenderer.add(newModel, mesh, Vector3(color.getX(), color.getY(), color.getZ()));
 
     newModel->scale(scaleObject.getX(), scaleObject.getY(), scaleObject.getZ());
     sceneGraph->add(name, newModel);
@@ -111,11 +106,39 @@ void Graphics_3D_System::add_ComponentSphere(const std::string& name, Entity& en
     addComponent(name, entity, "../../assets/sphere.obj", scaleObject, color);
 }
 
+/**
+ * Stop drawing the model of an entity. Its mesh is released once no other model uses it.
+ */
+void Graphics_3D_System::removeComponent(Entity& entity) {
+    batchRenderer.remove(entity.get_Graphic_Model());
+}
+
+/**
+ * Use the model of an entity to hide the objects behind it. Meant for large static boxes like walls and floors.
+ */
+void Graphics_3D_System::setOccluder(Entity& entity) {
+    batchRenderer.setOccluder(entity.get_Graphic_Model());
+}
+
 /**
  * Render the scene.
+ * Meshes that finished loading since the last frame are uploaded first. The models are drawn by the
+ * batch renderer; the scene graph only provides the camera and the light.
  */
 void Graphics_3D_System::render() {
-    sceneGraph->render();
+    meshCache.update();
+
+    Vector3 lightPosition = extract_translation(sceneGraph->get("light")->get_total_transformation());
+    batchRenderer.render(*sceneGraph->get_active_camera(), lightPosition);
+}
+
+/**
+ * Draw the debug lines collected by a drawer on top of the scene, from the active camera.
+ * @param drawer The drawer holding the lines of the last physics frame.
+ */
+void Graphics_3D_System::renderDebug(Debug_Drawer& drawer) {
+    Camera& camera = *sceneGraph->get_active_camera();
+    drawer.render(camera.get_projection_matrix() * glt::inverse(camera.get_total_transformation()));
 }
 
 /**
@@ -143,4 +166,20 @@ void Graphics_3D_System::configure_scene_basics_glt(glt::Render_Node& scene) {
  */
 std::shared_ptr<glt::Render_Node> Graphics_3D_System::getSceneGraph() const {
     return sceneGraph;
+}
+
+/**
+ * Get the frustum culling results of the last rendered frame.
+ * @return The number of objects tested, visible and culled.
+ */
+const Batch_Renderer::Cull_Statistics& Graphics_3D_System::getCullStatistics() const {
+    return batchRenderer.getCullStatistics();
+}
+
+/**
+ * Get the occlusion culling results of the last rendered frame.
+ * @return The number of occluders and of objects tested, visible and occluded.
+ */
+const Occlusion_Culler::Statistics& Graphics_3D_System::getOcclusionStatistics() const {
+    return batchRenderer.getOcclusionStatistics();
 }
\ No newline at end of file
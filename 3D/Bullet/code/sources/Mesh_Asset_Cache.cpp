@@ -0,0 +1,252 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <iostream>
+#include <unordered_map>
+
+#include <Vertex_Array_Object.hpp>
+#include <Vertex_Buffer_Object.hpp>
+#include "Mesh_Asset_Cache.h"
+#include "Obj_Loader.h"
+
+using namespace std;
+using namespace glt;
+
+/**
+ * Create the vertex buffers and the vertex array object of the mesh.
+ * @param data The vertex data produced by the loader.
+ */
+void Shared_Mesh::upload(const Vertex_Data& data)
+{
+    if (data.indices.empty()) {
+        return;
+    }
+
+    auto coordinates = make_shared<Vertex_Buffer_Object>(data.coordinates.data(), data.coordinates.size() * sizeof(GLfloat));
+    auto normals     = make_shared<Vertex_Buffer_Object>(data.normals.data(),     data.normals.size()     * sizeof(GLfloat));
+    auto indices     = make_shared<Vertex_Buffer_Object>(data.indices.data(),     data.indices.size()     * sizeof(GLuint), Vertex_Buffer_Object::ELEMENT_ARRAY_BUFFER);
+
+    set_vao(shared_ptr<Vertex_Array_Object>(new Vertex_Array_Object(
+        {
+            { coordinates, COORDINATES, 3, GL_FLOAT },
+            { normals,     NORMALS,     3, GL_FLOAT },
+        },
+        indices)));
+
+    set_vertices_count(GLsizei(data.indices.size()));
+    set_indices_type(GL_UNSIGNED_INT);
+
+    boundsMin = glm::vec3(data.coordinates[0], data.coordinates[1], data.coordinates[2]);
+    boundsMax = boundsMin;
+    for (size_t i = 3; i + 2 < data.coordinates.size(); i += 3) {
+        glm::vec3 position(data.coordinates[i], data.coordinates[i + 1], data.coordinates[i + 2]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+}
+
+/**
+ * Draw several instances of the mesh with one call.
+ * @param count Number of instances.
+ */
+void Shared_Mesh::draw_instances(GLsizei count)
+{
+    if (!vao || count <= 0) {
+        return;
+    }
+
+    vao->bind();
+
+    if (indices_type == GL_NONE) {
+        glDrawArraysInstanced(primitive_type, 0, vertices_count, count);
+    }
+    else {
+        glDrawElementsInstanced(primitive_type, vertices_count, indices_type, 0, count);
+    }
+
+    vao->unbind();
+}
+
+/**
+ * Get the shared mesh of a model file.
+ * If no live model uses the file yet, it is parsed asynchronously and uploaded by a later update(). The entries of
+ * the meshes that have been released are dropped at that point too.
+ * @param path Path of the OBJ file.
+ * @return The shared mesh.
+ */
+std::shared_ptr<Shared_Mesh> Mesh_Asset_Cache::get(const std::string& path)
+{
+    auto found = meshes.find(path);
+    if (found != meshes.end()) {
+        if (auto mesh = found->second.lock()) {
+            return mesh;
+        }
+    }
+
+    for (auto entry = meshes.begin(); entry != meshes.end(); ) {
+        entry = entry->second.expired() ? meshes.erase(entry) : next(entry);
+    }
+
+    auto mesh = make_shared<Shared_Mesh>();
+    meshes[path] = mesh;
+    pendingUploads.push_back({ mesh, async(launch::async, &Mesh_Asset_Cache::loadVertexData, path), path });
+    return mesh;
+}
+
+/**
+ * Get the cube shared by all the box-shaped entities. It spans from -1 to 1 on every axis, like glt::Cube.
+ * The cube is generated in place, so it is uploaded immediately and needs a current GL context.
+ * @return The cube mesh.
+ */
+std::shared_ptr<Shared_Mesh> Mesh_Asset_Cache::getCube()
+{
+    if (!cube) {
+        cube = make_shared<Shared_Mesh>();
+        cube->upload(createCubeData());
+    }
+    return cube;
+}
+
+/**
+ * Upload the meshes whose files have been parsed by the worker threads.
+ * Must be called on the thread that owns the GL context.
+ */
+void Mesh_Asset_Cache::update()
+{
+    for (auto pending = pendingUploads.begin(); pending != pendingUploads.end(); )
+    {
+        if (pending->data.wait_for(chrono::seconds(0)) != future_status::ready) {
+            ++pending;
+            continue;
+        }
+
+        Shared_Mesh::Vertex_Data data = pending->data.get();
+        if (data.indices.empty()) {
+            std::cerr << "Error: Cannot load the model " << pending->path << std::endl;
+
+            // Forget the empty mesh so that the next get() of the path tries again
+            auto entry = meshes.find(pending->path);
+            if (entry != meshes.end() && entry->second.lock() == pending->mesh.lock()) {
+                meshes.erase(entry);
+            }
+        }
+        else if (auto mesh = pending->mesh.lock()) {
+            mesh->upload(data);
+        }
+
+        pending = pendingUploads.erase(pending);
+    }
+}
+
+/**
+ * Wait for every pending load and upload the results.
+ */
+void Mesh_Asset_Cache::finishLoading()
+{
+    for (auto& pending : pendingUploads) {
+        pending.data.wait();
+    }
+    update();
+}
+
+/**
+ * Parse an OBJ file into indexed vertex arrays. Runs on a worker thread, so it must not touch OpenGL.
+ * Corners that share both position and normal become a single vertex; corners without a normal get
+ * the normal of their face.
+ * @param path Path of the OBJ file.
+ * @return The vertex data, with no indices if the file cannot be read.
+ */
+Shared_Mesh::Vertex_Data Mesh_Asset_Cache::loadVertexData(const std::string& path)
+{
+    Shared_Mesh::Vertex_Data data;
+    Obj_Mesh_Data mesh;
+    std::string error;
+
+    if (!Obj_Loader::load(path, mesh, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return data;
+    }
+
+    unordered_map< uint64_t, GLuint > vertexIndices;
+    data.indices.reserve(mesh.positionIndices.size());
+
+    for (size_t triangle = 0; triangle < mesh.triangleCount(); ++triangle)
+    {
+        const int* positions = &mesh.positionIndices[triangle * 3];
+        const int* normals = &mesh.normalIndices[triangle * 3];
+
+        glm::vec3 faceNormal = glm::cross(
+            mesh.positions[positions[1]] - mesh.positions[positions[0]],
+            mesh.positions[positions[2]] - mesh.positions[positions[0]]);
+        if (glm::length(faceNormal) > 0.f) {
+            faceNormal = glm::normalize(faceNormal);
+        }
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            // Corners without a normal are never shared, since they take the normal of their own face
+            uint64_t key = normals[corner] >= 0
+                ? (uint64_t(uint32_t(positions[corner])) << 32) | uint32_t(normals[corner])
+                : ~uint64_t(triangle * 3 + corner);
+
+            auto found = vertexIndices.find(key);
+            if (found != vertexIndices.end()) {
+                data.indices.push_back(found->second);
+                continue;
+            }
+
+            const glm::vec3& position = mesh.positions[positions[corner]];
+            const glm::vec3& normal = normals[corner] >= 0 ? mesh.normals[normals[corner]] : faceNormal;
+
+            GLuint index = GLuint(data.coordinates.size() / 3);
+            data.coordinates.insert(data.coordinates.end(), { position.x, position.y, position.z });
+            data.normals.insert(data.normals.end(), { normal.x, normal.y, normal.z });
+            data.indices.push_back(index);
+            vertexIndices.emplace(key, index);
+        }
+    }
+
+    return data;
+}
+
+/**
+ * Build the vertex data of the cube: four vertices per face so that every face has flat normals.
+ * @return The vertex data.
+ */
+Shared_Mesh::Vertex_Data Mesh_Asset_Cache::createCubeData()
+{
+    Shared_Mesh::Vertex_Data data;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (float side : { -1.f, 1.f })
+        {
+            glm::vec3 normal(0.f);
+            normal[axis] = side;
+
+            // Two axes spanning the face, ordered so that the triangles wind counter-clockwise seen from outside
+            glm::vec3 u(0.f), v(0.f);
+            u[(axis + 1) % 3] = 1.f;
+            v[(axis + 2) % 3] = side;
+
+            GLuint first = GLuint(data.coordinates.size() / 3);
+            for (const glm::vec2& corner : { glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(1, 1), glm::vec2(-1, 1) })
+            {
+                glm::vec3 position = normal + u * corner.x + v * corner.y;
+                data.coordinates.insert(data.coordinates.end(), { position.x, position.y, position.z });
+                data.normals.insert(data.normals.end(), { normal.x, normal.y, normal.z });
+            }
+
+            data.indices.insert(data.indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+        }
+    }
+
+    return data;
+}
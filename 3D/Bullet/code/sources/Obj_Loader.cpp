@@ -0,0 +1,124 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Obj_Loader.h"
+
+using namespace std;
+
+namespace
+{
+    /**
+     * Converts an OBJ index (1-based, or negative relative to the end) into a 0-based index.
+     * @return The index, or -1 if it is out of range.
+     */
+    int resolveIndex(long index, size_t count)
+    {
+        long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+        return (resolved >= 0 && resolved < static_cast<long>(count)) ? static_cast<int>(resolved) : -1;
+    }
+}
+
+/**
+ * Parse an OBJ file into positions, normals and triangle index lists.
+ * Texture coordinates, materials and groups are ignored.
+ * @param path Path of the OBJ file.
+ * @param data Receives the geometry.
+ * @param error Receives a description of the problem on failure.
+ * @return True on success.
+ */
+bool Obj_Loader::load(const std::string& path, Obj_Mesh_Data& data, std::string& error)
+{
+    data = Obj_Mesh_Data();
+
+    ifstream file(path);
+    if (!file) {
+        error = "Cannot open " + path;
+        return false;
+    }
+
+    string line;
+    vector< int > facePositions;
+    vector< int > faceNormals;
+
+    while (getline(file, line))
+    {
+        istringstream tokens(line);
+        string keyword;
+        tokens >> keyword;
+
+        if (keyword == "v")
+        {
+            glm::vec3 position;
+            tokens >> position.x >> position.y >> position.z;
+            data.positions.push_back(position);
+        }
+        else if (keyword == "vn")
+        {
+            glm::vec3 normal;
+            tokens >> normal.x >> normal.y >> normal.z;
+            data.normals.push_back(normal);
+        }
+        else if (keyword == "f")
+        {
+            facePositions.clear();
+            faceNormals.clear();
+
+            // Each corner is "v", "v/vt", "v//vn" or "v/vt/vn"
+            string corner;
+            while (tokens >> corner)
+            {
+                const char* text = corner.c_str();
+                char* end = nullptr;
+
+                int position = resolveIndex(strtol(text, &end, 10), data.positions.size());
+                int normal = -1;
+
+                if (*end == '/')
+                {
+                    const char* normalText = strchr(end + 1, '/');
+                    if (normalText)
+                        normal = resolveIndex(strtol(normalText + 1, nullptr, 10), data.normals.size());
+                }
+
+                if (position < 0) {
+                    error = "Invalid face in " + path + ": " + line;
+                    data = Obj_Mesh_Data();
+                    return false;
+                }
+
+                facePositions.push_back(position);
+                faceNormals.push_back(normal);
+            }
+
+            // Fan-triangulate polygons around their first corner
+            for (size_t i = 2; i < facePositions.size(); ++i)
+            {
+                data.positionIndices.push_back(facePositions[0]);
+                data.positionIndices.push_back(facePositions[i - 1]);
+                data.positionIndices.push_back(facePositions[i]);
+                data.normalIndices.push_back(faceNormals[0]);
+                data.normalIndices.push_back(faceNormals[i - 1]);
+                data.normalIndices.push_back(faceNormals[i]);
+            }
+        }
+    }
+
+    if (data.positionIndices.empty()) {
+        error = "No faces found in " + path;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,384 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <cmath>
+#include <algorithm>
+
+#include "Occlusion_Culler.h"
+
+#if OCCLUSION_CULLER_ENABLE_CHECK
+    #include <iostream>
+    #include <glm/gtc/matrix_transform.hpp>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OCCLUSION_USE_SSE 1
+    #include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    /// Clip space w below which a point is considered to be on or behind the camera.
+    const float NEAR_W = 1e-3f;
+
+    /// Corners of each face of a box, indexed as bit 0 = x, bit 1 = y, bit 2 = z of the maximum corner.
+    const int BOX_FACES[6][4] =
+    {
+        { 0, 2, 6, 4 }, { 1, 5, 7, 3 },                // -x, +x
+        { 0, 4, 5, 1 }, { 2, 3, 7, 6 },                // -y, +y
+        { 0, 1, 3, 2 }, { 4, 6, 7, 5 },                // -z, +z
+    };
+
+    /// Face of a box on the other side of the edge between its corners u and v, numbered like BOX_FACES.
+    inline int adjacentFace(int face, int u, int v)
+    {
+        int sharedAxes = 7 & ~(u ^ v) & ~(1 << (face >> 1));
+        int axis = sharedAxes == 1 ? 0 : sharedAxes == 2 ? 1 : 2;
+        return 2 * axis + ((u >> axis) & 1);
+    }
+
+    /// Twice the signed area of the triangle a, b, p: positive when p is to the left of a->b.
+    inline float edge(const glm::vec3& a, const glm::vec3& b, float px, float py)
+    {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    }
+}
+
+/**
+ * Create a culler with a depth buffer of the given resolution.
+ * @param width Width in pixels, rounded up to a multiple of 4.
+ * @param height Height in pixels.
+ */
+Occlusion_Culler::Occlusion_Culler(int width, int height)
+    : width((max(width, 4) + 3) & ~3), height(max(height, 1)), viewProjection(1.f), eye(0.f)
+{
+    depthBuffer.assign(size_t(this->width) * this->height, 1.f);
+}
+
+/**
+ * Clear the depth buffer and the statistics.
+ * @param viewProjection Product of the projection and view matrices of the camera.
+ */
+void Occlusion_Culler::beginFrame(const glm::mat4& viewProjection)
+{
+    this->viewProjection = viewProjection;
+
+    // The camera is the point projected to x = y = w = 0, at infinity for an orthographic projection
+    eye = glm::inverse(viewProjection) * glm::vec4(0.f, 0.f, 1.f, 0.f);
+    eye = std::fabs(eye.w) > 1e-6f * glm::length(glm::vec3(eye)) ? eye / eye.w : glm::vec4(0.f);
+
+    fill(depthBuffer.begin(), depthBuffer.end(), 1.f);
+    statistics = Statistics();
+}
+
+/**
+ * Project the corners of a box to the depth buffer: x and y in pixels, z as depth in [0, 1].
+ * @return False if a corner is on or behind the camera plane.
+ */
+bool Occlusion_Culler::projectCorners(const glm::mat4& transformation, const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3 corners[8]) const
+{
+    glm::mat4 toClip = viewProjection * transformation;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec4 corner((i & 1) ? boxMax.x : boxMin.x, (i & 2) ? boxMax.y : boxMin.y, (i & 4) ? boxMax.z : boxMin.z, 1.f);
+        glm::vec4 clip = toClip * corner;
+        if (clip.w < NEAR_W) {
+            return false;
+        }
+
+        float inverseW = 1.f / clip.w;
+        corners[i] = glm::vec3(
+            (clip.x * inverseW * 0.5f + 0.5f) * width,
+            (clip.y * inverseW * 0.5f + 0.5f) * height,
+            clip.z * inverseW * 0.5f + 0.5f);
+    }
+    return true;
+}
+
+/**
+ * Rasterize the faces of a box into the depth buffer.
+ * Boxes crossing the camera plane are skipped rather than clipped, which only makes the culling less aggressive.
+ * @param transformation Transformation from the box space to world space.
+ * @param boxMin Minimum corner of the box.
+ * @param boxMax Maximum corner of the box.
+ */
+void Occlusion_Culler::addOccluder(const glm::mat4& transformation, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    glm::vec3 corners[8];
+    if (!projectCorners(transformation, boxMin, boxMax, corners)) {
+        return;
+    }
+
+    // Only the faces the camera is in front of are drawn, and the edges they share with the other faces are the
+    // outline of the box. Without the camera position every face is drawn and every edge is part of the outline
+    bool perspective = eye.w != 0.f;
+    bool seen[6];
+    if (perspective)
+    {
+        glm::vec3 localEye(glm::inverse(transformation) * eye);
+        for (int axis = 0; axis < 3; ++axis) {
+            seen[2 * axis]     = localEye[axis] < boxMin[axis];
+            seen[2 * axis + 1] = localEye[axis] > boxMax[axis];
+        }
+    }
+
+    ++statistics.occluders;
+    for (int face = 0; face < 6; ++face)
+    {
+        if (perspective && !seen[face]) {
+            continue;
+        }
+
+        const int* quad = BOX_FACES[face];
+        int outlineEdges = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (!perspective || !seen[adjacentFace(face, quad[i], quad[(i + 1) & 3])]) {
+                outlineEdges |= 1 << i;
+            }
+        }
+
+        // The diagonal splitting the face is never part of the outline
+        rasterizeTriangle(corners[quad[0]], corners[quad[1]], corners[quad[2]], outlineEdges & 3);
+        rasterizeTriangle(corners[quad[0]], corners[quad[2]], corners[quad[3]], (outlineEdges >> 1) & 6);
+    }
+}
+
+/**
+ * Write the farthest depth of a triangle over each pixel into the pixels it covers.
+ * Along the edges of the outline only the pixels entirely inside the triangle are covered, so that nothing seen
+ * through a pixel at the border of an occluder is hidden. Along the other edges, shared with another triangle of
+ * the occluder, the pixels whose centers are inside are covered, which leaves no gap between the two.
+ * Both windings are accepted.
+ * @param a First vertex in depth buffer space.
+ * @param b Second vertex.
+ * @param c Third vertex.
+ * @param outlineEdges Edges on the outline of the occluder: bit 0 for ab, bit 1 for bc, bit 2 for ca.
+ */
+void Occlusion_Culler::rasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, int outlineEdges)
+{
+    float area = edge(a, b, c.x, c.y);
+    if (std::fabs(area) < 1e-6f) {
+        return;
+    }
+    if (area < 0) {
+        swap(b, c);
+        outlineEdges = (outlineEdges & 2) | ((outlineEdges & 1) << 2) | ((outlineEdges & 4) >> 2);   // ab and ca trade places
+        area = -area;
+    }
+
+    int minX = max(int(std::floor(min(a.x, min(b.x, c.x)))), 0);
+    int maxX = min(int(std::ceil (max(a.x, max(b.x, c.x)))), width - 1);
+    int minY = max(int(std::floor(min(a.y, min(b.y, c.y)))), 0);
+    int maxY = min(int(std::ceil (max(a.y, max(b.y, c.y)))), height - 1);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    ++statistics.triangles;
+
+    // Edge functions and depth are linear in x and y, so they are evaluated at one pixel and stepped
+    float stepX0 = -(c.y - b.y), stepX1 = -(a.y - c.y), stepX2 = -(b.y - a.y);
+    float stepY0 = c.x - b.x, stepY1 = a.x - c.x, stepY2 = b.x - a.x;
+    float inverseArea = 1.f / area;
+    float depthStepX = (stepX0 * a.z + stepX1 * b.z + stepX2 * c.z) * inverseArea;
+    float depthStepY = (stepY0 * a.z + stepY1 * b.z + stepY2 * c.z) * inverseArea;
+
+    // Evaluating at the worst corner of the pixel instead of its center: the outline edges test the whole pixel
+    // and the depth is the farthest one over the pixel
+    float inset0 = (outlineEdges & 2) ? 0.5f * (std::fabs(stepX0) + std::fabs(stepY0)) : 0.f;
+    float inset1 = (outlineEdges & 4) ? 0.5f * (std::fabs(stepX1) + std::fabs(stepY1)) : 0.f;
+    float inset2 = (outlineEdges & 1) ? 0.5f * (std::fabs(stepX2) + std::fabs(stepY2)) : 0.f;
+    float depthOffset = 0.5f * (std::fabs(depthStepX) + std::fabs(depthStepY));
+
+    // Rows are processed in groups of four pixels starting at a multiple of 4, which stays inside the row
+    int startX = minX & ~3;
+    float px = startX + 0.5f;
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py = y + 0.5f;
+        float w0 = edge(b, c, px, py);
+        float w1 = edge(c, a, px, py);
+        float w2 = edge(a, b, px, py);
+        float depth = (w0 * a.z + w1 * b.z + w2 * c.z) * inverseArea + depthOffset;
+        w0 -= inset0;
+        w1 -= inset1;
+        w2 -= inset2;
+        float* row = &depthBuffer[size_t(y) * width];
+
+#ifdef OCCLUSION_USE_SSE
+        const __m128 lanes = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+        __m128 edge0 = _mm_add_ps(_mm_set1_ps(w0), _mm_mul_ps(lanes, _mm_set1_ps(stepX0)));
+        __m128 edge1 = _mm_add_ps(_mm_set1_ps(w1), _mm_mul_ps(lanes, _mm_set1_ps(stepX1)));
+        __m128 edge2 = _mm_add_ps(_mm_set1_ps(w2), _mm_mul_ps(lanes, _mm_set1_ps(stepX2)));
+        __m128 depths = _mm_add_ps(_mm_set1_ps(depth), _mm_mul_ps(lanes, _mm_set1_ps(depthStepX)));
+        const __m128 edge0Step = _mm_set1_ps(stepX0 * 4), edge1Step = _mm_set1_ps(stepX1 * 4), edge2Step = _mm_set1_ps(stepX2 * 4);
+        const __m128 depthStep = _mm_set1_ps(depthStepX * 4);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (int x = startX; x <= maxX; x += 4)
+        {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+            if (_mm_movemask_ps(inside))
+            {
+                __m128 stored = _mm_loadu_ps(row + x);
+                __m128 nearest = _mm_min_ps(stored, depths);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+            }
+            edge0 = _mm_add_ps(edge0, edge0Step);
+            edge1 = _mm_add_ps(edge1, edge1Step);
+            edge2 = _mm_add_ps(edge2, edge2Step);
+            depths = _mm_add_ps(depths, depthStep);
+        }
+#else
+        for (int x = startX; x <= maxX; ++x)
+        {
+            if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
+                row[x] = min(row[x], depth);
+            }
+            w0 += stepX0;
+            w1 += stepX1;
+            w2 += stepX2;
+            depth += depthStepX;
+        }
+#endif
+    }
+}
+
+/**
+ * Test a world-space box against the depth buffer.
+ * @param boxMin Minimum corner of the box.
+ * @param boxMax Maximum corner of the box.
+ * @return False only if every pixel the box can cover already holds a nearer occluder.
+ */
+bool Occlusion_Culler::isVisible(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    ++statistics.tested;
+
+    glm::vec3 corners[8];
+    if (!projectCorners(glm::mat4(1.f), boxMin, boxMax, corners)) {
+        ++statistics.visible;
+        return true;
+    }
+
+    glm::vec3 screenMin = corners[0], screenMax = corners[0];
+    for (int i = 1; i < 8; ++i) {
+        screenMin = glm::min(screenMin, corners[i]);
+        screenMax = glm::max(screenMax, corners[i]);
+    }
+
+    int minX = max(int(std::floor(screenMin.x)), 0);
+    int maxX = min(int(std::ceil (screenMax.x)), width - 1);
+    int minY = max(int(std::floor(screenMin.y)), 0);
+    int maxY = min(int(std::ceil (screenMax.y)), height - 1);
+    float nearest = screenMin.z;
+
+    bool visible = minX > maxX || minY > maxY;          // Outside the buffer: left to the frustum test
+
+    for (int y = minY; y <= maxY && !visible; ++y)
+    {
+        const float* row = &depthBuffer[size_t(y) * width];
+        int x = minX;
+
+#ifdef OCCLUSION_USE_SSE
+        const __m128 objectDepth = _mm_set1_ps(nearest);
+        for (; x + 3 <= maxX; x += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmple_ps(objectDepth, _mm_loadu_ps(row + x)))) {
+                visible = true;
+                break;
+            }
+        }
+#endif
+        for (; x <= maxX && !visible; ++x) {
+            visible = nearest <= row[x];
+        }
+    }
+
+    ++(visible ? statistics.visible : statistics.occluded);
+    return visible;
+}
+
+#if OCCLUSION_CULLER_ENABLE_CHECK
+
+/**
+ * Slide small boxes behind a wall facing the camera and behind a block turned by 40 degrees, with a corner toward the
+ * camera, across their left and right edges and across the top and bottom edges of the wall. Count the boxes hidden
+ * while part of them is outside the occluder on screen, and the boxes at least two pixels inside it that are not
+ * hidden.
+ * @return The number of wrong results.
+ */
+int Occlusion_Culler::check()
+{
+    const glm::mat4 VIEW_PROJECTION = glm::perspective(glm::radians(60.f), 2.f, 0.5f, 100.f);     // Camera at the origin looking down -z
+    const glm::vec3 OBJECT_HALF_EXTENTS(0.25f, 0.25f, 0.25f);
+    const float OBJECT_DEPTH = -20.f;
+    const float MARGIN = 2.f;                                                                       // Pixels
+    const glm::mat4 OCCLUDERS[] =
+    {
+        glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, -10.f)),
+        glm::rotate(glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, -10.f)), glm::radians(40.f), glm::vec3(0.f, 1.f, 0.f)),
+    };
+    const glm::vec3 OCCLUDER_HALF_EXTENTS[] = { glm::vec3(2.f, 3.f, 0.1f), glm::vec3(2.f, 3.f, 2.f) };
+
+    Occlusion_Culler culler;
+    size_t tested = 0, hiddenInSight = 0, insideWall = 0, shownInsideWall = 0;
+
+    auto screenRectangle = [&culler](const glm::mat4& transformation, const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3& screenMin, glm::vec3& screenMax)
+    {
+        glm::vec3 corners[8];
+        culler.projectCorners(transformation, boxMin, boxMax, corners);
+        screenMin = screenMax = corners[0];
+        for (const auto& corner : corners) {
+            screenMin = glm::min(screenMin, corner);
+            screenMax = glm::max(screenMax, corner);
+        }
+    };
+
+    for (int sweep = 0; sweep < 3; ++sweep)
+    {
+        int occluder = sweep == 1 ? 1 : 0;
+        int axis = sweep == 2 ? 1 : 0;                  // The vertical edges of both occluders, then the horizontal ones of the wall
+        const glm::vec3& halfExtents = OCCLUDER_HALF_EXTENTS[occluder];
+
+        culler.beginFrame(VIEW_PROJECTION);
+        culler.addOccluder(OCCLUDERS[occluder], -halfExtents, halfExtents);
+        glm::vec3 occluderMin, occluderMax;
+        screenRectangle(OCCLUDERS[occluder], -halfExtents, halfExtents, occluderMin, occluderMax);
+
+        for (float offset = -8.f; offset <= 8.f; offset += 0.002f)
+        {
+            glm::vec3 center(0.f, 0.f, OBJECT_DEPTH);
+            center[axis] = offset;
+            glm::vec3 objectMin = center - OBJECT_HALF_EXTENTS, objectMax = center + OBJECT_HALF_EXTENTS;
+            glm::vec3 screenMin, screenMax;
+            screenRectangle(glm::mat4(1.f), objectMin, objectMax, screenMin, screenMax);
+
+            // The swept edges are straight lines on screen along the other axis, which the boxes stay inside of
+            bool inSight = screenMin[axis] < occluderMin[axis] || screenMax[axis] > occluderMax[axis];
+            bool inside = screenMin[axis] >= occluderMin[axis] + MARGIN && screenMax[axis] <= occluderMax[axis] - MARGIN;
+            bool visible = culler.isVisible(objectMin, objectMax);
+
+            ++tested;
+            hiddenInSight += inSight && !visible;
+            insideWall += inside;
+            shownInsideWall += inside && visible;
+        }
+    }
+
+    std::cout << "Occlusion_Culler check: " << tested << " boxes, " << hiddenInSight << " hidden while partly in sight, "
+        << shownInsideWall << " of " << insideWall << " not hidden " << MARGIN << " pixels inside an occluder" << std::endl;
+    return int(hiddenInSight + shownInsideWall);
+}
+
+#endif
@@ -8,11 +8,25 @@
 *
 **********************************************************************/
 
+#include <iostream>
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+#include <BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h>
+#include <BulletDynamics/Featherstone/btMultiBodyLinkCollider.h>
 #include "Physics_3D_System.h"
 #include "Physics_Component.h"
 #include "Entity.h"
+#include "Debug_Drawer.h"
+
+#if !defined(BT_USE_DOUBLE_PRECISION) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+    #define TRANSFORM_EXPORT_USE_SSE 1
+    #include <xmmintrin.h>
+#endif
+
+#if TRANSFORM_EXPORT_ENABLE_BENCHMARK
+    #include <chrono>
+#endif
 
 using namespace std;
 using namespace glt;
@@ -20,25 +34,69 @@ using namespace glt;
 const float GRAVITY = -10.0f;
 const float LINEAR_SLOP = 0.01f;
 const float RESTITUTION = 0.0f;
+const float ISLAND_RESIDUAL = 1e-5f;
+const int   MAX_ISLAND_ITERATIONS = 40;
+const int   SOLVER_SUBSTEPS = 4;
+const int   SUBSTEP_ITERATIONS = 2;
+
+namespace
+{
+    /**
+     * Setup of the collision configuration: the pools of pairs and manifolds add slabs as the scene fills up,
+     * instead of allocating every element past their size on its own.
+     */
+    btDefaultCollisionConstructionInfo collisionConstructionInfo()
+    {
+        btDefaultCollisionConstructionInfo info;
+        info.m_growablePools = true;
+        return info;
+    }
+}
 
 /**
  * Constructor for the 3D Physics System.
  * Initializes the physics world and sets up basic simulation parameters.
+ * @param articulated True to create a multibody world, where vehicles can be built as one btMultiBody.
  */
-Physics_3D_System::Physics_3D_System() : collisionDispatcher(&collisionConfiguration)
+Physics_3D_System::Physics_3D_System(bool articulated) :
+    collisionConfiguration(collisionConstructionInfo()),
+    collisionDispatcher(&collisionConfiguration),
+    constraintSolver(SOLVER_SUBSTEPS, SUBSTEP_ITERATIONS),
+    multiBodyWorld(nullptr)
 {
     // Create the dynamics world for physics simulation
-    dynamicsWorld = std::make_unique<btDiscreteDynamicsWorld>(
-        &collisionDispatcher,
-        &overlappingPairCache,
-        &constraintSolver,
-        &collisionConfiguration
-    );
+    if (articulated) {
+        auto world = std::make_unique<btMultiBodyDynamicsWorld>(
+            &collisionDispatcher,
+            &overlappingPairCache,
+            &multiBodySolver,
+            &collisionConfiguration
+        );
+        multiBodyWorld = world.get();
+        dynamicsWorld = std::move(world);
+    }
+    else {
+        dynamicsWorld = std::make_unique<btDiscreteDynamicsWorld>(
+            &collisionDispatcher,
+            &overlappingPairCache,
+            &constraintSolver,
+            &collisionConfiguration
+        );
+    }
 
     // Configure gravity and solver parameters
     dynamicsWorld->setGravity(btVector3(0, GRAVITY, 0));  // Set gravity in Y-axis
     dynamicsWorld->getSolverInfo().m_linearSlop = LINEAR_SLOP;  // Linear precision in simulation
     dynamicsWorld->getSolverInfo().m_restitution = RESTITUTION;  // Restitution coefficient for physics
+    dynamicsWorld->getSolverInfo().m_solverMode |= SOLVER_BATCHED_ROWS;  // Contact rows 8 at a time where the CPU has AVX2
+
+    // Resting props stop iterating early and lend their iterations to the stacks and vehicles
+    dynamicsWorld->getSolverInfo().m_solverMode |= SOLVER_ADAPTIVE_ISLAND_ITERATIONS;
+    dynamicsWorld->getSolverInfo().m_leastSquaresResidualThreshold = ISLAND_RESIDUAL;
+    dynamicsWorld->getSolverInfo().m_maxIslandIterations = MAX_ISLAND_ITERATIONS;
+
+    // Damp and move the bodies four at a time with SSE; fast projectiles are left to the CCD sweeps, which run over the task scheduler
+    dynamicsWorld->setUseBodyIntegrator(true);
 }
 
 
@@ -64,11 +122,21 @@ Physics_3D_System::~Physics_3D_System()
         dynamicsWorld->removeRigidBody(rigidBody.get());
     }
 
+    // Remove the multibodies and the colliders of their links
+    for (auto& linkCollider : linkColliders) {
+        dynamicsWorld->removeCollisionObject(linkCollider.get());
+    }
+    for (auto& multiBody : multiBodies) {
+        multiBodyWorld->removeMultiBody(multiBody.get());
+    }
+
     // Clear the collision shapes, motion states, and rigid bodies
     collisionShapes.clear();
     motionStates.clear();
     rigidBodies.clear();
     collisionObjects.clear();
+    linkColliders.clear();
+    multiBodies.clear();
 }
 
 /**
@@ -88,42 +156,13 @@ void Physics_3D_System::stepSimulation(float timeStep) {
 void Physics_3D_System::add_Component(Entity& entity, 
     const btVector3& origin, const btVector3& shapeSize, btScalar mass)
 {
-    auto collisionShape = std::make_shared<btBoxShape>(shapeSize);
-
-    btTransform transform;
-    transform.setIdentity();
-    transform.setOrigin(origin);
-
-    btVector3 localInertia(0, 0, 0);
-    if (mass != 0.f)
-        collisionShape->calculateLocalInertia(mass, localInertia);
-
-    auto motionState = std::make_shared<btDefaultMotionState>(transform);
-    btRigidBody::btRigidBodyConstructionInfo info(mass, motionState.get(), collisionShape.get(), localInertia);
-    auto rigidBody = std::make_shared<btRigidBody>(info);
-
-    dynamicsWorld->addRigidBody(rigidBody.get());
-
-    auto physicsComponent = std::make_shared<Physics_Component>(collisionShape,motionState, rigidBody);
-    entity.addPhysicsComponent(physicsComponent);
-
-    rigidBodies    .push_back (rigidBody);
-    motionStates   .push_back (motionState);
-    collisionShapes.push_back (collisionShape);
+    addRigidBody(entity, std::make_shared<btBoxShape>(shapeSize), origin, mass);
 }
 void Physics_3D_System::add_ComponentSensor(Entity& entity,
     const btVector3& origin, const btVector3& shapeSize, btScalar mass)
 {
     Physics_3D_System::add_Component(entity,origin,shapeSize,mass);
-
-    // Create and add sensor object
-    auto sensor = std::make_shared<btGhostObject>();
-    sensor->setCollisionShape(entity.getBody()->getCollisionShape());
-    sensor->setWorldTransform(entity.getBody()->getWorldTransform());
-    sensor->setCollisionFlags(sensor->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
-    dynamicsWorld->addCollisionObject(sensor.get());
-
-    sensorObjects.push_back(sensor);
+    addSensor(entity);
 }
 /**
  * Add a collision component to the entity.
@@ -146,43 +185,116 @@ void Physics_3D_System::add_ComponentCollision(Entity& entity,
 
 /**
  * Add a sphere component to the entity.
+ * The radius is taken from the hull of the rendered sphere model, so it matches what is drawn.
  * @param entity The entity to add the physics component to.
  * @param origin The initial position of the sphere.
- * @param shapeSize The size of the sphere (currently unused).
+ * @param shapeSize The scale of the rendered sphere model.
  * @param mass The mass of the sphere.
  */
 void Physics_3D_System::add_ComponentSphere(Entity& entity,
     const btVector3& origin, const btVector3& shapeSize, btScalar mass)
 {
-    // Create the collision shape for the projectile (in this case, a sphere)
-    btScalar radius = 0.1f;
-    auto collisionShape = std::make_shared<btSphereShape>(radius);
+    btScalar radius = shapeCache.getBoundingRadius("../../assets/sphere.obj") * shapeSize.getX();
+    if (radius <= 0.f)
+        radius = 0.1f;
 
-    // Create the rigid body for the projectile
-    btTransform startTransform;
-    startTransform.setIdentity();
-    startTransform.setOrigin(origin);
+    addRigidBody(entity, std::make_shared<btSphereShape>(radius), origin, mass);
+}
 
-    // Calculate the local inertia (projectiles are immune to rotation)
-    btVector3 localInertia(0, 0, 0);
-    collisionShape->calculateLocalInertia(mass, localInertia);
+/**
+ * Add a sphere component with continuous collision to the entity, for projectiles.
+ * Whenever the sphere moves further than its radius in a step, the world sweeps it along its motion,
+ * so it stops at the first wall in its way instead of passing through it.
+ * @param entity The entity to add the physics component to.
+ * @param origin The initial position of the projectile.
+ * @param shapeSize The scale of the rendered sphere model.
+ * @param mass The mass of the projectile.
+ */
+void Physics_3D_System::add_ComponentProjectile(Entity& entity,
+    const btVector3& origin, const btVector3& shapeSize, btScalar mass)
+{
+    add_ComponentSphere(entity, origin, shapeSize, mass);
 
-    // Create the motion state and rigid body for the projectile
-    auto motionState = std::make_shared<btDefaultMotionState>(startTransform);
-    btRigidBody::btRigidBodyConstructionInfo info(mass, motionState.get(), collisionShape.get(), localInertia);
-    auto rigidBody = std::make_shared<btRigidBody>(info);
+    btRigidBody* body = entity.getBody();
+    btScalar radius = static_cast<btSphereShape*>(body->getCollisionShape())->getRadius();
+    body->setCcdMotionThreshold(radius);
+    body->setCcdSweptSphereRadius(radius);
+}
 
-    // Add the rigid body to the dynamics world
-    dynamicsWorld->addRigidBody(rigidBody.get());
+/**
+ * Add a convex hull component built from a model file to the entity.
+ * @param entity The entity to add the physics component to.
+ * @param origin The initial position of the object.
+ * @param modelPath The OBJ file whose hull is used as the collision shape.
+ * @param scale The scale of the model.
+ * @param mass The mass of the object.
+ */
+void Physics_3D_System::add_ComponentHull(Entity& entity,
+    const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass)
+{
+    std::shared_ptr<btCollisionShape> collisionShape = shapeCache.getConvexHull(modelPath, scale);
+    if (!collisionShape) {
+        // Fall back to the model's nominal bounds so the entity still collides
+        collisionShape = std::make_shared<btBoxShape>(scale);
+    }
 
-    // Create and add the physics component to the entity
-    auto physicsComponent = std::make_shared<Physics_Component>(collisionShape, motionState, rigidBody);
-    entity.addPhysicsComponent(physicsComponent);
+    addRigidBody(entity, collisionShape, origin, mass);
+}
 
-    // Add the rigid body, motion state, and collision shape to the internal lists
-    rigidBodies.push_back(rigidBody);
-    motionStates.push_back(motionState);
-    collisionShapes.push_back(collisionShape);
+/**
+ * Add a convex hull component built from a model file to the entity, plus a sensor object sharing its shape.
+ * @param entity The entity to add the physics component to.
+ * @param origin The initial position of the object.
+ * @param modelPath The OBJ file whose hull is used as the collision shape.
+ * @param scale The scale of the model.
+ * @param mass The mass of the object.
+ */
+void Physics_3D_System::add_ComponentHullSensor(Entity& entity,
+    const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass)
+{
+    add_ComponentHull(entity, origin, modelPath, scale, mass);
+    addSensor(entity);
+}
+/**
+ * Add a concave model to the entity as a compound of convex hulls, so it collides through the
+ * convex-convex algorithms instead of a triangle mesh shape.
+ * @param entity The entity to add the physics component to.
+ * @param origin The initial position of the object.
+ * @param modelPath The OBJ file to decompose.
+ * @param scale The scale of the model.
+ * @param mass The mass of the object.
+ * @param maxHulls Maximum number of convex pieces.
+ * @param maxVolumeError Accepted excess of the pieces' volume over the model volume (0.1 is 10%).
+ */
+void Physics_3D_System::add_ComponentDecomposed(Entity& entity,
+    const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass,
+    int maxHulls, btScalar maxVolumeError)
+{
+    std::shared_ptr<btCollisionShape> collisionShape = shapeCache.getConvexDecomposition(modelPath, scale, maxHulls, maxVolumeError);
+    if (!collisionShape) {
+        // Fall back to the model's nominal bounds so the entity still collides
+        collisionShape = std::make_shared<btBoxShape>(scale);
+    }
+
+    addRigidBody(entity, collisionShape, origin, mass);
+}
+
+/**
+ * Add a concave model to the entity as a compound of convex hulls, plus a sensor object sharing its shape.
+ * @param entity The entity to add the physics component to.
+ * @param origin The initial position of the object.
+ * @param modelPath The OBJ file to decompose.
+ * @param scale The scale of the model.
+ * @param mass The mass of the object.
+ * @param maxHulls Maximum number of convex pieces.
+ * @param maxVolumeError Accepted excess of the pieces' volume over the model volume (0.1 is 10%).
+ */
+void Physics_3D_System::add_ComponentDecomposedSensor(Entity& entity,
+    const btVector3& origin, const std::string& modelPath, const btVector3& scale, btScalar mass,
+    int maxHulls, btScalar maxVolumeError)
+{
+    add_ComponentDecomposed(entity, origin, modelPath, scale, mass, maxHulls, maxVolumeError);
+    addSensor(entity);
 }
 /**
  * Add a rigid body component to the entity and return the rigid body.
@@ -202,6 +314,113 @@ std::shared_ptr<btRigidBody> Physics_3D_System::add_ComponentAndReturnRigidBody(
     // Returns the pointer to the rigidbody
     return rigidBody;
 }
+/**
+ * Start a btMultiBody with a box as its base, and attach the base to the entity.
+ * The links must be set up with add_MultiBodyRevoluteLink() or add_MultiBodyFixedLink() and the body
+ * added with finalize_MultiBody() before the next step.
+ * @param entity The entity to add the physics component of the base to.
+ * @param origin The initial position of the base.
+ * @param shapeSize The size of the collision shape of the base.
+ * @param mass The mass of the base (0 for a fixed base).
+ * @param numLinks The number of links, not counting the base.
+ * @return The multibody, or nullptr when the world is not articulated.
+ */
+std::shared_ptr<btMultiBody> Physics_3D_System::add_MultiBody(Entity& entity,
+    const btVector3& origin, const btVector3& shapeSize, btScalar mass, int numLinks)
+{
+    if (!multiBodyWorld) {
+        std::cerr << "Error: Multibodies need an articulated physics system." << std::endl;
+        return nullptr;
+    }
+
+    auto collisionShape = std::make_shared<btBoxShape>(shapeSize);
+
+    btVector3 localInertia(0, 0, 0);
+    if (mass != 0.f)
+        collisionShape->calculateLocalInertia(mass, localInertia);
+
+    auto multiBody = std::make_shared<btMultiBody>(numLinks, mass, localInertia, mass == 0.f, false);
+    multiBody->setBaseWorldTransform(btTransform(btQuaternion::getIdentity(), origin));
+
+    // Undamped, like the rigid bodies, and the links of the body do not collide with each other
+    multiBody->setLinearDamping(0.f);
+    multiBody->setAngularDamping(0.f);
+    multiBody->setHasSelfCollision(false);
+
+    addLinkCollider(entity, *multiBody, -1, collisionShape);
+
+    multiBodies.push_back(multiBody);
+    return multiBody;
+}
+
+/**
+ * Set up a link of a btMultiBody that turns around an axis, and attach it to the entity.
+ * @param multiBody The multibody started with add_MultiBody().
+ * @param link The index of the link.
+ * @param parent The index of the parent link, or -1 for the base.
+ * @param entity The entity to add the physics component of the link to.
+ * @param parentPivot The pivot, which is also the center of the link, from the center of the parent in its frame.
+ * @param axis The axis of rotation.
+ * @param shapeSize The size of the collision shape of the link.
+ * @param mass The mass of the link.
+ */
+void Physics_3D_System::add_MultiBodyRevoluteLink(btMultiBody& multiBody, int link, int parent, Entity& entity,
+    const btVector3& parentPivot, const btVector3& axis, const btVector3& shapeSize, btScalar mass)
+{
+    auto collisionShape = std::make_shared<btBoxShape>(shapeSize);
+
+    btVector3 localInertia(0, 0, 0);
+    collisionShape->calculateLocalInertia(mass, localInertia);
+
+    multiBody.setupRevolute(link, mass, localInertia, parent, btQuaternion::getIdentity(), axis, parentPivot, btVector3(0, 0, 0));
+
+    addLinkCollider(entity, multiBody, link, collisionShape);
+}
+
+/**
+ * Set up a link of a btMultiBody welded to its parent, and attach it to the entity.
+ * @param multiBody The multibody started with add_MultiBody().
+ * @param link The index of the link.
+ * @param parent The index of the parent link, or -1 for the base.
+ * @param entity The entity to add the physics component of the link to.
+ * @param parentOffset The center of the link from the center of the parent, in its frame.
+ * @param shapeSize The size of the collision shape of the link.
+ * @param mass The mass of the link.
+ */
+void Physics_3D_System::add_MultiBodyFixedLink(btMultiBody& multiBody, int link, int parent, Entity& entity,
+    const btVector3& parentOffset, const btVector3& shapeSize, btScalar mass)
+{
+    auto collisionShape = std::make_shared<btBoxShape>(shapeSize);
+
+    btVector3 localInertia(0, 0, 0);
+    collisionShape->calculateLocalInertia(mass, localInertia);
+
+    multiBody.setupFixed(link, mass, localInertia, parent, btQuaternion::getIdentity(), parentOffset, btVector3(0, 0, 0));
+
+    addLinkCollider(entity, multiBody, link, collisionShape);
+}
+
+/**
+ * Add a btMultiBody whose links are all set up to the world.
+ * The colliders are placed where the links start before they enter the broadphase.
+ * @param multiBody The multibody started with add_MultiBody().
+ */
+void Physics_3D_System::finalize_MultiBody(btMultiBody& multiBody)
+{
+    multiBody.finalizeMultiDof();
+    multiBodyWorld->addMultiBody(&multiBody);
+
+    btAlignedObjectArray<btQuaternion> worldToLocal;
+    btAlignedObjectArray<btVector3> localOrigin;
+    multiBody.forwardKinematics(worldToLocal, localOrigin);
+    multiBody.updateCollisionObjectWorldTransforms(worldToLocal, localOrigin);
+
+    dynamicsWorld->addCollisionObject(multiBody.getBaseCollider(), btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+    for (int i = 0; i < multiBody.getNumLinks(); ++i) {
+        dynamicsWorld->addCollisionObject(multiBody.getLink(i).m_collider, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+    }
+}
+
 /**
  * Get the dynamics world.
  * @return A pointer to the dynamics world.
@@ -210,3 +429,234 @@ btDynamicsWorld* Physics_3D_System::getDynamicsWorld() const
 {
 	return dynamicsWorld.get();
 }
+
+/**
+ * Get the counts and times of impact of the continuous collision sweeps of the last step.
+ * @return The statistics of the sweeps done during the last call to stepSimulation().
+ */
+const btContinuousCollisionStats& Physics_3D_System::getContinuousCollisionStats() const
+{
+    return dynamicsWorld->getContinuousCollisionStats();
+}
+
+/**
+ * Attach a debug drawer to the dynamics world. The drawer is also given the broadphase so it can draw its tree.
+ * @param drawer The drawer, or nullptr to detach the current one.
+ */
+void Physics_3D_System::setDebugDrawer(Debug_Drawer* drawer)
+{
+    if (drawer) {
+        drawer->setBroadphase(&overlappingPairCache);
+    }
+    dynamicsWorld->setDebugDrawer(drawer);
+}
+
+/**
+ * Collect the debug geometry of the world into the attached drawer.
+ * Without a drawer, or with every category off, the world is not walked at all.
+ */
+void Physics_3D_System::debugDraw()
+{
+    btIDebugDraw* drawer = dynamicsWorld->getDebugDrawer();
+    if (drawer && drawer->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
+        dynamicsWorld->debugDrawWorld();
+    }
+}
+/**
+ * Create a rigid body with the given shape and attach it to the entity.
+ * @param entity The entity to add the physics component to.
+ * @param collisionShape The collision shape of the body.
+ * @param origin The initial position of the body.
+ * @param mass The mass of the body (0 for static bodies).
+ */
+void Physics_3D_System::addRigidBody(Entity& entity, std::shared_ptr<btCollisionShape> collisionShape,
+    const btVector3& origin, btScalar mass)
+{
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(origin);
+
+    btVector3 localInertia(0, 0, 0);
+    if (mass != 0.f)
+        collisionShape->calculateLocalInertia(mass, localInertia);
+
+    auto motionState = std::make_shared<btDefaultMotionState>(transform);
+    btRigidBody::btRigidBodyConstructionInfo info(mass, motionState.get(), collisionShape.get(), localInertia);
+    auto rigidBody = std::make_shared<btRigidBody>(info);
+
+    dynamicsWorld->addRigidBody(rigidBody.get());
+
+    auto physicsComponent = std::make_shared<Physics_Component>(collisionShape, motionState, rigidBody);
+    entity.addPhysicsComponent(physicsComponent);
+
+    rigidBodies    .push_back (rigidBody);
+    motionStates   .push_back (motionState);
+    collisionShapes.push_back (collisionShape);
+}
+/**
+ * Create a sensor object that shares the entity's collision shape and transform.
+ * @param entity The entity whose body the sensor mirrors.
+ */
+void Physics_3D_System::addSensor(Entity& entity)
+{
+    auto sensor = std::make_shared<btGhostObject>();
+    sensor->setCollisionShape(entity.getBody()->getCollisionShape());
+    sensor->setWorldTransform(entity.getBody()->getWorldTransform());
+    sensor->setCollisionFlags(sensor->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    dynamicsWorld->addCollisionObject(sensor.get());
+
+    sensorObjects.push_back(sensor);
+}
+
+/**
+ * Create the collider of the base or a link of a btMultiBody and attach it to the entity.
+ * @param entity The entity to add the physics component to.
+ * @param multiBody The multibody of the link.
+ * @param link The index of the link, or -1 for the base.
+ * @param collisionShape The collision shape of the link.
+ */
+void Physics_3D_System::addLinkCollider(Entity& entity, btMultiBody& multiBody, int link, std::shared_ptr<btCollisionShape> collisionShape)
+{
+    auto linkCollider = std::make_shared<btMultiBodyLinkCollider>(&multiBody, link);
+    linkCollider->setCollisionShape(collisionShape.get());
+
+    if (link < 0)
+        multiBody.setBaseCollider(linkCollider.get());
+    else
+        multiBody.getLink(link).m_collider = linkCollider.get();
+
+    auto physicsComponent = std::make_shared<Physics_Component>(collisionShape, linkCollider);
+    entity.addPhysicsComponent(physicsComponent);
+
+    linkColliders  .push_back (linkCollider);
+    collisionShapes.push_back (collisionShape);
+}
+
+/**
+ * Write the render matrices of a set of bodies, with the scale of each model folded in.
+ * The transforms are gathered first, so the conversion itself runs over one contiguous array.
+ * @param bodies Bodies to export.
+ * @param scales Scale of the model of each body.
+ * @param count Number of bodies.
+ * @param matrices Receives a column-major 4x4 matrix per body.
+ * @param stride Distance in floats between consecutive matrices.
+ */
+void Physics_3D_System::exportTransforms(const btCollisionObject* const* bodies, const btVector3* scales, size_t count, float* matrices, size_t stride)
+{
+    exportedTransforms.resizeNoInitialize(int(count));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const btRigidBody* rigidBody = btRigidBody::upcast(bodies[i]);
+        if (rigidBody && rigidBody->getMotionState())
+            rigidBody->getMotionState()->getWorldTransform(exportedTransforms[int(i)]);
+        else
+            exportedTransforms[int(i)] = bodies[i]->getWorldTransform();
+    }
+
+    if (count > 0) {
+        convertTransforms(&exportedTransforms[0], scales, count, matrices, stride);
+    }
+}
+
+/**
+ * Convert transforms to column-major 4x4 matrices whose first three columns are scaled.
+ * The result equals getOpenGLMatrix() followed by a scale by (x, y, z). With SSE every matrix is
+ * one transpose of the three basis rows plus the origin, and four stores.
+ * @param transforms Transforms to convert.
+ * @param scales Scale of each transform.
+ * @param count Number of transforms.
+ * @param matrices Receives a matrix per transform.
+ * @param stride Distance in floats between consecutive matrices.
+ */
+void Physics_3D_System::convertTransforms(const btTransform* transforms, const btVector3* scales, size_t count, float* matrices, size_t stride)
+{
+#ifdef TRANSFORM_EXPORT_USE_SSE
+    const __m128 lastRow = _mm_setr_ps(0.f, 0.f, 0.f, 1.f);
+    const __m128 ones = _mm_set1_ps(1.f);
+
+    for (size_t i = 0; i < count; ++i, matrices += stride)
+    {
+        const btMatrix3x3& basis = transforms[i].getBasis();
+
+        __m128 column0 = _mm_loadu_ps(&basis.getRow(0).x());
+        __m128 column1 = _mm_loadu_ps(&basis.getRow(1).x());
+        __m128 column2 = _mm_loadu_ps(&basis.getRow(2).x());
+        __m128 column3 = lastRow;
+        _MM_TRANSPOSE4_PS(column0, column1, column2, column3);     // The rows become columns ending in 0
+
+        // Origin with w = 1, whatever the padding lane of the btVector3 holds
+        __m128 origin = _mm_loadu_ps(&transforms[i].getOrigin().x());
+        origin = _mm_shuffle_ps(origin, _mm_unpackhi_ps(origin, ones), _MM_SHUFFLE(1, 0, 1, 0));
+
+        __m128 scale = _mm_loadu_ps(&scales[i].x());
+        _mm_storeu_ps(matrices,      _mm_mul_ps(column0, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(0, 0, 0, 0))));
+        _mm_storeu_ps(matrices + 4,  _mm_mul_ps(column1, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(1, 1, 1, 1))));
+        _mm_storeu_ps(matrices + 8,  _mm_mul_ps(column2, _mm_shuffle_ps(scale, scale, _MM_SHUFFLE(2, 2, 2, 2))));
+        _mm_storeu_ps(matrices + 12, origin);
+    }
+#else
+    for (size_t i = 0; i < count; ++i, matrices += stride)
+    {
+        const btMatrix3x3& basis = transforms[i].getBasis();
+        const btVector3& origin = transforms[i].getOrigin();
+
+        for (int column = 0; column < 3; ++column)
+        {
+            btScalar scale = scales[i][column];
+            matrices[column * 4 + 0] = float(basis[0][column] * scale);
+            matrices[column * 4 + 1] = float(basis[1][column] * scale);
+            matrices[column * 4 + 2] = float(basis[2][column] * scale);
+            matrices[column * 4 + 3] = 0.f;
+        }
+        matrices[12] = float(origin.x());
+        matrices[13] = float(origin.y());
+        matrices[14] = float(origin.z());
+        matrices[15] = 1.f;
+    }
+#endif
+}
+
+#if TRANSFORM_EXPORT_ENABLE_BENCHMARK
+
+/**
+ * Time the conversion of 10000 transforms with the per-entity path used before
+ * (getOpenGLMatrix into a glm::mat4 and a glt::scale) and with convertTransforms().
+ */
+void Physics_3D_System::benchmark()
+{
+    const int COUNT = 10000;
+    const int REPETITIONS = 100;
+
+    btAlignedObjectArray< btTransform > transforms;
+    btAlignedObjectArray< btVector3 > scales;
+    for (int i = 0; i < COUNT; ++i) {
+        transforms.push_back(btTransform(btQuaternion(btVector3(1, 2, 3).normalized(), btScalar(i) * btScalar(0.01)), btVector3(btScalar(i), 1, 2)));
+        scales.push_back(btVector3(1, btScalar(0.5), btScalar(0.25)));
+    }
+
+    std::vector< glm::mat4 > matrices(COUNT);
+    chrono::nanoseconds perEntityTime(0), batchTime(0);
+
+    for (int repetition = 0; repetition < REPETITIONS; ++repetition)
+    {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < COUNT; ++i) {
+            glm::mat4 matrix;
+            transforms[i].getOpenGLMatrix(&matrix[0][0]);
+            matrices[i] = glt::scale(matrix, scales[i].x(), scales[i].y(), scales[i].z());
+        }
+        auto middle = chrono::steady_clock::now();
+        convertTransforms(&transforms[0], &scales[0], COUNT, &matrices[0][0][0]);
+        auto end = chrono::steady_clock::now();
+
+        perEntityTime += middle - start;
+        batchTime += end - middle;
+    }
+
+    std::cout << "Transform export of " << COUNT << " bodies: per entity "
+        << chrono::duration< double, micro >(perEntityTime).count() / REPETITIONS << " us, batch "
+        << chrono::duration< double, micro >(batchTime).count() / REPETITIONS << " us" << std::endl;
+}
+
+#endif
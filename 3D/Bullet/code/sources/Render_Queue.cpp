@@ -0,0 +1,147 @@
+/**********************************************************************
+*Project           : Bullet3D Practice
+*
+*Author : Lucas Garca
+*
+*
+*Purpose : Physics Practice using Bullet that moves a tank and other features
+*
+**********************************************************************/
+
+#include <algorithm>
+
+#include "Render_Queue.h"
+
+#if RENDER_QUEUE_ENABLE_BENCHMARK
+#include <chrono>
+#include <random>
+#include <iostream>
+#endif
+
+using namespace std;
+
+/**
+ * Pack the render state and depth of a draw into a sort key.
+ * Identifiers wider than their field are truncated, which only makes unrelated draws share a state.
+ * @param shader Identifier of the shader program.
+ * @param material Identifier of the material.
+ * @param mesh Identifier of the mesh.
+ * @param depth Distance to the camera normalized to [0, 1].
+ * @return The key.
+ */
+uint64_t Render_Queue::makeKey(uint32_t shader, uint32_t material, uint32_t mesh, float depth)
+{
+    const uint64_t depthRange = (uint64_t(1) << DEPTH_BITS) - 1;
+    uint64_t quantizedDepth = uint64_t(min(max(depth, 0.f), 1.f) * float(depthRange));
+
+    return (uint64_t(shader   & ((1u << SHADER_BITS)   - 1)) << (MATERIAL_BITS + MESH_BITS + DEPTH_BITS))
+         | (uint64_t(material & ((1u << MATERIAL_BITS) - 1)) << (MESH_BITS + DEPTH_BITS))
+         | (uint64_t(mesh     & ((1u << MESH_BITS)     - 1)) << DEPTH_BITS)
+         | min(quantizedDepth, depthRange);
+}
+
+/**
+ * Sort the draws by key with a least significant digit radix sort on bytes.
+ * The histograms of all the bytes are counted in a single pass, and bytes where every key has the
+ * same value are skipped, so a frame with one shader and material only sorts the mesh and depth bytes.
+ */
+void Render_Queue::sort()
+{
+    const size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+
+    uint32_t histograms[8][256] = {};
+    for (const auto& item : items) {
+        for (int digit = 0; digit < 8; ++digit) {
+            ++histograms[digit][(item.key >> (digit * 8)) & 0xFF];
+        }
+    }
+
+    scratch.resize(count);
+    Item* source = items.data();
+    Item* destination = scratch.data();
+
+    for (int digit = 0; digit < 8; ++digit)
+    {
+        uint32_t* histogram = histograms[digit];
+        if (histogram[(source[0].key >> (digit * 8)) & 0xFF] == count)
+            continue;                                   // Every key has the same byte here
+
+        // Turn the counts into the first output position of each byte value
+        uint32_t offset = 0;
+        for (int value = 0; value < 256; ++value) {
+            uint32_t valueCount = histogram[value];
+            histogram[value] = offset;
+            offset += valueCount;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            destination[histogram[(source[i].key >> (digit * 8)) & 0xFF]++] = source[i];
+        }
+
+        swap(source, destination);
+    }
+
+    if (source != items.data()) {
+        items.swap(scratch);
+    }
+}
+
+#if RENDER_QUEUE_ENABLE_BENCHMARK
+
+/**
+ * Time filling and sorting queues of 10000 and 100000 draws spread over a few shaders, materials and meshes,
+ * next to std::stable_sort of the same keys.
+ */
+void Render_Queue::benchmark()
+{
+    const int REPETITIONS = 50;
+    mt19937 random(1234);
+    uniform_int_distribution< uint32_t > shaders(0, 3), materials(0, 63), meshes(0, 255);
+    uniform_real_distribution< float > depths(0.f, 1.f);
+
+    for (size_t count : { size_t(10000), size_t(100000) })
+    {
+        vector< uint64_t > keys(count);
+        for (auto& key : keys) {
+            key = makeKey(shaders(random), materials(random), meshes(random), depths(random));
+        }
+
+        Render_Queue queue;
+        queue.reserve(count);
+        chrono::nanoseconds buildTime(0), sortTime(0), stdSortTime(0);
+
+        for (int repetition = 0; repetition < REPETITIONS; ++repetition)
+        {
+            auto start = chrono::steady_clock::now();
+            queue.clear();
+            for (size_t i = 0; i < count; ++i) {
+                queue.push(keys[i], uint32_t(i));
+            }
+            auto built = chrono::steady_clock::now();
+            queue.sort();
+            auto sorted = chrono::steady_clock::now();
+
+            vector< Item > reference(queue.getItems().size());
+            for (size_t i = 0; i < count; ++i) {
+                reference[i] = { keys[i], uint32_t(i) };
+            }
+            auto referenceStart = chrono::steady_clock::now();
+            std::stable_sort(reference.begin(), reference.end(), [](const Item& a, const Item& b) { return a.key < b.key; });
+            auto referenceEnd = chrono::steady_clock::now();
+
+            buildTime += built - start;
+            sortTime += sorted - built;
+            stdSortTime += referenceEnd - referenceStart;
+        }
+
+        std::cout << "Render_Queue " << count << " draws: build "
+            << chrono::duration< double, micro >(buildTime).count() / REPETITIONS << " us, radix sort "
+            << chrono::duration< double, micro >(sortTime).count() / REPETITIONS << " us, std::stable_sort "
+            << chrono::duration< double, micro >(stdSortTime).count() / REPETITIONS << " us" << std::endl;
+    }
+}
+
+#endif
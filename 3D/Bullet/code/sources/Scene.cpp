@@ -15,6 +15,9 @@
 #include <Projectile.h>
 #include "ContactListener.h"
 
+// Build the tank as one btMultiBody in a multibody world instead of rigid bodies held by constraints
+const bool ARTICULATED_TANK = false;
+
 /**
  * Scene constructor.
  * Initializes the window, graphics, physics systems, and the contact listener.
@@ -31,7 +34,7 @@ Scene::Scene()
 
     // Initialize the graphics and physics systems
     graphics_system = std::make_shared<Graphics_3D_System>();
-    physics_system = std::make_shared<Physics_3D_System>();
+    physics_system = std::make_shared<Physics_3D_System>(ARTICULATED_TANK);
 
     // Initialize the contact listener for handling collisions
     contactListener = std::make_shared<ContactListener>();
@@ -41,6 +44,9 @@ Scene::Scene()
 
     // Initialize the graphics system with the window context
     graphics_system->initialize(window);
+
+    // Wireframes, contacts and constraints, drawn once debug drawing is switched on with F1
+    debugDrawer.setDebugMode(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawContactPoints | btIDebugDraw::DBG_DrawConstraints);
 }
 
 /**
@@ -69,6 +75,11 @@ void Scene::addEntity(const std::string& name, std::shared_ptr<Entity> entity,
     graphics_system->add_Component(name, *entity, scale, color);
     physics_system->add_Component(*entity, origin, shapeSize, mass);
 
+    // Static boxes (floors, walls) hide whatever is behind them
+    if (mass == 0.f) {
+        graphics_system->setOccluder(*entity);
+    }
+
     // Store the entity in the entities map with its name as the key
     entities[name] = entity;
     entities[name]->position = origin;
@@ -92,6 +103,7 @@ void Scene::addDoor(const std::string& name, std::shared_ptr<Entity> entity,
     // Add graphical and physical components to the door
     graphics_system->add_Component(name, *entity, scale, color);
     physics_system->add_Component(*entity, origin, shapeSize, mass);
+    graphics_system->setOccluder(*entity);
 
     // Store the door in the entities map with its name as the key
     entities[name] = entity;
@@ -107,21 +119,18 @@ void Scene::addDoor(const std::string& name, std::shared_ptr<Entity> entity,
  * @param name Name of the key.
  * @param entity Shared pointer to the key entity.
  * @param origin The initial position of the key.
- * @param shapeSize The size of the key's collision shape.
  * @param mass The mass of the key.
  * @param scale The scale of the key's graphical representation.
  * @param color The color of the key.
  */
 void Scene::addKey(const std::string& name, std::shared_ptr<Entity> entity,
-    const btVector3& origin, const btVector3& shapeSize,
-    btScalar mass, btVector3 scale, btVector3 color)
+    const btVector3& origin, btScalar mass, btVector3 scale, btVector3 color)
 {
     // Add graphical component specific to the key
     graphics_system->add_ComponentKey(name, *entity, scale, color);
 
-    // Add a sensor physics component for the key (using a different scale)
-    const btVector3 scaleKey(0.25f, 1.0f, 2.0f);  // Specific scale for key collision shape
-    physics_system->add_ComponentSensor(*entity, origin, scaleKey, mass);
+    // Add a sensor physics component for the key, shaped as a few convex pieces of the rendered key model
+    physics_system->add_ComponentDecomposedSensor(*entity, origin, "../../assets/key.obj", scale, mass);
 
     // Store the key in the entities map and set its position and scale
     entities[name] = entity;
@@ -166,95 +175,30 @@ void Scene::addPlatform(const std::string& name, std::shared_ptr<Platform> entit
  */
 void Scene::addTank(const std::string& name, std::shared_ptr<Tank> tank)
 {
-    // Set mass for chassis and tracks (adjust as necessary)
-    btScalar chasisMass = 1.0f;
-    btScalar trackMass = 1.0f;
-
-    // Define positions, scales, and colors for tank components
-    btVector3 leftTrackPosition(-1.2f, 0.0f, 0.0f);
-    btVector3 rightTrackPosition(1.2f, 0.0f, 0.0f);
-    const btVector3 trackScale(0.25f, 0.25f, 1.0f);
+    // Bodies of the parts: one multibody in an articulated world, constrained rigid bodies otherwise
+    tank->addPhysics(*physics_system, btVector3(0.0f, 0.0f, 0.0f));
+
+    // Colors of the tank components
     btVector3 trackColor(0.216f, 0.541f, 0.243f);
+    btVector3 chasisColor(0.36f, 0.541f, 0.243f);
+    btVector3 turretColor(0.255f, 0.529f, 0.278f);
+    btVector3 canyonColor(0.255f, 0.529f, 0.378f);
 
-    // Left track: Add graphical and physical components
-    graphics_system->add_Component("leftTrack", *tank->leftTrack, trackScale, trackColor);
-    physics_system->add_ComponentSensor(*tank->leftTrack, leftTrackPosition, trackScale, trackMass);
+    // Add the graphical components, with the scales set by the physical parts
+    graphics_system->add_Component("leftTrack", *tank->leftTrack, tank->leftTrack->scale, trackColor);
     entities["leftTrack"] = tank->leftTrack;
-    entities["leftTrack"]->position = leftTrackPosition;
-    entities["leftTrack"]->scale = trackScale;
 
-    // Right track: Add graphical and physical components
-    graphics_system->add_Component("rightTrack", *tank->rightTrack, trackScale, trackColor);
-    physics_system->add_ComponentSensor(*tank->rightTrack, rightTrackPosition, trackScale, trackMass);
+    graphics_system->add_Component("rightTrack", *tank->rightTrack, tank->rightTrack->scale, trackColor);
     entities["rightTrack"] = tank->rightTrack;
-    entities["rightTrack"]->position = rightTrackPosition;
-    entities["rightTrack"]->scale = trackScale;
 
-    // Chassis: Set position, scale, and color
-    btVector3 chasisPosition(0.0f, 0.0f, 0.0f);
-    btVector3 chasisScale(1.0f, 0.2f, 1.0f);
-    btVector3 chasisColor(0.36f, 0.541f, 0.243f);
-    graphics_system->add_Component("chassis", *tank->chasis, chasisScale, chasisColor);
-    physics_system->add_ComponentSensor(*tank->chasis, chasisPosition, chasisScale, chasisMass);
+    graphics_system->add_Component("chassis", *tank->chasis, tank->chasis->scale, chasisColor);
     entities["chassis"] = tank->chasis;
-    entities["chassis"]->position = chasisPosition;
-    entities["chassis"]->scale = chasisScale;
 
-    // Turret: Set position, scale, and color
-    btVector3 turretPosition(0.0f, 0.55f, 0.0f);
-    btVector3 turretScale(0.5f, 0.2f, 0.35f);
-    btVector3 turretColor(0.255f, 0.529f, 0.278f);
-    graphics_system->add_Component("turret", *tank->turret, turretScale, turretColor);
-    physics_system->add_Component(*tank->turret, turretPosition, turretScale, 1.0f);
+    graphics_system->add_Component("turret", *tank->turret, tank->turret->scale, turretColor);
     entities["turret"] = tank->turret;
-    entities["turret"]->position = turretPosition;
-    entities["turret"]->scale = turretScale;
 
-    // Cannon: Set position, scale, and color
-    btVector3 canyonPosition(0.0f, 0.55f, -2.0f);
-    btVector3 canyonScale(0.2f, 0.1f, 0.5f);
-    btVector3 canyonColor(0.255f, 0.529f, 0.378f);
-    graphics_system->add_Component("canyon", *tank->canyon, canyonScale, canyonColor);
-    physics_system->add_Component(*tank->canyon, canyonPosition, canyonScale, 1.0f);
+    graphics_system->add_Component("canyon", *tank->canyon, tank->canyon->scale, canyonColor);
     entities["canyon"] = tank->canyon;
-    entities["canyon"]->position = canyonPosition;
-    entities["canyon"]->scale = canyonScale;
-
-    // Add constraints for left and right tracks, turret, and cannon
-
-    // Left track constraint (hinge)
-    tank->leftTrackConstraint = std::make_shared<btHingeConstraint>(
-        *tank->chasis->getBody(), *tank->leftTrack->getBody(),
-        btVector3(-1.2f, 0.0f, 0.0f), btVector3(0.0f, 0.0f, 0.0f),
-        btVector3(0, 1, 0), btVector3(0, 1, 0), false);
-
-    // Right track constraint (hinge)
-    tank->rightTrackConstraint = std::make_shared<btHingeConstraint>(
-        *tank->chasis->getBody(), *tank->rightTrack->getBody(),
-        btVector3(1.2f, 0.0f, 0.0f), btVector3(0.0f, 0.0f, 0.0f),
-        btVector3(0, 1, 0), btVector3(0, 1, 0), false);
-
-    // Turret constraint (fixed)
-    btTransform frameInA, frameInB;
-    frameInA = btTransform::getIdentity();
-    frameInA.setOrigin(btVector3(0.0f, 0.50f, 0.0f));  // Turret position relative to chassis
-    frameInB = btTransform::getIdentity();
-    tank->turretConstraint = std::make_shared<btFixedConstraint>(
-        *tank->chasis->getBody(), *tank->turret->getBody(), frameInA, frameInB);
-
-    // Cannon constraint (fixed)
-    btTransform cannonFrameInA, cannonFrameInB;
-    cannonFrameInA = btTransform::getIdentity();
-    cannonFrameInA.setOrigin(btVector3(0.0f, 0.0f, -0.85f));  // Cannon position relative to turret
-    cannonFrameInB = btTransform::getIdentity();
-    tank->canyonConstraint = std::make_shared<btFixedConstraint>(
-        *tank->turret->getBody(), *tank->canyon->getBody(), cannonFrameInA, cannonFrameInB);
-
-    // Add constraints to the dynamics world
-    physics_system->getDynamicsWorld()->addConstraint(tank->turretConstraint.get());
-    physics_system->getDynamicsWorld()->addConstraint(tank->canyonConstraint.get());
-    physics_system->getDynamicsWorld()->addConstraint(tank->leftTrackConstraint.get());
-    physics_system->getDynamicsWorld()->addConstraint(tank->rightTrackConstraint.get());
 
     // Register the tank with the contact listener
     contactListener->addTank(tank);
@@ -270,13 +214,7 @@ void Scene::addTank(const std::string& name, std::shared_ptr<Tank> tank)
     btVector3 projectileColor(1.0f, 1.0f, 1.0f);
 
     // Get current cannon transformation
-    btTransform canyonTransform;
-    tank->canyon->getBody()->getMotionState()->getWorldTransform(canyonTransform);
-
-    // Disable deactivation for tank components (keep them active)
-    tank->chasis->getBody()->setActivationState(DISABLE_DEACTIVATION);
-    tank->leftTrack->getBody()->setActivationState(DISABLE_DEACTIVATION);
-    tank->rightTrack->getBody()->setActivationState(DISABLE_DEACTIVATION);
+    btTransform canyonTransform = tank->canyon->getWorldTransform();
 
     // Calculate initial projectile position, displaced forward
     btVector3 projectilePosition = canyonTransform.getOrigin() + canyonTransform.getBasis() * btVector3(0, 30, -0.5f);
@@ -285,9 +223,9 @@ void Scene::addTank(const std::string& name, std::shared_ptr<Tank> tank)
     for (size_t i = 0; i < 10; i++) {
         shared_ptr<Projectile> projectile = make_shared<Projectile>();
         graphics_system->add_ComponentSphere("projectile" + std::to_string(i), *projectile.get(), projectileScale, projectileColor);
-        physics_system->add_ComponentSphere(*projectile.get(), projectilePosition, projectileScale, 1.0f);
+        physics_system->add_ComponentProjectile(*projectile.get(), projectilePosition, projectileScale, 1.0f);
         entities["projectile" + std::to_string(i)] = projectile;
-        entities["projectile" + std::to_string(i)]->position = canyonPosition;
+        entities["projectile" + std::to_string(i)]->position = tank->canyon->position;
         entities["projectile" + std::to_string(i)]->scale = projectileScale;
         projectile->setActive(false);  // Set initial state of projectile to inactive
         tank->projectiles.push_back(projectile);
@@ -324,6 +262,10 @@ void Scene::run()
                     // Tank shoots a projectile when space is pressed
                     tankCharacter->shootProjectile(graphics_system, physics_system, entities);
                 }
+                else if (event.key.code == sf::Keyboard::F1)
+                {
+                    setDebugDrawing(!debugDrawing);
+                }
                 break;
             }
         }
@@ -347,9 +289,15 @@ void Scene::run()
         // Apply the updated physics transforms to the graphics entities
         updateGraphicsTransforms();
 
+        // Collect the physics debug lines; nothing is done while debug drawing is off
+        physics_system->debugDraw();
+
         // Clear the screen and render the scene
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         graphics_system->render();
+        if (debugDrawing) {
+            graphics_system->renderDebug(debugDrawer);
+        }
         window.display();
 
     } while (running);
@@ -364,8 +312,7 @@ void Scene::run()
  */
 void Scene::handleTankMovement()
 {
-    btTransform chassisTransform;
-    tankCharacter->chasis->getBody()->getMotionState()->getWorldTransform(chassisTransform);
+    btTransform chassisTransform = tankCharacter->chasis->getWorldTransform();
     btMatrix3x3 chassisRotation = chassisTransform.getBasis();
 
     const btVector3 forwardForce(0, 0, -10);  // Force applied forward
@@ -404,8 +351,8 @@ void Scene::handleTankMovement()
 void Scene::applyTankForce(const btVector3& force, const btMatrix3x3& rotation)
 {
     btVector3 rotatedForce = rotation * force;
-    tankCharacter->leftTrack->getBody()->applyCentralForce(rotatedForce);
-    tankCharacter->rightTrack->getBody()->applyCentralForce(rotatedForce);
+    tankCharacter->leftTrack->applyCentralForce(rotatedForce);
+    tankCharacter->rightTrack->applyCentralForce(rotatedForce);
 }
 
 /**
@@ -419,37 +366,44 @@ void Scene::applyTankTurningForce(const btVector3& leftForce, const btVector3& r
     btVector3 rotatedLeftForce = rotation * leftForce;
     btVector3 rotatedRightForce = rotation * rightForce;
 
-    tankCharacter->leftTrack->getBody()->applyCentralForce(rotatedLeftForce);
-    tankCharacter->rightTrack->getBody()->applyCentralForce(rotatedRightForce);
+    tankCharacter->leftTrack->applyCentralForce(rotatedLeftForce);
+    tankCharacter->rightTrack->applyCentralForce(rotatedRightForce);
 }
 
 /**
  * Updates the graphics transformations based on the current physics state.
- * Applies the physics transformation to the corresponding graphical models.
+ * The bodies of all the entities are exported in one batch by the physics system, with the model
+ * scales already folded into the matrices, and the result is applied to the graphical models.
  */
 void Scene::updateGraphicsTransforms()
 {
+    syncBodies.clear();
+    syncScales.clear();
+    syncModels.clear();
+
     for (auto& pair : entities)
     {
         auto& entity = pair.second;
 
-        // Only update entities with a valid physics body
-        if (entity->getBody())
+        // Only update entities with a valid physics body and a graphical model
+        if (entity->getCollisionObject() && entity->get_Graphic_Model())
         {
-            btTransform physicsTransform;
-            entity->getBody()->getMotionState()->getWorldTransform(physicsTransform);
+            syncBodies.push_back(entity->getCollisionObject());
+            syncScales.push_back(entity->scale);
+            syncModels.push_back(entity->get_Graphic_Model());
+        }
+    }
 
-            glm::mat4 graphicsTransform;
-            physicsTransform.getOpenGLMatrix(glm::value_ptr(graphicsTransform));
+    if (syncBodies.empty())
+        return;
 
-            // Update the graphical model's transformation
-            if (entity->get_Graphic_Model())
-            {
-                entity->get_Graphic_Model()->set_transformation(graphicsTransform);
-                btVector3 scale = entity->scale;
-                entity->get_Graphic_Model()->scale(scale.getX(), scale.getY(), scale.getZ());
-            }
-        }
+    syncMatrices.resize(syncBodies.size());
+    physics_system->exportTransforms(syncBodies.data(), &syncScales[0], syncBodies.size(), glm::value_ptr(syncMatrices[0]));
+
+    // Update the graphical models' transformations
+    for (size_t i = 0; i < syncModels.size(); ++i)
+    {
+        syncModels[i]->set_transformation(syncMatrices[i]);
     }
 }
 
@@ -458,3 +412,25 @@ void Scene::resetDynamicsWorld()
 {
     dynamicsWorld.reset();
 }
+
+/**
+ * Switches the physics debug drawing on or off.
+ * While it is off the drawer is detached from the world, so the simulation does no debug work.
+ * @param enabled True to draw the categories set with setDebugDrawMode().
+ */
+void Scene::setDebugDrawing(bool enabled)
+{
+    debugDrawing = enabled;
+    physics_system->setDebugDrawer(enabled ? &debugDrawer : nullptr);
+}
+
+/**
+ * Chooses what the physics debug drawing shows, and optionally dumps it to a file.
+ * @param mode Combination of btIDebugDraw::DebugDrawModes flags and Debug_Drawer::DRAW_BROADPHASE.
+ * @param dumpPath File that receives the lines of every frame, for runs without a window. Empty to not dump.
+ */
+void Scene::setDebugDrawMode(int mode, const std::string& dumpPath)
+{
+    debugDrawer.setDebugMode(mode);
+    debugDrawer.setDumpFile(dumpPath);
+}
@@ -21,10 +21,28 @@
 #include <Projectile.h>
 #include <Graphics_3D_System.h>
 #include <Physics_3D_System.h>
+#include <BulletDynamics/Featherstone/btMultiBody.h>
+
+#if TANK_ENABLE_BENCHMARK
+    #include <chrono>
+    #include <cmath>
+#endif
 
 using namespace std;
 using namespace glt;
 
+// Layout of the parts, relative to the center of the chassis
+const btScalar  PART_MASS = 1.0f;
+const btVector3 TRACK_POSITION(1.2f, 0.0f, 0.0f);       // Right track, the left one is mirrored
+const btVector3 TRACK_SCALE(0.25f, 0.25f, 1.0f);
+const btVector3 CHASSIS_SCALE(1.0f, 0.2f, 1.0f);
+const btVector3 TURRET_POSITION(0.0f, 0.55f, 0.0f);
+const btVector3 TURRET_SCALE(0.5f, 0.2f, 0.35f);
+const btVector3 TURRET_JOINT(0.0f, 0.50f, 0.0f);        // Turret position relative to chassis
+const btVector3 CANNON_POSITION(0.0f, 0.55f, -2.0f);
+const btVector3 CANNON_SCALE(0.2f, 0.1f, 0.5f);
+const btVector3 CANNON_JOINT(0.0f, 0.0f, -0.85f);       // Cannon position relative to turret
+
 /**
  * Constructor for the Tank class.
  * Initializes the tank components (left track, right track, chassis, turret, and cannon).
@@ -48,6 +66,85 @@ Tank::~Tank() {
     // Destructor cleanup if necessary (automatic with shared_ptr)
 }
 
+/**
+ * Creates the physical parts of the tank and joins them.
+ * @param physicsSystem The physics system that simulates the tank.
+ * @param origin The initial position of the chassis.
+ */
+void Tank::addPhysics(Physics_3D_System& physicsSystem, const btVector3& origin)
+{
+    const btVector3 leftTrackPosition(-TRACK_POSITION.x(), TRACK_POSITION.y(), TRACK_POSITION.z());
+
+    leftTrack->position = origin + leftTrackPosition;
+    rightTrack->position = origin + TRACK_POSITION;
+    chasis->position = origin;
+    turret->position = origin + TURRET_POSITION;
+    canyon->position = origin + CANNON_POSITION;
+
+    leftTrack->scale = TRACK_SCALE;
+    rightTrack->scale = TRACK_SCALE;
+    chasis->scale = CHASSIS_SCALE;
+    turret->scale = TURRET_SCALE;
+    canyon->scale = CANNON_SCALE;
+
+    if (physicsSystem.isArticulated())
+    {
+        // One multibody: the joints are its coordinates, so they cannot drift and the solver only sees the contacts
+        multiBody = physicsSystem.add_MultiBody(*chasis, origin, CHASSIS_SCALE, PART_MASS, 4);
+        physicsSystem.add_MultiBodyRevoluteLink(*multiBody, 0, -1, *leftTrack, leftTrackPosition, btVector3(0, 1, 0), TRACK_SCALE, PART_MASS);
+        physicsSystem.add_MultiBodyRevoluteLink(*multiBody, 1, -1, *rightTrack, TRACK_POSITION, btVector3(0, 1, 0), TRACK_SCALE, PART_MASS);
+        physicsSystem.add_MultiBodyFixedLink(*multiBody, 2, -1, *turret, TURRET_JOINT, TURRET_SCALE, PART_MASS);
+        physicsSystem.add_MultiBodyFixedLink(*multiBody, 3, 2, *canyon, CANNON_JOINT, CANNON_SCALE, PART_MASS);
+        physicsSystem.finalize_MultiBody(*multiBody);
+        return;
+    }
+
+    physicsSystem.add_ComponentSensor(*leftTrack, leftTrack->position, TRACK_SCALE, PART_MASS);
+    physicsSystem.add_ComponentSensor(*rightTrack, rightTrack->position, TRACK_SCALE, PART_MASS);
+    physicsSystem.add_ComponentSensor(*chasis, chasis->position, CHASSIS_SCALE, PART_MASS);
+    physicsSystem.add_Component(*turret, turret->position, TURRET_SCALE, PART_MASS);
+    physicsSystem.add_Component(*canyon, canyon->position, CANNON_SCALE, PART_MASS);
+
+    // Left track constraint (hinge)
+    leftTrackConstraint = std::make_shared<btHingeConstraint>(
+        *chasis->getBody(), *leftTrack->getBody(),
+        leftTrackPosition, btVector3(0.0f, 0.0f, 0.0f),
+        btVector3(0, 1, 0), btVector3(0, 1, 0), false);
+
+    // Right track constraint (hinge)
+    rightTrackConstraint = std::make_shared<btHingeConstraint>(
+        *chasis->getBody(), *rightTrack->getBody(),
+        TRACK_POSITION, btVector3(0.0f, 0.0f, 0.0f),
+        btVector3(0, 1, 0), btVector3(0, 1, 0), false);
+
+    // Turret constraint (fixed)
+    btTransform frameInA, frameInB;
+    frameInA = btTransform::getIdentity();
+    frameInA.setOrigin(TURRET_JOINT);
+    frameInB = btTransform::getIdentity();
+    turretConstraint = std::make_shared<btFixedConstraint>(
+        *chasis->getBody(), *turret->getBody(), frameInA, frameInB);
+
+    // Cannon constraint (fixed)
+    btTransform cannonFrameInA, cannonFrameInB;
+    cannonFrameInA = btTransform::getIdentity();
+    cannonFrameInA.setOrigin(CANNON_JOINT);
+    cannonFrameInB = btTransform::getIdentity();
+    canyonConstraint = std::make_shared<btFixedConstraint>(
+        *turret->getBody(), *canyon->getBody(), cannonFrameInA, cannonFrameInB);
+
+    // Add constraints to the dynamics world
+    physicsSystem.getDynamicsWorld()->addConstraint(turretConstraint.get());
+    physicsSystem.getDynamicsWorld()->addConstraint(canyonConstraint.get());
+    physicsSystem.getDynamicsWorld()->addConstraint(leftTrackConstraint.get());
+    physicsSystem.getDynamicsWorld()->addConstraint(rightTrackConstraint.get());
+
+    // Disable deactivation for tank components (keep them active)
+    chasis->getBody()->setActivationState(DISABLE_DEACTIVATION);
+    leftTrack->getBody()->setActivationState(DISABLE_DEACTIVATION);
+    rightTrack->getBody()->setActivationState(DISABLE_DEACTIVATION);
+}
+
 /**
  * Fires a projectile from the tank's cannon.
  * @param graphicsSystem Shared pointer to the graphics system.
@@ -58,8 +155,7 @@ void Tank::shootProjectile(shared_ptr<Graphics_3D_System> graphicsSystem, shared
     std::map<std::string, std::shared_ptr<Entity>> entities)
 {
     // Get the current transformation of the cannon
-    btTransform canyonTransform;
-    canyon->getBody()->getMotionState()->getWorldTransform(canyonTransform);
+    btTransform canyonTransform = canyon->getWorldTransform();
 
     // Calculate the initial position of the projectile, slightly forward of the cannon
     btVector3 projectilePosition = canyonTransform.getOrigin() + canyonTransform.getBasis() * btVector3(0, 0, -0.5f);
@@ -83,3 +179,58 @@ void Tank::shootProjectile(shared_ptr<Graphics_3D_System> graphicsSystem, shared
     // Update the index to point to the next projectile in the list
     nextProjectileIndex = (nextProjectileIndex + 1) % projectiles.size();  // Wrap around when the last projectile is reached
 }
+
+#if TANK_ENABLE_BENCHMARK
+
+/**
+ * Time the steps of a grid of tanks driving forward on a ground box, built as five constrained rigid
+ * bodies each and as one multibody each.
+ */
+void Tank::benchmark()
+{
+    const int TANK_COUNTS[] = { 25, 100, 400 };
+    const int WARMUP_STEPS = 60;
+    const int STEPS = 300;
+    const float SPACING = 5.0f;
+    const btVector3 DRIVE_FORCE(0, 0, -10);
+
+    for (int tankCount : TANK_COUNTS)
+    {
+        double stepTime[2];
+
+        for (int articulated = 0; articulated < 2; ++articulated)
+        {
+            std::vector< shared_ptr< Tank > > tanks;
+            Entity ground;
+            Physics_3D_System physicsSystem(articulated != 0);
+            physicsSystem.add_Component(ground, btVector3(0, -1, 0), btVector3(200, 1, 200), 0.f);
+
+            int columns = int(std::ceil(std::sqrt(float(tankCount))));
+            for (int i = 0; i < tankCount; ++i) {
+                auto tank = make_shared<Tank>();
+                tank->addPhysics(physicsSystem, btVector3((i % columns - columns / 2) * SPACING, 0.3f, (i / columns - columns / 2) * SPACING));
+                tanks.push_back(tank);
+            }
+
+            chrono::steady_clock::time_point start;
+            for (int step = 0; step < WARMUP_STEPS + STEPS; ++step)
+            {
+                if (step == WARMUP_STEPS)
+                    start = chrono::steady_clock::now();
+
+                for (auto& tank : tanks) {
+                    btVector3 force = tank->chasis->getWorldTransform().getBasis() * DRIVE_FORCE;
+                    tank->leftTrack->applyCentralForce(force);
+                    tank->rightTrack->applyCentralForce(force);
+                }
+                physicsSystem.stepSimulation(1.f / 60.f);
+            }
+            stepTime[articulated] = chrono::duration< double, milli >(chrono::steady_clock::now() - start).count() / STEPS;
+        }
+
+        std::cout << "Step of " << tankCount << " tanks: rigid bodies " << stepTime[0]
+            << " ms, multibodies " << stepTime[1] << " ms" << std::endl;
+    }
+}
+
+#endif
@@ -79,7 +79,7 @@ btPersistentManifold* btCollisionDispatcher::getNewManifold(const btCollisionObj
 	void* mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
 	if (NULL == mem)
 	{
-		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
+		//we got a pool memory overflow of a pool that cannot grow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
 		if ((m_dispatcherFlags & CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION) == 0)
 		{
 			mem = btAlignedAlloc(sizeof(btPersistentManifold), 16);
@@ -270,7 +270,7 @@ void* btCollisionDispatcher::allocateCollisionAlgorithm(int size)
 	void* mem = m_collisionAlgorithmPoolAllocator->allocate(size);
 	if (NULL == mem)
 	{
-		//warn user for overflow?
+		//the pool is full and cannot grow, see btPoolAllocator::getOverflowCount
 		return btAlignedAlloc(static_cast<size_t>(size), 16);
 	}
 	return mem;
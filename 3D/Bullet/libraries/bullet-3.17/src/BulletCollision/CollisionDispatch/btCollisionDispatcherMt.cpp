@@ -28,7 +28,8 @@ subject to the following restrictions:
 btCollisionDispatcherMt::btCollisionDispatcherMt(btCollisionConfiguration* config, int grainSize)
 	: btCollisionDispatcher(config)
 {
-	m_batchManifoldsPtr.resize(btGetTaskScheduler()->getNumThreads());
+	// indexed by btGetCurrentThreadIndex, which stays below BT_MAX_THREAD_COUNT whatever the scheduler is set to later
+	m_batchManifoldsPtr.resize(BT_MAX_THREAD_COUNT);
 	m_batchUpdating = false;
 	m_grainSize = grainSize;  // iterations per task
 }
@@ -100,6 +101,23 @@ void btCollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
 	}
 }
 
+static int btGetManifoldBodyUid(const btCollisionObject* body)
+{
+	return body->getBroadphaseHandle() ? body->getBroadphaseHandle()->m_uniqueId : -1;
+}
+
+class ManifoldSortKeyPredicate
+{
+public:
+	template <class T>
+	bool operator()(const T& a, const T& b) const
+	{
+		return a.m_uid0 < b.m_uid0 ||
+			   (a.m_uid0 == b.m_uid0 && a.m_uid1 < b.m_uid1) ||
+			   (a.m_uid0 == b.m_uid0 && a.m_uid1 == b.m_uid1 && a.m_index < b.m_index);
+	}
+};
+
 struct CollisionDispatcherUpdater : public btIParallelForBody
 {
 	btBroadphasePair* mPairArray;
@@ -142,6 +160,7 @@ void btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache*
 	m_batchUpdating = false;
 
 	// merge new manifolds, if any
+	const int firstNewManifold = m_manifoldsPtr.size();
 	for (int i = 0; i < m_batchManifoldsPtr.size(); ++i)
 	{
 		btAlignedObjectArray<btPersistentManifold*>& batchManifoldsPtr = m_batchManifoldsPtr[i];
@@ -154,6 +173,29 @@ void btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache*
 		batchManifoldsPtr.resizeNoInitialize(0);
 	}
 
+	if (info.m_deterministicOverlappingPairs && m_manifoldsPtr.size() - firstNewManifold > 1)
+	{
+		BT_PROFILE("sortNewManifolds");
+		// the threads made the manifolds in whatever order they got to the pairs. A pair is handled by one thread,
+		// so sorting on the bodies with the merged position as tie breaker gives the same order for any thread count
+		const int numNewManifolds = m_manifoldsPtr.size() - firstNewManifold;
+		m_sortKeys.resizeNoInitialize(numNewManifolds);
+		for (int i = 0; i < numNewManifolds; ++i)
+		{
+			btPersistentManifold* manifold = m_manifoldsPtr[firstNewManifold + i];
+			ManifoldSortKey& key = m_sortKeys[i];
+			key.m_uid0 = btGetManifoldBodyUid(manifold->getBody0());
+			key.m_uid1 = btGetManifoldBodyUid(manifold->getBody1());
+			key.m_index = i;
+			key.m_manifold = manifold;
+		}
+		m_sortKeys.quickSort(ManifoldSortKeyPredicate());
+		for (int i = 0; i < numNewManifolds; ++i)
+		{
+			m_manifoldsPtr[firstNewManifold + i] = m_sortKeys[i].m_manifold;
+		}
+	}
+
 	// update the indices (used when releasing manifolds)
 	for (int i = 0; i < m_manifoldsPtr.size(); ++i)
 	{
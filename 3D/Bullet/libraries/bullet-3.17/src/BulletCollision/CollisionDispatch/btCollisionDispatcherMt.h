@@ -27,10 +27,21 @@ public:
 	virtual btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) BT_OVERRIDE;
 	virtual void releaseManifold(btPersistentManifold* manifold) BT_OVERRIDE;
 
+	///with btDispatcherInfo::m_deterministicOverlappingPairs the manifolds made by the worker threads are sorted by the
+	///unique ids of their bodies before they are appended, so their order does not depend on the threads
 	virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& info, btDispatcher* dispatcher) BT_OVERRIDE;
 
 protected:
+	struct ManifoldSortKey
+	{
+		int m_uid0;
+		int m_uid1;
+		int m_index;  // position after the merge, keeps the manifolds of one pair in the order they were made
+		btPersistentManifold* m_manifold;
+	};
+
 	btAlignedObjectArray<btAlignedObjectArray<btPersistentManifold*> > m_batchManifoldsPtr;
+	btAlignedObjectArray<ManifoldSortKey> m_sortKeys;
 	bool m_batchUpdating;
 	int m_grainSize;
 };
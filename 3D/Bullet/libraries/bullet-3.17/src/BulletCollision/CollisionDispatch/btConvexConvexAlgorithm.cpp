@@ -539,7 +539,8 @@ void btConvexConvexAlgorithm ::processCollision(const btCollisionObjectWrapper*
 				//we can also deal with convex versus triangle (without connectivity data)
 				if (dispatchInfo.m_enableSatConvex && polyhedronA->getConvexPolyhedron() && polyhedronB->getShapeType() == TRIANGLE_SHAPE_PROXYTYPE)
 				{
-					btVertexArray worldSpaceVertices;
+					//the clipped triangle rarely has more than a few vertices, keep them off the heap
+					btSmallObjectArray<btVector3, 16> worldSpaceVertices;
 					btTriangleShape* tri = (btTriangleShape*)polyhedronB;
 					worldSpaceVertices.push_back(body1Wrap->getWorldTransform() * tri->m_vertices1[0]);
 					worldSpaceVertices.push_back(body1Wrap->getWorldTransform() * tri->m_vertices1[1]);
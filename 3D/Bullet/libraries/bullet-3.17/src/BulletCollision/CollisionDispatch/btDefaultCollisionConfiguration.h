@@ -28,6 +28,10 @@ struct btDefaultCollisionConstructionInfo
 	int m_defaultMaxCollisionAlgorithmPoolSize;
 	int m_customCollisionAlgorithmMaxElementSize;
 	int m_useEpaPenetrationAlgorithm;
+	///Off by default, the pools keep their fixed size and the dispatcher falls back to btAlignedAlloc for every element past
+	///it. When set, the default pools add slabs when they are full instead. The slabs are only freed with the configuration,
+	///so the memory of the pools stays at the peak number of pairs and manifolds, and a pool is no longer one block.
+	int m_growablePools;
 
 	btDefaultCollisionConstructionInfo()
 		: m_persistentManifoldPool(0),
@@ -35,7 +39,8 @@ struct btDefaultCollisionConstructionInfo
 		  m_defaultMaxPersistentManifoldPoolSize(4096),
 		  m_defaultMaxCollisionAlgorithmPoolSize(4096),
 		  m_customCollisionAlgorithmMaxElementSize(0),
-		  m_useEpaPenetrationAlgorithm(true)
+		  m_useEpaPenetrationAlgorithm(true),
+		  m_growablePools(false)
 	{
 	}
 };
@@ -28,7 +28,7 @@ btHashedSimplePairCache::btHashedSimplePairCache()
 {
 	int initialAllocatedSize = 2;
 	m_overlappingPairArray.reserve(initialAllocatedSize);
-	growTables();
+	m_indexTable.reserve(initialAllocatedSize);
 }
 
 btHashedSimplePairCache::~btHashedSimplePairCache()
@@ -38,12 +38,11 @@ btHashedSimplePairCache::~btHashedSimplePairCache()
 void btHashedSimplePairCache::removeAllPairs()
 {
 	m_overlappingPairArray.clear();
-	m_hashTable.clear();
-	m_next.clear();
+	m_indexTable.clear();
 
 	int initialAllocatedSize = 2;
 	m_overlappingPairArray.reserve(initialAllocatedSize);
-	growTables();
+	m_indexTable.reserve(initialAllocatedSize);
 }
 
 btSimplePair* btHashedSimplePairCache::findPair(int indexA, int indexB)
@@ -55,70 +54,12 @@ btSimplePair* btHashedSimplePairCache::findPair(int indexA, int indexB)
 	/*if (indexA > indexB) 
 		btSwap(indexA, indexB);*/
 
-	int hash = static_cast<int>(getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB)) & (m_overlappingPairArray.capacity() - 1));
-
-	if (hash >= m_hashTable.size())
-	{
-		return NULL;
-	}
-
-	int index = m_hashTable[hash];
-	while (index != BT_SIMPLE_NULL_PAIR && equalsPair(m_overlappingPairArray[index], indexA, indexB) == false)
-	{
-		index = m_next[index];
-	}
-
-	if (index == BT_SIMPLE_NULL_PAIR)
-	{
-		return NULL;
-	}
-
-	btAssert(index < m_overlappingPairArray.size());
-
-	return &m_overlappingPairArray[index];
-}
-
-//#include <stdio.h>
-
-void btHashedSimplePairCache::growTables()
-{
-	int newCapacity = m_overlappingPairArray.capacity();
-
-	if (m_hashTable.size() < newCapacity)
-	{
-		//grow hashtable and next table
-		int curHashtableSize = m_hashTable.size();
-
-		m_hashTable.resize(newCapacity);
-		m_next.resize(newCapacity);
-
-		int i;
-
-		for (i = 0; i < newCapacity; ++i)
-		{
-			m_hashTable[i] = BT_SIMPLE_NULL_PAIR;
-		}
-		for (i = 0; i < newCapacity; ++i)
-		{
-			m_next[i] = BT_SIMPLE_NULL_PAIR;
-		}
-
-		for (i = 0; i < curHashtableSize; i++)
-		{
-			const btSimplePair& pair = m_overlappingPairArray[i];
-			int indexA = pair.m_indexA;
-			int indexB = pair.m_indexB;
-
-			int hashValue = static_cast<int>(getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB)) & (m_overlappingPairArray.capacity() - 1));  // New hash value with new mask
-			m_next[i] = m_hashTable[hashValue];
-			m_hashTable[hashValue] = i;
-		}
-	}
+	return internalFindPair(indexA, indexB, getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB)));
 }
 
 btSimplePair* btHashedSimplePairCache::internalAddPair(int indexA, int indexB)
 {
-	int hash = static_cast<int>(getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB)) & (m_overlappingPairArray.capacity() - 1));  // New hash value with new mask
+	unsigned int hash = getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB));
 
 	btSimplePair* pair = internalFindPair(indexA, indexB, hash);
 	if (pair != NULL)
@@ -127,24 +68,13 @@ btSimplePair* btHashedSimplePairCache::internalAddPair(int indexA, int indexB)
 	}
 
 	int count = m_overlappingPairArray.size();
-	int oldCapacity = m_overlappingPairArray.capacity();
 	void* mem = &m_overlappingPairArray.expandNonInitializing();
 
-	int newCapacity = m_overlappingPairArray.capacity();
-
-	if (oldCapacity < newCapacity)
-	{
-		growTables();
-		//hash with new capacity
-		hash = static_cast<int>(getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB)) & (m_overlappingPairArray.capacity() - 1));
-	}
-
 	pair = new (mem) btSimplePair(indexA, indexB);
 
 	pair->m_userPointer = 0;
 
-	m_next[count] = m_hashTable[hash];
-	m_hashTable[hash] = count;
+	m_indexTable.insert(hash, count);
 
 	return pair;
 }
@@ -158,7 +88,7 @@ void* btHashedSimplePairCache::removeOverlappingPair(int indexA, int indexB)
 	/*if (indexA > indexB) 
 		btSwap(indexA, indexB);*/
 
-	int hash = static_cast<int>(getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB)) & (m_overlappingPairArray.capacity() - 1));
+	unsigned int hash = getHash(static_cast<unsigned int>(indexA), static_cast<unsigned int>(indexB));
 
 	btSimplePair* pair = internalFindPair(indexA, indexB, hash);
 	if (pair == NULL)
@@ -172,29 +102,10 @@ void* btHashedSimplePairCache::removeOverlappingPair(int indexA, int indexB)
 	btAssert(pairIndex < m_overlappingPairArray.size());
 
 	// Remove the pair from the hash table.
-	int index = m_hashTable[hash];
-	btAssert(index != BT_SIMPLE_NULL_PAIR);
-
-	int previous = BT_SIMPLE_NULL_PAIR;
-	while (index != pairIndex)
-	{
-		previous = index;
-		index = m_next[index];
-	}
-
-	if (previous != BT_SIMPLE_NULL_PAIR)
-	{
-		btAssert(m_next[previous] == pairIndex);
-		m_next[previous] = m_next[pairIndex];
-	}
-	else
-	{
-		m_hashTable[hash] = m_next[pairIndex];
-	}
+	m_indexTable.remove(hash, pairIndex);
 
 	// We now move the last pair into spot of the
-	// pair being removed. We need to fix the hash
-	// table indices to support the move.
+	// pair being removed, and point its table entry there.
 
 	int lastPairIndex = m_overlappingPairArray.size() - 1;
 
@@ -205,40 +116,77 @@ void* btHashedSimplePairCache::removeOverlappingPair(int indexA, int indexB)
 		return userData;
 	}
 
-	// Remove the last pair from the hash table.
 	const btSimplePair* last = &m_overlappingPairArray[lastPairIndex];
 	/* missing swap here too, Nat. */
-	int lastHash = static_cast<int>(getHash(static_cast<unsigned int>(last->m_indexA), static_cast<unsigned int>(last->m_indexB)) & (m_overlappingPairArray.capacity() - 1));
+	unsigned int lastHash = getHash(static_cast<unsigned int>(last->m_indexA), static_cast<unsigned int>(last->m_indexB));
+	m_indexTable.replaceIndex(lastHash, lastPairIndex, pairIndex);
 
-	index = m_hashTable[lastHash];
-	btAssert(index != BT_SIMPLE_NULL_PAIR);
+	// Copy the last pair into the remove pair's spot.
+	m_overlappingPairArray[pairIndex] = m_overlappingPairArray[lastPairIndex];
 
-	previous = BT_SIMPLE_NULL_PAIR;
-	while (index != lastPairIndex)
-	{
-		previous = index;
-		index = m_next[index];
-	}
+	m_overlappingPairArray.pop_back();
 
-	if (previous != BT_SIMPLE_NULL_PAIR)
-	{
-		btAssert(m_next[previous] == lastPairIndex);
-		m_next[previous] = m_next[lastPairIndex];
-	}
-	else
+	return userData;
+}
+
+#if BT_HASHED_SIMPLE_PAIR_CACHE_ENABLE_BENCHMARK
+
+#include "LinearMath/btQuickprof.h"
+
+///Times the queries of a simple pair cache holding 1000 to 64000 pairs, half of them hits and half misses, and the
+///lookups of pointer keys in a btHashMap<btHashPtr, int> the size of the pointer table of a serialized world.
+void btHashedSimplePairCache::benchmark()
+{
+	const int queries = 1 << 20;
+	btClock clock;
+	long checksum = 0;
+
+	printf("%8s %12s %12s %12s %12s  (ns per operation)\n", "entries", "pair add", "pair find", "pair remove", "ptr find");
+	for (int count = 1000; count <= 64000; count *= 4)
 	{
-		m_hashTable[lastHash] = m_next[lastPairIndex];
-	}
+		btHashedSimplePairCache cache;
+		clock.reset();
+		for (int i = 0; i < count; i++)
+		{
+			cache.addOverlappingPair(i % 1024, i / 1024 + 1024);
+		}
+		double addTime = double(clock.getTimeNanoseconds()) / count;
 
-	// Copy the last pair into the remove pair's spot.
-	m_overlappingPairArray[pairIndex] = m_overlappingPairArray[lastPairIndex];
+		clock.reset();
+		for (int q = 0; q < queries; q++)
+		{
+			//odd queries ask for pairs that are not in the cache
+			int i = int((unsigned(q) * 7919u) % unsigned(count));
+			btSimplePair* pair = cache.findPair(i % 1024, i / 1024 + 1024 + (q & 1) * 4096);
+			checksum += pair ? pair->m_indexA : -1;
+		}
+		double findTime = double(clock.getTimeNanoseconds()) / queries;
 
-	// Insert the last pair into the hash table
-	m_next[pairIndex] = m_hashTable[lastHash];
-	m_hashTable[lastHash] = pairIndex;
+		btHashMap<btHashPtr, int> pointers;
+		btAlignedObjectArray<int> storage;
+		storage.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			pointers.insert(&storage[i], i);
+		}
+		clock.reset();
+		for (int q = 0; q < queries; q++)
+		{
+			const int* value = pointers.find(&storage[(unsigned(q) * 7919u) % unsigned(count)]);
+			checksum += value ? *value : -1;
+		}
+		double pointerTime = double(clock.getTimeNanoseconds()) / queries;
 
-	m_overlappingPairArray.pop_back();
+		clock.reset();
+		for (int i = 0; i < count; i++)
+		{
+			cache.removeOverlappingPair(i % 1024, i / 1024 + 1024);
+		}
+		double removeTime = double(clock.getTimeNanoseconds()) / count;
 
-	return userData;
+		printf("%8d %12.2f %12.2f %12.2f %12.2f\n", count, addTime, findTime, removeTime, pointerTime);
+	}
+	printf("checksum %ld\n", checksum);
 }
-//#include <stdio.h>
+
+#endif  //BT_HASHED_SIMPLE_PAIR_CACHE_ENABLE_BENCHMARK
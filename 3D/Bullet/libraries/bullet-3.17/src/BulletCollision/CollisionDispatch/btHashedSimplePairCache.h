@@ -17,6 +17,12 @@ subject to the following restrictions:
 #define BT_HASHED_SIMPLE_PAIR_CACHE_H
 
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btHashMap.h"
+
+// Enable the benchmark of pair and pointer lookups
+#ifndef BT_HASHED_SIMPLE_PAIR_CACHE_ENABLE_BENCHMARK
+#define BT_HASHED_SIMPLE_PAIR_CACHE_ENABLE_BENCHMARK 0
+#endif
 
 const int BT_SIMPLE_NULL_PAIR = 0xffffffff;
 
@@ -46,13 +52,13 @@ extern int gAddedSimplePairs;
 extern int gFindSimplePairs;
 #endif  //BT_DEBUG_COLLISION_PAIRS
 
+///btHashedSimplePairCache keeps the pairs in a dense array and finds them through an open addressing btHashIndexTable
 class btHashedSimplePairCache
 {
 	btSimplePairArray m_overlappingPairArray;
 
 protected:
-	btAlignedObjectArray<int> m_hashTable;
-	btAlignedObjectArray<int> m_next;
+	btHashIndexTable m_indexTable;
 
 public:
 	btHashedSimplePairCache();
@@ -102,15 +108,35 @@ public:
 		return m_overlappingPairArray.size();
 	}
 
+#if BT_HASHED_SIMPLE_PAIR_CACHE_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
+
 private:
-	btSimplePair* internalAddPair(int indexA, int indexB);
+	struct PairEquals
+	{
+		const btSimplePairArray& m_pairs;
+		int m_indexA;
+		int m_indexB;
+
+		PairEquals(const btSimplePairArray& pairs, int indexA, int indexB)
+			: m_pairs(pairs),
+			  m_indexA(indexA),
+			  m_indexB(indexB)
+		{
+		}
 
-	void growTables();
+		bool operator()(int index) const
+		{
+			return m_pairs[index].m_indexA == m_indexA && m_pairs[index].m_indexB == m_indexB;
+		}
+	};
 
-	SIMD_FORCE_INLINE bool equalsPair(const btSimplePair& pair, int indexA, int indexB)
-	{
-		return pair.m_indexA == indexA && pair.m_indexB == indexB;
-	}
+	btSimplePair* internalAddPair(int indexA, int indexB);
 
 	SIMD_FORCE_INLINE unsigned int getHash(unsigned int indexA, unsigned int indexB)
 	{
@@ -126,14 +152,9 @@ private:
 		return key;
 	}
 
-	SIMD_FORCE_INLINE btSimplePair* internalFindPair(int proxyIdA, int proxyIdB, int hash)
+	SIMD_FORCE_INLINE btSimplePair* internalFindPair(int proxyIdA, int proxyIdB, unsigned int hash)
 	{
-		int index = m_hashTable[hash];
-
-		while (index != BT_SIMPLE_NULL_PAIR && equalsPair(m_overlappingPairArray[index], proxyIdA, proxyIdB) == false)
-		{
-			index = m_next[index];
-		}
+		int index = m_indexTable.findIndex(hash, PairEquals(m_overlappingPairArray, proxyIdA, proxyIdB));
 
 		if (index == BT_SIMPLE_NULL_PAIR)
 		{
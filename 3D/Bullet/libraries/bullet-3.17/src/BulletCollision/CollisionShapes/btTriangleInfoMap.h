@@ -59,6 +59,10 @@ struct btTriangleInfoMap : public btInternalTriangleInfoMap
 	btScalar m_maxEdgeAngleThreshold;  //ignore edges that connect triangles at an angle larger than this m_maxEdgeAngleThreshold
 	btScalar m_zeroAreaThreshold;      ///used to determine if a triangle is degenerate (length squared of cross product of 2 triangle edges < threshold)
 
+	///the serialized format keeps the separate chaining tables of the earlier btHashMap, serialize() builds them here
+	mutable btAlignedObjectArray<int> m_serializedHashTable;
+	mutable btAlignedObjectArray<int> m_serializedNext;
+
 	btTriangleInfoMap()
 	{
 		m_convexEpsilon = 0.00f;
@@ -126,9 +130,11 @@ SIMD_FORCE_INLINE const char* btTriangleInfoMap::serialize(void* dataBuffer, btS
 	tmapData->m_edgeDistanceThreshold = (float)m_edgeDistanceThreshold;
 	tmapData->m_zeroAreaThreshold = (float)m_zeroAreaThreshold;
 
-	tmapData->m_hashTableSize = m_hashTable.size();
+	buildChainedTables(m_serializedHashTable, m_serializedNext);
+
+	tmapData->m_hashTableSize = m_serializedHashTable.size();
 
-	tmapData->m_hashTablePtr = tmapData->m_hashTableSize ? (int*)serializer->getUniquePointer((void*)&m_hashTable[0]) : 0;
+	tmapData->m_hashTablePtr = tmapData->m_hashTableSize ? (int*)serializer->getUniquePointer((void*)&m_serializedHashTable[0]) : 0;
 	if (tmapData->m_hashTablePtr)
 	{
 		//serialize an int buffer
@@ -138,13 +144,13 @@ SIMD_FORCE_INLINE const char* btTriangleInfoMap::serialize(void* dataBuffer, btS
 		int* memPtr = (int*)chunk->m_oldPtr;
 		for (int i = 0; i < numElem; i++, memPtr++)
 		{
-			*memPtr = m_hashTable[i];
+			*memPtr = m_serializedHashTable[i];
 		}
-		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_hashTable[0]);
+		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_serializedHashTable[0]);
 	}
 
-	tmapData->m_nextSize = m_next.size();
-	tmapData->m_nextPtr = tmapData->m_nextSize ? (int*)serializer->getUniquePointer((void*)&m_next[0]) : 0;
+	tmapData->m_nextSize = m_serializedNext.size();
+	tmapData->m_nextPtr = tmapData->m_nextSize ? (int*)serializer->getUniquePointer((void*)&m_serializedNext[0]) : 0;
 	if (tmapData->m_nextPtr)
 	{
 		int sz = sizeof(int);
@@ -153,9 +159,9 @@ SIMD_FORCE_INLINE const char* btTriangleInfoMap::serialize(void* dataBuffer, btS
 		int* memPtr = (int*)chunk->m_oldPtr;
 		for (int i = 0; i < numElem; i++, memPtr++)
 		{
-			*memPtr = m_next[i];
+			*memPtr = m_serializedNext[i];
 		}
-		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_next[0]);
+		serializer->finalizeChunk(chunk, "int", BT_ARRAY_CODE, (void*)&m_serializedNext[0]);
 	}
 
 	tmapData->m_numValues = m_valueArray.size();
@@ -208,17 +214,7 @@ SIMD_FORCE_INLINE void btTriangleInfoMap::deSerialize(btTriangleInfoMapData& tma
 	m_equalVertexThreshold = tmapData.m_equalVertexThreshold;
 	m_edgeDistanceThreshold = tmapData.m_edgeDistanceThreshold;
 	m_zeroAreaThreshold = tmapData.m_zeroAreaThreshold;
-	m_hashTable.resize(tmapData.m_hashTableSize);
 	int i = 0;
-	for (i = 0; i < tmapData.m_hashTableSize; i++)
-	{
-		m_hashTable[i] = tmapData.m_hashTablePtr[i];
-	}
-	m_next.resize(tmapData.m_nextSize);
-	for (i = 0; i < tmapData.m_nextSize; i++)
-	{
-		m_next[i] = tmapData.m_nextPtr[i];
-	}
 	m_valueArray.resize(tmapData.m_numValues);
 	for (i = 0; i < tmapData.m_numValues; i++)
 	{
@@ -233,6 +229,8 @@ SIMD_FORCE_INLINE void btTriangleInfoMap::deSerialize(btTriangleInfoMapData& tma
 	{
 		m_keyArray[i].setUid1(tmapData.m_keyArrayPtr[i]);
 	}
+	//the stored chaining tables are not needed, the lookups go through the index table
+	rebuildIndexTable();
 }
 
 #endif  //_BT_TRIANGLE_INFO_MAP_H
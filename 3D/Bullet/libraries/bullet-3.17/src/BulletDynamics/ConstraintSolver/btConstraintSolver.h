@@ -27,6 +27,7 @@ struct btBroadphaseProxy;
 class btIDebugDraw;
 class btStackAlloc;
 class btDispatcher;
+struct btSolverAnalyticsData;
 /// btConstraintSolver provides solver interface
 
 enum btConstraintSolverType
@@ -36,6 +37,7 @@ enum btConstraintSolverType
 	BT_NNCG_SOLVER = 4,
 	BT_MULTIBODY_SOLVER = 8,
 	BT_BLOCK_SOLVER = 16,
+	BT_TGS_SOLVER = 32,
 };
 
 class btConstraintSolver
@@ -54,6 +56,13 @@ public:
 	virtual void reset() = 0;
 
 	virtual btConstraintSolverType getSolverType() const = 0;
+
+	///statistics of the last solveGroup, or 0 if the solver does not record them. btSequentialImpulseConstraintSolver
+	///and the solvers derived from it do, whatever getSolverType they report
+	virtual const btSolverAnalyticsData* getAnalyticsData() const
+	{
+		return 0;
+	}
 };
 
 #endif  //BT_CONSTRAINT_SOLVER_H
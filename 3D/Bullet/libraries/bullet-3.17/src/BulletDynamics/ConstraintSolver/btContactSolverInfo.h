@@ -32,6 +32,17 @@ enum btSolverMode
 	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024,
 	SOLVER_DISABLE_IMPLICIT_CONE_FRICTION = 2048,
 	SOLVER_USE_ARTICULATED_WARMSTARTING = 4096,
+	///solve contact and friction rows 8 at a time with AVX2 (see btSolverRowBatches). Ignored without AVX2, with
+	///SOLVER_RANDMIZE_ORDER or SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS.
+	SOLVER_BATCHED_ROWS = 8192,
+	///solve every island on its own and stop it once its residual drops below m_leastSquaresResidualThreshold.
+	///The iterations an island saves are lent to the islands solved after it in the same step, up to m_maxIslandIterations.
+	///btDiscreteDynamicsWorld solves the smallest islands first, so the leftover goes to the large stacks and joint chains.
+	SOLVER_ADAPTIVE_ISLAND_ITERATIONS = 16384,
+	///make the multithreaded pipeline (btDiscreteDynamicsWorldMt) independent of the number of threads and their timing:
+	///islands do not share solver state and the residuals of parallel batches are added in batch order.
+	///Islands then cannot lend each other iterations with SOLVER_ADAPTIVE_ISLAND_ITERATIONS.
+	SOLVER_DETERMINISTIC = 32768,
 };
 
 struct btContactSolverInfoData
@@ -70,6 +81,7 @@ struct btContactSolverInfoData
 	bool m_jointFeedbackInJointFrame;
 	int m_reportSolverAnalytics;
 	int m_numNonContactInnerIterations;
+	int m_maxIslandIterations;  //with SOLVER_ADAPTIVE_ISLAND_ITERATIONS, iterations an island may use when others left some over
 };
 
 struct btContactSolverInfo : public btContactSolverInfoData
@@ -110,6 +122,7 @@ struct btContactSolverInfo : public btContactSolverInfoData
 		m_jointFeedbackInJointFrame = false;
 		m_reportSolverAnalytics = 0;
 		m_numNonContactInnerIterations = 1;   // the number of inner iterations for solving motor constraint in a single iteration of the constraint solve
+		m_maxIslandIterations = 40;
 	}
 };
 
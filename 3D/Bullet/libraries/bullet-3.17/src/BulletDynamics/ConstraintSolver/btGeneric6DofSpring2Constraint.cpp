@@ -615,6 +615,94 @@ int btGeneric6DofSpring2Constraint::setAngularLimits(btConstraintInfo2* info, in
 	return row;
 }
 
+bool btGeneric6DofSpring2Constraint::isLocked() const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (m_linearLimits.m_currentLimit[i] != 3 || m_linearLimits.m_enableMotor[i] || m_linearLimits.m_enableSpring[i])
+			return false;
+		if (m_angularLimits[i].m_currentLimit != 3 || m_angularLimits[i].m_enableMotor || m_angularLimits[i].m_enableSpring)
+			return false;
+	}
+	return true;
+}
+
+static bool btLockedAxisViolated(const btRotationalLimitMotor2& limot)
+{
+	return limot.m_currentLimitError < -D6_LIMIT_ERROR_THRESHOLD_FOR_ROTATION || limot.m_currentLimitError > D6_LIMIT_ERROR_THRESHOLD_FOR_ROTATION;
+}
+
+void btGeneric6DofSpring2Constraint::getInfo2Locked(btConstraintInfo2* info)
+{
+	btAssert(isLocked());
+	//order of the rotational rows, see setAngularLimits
+	static const int rotateOrderAxes[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+	const int* cIdx = rotateOrderAxes[m_rotateOrder];
+	const btTransform& transA = m_rbA.getCenterOfMassTransform();
+	const btTransform& transB = m_rbB.getCenterOfMassTransform();
+	int srow = 0;
+	int j;
+
+	// for stability better to solve angular limits first
+	for (int ii = 0; ii < 3; ii++)
+	{
+		int i = cIdx[ii];
+		btRotationalLimitMotor2& limot = m_angularLimits[i];
+		int flags = m_flags >> ((i + 3) * BT_6DOF_FLAGS_AXIS_SHIFT2);
+		if (!(flags & BT_6DOF_FLAGS_CFM_STOP2))
+		{
+			limot.m_stopCFM = info->cfm[0];
+		}
+		if (!(flags & BT_6DOF_FLAGS_ERP_STOP2))
+		{
+			limot.m_stopERP = info->erp;
+		}
+		if (!(flags & BT_6DOF_FLAGS_CFM_MOTO2))
+		{
+			limot.m_motorCFM = info->cfm[0];
+		}
+		if (!(flags & BT_6DOF_FLAGS_ERP_MOTO2))
+		{
+			limot.m_motorERP = info->erp;
+		}
+		const btVector3& axis = m_calculatedAxis[i];
+		for (j = 0; j < 3; j++) info->m_J1angularAxis[srow + j] = axis[j];
+		for (j = 0; j < 3; j++) info->m_J2angularAxis[srow + j] = -axis[j];
+		info->m_constraintError[srow] = info->fps * limot.m_stopERP * limot.m_currentLimitError * btScalar(-1);
+		info->m_lowerLimit[srow] = -SIMD_INFINITY;
+		info->m_upperLimit[srow] = SIMD_INFINITY;
+		info->cfm[srow] = limot.m_stopCFM;
+		srow += info->rowskip;
+	}
+
+	const btVector3 relA = m_calculatedTransformA.getOrigin() - transA.getOrigin();
+	const btVector3 relB = m_calculatedTransformB.getOrigin() - transB.getOrigin();
+	for (int i = 0; i < 3; i++)
+	{
+		int flags = m_flags >> (i * BT_6DOF_FLAGS_AXIS_SHIFT2);
+		btScalar stopCFM = (flags & BT_6DOF_FLAGS_CFM_STOP2) ? m_linearLimits.m_stopCFM[i] : info->cfm[0];
+		btScalar stopERP = (flags & BT_6DOF_FLAGS_ERP_STOP2) ? m_linearLimits.m_stopERP[i] : info->erp;
+		btVector3 axis = m_calculatedTransformA.getBasis().getColumn(i);
+		btVector3 tmpA = relA.cross(axis);
+		btVector3 tmpB = relB.cross(axis);
+		//see rotAllowed in setLinearLimits
+		if (m_hasStaticBody && btLockedAxisViolated(m_angularLimits[(i + 1) % 3]) && btLockedAxisViolated(m_angularLimits[(i + 2) % 3]))
+		{
+			tmpA *= m_factA;
+			tmpB *= m_factB;
+		}
+		for (j = 0; j < 3; j++) info->m_J1linearAxis[srow + j] = axis[j];
+		for (j = 0; j < 3; j++) info->m_J2linearAxis[srow + j] = -axis[j];
+		for (j = 0; j < 3; j++) info->m_J1angularAxis[srow + j] = tmpA[j];
+		for (j = 0; j < 3; j++) info->m_J2angularAxis[srow + j] = -tmpB[j];
+		info->m_constraintError[srow] = info->fps * stopERP * m_linearLimits.m_currentLimitError[i];
+		info->m_lowerLimit[srow] = -SIMD_INFINITY;
+		info->m_upperLimit[srow] = SIMD_INFINITY;
+		info->cfm[srow] = stopCFM;
+		srow += info->rowskip;
+	}
+}
+
 void btGeneric6DofSpring2Constraint::setFrames(const btTransform& frameA, const btTransform& frameB)
 {
 	m_frameInA = frameA;
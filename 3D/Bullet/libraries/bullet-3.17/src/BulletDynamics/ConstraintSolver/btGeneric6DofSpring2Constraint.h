@@ -322,6 +322,10 @@ public:
 	virtual void buildJacobian() {}
 	virtual void getInfo1(btConstraintInfo1 * info);
 	virtual void getInfo2(btConstraintInfo2 * info);
+	///true when getInfo1 found every axis locked without a motor or a spring, as btFixedConstraint sets it up
+	bool isLocked() const;
+	///the rows of getInfo2 for a constraint that isLocked(), without going through the limit, motor and spring cases
+	void getInfo2Locked(btConstraintInfo2 * info);
 	virtual int calculateSerializeBufferSize() const;
 	virtual const char* serialize(void* dataBuffer, btSerializer* serializer) const;
 
@@ -29,6 +29,9 @@ subject to the following restrictions:
 //#include "btJacobianEntry.h"
 #include "LinearMath/btMinMax.h"
 #include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
+#include "BulletDynamics/ConstraintSolver/btHingeConstraint.h"
+#include "BulletDynamics/ConstraintSolver/btGeneric6DofSpring2Constraint.h"
+#include "BulletDynamics/ConstraintSolver/btFixedConstraint.h"
 #include <new>
 #include "LinearMath/btStackAlloc.h"
 #include "LinearMath/btQuickprof.h"
@@ -111,7 +114,14 @@ static inline __m128 btSimdDot3(__m128 vec0, __m128 vec1)
 }
 
 #if defined(BT_ALLOW_SSE4)
+#ifdef _MSC_VER
 #include <intrin.h>
+#define BT_TARGET_SSE4_1_FMA3
+#else
+//GCC and Clang only accept the FMA intrinsics in functions built for FMA; they are only called when btCpuFeatureUtility finds it
+#include <immintrin.h>
+#define BT_TARGET_SSE4_1_FMA3 __attribute__((target("sse4.1,fma")))
+#endif
 
 #define USE_FMA 1
 #define USE_FMA3_INSTEAD_FMA4 1
@@ -178,6 +188,9 @@ static btScalar gResolveSingleConstraintRowGeneric_sse2(btSolverBody& bodyA, btS
 }
 
 // Enhanced version of gResolveSingleConstraintRowGeneric_sse2 with SSE4.1 and FMA3
+#if defined(BT_ALLOW_SSE4)
+BT_TARGET_SSE4_1_FMA3
+#endif
 static btScalar gResolveSingleConstraintRowGeneric_sse4_1_fma3(btSolverBody& bodyA, btSolverBody& bodyB, const btSolverConstraint& c)
 {
 #if defined(BT_ALLOW_SSE4)
@@ -233,6 +246,9 @@ static btScalar gResolveSingleConstraintRowLowerLimit_sse2(btSolverBody& bodyA,
 }
 
 // Enhanced version of gResolveSingleConstraintRowGeneric_sse2 with SSE4.1 and FMA3
+#ifdef BT_ALLOW_SSE4
+BT_TARGET_SSE4_1_FMA3
+#endif
 static btScalar gResolveSingleConstraintRowLowerLimit_sse4_1_fma3(btSolverBody& bodyA, btSolverBody& bodyB, const btSolverConstraint& c)
 {
 #ifdef BT_ALLOW_SSE4
@@ -354,6 +370,7 @@ btSequentialImpulseConstraintSolver::btSequentialImpulseConstraintSolver()
 {
 	m_btSeed2 = 0;
 	m_cachedSolverMode = 0;
+	m_iterationCredit = 0;
 	setupSolverFunctions(false);
 }
 
@@ -1159,12 +1176,107 @@ void btSequentialImpulseConstraintSolver::convertContacts(btPersistentManifold**
 	}
 }
 
+#if defined(__GXX_RTTI) || defined(_CPPRTTI) || defined(__cpp_rtti)
+#define BT_USE_SPECIALIZED_ROW_BUILDERS
+#include <typeinfo>
+#endif
+
+enum btConstraintRowBuilder
+{
+	BT_GENERIC_ROW_BUILDER = 0,
+	BT_HINGE_ROW_BUILDER,
+	BT_6DOF_SPRING2_ROW_BUILDER
+};
+
+///the hinge and 6dof spring2 row builders call getInfo1 and getInfo2 without the virtual dispatch, so they are only
+///used for the objects of exactly these classes: a derived class may override getInfo1 or getInfo2, like
+///btHingeAccumulatedAngleConstraint does. btFixedConstraint only adds a constructor. The class is found with RTTI;
+///without it every joint goes through the virtual calls of the generic builder.
+static btConstraintRowBuilder btGetRowBuilder(const btTypedConstraint* constraint)
+{
+#ifdef BT_USE_SPECIALIZED_ROW_BUILDERS
+	switch (constraint->getConstraintType())
+	{
+		case HINGE_CONSTRAINT_TYPE:
+			if (typeid(*constraint) == typeid(btHingeConstraint))
+				return BT_HINGE_ROW_BUILDER;
+			break;
+		case D6_SPRING_2_CONSTRAINT_TYPE:
+			if (typeid(*constraint) == typeid(btGeneric6DofSpring2Constraint) || typeid(*constraint) == typeid(btFixedConstraint))
+				return BT_6DOF_SPRING2_ROW_BUILDER;
+			break;
+		default:
+			break;
+	}
+#else
+	(void)constraint;
+#endif
+	return BT_GENERIC_ROW_BUILDER;
+}
+
+///row builders for convertJointRows, picked by btGetRowBuilder
+struct btGenericJointRows
+{
+	static void getInfo1(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo1* info)
+	{
+		constraint->getInfo1(info);
+	}
+	static void getInfo2(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo2* info)
+	{
+		constraint->getInfo2(info);
+	}
+};
+
+struct btHingeJointRows
+{
+	static void getInfo1(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo1* info)
+	{
+		static_cast<btHingeConstraint*>(constraint)->btHingeConstraint::getInfo1(info);
+	}
+	static void getInfo2(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo2* info)
+	{
+		static_cast<btHingeConstraint*>(constraint)->btHingeConstraint::getInfo2(info);
+	}
+};
+
+struct btSpring2JointRows
+{
+	static void getInfo1(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo1* info)
+	{
+		static_cast<btGeneric6DofSpring2Constraint*>(constraint)->btGeneric6DofSpring2Constraint::getInfo1(info);
+	}
+	static void getInfo2(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo2* info)
+	{
+		static_cast<btGeneric6DofSpring2Constraint*>(constraint)->btGeneric6DofSpring2Constraint::getInfo2(info);
+	}
+};
+
+///btGeneric6DofSpring2Constraint::isLocked after getInfo1
+struct btLockedSpring2JointRows
+{
+	static void getInfo2(btTypedConstraint* constraint, btTypedConstraint::btConstraintInfo2* info)
+	{
+		static_cast<btGeneric6DofSpring2Constraint*>(constraint)->getInfo2Locked(info);
+	}
+};
+
 void btSequentialImpulseConstraintSolver::convertJoint(btSolverConstraint* currentConstraintRow,
 	btTypedConstraint* constraint,
 	const btTypedConstraint::btConstraintInfo1& info1,
 	int solverBodyIdA,
 	int solverBodyIdB,
 	const btContactSolverInfo& infoGlobal)
+{
+	convertJointRows<btGenericJointRows>(currentConstraintRow, constraint, info1, solverBodyIdA, solverBodyIdB, infoGlobal);
+}
+
+template <class JointRows>
+void btSequentialImpulseConstraintSolver::convertJointRows(btSolverConstraint* currentConstraintRow,
+	btTypedConstraint* constraint,
+	const btTypedConstraint::btConstraintInfo1& info1,
+	int solverBodyIdA,
+	int solverBodyIdB,
+	const btContactSolverInfo& infoGlobal)
 {
 	const btRigidBody& rbA = constraint->getRigidBodyA();
 	const btRigidBody& rbB = constraint->getRigidBodyB();
@@ -1175,6 +1287,11 @@ void btSequentialImpulseConstraintSolver::convertJoint(btSolverConstraint* curre
 	int overrideNumSolverIterations = constraint->getOverrideNumSolverIterations() > 0 ? constraint->getOverrideNumSolverIterations() : infoGlobal.m_numIterations;
 	if (overrideNumSolverIterations > m_maxOverrideNumSolverIterations)
 		m_maxOverrideNumSolverIterations = overrideNumSolverIterations;
+	if ((infoGlobal.m_solverMode & SOLVER_ADAPTIVE_ISLAND_ITERATIONS) && constraint->getOverrideNumSolverIterations() <= 0)
+	{
+		//joints without their own count keep iterating with the contacts when the island borrows iterations
+		overrideNumSolverIterations = btMax(overrideNumSolverIterations, infoGlobal.m_maxIslandIterations);
+	}
 
 	for (int j = 0; j < info1.m_numConstraintRows; j++)
 	{
@@ -1223,39 +1340,50 @@ void btSequentialImpulseConstraintSolver::convertJoint(btSolverConstraint* curre
 	info2.m_lowerLimit = &currentConstraintRow->m_lowerLimit;
 	info2.m_upperLimit = &currentConstraintRow->m_upperLimit;
 	info2.m_numIterations = infoGlobal.m_numIterations;
-	constraint->getInfo2(&info2);
+	JointRows::getInfo2(constraint, &info2);
 
 	///finalize the constraint setup
+	//the same for all rows of the joint
+	const btScalar breakingImpulseThreshold = constraint->getBreakingImpulseThreshold();
+	const btMatrix3x3& invInertiaA = rbA.getInvInertiaTensorWorld();
+	const btMatrix3x3& invInertiaB = rbB.getInvInertiaTensorWorld();
+	const btVector3& angularFactorA = rbA.getAngularFactor();
+	const btVector3& angularFactorB = rbB.getAngularFactor();
+	const btScalar invMassA = rbA.getInvMass();
+	const btScalar invMassB = rbB.getInvMass();
+	btVector3 externalForceImpulseA = bodyAPtr->m_originalBody ? bodyAPtr->m_externalForceImpulse : btVector3(0, 0, 0);
+	btVector3 externalTorqueImpulseA = bodyAPtr->m_originalBody ? bodyAPtr->m_externalTorqueImpulse : btVector3(0, 0, 0);
+	btVector3 externalForceImpulseB = bodyBPtr->m_originalBody ? bodyBPtr->m_externalForceImpulse : btVector3(0, 0, 0);
+	btVector3 externalTorqueImpulseB = bodyBPtr->m_originalBody ? bodyBPtr->m_externalTorqueImpulse : btVector3(0, 0, 0);
+	const btVector3 linVelA = rbA.getLinearVelocity() + externalForceImpulseA;
+	const btVector3 angVelA = rbA.getAngularVelocity() + externalTorqueImpulseA;
+	const btVector3 linVelB = rbB.getLinearVelocity() + externalForceImpulseB;
+	const btVector3 angVelB = rbB.getAngularVelocity() + externalTorqueImpulseB;
+
 	for (int j = 0; j < info1.m_numConstraintRows; j++)
 	{
 		btSolverConstraint& solverConstraint = currentConstraintRow[j];
 
-		if (solverConstraint.m_upperLimit >= constraint->getBreakingImpulseThreshold())
+		if (solverConstraint.m_upperLimit >= breakingImpulseThreshold)
 		{
-			solverConstraint.m_upperLimit = constraint->getBreakingImpulseThreshold();
+			solverConstraint.m_upperLimit = breakingImpulseThreshold;
 		}
 
-		if (solverConstraint.m_lowerLimit <= -constraint->getBreakingImpulseThreshold())
+		if (solverConstraint.m_lowerLimit <= -breakingImpulseThreshold)
 		{
-			solverConstraint.m_lowerLimit = -constraint->getBreakingImpulseThreshold();
+			solverConstraint.m_lowerLimit = -breakingImpulseThreshold;
 		}
 
 		solverConstraint.m_originalContactPoint = constraint;
 
-		{
-			const btVector3& ftorqueAxis1 = solverConstraint.m_relpos1CrossNormal;
-			solverConstraint.m_angularComponentA = constraint->getRigidBodyA().getInvInertiaTensorWorld() * ftorqueAxis1 * constraint->getRigidBodyA().getAngularFactor();
-		}
-		{
-			const btVector3& ftorqueAxis2 = solverConstraint.m_relpos2CrossNormal;
-			solverConstraint.m_angularComponentB = constraint->getRigidBodyB().getInvInertiaTensorWorld() * ftorqueAxis2 * constraint->getRigidBodyB().getAngularFactor();
-		}
+		btVector3 iMJaA = invInertiaA * solverConstraint.m_relpos1CrossNormal;
+		btVector3 iMJaB = invInertiaB * solverConstraint.m_relpos2CrossNormal;
+		solverConstraint.m_angularComponentA = iMJaA * angularFactorA;
+		solverConstraint.m_angularComponentB = iMJaB * angularFactorB;
 
 		{
-			btVector3 iMJlA = solverConstraint.m_contactNormal1 * rbA.getInvMass();
-			btVector3 iMJaA = rbA.getInvInertiaTensorWorld() * solverConstraint.m_relpos1CrossNormal;
-			btVector3 iMJlB = solverConstraint.m_contactNormal2 * rbB.getInvMass();  //sign of normal?
-			btVector3 iMJaB = rbB.getInvInertiaTensorWorld() * solverConstraint.m_relpos2CrossNormal;
+			btVector3 iMJlA = solverConstraint.m_contactNormal1 * invMassA;
+			btVector3 iMJlB = solverConstraint.m_contactNormal2 * invMassB;  //sign of normal?
 
 			btScalar sum = iMJlA.dot(solverConstraint.m_contactNormal1);
 			sum += iMJaA.dot(solverConstraint.m_relpos1CrossNormal);
@@ -1269,15 +1397,9 @@ void btSequentialImpulseConstraintSolver::convertJoint(btSolverConstraint* curre
 
 		{
 			btScalar rel_vel;
-			btVector3 externalForceImpulseA = bodyAPtr->m_originalBody ? bodyAPtr->m_externalForceImpulse : btVector3(0, 0, 0);
-			btVector3 externalTorqueImpulseA = bodyAPtr->m_originalBody ? bodyAPtr->m_externalTorqueImpulse : btVector3(0, 0, 0);
-
-			btVector3 externalForceImpulseB = bodyBPtr->m_originalBody ? bodyBPtr->m_externalForceImpulse : btVector3(0, 0, 0);
-			btVector3 externalTorqueImpulseB = bodyBPtr->m_originalBody ? bodyBPtr->m_externalTorqueImpulse : btVector3(0, 0, 0);
-
-			btScalar vel1Dotn = solverConstraint.m_contactNormal1.dot(rbA.getLinearVelocity() + externalForceImpulseA) + solverConstraint.m_relpos1CrossNormal.dot(rbA.getAngularVelocity() + externalTorqueImpulseA);
+			btScalar vel1Dotn = solverConstraint.m_contactNormal1.dot(linVelA) + solverConstraint.m_relpos1CrossNormal.dot(angVelA);
 
-			btScalar vel2Dotn = solverConstraint.m_contactNormal2.dot(rbB.getLinearVelocity() + externalForceImpulseB) + solverConstraint.m_relpos2CrossNormal.dot(rbB.getAngularVelocity() + externalTorqueImpulseB);
+			btScalar vel2Dotn = solverConstraint.m_contactNormal2.dot(linVelB) + solverConstraint.m_relpos2CrossNormal.dot(angVelB);
 
 			rel_vel = vel1Dotn + vel2Dotn;
 			btScalar restitution = 0.f;
@@ -1291,6 +1413,17 @@ void btSequentialImpulseConstraintSolver::convertJoint(btSolverConstraint* curre
 	}
 }
 
+template <class JointRows>
+void btSequentialImpulseConstraintSolver::convertJointBucket(const btAlignedObjectArray<btJointRowRange>& bucket, btTypedConstraint** constraints, const btContactSolverInfo& infoGlobal)
+{
+	for (int i = 0; i < bucket.size(); i++)
+	{
+		const btJointRowRange& range = bucket[i];
+		convertJointRows<JointRows>(&m_tmpSolverNonContactConstraintPool[range.m_firstRow], constraints[range.m_constraint],
+									m_tmpConstraintSizesPool[range.m_constraint], range.m_solverBodyIdA, range.m_solverBodyIdB, infoGlobal);
+	}
+}
+
 void btSequentialImpulseConstraintSolver::convertJoints(btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal)
 {
 	BT_PROFILE("convertJoints");
@@ -1319,7 +1452,17 @@ void btSequentialImpulseConstraintSolver::convertJoints(btTypedConstraint** cons
 
 		if (constraints[i]->isEnabled())
 		{
-			constraints[i]->getInfo1(&info1);
+			switch (btGetRowBuilder(constraints[i]))
+			{
+				case BT_HINGE_ROW_BUILDER:
+					btHingeJointRows::getInfo1(constraints[i], &info1);
+					break;
+				case BT_6DOF_SPRING2_ROW_BUILDER:
+					btSpring2JointRows::getInfo1(constraints[i], &info1);
+					break;
+				default:
+					btGenericJointRows::getInfo1(constraints[i], &info1);
+			}
 		}
 		else
 		{
@@ -1330,7 +1473,12 @@ void btSequentialImpulseConstraintSolver::convertJoints(btTypedConstraint** cons
 	}
 	m_tmpSolverNonContactConstraintPool.resizeNoInitialize(totalNumRows);
 
-	///setup the btSolverConstraints
+	///assign the rows and the solver bodies in the order of the constraints, then setup the btSolverConstraints bucket by bucket
+	int bucket;
+	for (bucket = 0; bucket < NUM_JOINT_BUCKETS; bucket++)
+	{
+		m_jointBuckets[bucket].resize(0);
+	}
 	int currentRow = 0;
 
 	for (int i = 0; i < numConstraints; i++)
@@ -1341,18 +1489,31 @@ void btSequentialImpulseConstraintSolver::convertJoints(btTypedConstraint** cons
 		{
 			btAssert(currentRow < totalNumRows);
 
-			btSolverConstraint* currentConstraintRow = &m_tmpSolverNonContactConstraintPool[currentRow];
 			btTypedConstraint* constraint = constraints[i];
-			btRigidBody& rbA = constraint->getRigidBodyA();
-			btRigidBody& rbB = constraint->getRigidBodyB();
-
-			int solverBodyIdA = getOrInitSolverBody(rbA, infoGlobal.m_timeStep);
-			int solverBodyIdB = getOrInitSolverBody(rbB, infoGlobal.m_timeStep);
-
-			convertJoint(currentConstraintRow, constraint, info1, solverBodyIdA, solverBodyIdB, infoGlobal);
+			switch (btGetRowBuilder(constraint))
+			{
+				case BT_HINGE_ROW_BUILDER:
+					bucket = HINGE_JOINTS;
+					break;
+				case BT_6DOF_SPRING2_ROW_BUILDER:
+					bucket = static_cast<btGeneric6DofSpring2Constraint*>(constraint)->isLocked() ? LOCKED_SPRING2_JOINTS : SPRING2_JOINTS;
+					break;
+				default:
+					bucket = GENERIC_JOINTS;
+			}
+			btJointRowRange& range = m_jointBuckets[bucket].expandNonInitializing();
+			range.m_constraint = i;
+			range.m_firstRow = currentRow;
+			range.m_solverBodyIdA = getOrInitSolverBody(constraint->getRigidBodyA(), infoGlobal.m_timeStep);
+			range.m_solverBodyIdB = getOrInitSolverBody(constraint->getRigidBodyB(), infoGlobal.m_timeStep);
 		}
 		currentRow += info1.m_numConstraintRows;
 	}
+
+	convertJointBucket<btGenericJointRows>(m_jointBuckets[GENERIC_JOINTS], constraints, infoGlobal);
+	convertJointBucket<btHingeJointRows>(m_jointBuckets[HINGE_JOINTS], constraints, infoGlobal);
+	convertJointBucket<btSpring2JointRows>(m_jointBuckets[SPRING2_JOINTS], constraints, infoGlobal);
+	convertJointBucket<btLockedSpring2JointRows>(m_jointBuckets[LOCKED_SPRING2_JOINTS], constraints, infoGlobal);
 }
 
 void btSequentialImpulseConstraintSolver::convertBodies(btCollisionObject** bodies, int numBodies, const btContactSolverInfo& infoGlobal)
@@ -1523,6 +1684,13 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(btCol
 	return 0.f;
 }
 
+bool btSequentialImpulseConstraintSolver::useRowBatches(const btContactSolverInfo& infoGlobal) const
+{
+	//a random order every iteration would need a new packing every iteration
+	const int incompatibleModes = SOLVER_RANDMIZE_ORDER | SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS;
+	return (infoGlobal.m_solverMode & SOLVER_BATCHED_ROWS) && !(infoGlobal.m_solverMode & incompatibleModes) && btSolverRowBatches::isSupported();
+}
+
 btScalar btSequentialImpulseConstraintSolver::solveSingleIteration(int iteration, btCollisionObject** /*bodies */, int /*numBodies*/, btPersistentManifold** /*manifoldPtr*/, int /*numManifolds*/, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* /*debugDrawer*/)
 {
 	BT_PROFILE("solveSingleIteration");
@@ -1640,6 +1808,20 @@ btScalar btSequentialImpulseConstraintSolver::solveSingleIteration(int iteration
 				}
 			}
 		}
+		else if (useRowBatches(infoGlobal))
+		{
+			//the rows are packed once per solve, in the order of the order pools
+			if (iteration == 0)
+			{
+				m_rowBatches.build(m_tmpSolverBodyPool, m_tmpSolverContactConstraintPool, numConstraintPool ? &m_orderTmpConstraintPool[0] : 0,
+								   m_tmpSolverContactFrictionConstraintPool, numFrictionPool ? &m_orderFrictionConstraintPool[0] : 0);
+			}
+			leastSquaresResidual = btMax(leastSquaresResidual, m_rowBatches.solveContactRows());
+			leastSquaresResidual = btMax(leastSquaresResidual, m_rowBatches.solveFrictionRows());
+			//rolling friction bounds come from the contact impulses; everything else is copied back in solveGroupCacheFriendlyFinish
+			if (m_tmpSolverContactRollingFrictionConstraintPool.size())
+				m_rowBatches.writeBackContactImpulses(m_tmpSolverContactConstraintPool);
+		}
 		else  //SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS
 		{
 			//solve the friction constraints after all contact constraints, don't interleave them
@@ -1736,14 +1918,37 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyIterations(
 		solveGroupCacheFriendlySplitImpulseIterations(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
 
 		int maxIterations = m_maxOverrideNumSolverIterations > infoGlobal.m_numIterations ? m_maxOverrideNumSolverIterations : infoGlobal.m_numIterations;
+		const bool adaptive = (infoGlobal.m_solverMode & SOLVER_ADAPTIVE_ISLAND_ITERATIONS) != 0;
+		const int iterationLimit = adaptive ? btMax(maxIterations, infoGlobal.m_maxIslandIterations) : maxIterations;
+		//solveSingleIteration skips the contacts past m_numIterations, borrowed iterations raise it
+		const btContactSolverInfo* iterationInfo = &infoGlobal;
+		btContactSolverInfo borrowingInfo;
 
-		for (int iteration = 0; iteration < maxIterations; iteration++)
+		for (int iteration = 0; iteration < iterationLimit; iteration++)
 			//for ( int iteration = maxIterations-1  ; iteration >= 0;iteration--)
 		{
-			m_leastSquaresResidual = solveSingleIteration(iteration, bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+			m_leastSquaresResidual = solveSingleIteration(iteration, bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, *iterationInfo, debugDrawer);
 
-			if (m_leastSquaresResidual <= infoGlobal.m_leastSquaresResidualThreshold || (iteration >= (maxIterations - 1)))
+			const bool converged = m_leastSquaresResidual <= infoGlobal.m_leastSquaresResidualThreshold;
+			bool lastIteration = iteration >= (maxIterations - 1);
+			if (adaptive && !converged && lastIteration && iteration + 1 < iterationLimit && m_iterationCredit > 0)
+			{
+				//borrow one of the iterations an earlier island did not need
+				m_iterationCredit--;
+				lastIteration = false;
+				if (iterationInfo == &infoGlobal)
+				{
+					borrowingInfo = infoGlobal;
+					borrowingInfo.m_numIterations = iterationLimit;
+					iterationInfo = &borrowingInfo;
+				}
+			}
+			if (converged || lastIteration)
 			{
+				if (adaptive && iteration + 1 < maxIterations)
+				{
+					m_iterationCredit += maxIterations - (iteration + 1);
+				}
 #ifdef VERBOSE_RESIDUAL_PRINTF
 				printf("residual = %f at iteration #%d\n", m_leastSquaresResidual, iteration);
 #endif
@@ -1837,6 +2042,12 @@ btScalar btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyFinish(btCo
 {
 	BT_PROFILE("solveGroupCacheFriendlyFinish");
 
+	if (!m_rowBatches.isEmpty())
+	{
+		m_rowBatches.writeBack(m_tmpSolverContactConstraintPool, m_tmpSolverContactFrictionConstraintPool);
+		m_rowBatches.clear();
+	}
+
 	if (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING)
 	{
 		writeBackContacts(0, m_tmpSolverContactConstraintPool.size(), infoGlobal);
@@ -1872,4 +2083,180 @@ btScalar btSequentialImpulseConstraintSolver::solveGroup(btCollisionObject** bod
 void btSequentialImpulseConstraintSolver::reset()
 {
 	m_btSeed2 = 0;
+	m_iterationCredit = 0;
+}
+
+void btSequentialImpulseConstraintSolver::prepareSolve(int /* numBodies */, int /* numManifolds */)
+{
+	m_iterationCredit = 0;
+}
+
+#if BT_SEQUENTIAL_IMPULSE_ENABLE_BENCHMARK
+
+#include "btFixedConstraint.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "LinearMath/btDefaultMotionState.h"
+#include <stdio.h>
+
+///times convertJoints. With m_virtualRows it converts every joint like before the row builders: getInfo1 and
+///getInfo2 through the vtable, in the order of the constraints
+class btTimedJointSetupSolver : public btSequentialImpulseConstraintSolver
+{
+public:
+	bool m_virtualRows;
+	unsigned long long m_jointMicroseconds;
+	int m_joints;
+
+	btTimedJointSetupSolver(bool virtualRows) : m_virtualRows(virtualRows), m_jointMicroseconds(0), m_joints(0) {}
+
+	virtual void convertJoints(btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal)
+	{
+		btClock clock;
+		if (m_virtualRows)
+		{
+			int i;
+			int totalNumRows = 0;
+			m_tmpConstraintSizesPool.resizeNoInitialize(numConstraints);
+			for (i = 0; i < numConstraints; i++)
+			{
+				constraints[i]->buildJacobian();
+				constraints[i]->internalSetAppliedImpulse(0.0f);
+				constraints[i]->getInfo1(&m_tmpConstraintSizesPool[i]);
+				totalNumRows += m_tmpConstraintSizesPool[i].m_numConstraintRows;
+			}
+			m_tmpSolverNonContactConstraintPool.resizeNoInitialize(totalNumRows);
+			int currentRow = 0;
+			for (i = 0; i < numConstraints; i++)
+			{
+				const btTypedConstraint::btConstraintInfo1& info1 = m_tmpConstraintSizesPool[i];
+				if (info1.m_numConstraintRows)
+				{
+					int solverBodyIdA = getOrInitSolverBody(constraints[i]->getRigidBodyA(), infoGlobal.m_timeStep);
+					int solverBodyIdB = getOrInitSolverBody(constraints[i]->getRigidBodyB(), infoGlobal.m_timeStep);
+					convertJoint(&m_tmpSolverNonContactConstraintPool[currentRow], constraints[i], info1, solverBodyIdA, solverBodyIdB, infoGlobal);
+				}
+				currentRow += info1.m_numConstraintRows;
+			}
+		}
+		else
+		{
+			btSequentialImpulseConstraintSolver::convertJoints(constraints, numConstraints, infoGlobal);
+		}
+		m_jointMicroseconds += clock.getTimeMicroseconds();
+		m_joints += numConstraints;
+	}
+};
+
+///tanks like the ones of the demo: a chassis with two tracks on hinges, a turret and a cannon on fixed constraints
+struct btJointSetupBenchmarkScene
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btTimedJointSetupSolver m_solver;
+	btDiscreteDynamicsWorld m_world;
+	btBoxShape m_chassis;
+	btBoxShape m_track;
+	btBoxShape m_turret;
+	btBoxShape m_cannon;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+
+	btJointSetupBenchmarkScene(bool virtualRows, int tanks)
+		: m_dispatcher(&m_configuration),
+		  m_solver(virtualRows),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+		  m_chassis(btVector3(1.0, 0.2, 1.0)),
+		  m_track(btVector3(0.25, 0.25, 1.0)),
+		  m_turret(btVector3(0.5, 0.2, 0.35)),
+		  m_cannon(btVector3(0.2, 0.1, 0.5))
+	{
+		m_world.setGravity(btVector3(0, 0, 0));
+		for (int t = 0; t < tanks; t++)
+		{
+			const btVector3 center(btScalar(t % 40) * 6, 0, btScalar(t / 40) * 6);
+			btRigidBody* chassis = addBody(&m_chassis, 10, center);
+			btRigidBody* leftTrack = addBody(&m_track, 2, center + btVector3(-1.2f, 0, 0));
+			btRigidBody* rightTrack = addBody(&m_track, 2, center + btVector3(1.2f, 0, 0));
+			btRigidBody* turret = addBody(&m_turret, 1, center + btVector3(0, 0.5f, 0));
+			btRigidBody* cannon = addBody(&m_cannon, 1, center + btVector3(0, 0.5f, -0.85f));
+			btHingeConstraint* left = new btHingeConstraint(*chassis, *leftTrack, btVector3(-1.2f, 0, 0), btVector3(0, 0, 0), btVector3(0, 1, 0), btVector3(0, 1, 0));
+			left->enableAngularMotor(true, btScalar(1 + t % 3), 50);
+			addConstraint(left);
+			addConstraint(new btHingeConstraint(*chassis, *rightTrack, btVector3(1.2f, 0, 0), btVector3(0, 0, 0), btVector3(0, 1, 0), btVector3(0, 1, 0)));
+			btTransform frameInA = btTransform::getIdentity();
+			frameInA.setOrigin(btVector3(0, 0.5f, 0));
+			addConstraint(new btFixedConstraint(*chassis, *turret, frameInA, btTransform::getIdentity()));
+			frameInA.setOrigin(btVector3(0, 0, -0.85f));
+			addConstraint(new btFixedConstraint(*turret, *cannon, frameInA, btTransform::getIdentity()));
+		}
+	}
+
+	~btJointSetupBenchmarkScene()
+	{
+		for (int i = 0; i < m_constraints.size(); i++)
+		{
+			m_world.removeConstraint(m_constraints[i]);
+			delete m_constraints[i];
+		}
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeRigidBody(m_bodies[i]);
+			delete m_bodies[i]->getMotionState();
+			delete m_bodies[i];
+		}
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position)
+	{
+		btVector3 inertia(0, 0, 0);
+		shape->calculateLocalInertia(mass, inertia);
+		btRigidBody* body = new btRigidBody(mass, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), position)), shape, inertia);
+		body->setActivationState(DISABLE_DEACTIVATION);
+		//the parts of a tank overlap, only the joints are timed
+		m_world.addRigidBody(body, 1, 0);
+		m_bodies.push_back(body);
+		return body;
+	}
+
+	void addConstraint(btTypedConstraint* constraint)
+	{
+		m_world.addConstraint(constraint, true);
+		m_constraints.push_back(constraint);
+	}
+};
+
+void btSequentialImpulseConstraintSolver::benchmark()
+{
+	const int tanks = 1000;
+	const int warmupSteps = 20;
+	const int timedSteps = 200;
+	double microsecondsPerJoint[2];
+	btScalar checksum[2];
+	for (int virtualRows = 0; virtualRows < 2; virtualRows++)
+	{
+		btJointSetupBenchmarkScene scene(virtualRows != 0, tanks);
+		for (int i = 0; i < warmupSteps; i++)
+			scene.m_world.stepSimulation(1.f / 60.f, 0);
+		scene.m_solver.m_jointMicroseconds = 0;
+		scene.m_solver.m_joints = 0;
+		for (int i = 0; i < timedSteps; i++)
+			scene.m_world.stepSimulation(1.f / 60.f, 0);
+
+		checksum[virtualRows] = 0;
+		for (int i = 0; i < scene.m_bodies.size(); i++)
+			checksum[virtualRows] += scene.m_bodies[i]->getWorldTransform().getOrigin().dot(btVector3(1, 1, 1));
+		microsecondsPerJoint[virtualRows] = double(scene.m_solver.m_jointMicroseconds) / btMax(scene.m_solver.m_joints, 1);
+		printf("%d tanks, %d joints, %s: %.1f us per step, %.3f us per joint\n", tanks, scene.m_constraints.size(),
+			   virtualRows ? "virtual getInfo   " : "specialized builders",
+			   double(scene.m_solver.m_jointMicroseconds) / timedSteps, microsecondsPerJoint[virtualRows]);
+	}
+	printf("joint setup speedup %.2fx, position checksums %f %f\n", microsecondsPerJoint[1] / btMax(microsecondsPerJoint[0], 1e-9),
+		   checksum[0], checksum[1]);
 }
+
+#endif  //BT_SEQUENTIAL_IMPULSE_ENABLE_BENCHMARK
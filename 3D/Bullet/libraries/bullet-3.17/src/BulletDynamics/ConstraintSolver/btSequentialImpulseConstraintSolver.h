@@ -24,9 +24,14 @@ class btCollisionObject;
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 #include "BulletDynamics/ConstraintSolver/btSolverBody.h"
 #include "BulletDynamics/ConstraintSolver/btSolverConstraint.h"
+#include "BulletDynamics/ConstraintSolver/btSolverRowBatches.h"
 #include "BulletCollision/NarrowPhaseCollision/btManifoldPoint.h"
 #include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
 
+#ifndef BT_SEQUENTIAL_IMPULSE_ENABLE_BENCHMARK
+#define BT_SEQUENTIAL_IMPULSE_ENABLE_BENCHMARK 0
+#endif
+
 typedef btScalar (*btSingleConstraintRowSolver)(btSolverBody&, btSolverBody&, const btSolverConstraint&);
 
 struct btSolverAnalyticsData
@@ -46,6 +51,15 @@ struct btSolverAnalyticsData
 	double m_remainingLeastSquaresResidual;
 };
 
+///the rows of one joint in the non contact constraint pool, see btSequentialImpulseConstraintSolver::convertJoints
+struct btJointRowRange
+{
+	int m_constraint;
+	int m_firstRow;
+	int m_solverBodyIdA;
+	int m_solverBodyIdB;
+};
+
 ///The btSequentialImpulseConstraintSolver is a fast SIMD implementation of the Projected Gauss Seidel (iterative LCP) method.
 ATTRIBUTE_ALIGNED16(class)
 btSequentialImpulseConstraintSolver : public btConstraintSolver
@@ -82,6 +96,13 @@ protected:
 
 	btScalar m_leastSquaresResidual;
 
+	///contact and friction rows packed for SOLVER_BATCHED_ROWS, rebuilt at the first iteration of every solve
+	btSolverRowBatches m_rowBatches;
+	bool useRowBatches(const btContactSolverInfo& infoGlobal) const;
+
+	///iterations left over by the islands that converged early in this step, see SOLVER_ADAPTIVE_ISLAND_ITERATIONS
+	int m_iterationCredit;
+
 	void setupFrictionConstraint(btSolverConstraint & solverConstraint, const btVector3& normalAxis, int solverBodyIdA, int solverBodyIdB,
 		btManifoldPoint& cp, const btVector3& rel_pos1, const btVector3& rel_pos2,
 		btCollisionObject* colObj0, btCollisionObject* colObj1, btScalar relaxation,
@@ -113,8 +134,23 @@ protected:
 
 	void convertContact(btPersistentManifold * manifold, const btContactSolverInfo& infoGlobal);
 
+	///convertJoints sorts the joints by their class, so each bucket is converted by one specialized row builder
+	enum btJointBucket
+	{
+		GENERIC_JOINTS = 0,
+		HINGE_JOINTS,
+		SPRING2_JOINTS,
+		LOCKED_SPRING2_JOINTS,  ///< btGeneric6DofSpring2Constraint::isLocked, btFixedConstraint
+		NUM_JOINT_BUCKETS
+	};
+	btAlignedObjectArray<btJointRowRange> m_jointBuckets[NUM_JOINT_BUCKETS];
+
 	virtual void convertJoints(btTypedConstraint * *constraints, int numConstraints, const btContactSolverInfo& infoGlobal);
 	void convertJoint(btSolverConstraint * currentConstraintRow, btTypedConstraint * constraint, const btTypedConstraint::btConstraintInfo1& info1, int solverBodyIdA, int solverBodyIdB, const btContactSolverInfo& infoGlobal);
+	template <class JointRows>
+	void convertJointRows(btSolverConstraint * currentConstraintRow, btTypedConstraint * constraint, const btTypedConstraint::btConstraintInfo1& info1, int solverBodyIdA, int solverBodyIdB, const btContactSolverInfo& infoGlobal);
+	template <class JointRows>
+	void convertJointBucket(const btAlignedObjectArray<btJointRowRange>& bucket, btTypedConstraint** constraints, const btContactSolverInfo& infoGlobal);
 
 	virtual void convertBodies(btCollisionObject * *bodies, int numBodies, const btContactSolverInfo& infoGlobal);
 
@@ -163,6 +199,14 @@ public:
 	///clear internal cached data and reset random seed
 	virtual void reset();
 
+	///starts a new step: the iterations lent between islands do not carry over
+	virtual void prepareSolve(int numBodies, int numManifolds);
+
+	int getIterationCredit() const
+	{
+		return m_iterationCredit;
+	}
+
 	unsigned long btRand2();
 
 	int btRandInt2(int n);
@@ -181,6 +225,11 @@ public:
 		return BT_SEQUENTIAL_IMPULSE_SOLVER;
 	}
 
+	virtual const btSolverAnalyticsData* getAnalyticsData() const
+	{
+		return &m_analyticsData;
+	}
+
 	btSingleConstraintRowSolver getActiveConstraintRowSolverGeneric()
 	{
 		return m_resolveSingleConstraintRowGeneric;
@@ -210,6 +259,15 @@ public:
 	btSingleConstraintRowSolver getSSE2ConstraintRowSolverLowerLimit();
 	btSingleConstraintRowSolver getSSE4_1ConstraintRowSolverLowerLimit();
 	btSolverAnalyticsData m_analyticsData;
+
+	///times convertJoints on a world of tanks, with the specialized row builders and with getInfo1/getInfo2 called through the vtable
+#if BT_SEQUENTIAL_IMPULSE_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
 };
 
 #endif  //BT_SEQUENTIAL_IMPULSE_CONSTRAINT_SOLVER_H
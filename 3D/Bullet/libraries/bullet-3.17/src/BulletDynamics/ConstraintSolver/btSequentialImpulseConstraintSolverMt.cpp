@@ -34,6 +34,7 @@ btSequentialImpulseConstraintSolverMt::btSequentialImpulseConstraintSolverMt()
 	m_numFrictionDirections = 1;
 	m_useBatching = false;
 	m_useObsoleteJointConstraints = false;
+	m_sumBatchesInOrder = false;
 }
 
 btSequentialImpulseConstraintSolverMt::~btSequentialImpulseConstraintSolverMt()
@@ -836,6 +837,7 @@ btScalar btSequentialImpulseConstraintSolverMt::solveGroupCacheFriendlySetup(
 	btIDebugDraw* debugDrawer)
 {
 	m_numFrictionDirections = (infoGlobal.m_solverMode & SOLVER_USE_2_FRICTION_DIRECTIONS) ? 2 : 1;
+	m_sumBatchesInOrder = (infoGlobal.m_solverMode & SOLVER_DETERMINISTIC) != 0;
 	m_useBatching = false;
 	if (numManifolds >= s_minimumContactManifoldsForBatching &&
 		(s_allowNestedParallelForLoops || !btThreadsAreRunning()))
@@ -870,6 +872,47 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveMultipleContactSplitPenet
 	return leastSquaresResidual;
 }
 
+struct BatchResidualLoop : public btIParallelForBody
+{
+	const btIParallelSumBody* m_body;
+	btScalar* m_residuals;
+
+	BatchResidualLoop(const btIParallelSumBody* body, btScalar* residuals)
+	{
+		m_body = body;
+		m_residuals = residuals;
+	}
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int iBatch = iBegin; iBatch < iEnd; ++iBatch)
+		{
+			m_residuals[iBatch] = m_body->sumLoop(iBatch, iBatch + 1);
+		}
+	}
+};
+
+btScalar btSequentialImpulseConstraintSolverMt::sumOverBatches(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+	if (!m_sumBatchesInOrder)
+	{
+		return btParallelSum(iBegin, iEnd, grainSize, body);
+	}
+	// btParallelSum adds up whatever each thread summed, so the rounding depends on how the batches were
+	// spread over the threads. Keep the residual of every batch instead and add them in batch order.
+	if (m_batchResiduals.size() < iEnd)
+	{
+		m_batchResiduals.resizeNoInitialize(iEnd);
+	}
+	BatchResidualLoop loop(&body, &m_batchResiduals[0]);
+	btParallelFor(iBegin, iEnd, grainSize, loop);
+	btScalar sum = btScalar(0);
+	for (int iBatch = iBegin; iBatch < iEnd; ++iBatch)
+	{
+		sum += m_batchResiduals[iBatch];
+	}
+	return sum;
+}
+
 struct ContactSplitPenetrationImpulseSolverLoop : public btIParallelSumBody
 {
 	btSequentialImpulseConstraintSolverMt* m_solver;
@@ -911,7 +954,7 @@ void btSequentialImpulseConstraintSolverMt::solveGroupCacheFriendlySplitImpulseI
 					int iPhase = batchedCons.m_phaseOrder[iiPhase];
 					const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 					int grainSize = batchedCons.m_phaseGrainSize[iPhase];
-					leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+					leastSquaresResidual += sumOverBatches(phase.begin, phase.end, grainSize, loop);
 				}
 			}
 			else
@@ -1237,7 +1280,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllJointConstraints(int i
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = 1;
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumOverBatches(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1276,7 +1319,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactConstraints()
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = batchedCons.m_phaseGrainSize[iPhase];
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumOverBatches(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1315,7 +1358,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactFrictionConstra
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = batchedCons.m_phaseGrainSize[iPhase];
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumOverBatches(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1354,7 +1397,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllContactConstraintsInte
 		int iPhase = batchedCons.m_phaseOrder[iiPhase];
 		const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 		int grainSize = 1;
-		leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+		leastSquaresResidual += sumOverBatches(phase.begin, phase.end, grainSize, loop);
 	}
 	return leastSquaresResidual;
 }
@@ -1414,7 +1457,7 @@ btScalar btSequentialImpulseConstraintSolverMt::resolveAllRollingFrictionConstra
 			int iPhase = batchedCons.m_phaseOrder[iiPhase];
 			const btBatchedConstraints::Range& phase = batchedCons.m_phases[iPhase];
 			int grainSize = 1;
-			leastSquaresResidual += btParallelSum(phase.begin, phase.end, grainSize, loop);
+			leastSquaresResidual += sumOverBatches(phase.begin, phase.end, grainSize, loop);
 		}
 	}
 	else
@@ -106,7 +106,10 @@ protected:
 	char m_antiFalseSharingPadding[CACHE_LINE_SIZE];  // padding to keep mutexes in separate cachelines
 	btSpinMutex m_kinematicBodyUniqueIdToSolverBodyTableMutex;
 	btAlignedObjectArray<char> m_scratchMemory;
+	bool m_sumBatchesInOrder;                         // SOLVER_DETERMINISTIC: residuals are added in batch order
+	btAlignedObjectArray<btScalar> m_batchResiduals;  // residual of each batch when m_sumBatchesInOrder
 
+	btScalar sumOverBatches(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body);
 	virtual void randomizeConstraintOrdering(int iteration, int numIterations);
 	virtual btScalar resolveAllJointConstraints(int iteration);
 	virtual btScalar resolveAllContactConstraints();
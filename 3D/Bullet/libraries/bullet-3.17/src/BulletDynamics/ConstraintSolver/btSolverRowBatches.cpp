@@ -0,0 +1,639 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btSolverRowBatches.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include <string.h>  //for memset
+#include <stddef.h>  //for offsetof
+
+// The kernels need 64-bit x86 with SSE4 allowed, and a float btScalar. Other builds keep the per-row kernels.
+#if defined(BT_ALLOW_SSE4) && !defined(BT_USE_DOUBLE_PRECISION) && (defined(__x86_64__) || defined(_M_X64))
+#define BT_USE_ROW_BATCHES 1
+#include "LinearMath/btCpuFeatureUtility.h"
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define BT_TARGET_AVX2_FMA3
+#else
+#define BT_TARGET_AVX2_FMA3 __attribute__((target("avx2,fma")))
+#endif
+#else
+#define BT_USE_ROW_BATCHES 0
+#endif
+
+btSolverRowBatches::btSolverRowBatches()
+	: m_filledLanes(0)
+{
+	m_emptyLaneVelocity[0].setZero();
+	m_emptyLaneVelocity[1].setZero();
+	memset((void*)&m_emptyRow, 0, sizeof(m_emptyRow));
+}
+
+bool btSolverRowBatches::isSupported()
+{
+#if BT_USE_ROW_BATCHES
+	const int required = btCpuFeatureUtility::CPU_FEATURE_AVX2 | btCpuFeatureUtility::CPU_FEATURE_FMA3;
+	return (btCpuFeatureUtility::getCpuFeatures() & required) == required;
+#else
+	return false;
+#endif
+}
+
+void btSolverRowBatches::clear()
+{
+	m_contactBlocks.resize(0);
+	m_frictionBlocks.resize(0);
+	m_filledLanes = 0;
+}
+
+btScalar btSolverRowBatches::getLaneOccupancy() const
+{
+	int lanes = (m_contactBlocks.size() + m_frictionBlocks.size()) * LANE_COUNT;
+	return lanes ? btScalar(m_filledLanes) / btScalar(lanes) : btScalar(1);
+}
+
+#if BT_USE_ROW_BATCHES
+
+///Transposes 8 rows of 8 floats. Used both ways: per-lane body velocities to per-component vectors and back.
+BT_TARGET_AVX2_FMA3 static inline void btTranspose8x8(__m256* r)
+{
+	__m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+	__m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	__m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+	__m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	__m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+	__m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	__m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+	__m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+	__m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+	r[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+	r[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+	r[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+	r[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+	r[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+	r[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+	r[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+	r[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+///Loads the delta velocities of 8 bodies: v[0..2] linear x, y, z, v[4..6] angular x, y, z. v[3] and v[7] are the unused w.
+BT_TARGET_AVX2_FMA3 static inline void btGatherVelocities(float* const* bodies, __m256* v)
+{
+	for (int lane = 0; lane < btSolverRowBatches::LANE_COUNT; lane++)
+		v[lane] = _mm256_loadu_ps(bodies[lane]);
+	btTranspose8x8(v);
+}
+
+BT_TARGET_AVX2_FMA3 static inline void btScatterVelocities(float* const* bodies, __m256* v)
+{
+	btTranspose8x8(v);
+	for (int lane = 0; lane < btSolverRowBatches::LANE_COUNT; lane++)
+		_mm256_storeu_ps(bodies[lane], v[lane]);
+}
+
+BT_TARGET_AVX2_FMA3 static inline __m256 btRowVelocity(const float (*normal)[8], const float (*relposCrossNormal)[8], const __m256* v)
+{
+	__m256 dv = _mm256_mul_ps(_mm256_loadu_ps(normal[0]), v[0]);
+	dv = _mm256_fmadd_ps(_mm256_loadu_ps(normal[1]), v[1], dv);
+	dv = _mm256_fmadd_ps(_mm256_loadu_ps(normal[2]), v[2], dv);
+	dv = _mm256_fmadd_ps(_mm256_loadu_ps(relposCrossNormal[0]), v[4], dv);
+	dv = _mm256_fmadd_ps(_mm256_loadu_ps(relposCrossNormal[1]), v[5], dv);
+	return _mm256_fmadd_ps(_mm256_loadu_ps(relposCrossNormal[2]), v[6], dv);
+}
+
+BT_TARGET_AVX2_FMA3 static inline void btApplyRowImpulse(const float (*linear)[8], const float (*angular)[8], __m256 deltaImpulse, __m256* v)
+{
+	v[0] = _mm256_fmadd_ps(_mm256_loadu_ps(linear[0]), deltaImpulse, v[0]);
+	v[1] = _mm256_fmadd_ps(_mm256_loadu_ps(linear[1]), deltaImpulse, v[1]);
+	v[2] = _mm256_fmadd_ps(_mm256_loadu_ps(linear[2]), deltaImpulse, v[2]);
+	v[4] = _mm256_fmadd_ps(_mm256_loadu_ps(angular[0]), deltaImpulse, v[4]);
+	v[5] = _mm256_fmadd_ps(_mm256_loadu_ps(angular[1]), deltaImpulse, v[5]);
+	v[6] = _mm256_fmadd_ps(_mm256_loadu_ps(angular[2]), deltaImpulse, v[6]);
+}
+
+BT_TARGET_AVX2_FMA3 static inline float btHorizontalMax(__m256 x)
+{
+	__m128 m = _mm_max_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+	m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+	m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+	return _mm_cvtss_f32(m);
+}
+
+///The same steps as gResolveSingleConstraintRowLowerLimit_sse4_1_fma3, for the 8 rows of every group in turn
+template <typename Block>
+BT_TARGET_AVX2_FMA3 static float btSolveContactBlocksAVX2(Block* blocks, int numBlocks)
+{
+	__m256 maxResidual = _mm256_setzero_ps();
+	for (int g = 0; g < numBlocks; g++)
+	{
+		Block& block = blocks[g];
+		__m256 velA[8], velB[8];
+		btGatherVelocities(block.m_bodyA, velA);
+		btGatherVelocities(block.m_bodyB, velB);
+
+		const __m256 jacDiagABInv = _mm256_loadu_ps(block.m_jacDiagABInv);
+		const __m256 appliedImpulse = _mm256_loadu_ps(block.m_appliedImpulse);
+		const __m256 lowerLimit = _mm256_loadu_ps(block.m_lowerLimit);
+		__m256 deltaImpulse = _mm256_fnmadd_ps(appliedImpulse, _mm256_loadu_ps(block.m_cfm), _mm256_loadu_ps(block.m_rhs));
+		deltaImpulse = _mm256_fnmadd_ps(btRowVelocity(block.m_contactNormal1, block.m_relpos1CrossNormal, velA), jacDiagABInv, deltaImpulse);
+		deltaImpulse = _mm256_fnmadd_ps(btRowVelocity(block.m_contactNormal2, block.m_relpos2CrossNormal, velB), jacDiagABInv, deltaImpulse);
+
+		const __m256 sum = _mm256_add_ps(appliedImpulse, deltaImpulse);
+		const __m256 belowLower = _mm256_cmp_ps(sum, lowerLimit, _CMP_LT_OQ);
+		deltaImpulse = _mm256_blendv_ps(deltaImpulse, _mm256_sub_ps(lowerLimit, appliedImpulse), belowLower);
+		_mm256_storeu_ps(block.m_appliedImpulse, _mm256_blendv_ps(sum, lowerLimit, belowLower));
+
+		btApplyRowImpulse(block.m_linearComponentA, block.m_angularComponentA, deltaImpulse, velA);
+		btApplyRowImpulse(block.m_linearComponentB, block.m_angularComponentB, deltaImpulse, velB);
+		btScatterVelocities(block.m_bodyA, velA);
+		btScatterVelocities(block.m_bodyB, velB);
+
+		const __m256 residual = _mm256_mul_ps(deltaImpulse, _mm256_loadu_ps(block.m_residualScale));
+		maxResidual = _mm256_max_ps(maxResidual, _mm256_mul_ps(residual, residual));
+	}
+	return btHorizontalMax(maxResidual);
+}
+
+///Friction rows take their bounds from the impulse of their contact, gathered from the contact blocks.
+///Rows whose contact pushes with no impulse are left as they are, like the per-row loop skips them.
+template <typename Block>
+BT_TARGET_AVX2_FMA3 static float btSolveFrictionBlocksAVX2(Block* blocks, int numBlocks, const float* contactBlocks)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 maxResidual = zero;
+	for (int g = 0; g < numBlocks; g++)
+	{
+		Block& block = blocks[g];
+		const __m256 totalImpulse = _mm256_i32gather_ps(contactBlocks, _mm256_loadu_si256((const __m256i*)block.m_contactSlot), 4);
+		const __m256 active = _mm256_cmp_ps(totalImpulse, zero, _CMP_GT_OQ);
+		if (_mm256_movemask_ps(active) == 0)
+			continue;
+
+		const __m256 bound = _mm256_mul_ps(_mm256_loadu_ps(block.m_friction), totalImpulse);
+		const __m256 lowerLimit = _mm256_blendv_ps(_mm256_loadu_ps(block.m_lowerLimit), _mm256_sub_ps(zero, bound), active);
+		const __m256 upperLimit = _mm256_blendv_ps(_mm256_loadu_ps(block.m_upperLimit), bound, active);
+		_mm256_storeu_ps(block.m_lowerLimit, lowerLimit);
+		_mm256_storeu_ps(block.m_upperLimit, upperLimit);
+
+		__m256 velA[8], velB[8];
+		btGatherVelocities(block.m_bodyA, velA);
+		btGatherVelocities(block.m_bodyB, velB);
+
+		const __m256 jacDiagABInv = _mm256_loadu_ps(block.m_jacDiagABInv);
+		const __m256 appliedImpulse = _mm256_loadu_ps(block.m_appliedImpulse);
+		__m256 deltaImpulse = _mm256_fnmadd_ps(appliedImpulse, _mm256_loadu_ps(block.m_cfm), _mm256_loadu_ps(block.m_rhs));
+		deltaImpulse = _mm256_fnmadd_ps(btRowVelocity(block.m_contactNormal1, block.m_relpos1CrossNormal, velA), jacDiagABInv, deltaImpulse);
+		deltaImpulse = _mm256_fnmadd_ps(btRowVelocity(block.m_contactNormal2, block.m_relpos2CrossNormal, velB), jacDiagABInv, deltaImpulse);
+
+		const __m256 sum = _mm256_add_ps(appliedImpulse, deltaImpulse);
+		const __m256 belowLower = _mm256_cmp_ps(sum, lowerLimit, _CMP_LT_OQ);
+		const __m256 aboveUpper = _mm256_andnot_ps(belowLower, _mm256_cmp_ps(sum, upperLimit, _CMP_GT_OQ));
+		deltaImpulse = _mm256_blendv_ps(deltaImpulse, _mm256_sub_ps(lowerLimit, appliedImpulse), belowLower);
+		deltaImpulse = _mm256_blendv_ps(deltaImpulse, _mm256_sub_ps(upperLimit, appliedImpulse), aboveUpper);
+		deltaImpulse = _mm256_and_ps(deltaImpulse, active);
+		__m256 newImpulse = _mm256_blendv_ps(sum, lowerLimit, belowLower);
+		newImpulse = _mm256_blendv_ps(newImpulse, upperLimit, aboveUpper);
+		_mm256_storeu_ps(block.m_appliedImpulse, _mm256_blendv_ps(appliedImpulse, newImpulse, active));
+
+		btApplyRowImpulse(block.m_linearComponentA, block.m_angularComponentA, deltaImpulse, velA);
+		btApplyRowImpulse(block.m_linearComponentB, block.m_angularComponentB, deltaImpulse, velB);
+		btScatterVelocities(block.m_bodyA, velA);
+		btScatterVelocities(block.m_bodyB, velB);
+
+		const __m256 residual = _mm256_mul_ps(deltaImpulse, _mm256_loadu_ps(block.m_residualScale));
+		maxResidual = _mm256_max_ps(maxResidual, _mm256_mul_ps(residual, residual));
+	}
+	return btHorizontalMax(maxResidual);
+}
+
+
+///Copies two adjacent btVector3 members of 8 rows, at the given byte offset, to the x, y and z arrays of the block
+BT_TARGET_AVX2_FMA3 static inline void btTransposeRowVectors(const btSolverConstraint* const* rows, size_t offset, float (*first)[8], float (*second)[8])
+{
+	__m256 v[8];
+	for (int lane = 0; lane < btSolverRowBatches::LANE_COUNT; lane++)
+		v[lane] = _mm256_loadu_ps((const float*)((const char*)rows[lane] + offset));
+	btTranspose8x8(v);
+	for (int i = 0; i < 3; i++)
+	{
+		_mm256_storeu_ps(first[i], v[i]);
+		_mm256_storeu_ps(second[i], v[4 + i]);
+	}
+}
+
+///Fills a block from 8 rows with the same transposes the kernels use for the velocities; empty lanes read a zeroed row
+template <typename Block>
+BT_TARGET_AVX2_FMA3 static void btFillBlockAVX2(Block& block, const btSolverConstraint* const* rows, const btVector3* const* invMassA, const btVector3* const* invMassB)
+{
+	btTransposeRowVectors(rows, offsetof(btSolverConstraint, m_relpos1CrossNormal), block.m_relpos1CrossNormal, block.m_contactNormal1);
+	btTransposeRowVectors(rows, offsetof(btSolverConstraint, m_relpos2CrossNormal), block.m_relpos2CrossNormal, block.m_contactNormal2);
+	btTransposeRowVectors(rows, offsetof(btSolverConstraint, m_angularComponentA), block.m_angularComponentA, block.m_angularComponentB);
+
+	__m256 v[8];
+	for (int lane = 0; lane < btSolverRowBatches::LANE_COUNT; lane++)
+	{
+		const __m128 linearA = _mm_mul_ps(rows[lane]->m_contactNormal1.get128(), invMassA[lane]->get128());
+		const __m128 linearB = _mm_mul_ps(rows[lane]->m_contactNormal2.get128(), invMassB[lane]->get128());
+		v[lane] = _mm256_insertf128_ps(_mm256_castps128_ps256(linearA), linearB, 1);
+	}
+	btTranspose8x8(v);
+	for (int i = 0; i < 3; i++)
+	{
+		_mm256_storeu_ps(block.m_linearComponentA[i], v[i]);
+		_mm256_storeu_ps(block.m_linearComponentB[i], v[4 + i]);
+	}
+
+	//m_friction, m_jacDiagABInv, m_rhs, m_cfm, m_lowerLimit and m_upperLimit follow each other
+	for (int lane = 0; lane < btSolverRowBatches::LANE_COUNT; lane++)
+		v[lane] = _mm256_loadu_ps(&rows[lane]->m_friction);
+	btTranspose8x8(v);
+	_mm256_storeu_ps(block.m_friction, v[0]);
+	_mm256_storeu_ps(block.m_jacDiagABInv, v[1]);
+	_mm256_storeu_ps(block.m_rhs, v[2]);
+	_mm256_storeu_ps(block.m_cfm, v[3]);
+	_mm256_storeu_ps(block.m_lowerLimit, v[4]);
+	_mm256_storeu_ps(block.m_upperLimit, v[5]);
+	const __m256 hasMass = _mm256_cmp_ps(v[1], _mm256_setzero_ps(), _CMP_NEQ_OQ);
+	_mm256_storeu_ps(block.m_residualScale, _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.f), v[1]), hasMass));
+
+	for (int lane = 0; lane < btSolverRowBatches::LANE_COUNT; lane++)
+		block.m_appliedImpulse[lane] = rows[lane]->m_appliedImpulse;
+}
+
+#endif  //BT_USE_ROW_BATCHES
+
+///Finds the first group at or after start that still has a free lane; numGroups means a new group.
+///Full groups point to the next group, and the path is compressed on the way back.
+static int btFindOpenGroup(btAlignedObjectArray<int>& nextOpen, int start)
+{
+	int open = start;
+	while (nextOpen[open] != open)
+		open = nextOpen[open];
+	while (nextOpen[start] != open)
+	{
+		int next = nextOpen[start];
+		nextOpen[start] = open;
+		start = next;
+	}
+	return open;
+}
+
+///First fit: each row goes to the first group with a free lane after the last group of either of its bodies.
+///A body with k rows needs at least k groups, so the group count is set by the most constrained body, not by the row count.
+void btSolverRowBatches::packRows(const btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& rows, const int* order,
+								  btAlignedObjectArray<int>& rowGroup, btAlignedObjectArray<int>& rowLane)
+{
+	const int numRows = rows.size();
+	rowGroup.resize(numRows);
+	rowLane.resize(numRows);
+
+	//kinematic and fixed bodies only have their velocity read, so any number of rows in a group may share them
+	m_bodyLastGroup.resizeNoInitialize(bodies.size());
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		const btRigidBody* body = bodies[i].m_originalBody;
+		m_bodyLastGroup[i] = (!body || body->getInvMass() == btScalar(0)) ? int(STATIC_BODY) : -1;
+	}
+	m_groupSize.resize(0);
+	m_nextOpenGroup.resize(0);
+	m_nextOpenGroup.push_back(0);
+
+	for (int j = 0; j < numRows; j++)
+	{
+		const int row = order[j];
+		const btSolverConstraint& c = rows[row];
+		int& lastGroupA = m_bodyLastGroup[c.m_solverBodyIdA];
+		int& lastGroupB = m_bodyLastGroup[c.m_solverBodyIdB];
+		const int start = btMax(btMax(lastGroupA, lastGroupB) + 1, 0);
+
+		const int group = btFindOpenGroup(m_nextOpenGroup, start);
+		if (group == m_groupSize.size())
+		{
+			m_groupSize.push_back(0);
+			m_nextOpenGroup.push_back(group + 1);
+		}
+		rowGroup[row] = group;
+		rowLane[row] = m_groupSize[group]++;
+		if (m_groupSize[group] == LANE_COUNT)
+			m_nextOpenGroup[group] = group + 1;
+
+		if (lastGroupA != STATIC_BODY)
+			lastGroupA = group;
+		if (lastGroupB != STATIC_BODY)
+			lastGroupB = group;
+	}
+	m_filledLanes += numRows;
+}
+
+void btSolverRowBatches::fillBlocks(btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& rows,
+									const btAlignedObjectArray<int>& rowGroup, const btAlignedObjectArray<int>& rowLane,
+									btAlignedObjectArray<btRowBlock>& blocks)
+{
+#if BT_USE_ROW_BATCHES
+	const int numGroups = m_groupSize.size();
+	blocks.resizeNoInitialize(numGroups);
+
+	m_laneRow.resizeNoInitialize(numGroups * LANE_COUNT);
+	for (int i = 0; i < m_laneRow.size(); i++)
+		m_laneRow[i] = -1;
+	for (int row = 0; row < rows.size(); row++)
+		m_laneRow[rowGroup[row] * LANE_COUNT + rowLane[row]] = row;
+
+	static const btVector3 noMass(0, 0, 0);
+	float* emptyLane = &m_emptyLaneVelocity[0][0];
+	for (int g = 0; g < numGroups; g++)
+	{
+		btRowBlock& block = blocks[g];
+		const btSolverConstraint* laneRows[LANE_COUNT];
+		const btVector3* invMassA[LANE_COUNT];
+		const btVector3* invMassB[LANE_COUNT];
+		for (int lane = 0; lane < LANE_COUNT; lane++)
+		{
+			const int row = m_laneRow[g * LANE_COUNT + lane];
+			block.m_row[lane] = row;
+			block.m_contactSlot[lane] = 0;
+			if (row < 0)
+			{
+				laneRows[lane] = &m_emptyRow;
+				invMassA[lane] = &noMass;
+				invMassB[lane] = &noMass;
+				block.m_bodyA[lane] = emptyLane;
+				block.m_bodyB[lane] = emptyLane;
+				continue;
+			}
+			const btSolverConstraint& c = rows[row];
+			btSolverBody& bodyA = bodies[c.m_solverBodyIdA];
+			btSolverBody& bodyB = bodies[c.m_solverBodyIdB];
+			laneRows[lane] = &c;
+			invMassA[lane] = &bodyA.internalGetInvMass();
+			invMassB[lane] = &bodyB.internalGetInvMass();
+			block.m_bodyA[lane] = &bodyA.m_deltaLinearVelocity[0];
+			block.m_bodyB[lane] = &bodyB.m_deltaLinearVelocity[0];
+		}
+		btFillBlockAVX2(block, laneRows, invMassA, invMassB);
+	}
+#else
+	(void)bodies;
+	(void)rows;
+	(void)rowGroup;
+	(void)rowLane;
+	(void)blocks;
+	btAssert(0);  //only called when isSupported()
+#endif
+}
+
+void btSolverRowBatches::build(btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& contacts, const int* contactOrder,
+							   const btConstraintArray& frictions, const int* frictionOrder)
+{
+	//the velocities are read as 8 floats from the delta linear velocity on
+	btAssert(offsetof(btSolverBody, m_deltaAngularVelocity) == offsetof(btSolverBody, m_deltaLinearVelocity) + 4 * sizeof(float));
+	m_filledLanes = 0;
+
+	packRows(bodies, contacts, contactOrder, m_contactGroup, m_contactLane);
+	fillBlocks(bodies, contacts, m_contactGroup, m_contactLane, m_contactBlocks);
+
+	packRows(bodies, frictions, frictionOrder, m_frictionGroup, m_frictionLane);
+	fillBlocks(bodies, frictions, m_frictionGroup, m_frictionLane, m_frictionBlocks);
+
+	//friction rows find the impulse of their contact by its float index in the contact blocks
+	const int blockFloats = sizeof(btRowBlock) / sizeof(float);
+	const int impulseOffset = offsetof(btRowBlock, m_appliedImpulse) / sizeof(float);
+	for (int row = 0; row < frictions.size(); row++)
+	{
+		const int contact = frictions[row].m_frictionIndex;
+		btAssert(contact >= 0 && contact < contacts.size());
+		m_frictionBlocks[m_frictionGroup[row]].m_contactSlot[m_frictionLane[row]] =
+			m_contactGroup[contact] * blockFloats + impulseOffset + m_contactLane[contact];
+	}
+}
+
+void btSolverRowBatches::writeBackContactImpulses(btConstraintArray& contacts) const
+{
+	for (int g = 0; g < m_contactBlocks.size(); g++)
+	{
+		const btRowBlock& block = m_contactBlocks[g];
+		for (int lane = 0; lane < LANE_COUNT && block.m_row[lane] >= 0; lane++)
+		{
+			contacts[block.m_row[lane]].m_appliedImpulse = block.m_appliedImpulse[lane];
+		}
+	}
+}
+
+void btSolverRowBatches::writeBack(btConstraintArray& contacts, btConstraintArray& frictions) const
+{
+	writeBackContactImpulses(contacts);
+	for (int g = 0; g < m_frictionBlocks.size(); g++)
+	{
+		const btRowBlock& block = m_frictionBlocks[g];
+		for (int lane = 0; lane < LANE_COUNT && block.m_row[lane] >= 0; lane++)
+		{
+			btSolverConstraint& c = frictions[block.m_row[lane]];
+			c.m_appliedImpulse = block.m_appliedImpulse[lane];
+			c.m_lowerLimit = block.m_lowerLimit[lane];
+			c.m_upperLimit = block.m_upperLimit[lane];
+		}
+	}
+}
+
+
+btScalar btSolverRowBatches::solveContactRows()
+{
+#if BT_USE_ROW_BATCHES
+	if (m_contactBlocks.size())
+		return btSolveContactBlocksAVX2(&m_contactBlocks[0], m_contactBlocks.size());
+#else
+	btAssert(0);  //only called when isSupported()
+#endif
+	return btScalar(0);
+}
+
+btScalar btSolverRowBatches::solveFrictionRows()
+{
+#if BT_USE_ROW_BATCHES
+	if (m_frictionBlocks.size())
+		return btSolveFrictionBlocksAVX2(&m_frictionBlocks[0], m_frictionBlocks.size(), (const float*)&m_contactBlocks[0]);
+#else
+	btAssert(0);  //only called when isSupported()
+#endif
+	return btScalar(0);
+}
+
+#if BT_SOLVER_ROW_BATCHES_ENABLE_BENCHMARK
+
+#include "btSequentialImpulseConstraintSolver.h"
+#include "btHingeConstraint.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btCylinderShape.h"
+#include "BulletCollision/CollisionShapes/btStaticPlaneShape.h"
+#include "LinearMath/btDefaultMotionState.h"
+#include "LinearMath/btQuickprof.h"
+#include <stdio.h>
+
+///times only the iterations, so the two modes are compared on the same setup work
+class btTimedIterationsSolver : public btSequentialImpulseConstraintSolver
+{
+public:
+	unsigned long long m_iterationMicroseconds;
+	int m_iterations;
+	int m_rows;
+
+	btTimedIterationsSolver() : m_iterationMicroseconds(0), m_iterations(0), m_rows(0) {}
+
+	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+	{
+		btClock clock;
+		btScalar result = btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyIterations(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+		m_iterationMicroseconds += clock.getTimeMicroseconds();
+		m_iterations += m_analyticsData.m_numIterationsUsed;
+		m_rows += (m_tmpSolverContactConstraintPool.size() + m_tmpSolverContactFrictionConstraintPool.size() + m_tmpSolverNonContactConstraintPool.size()) * m_analyticsData.m_numIterationsUsed;
+		return result;
+	}
+};
+
+struct btRowBatchesBenchmarkScene
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btTimedIterationsSolver m_solver;
+	btDiscreteDynamicsWorld m_world;
+	btStaticPlaneShape m_ground;
+	btBoxShape m_box;
+	btBoxShape m_chassis;
+	btCylinderShapeX m_wheel;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+
+	btRowBatchesBenchmarkScene(bool batched)
+		: m_dispatcher(&m_configuration),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+		  m_ground(btVector3(0, 1, 0), 0),
+		  m_box(btVector3(0.5, 0.5, 0.5)),
+		  m_chassis(btVector3(1.5, 0.4, 2.5)),
+		  m_wheel(btVector3(0.3, 0.5, 0.5))
+	{
+		m_world.getSolverInfo().m_numIterations = 10;
+		if (batched)
+			m_world.getSolverInfo().m_solverMode |= SOLVER_BATCHED_ROWS;
+		addBody(&m_ground, 0, btVector3(0, 0, 0));
+	}
+
+	~btRowBatchesBenchmarkScene()
+	{
+		for (int i = 0; i < m_constraints.size(); i++)
+		{
+			m_world.removeConstraint(m_constraints[i]);
+			delete m_constraints[i];
+		}
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeRigidBody(m_bodies[i]);
+			delete m_bodies[i]->getMotionState();
+			delete m_bodies[i];
+		}
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass > 0)
+			shape->calculateLocalInertia(mass, inertia);
+		btRigidBody* body = new btRigidBody(mass, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), position)), shape, inertia);
+		body->setActivationState(DISABLE_DEACTIVATION);
+		m_world.addRigidBody(body);
+		m_bodies.push_back(body);
+		return body;
+	}
+
+	///columns of boxes resting on each other; with a spacing of 1 the columns touch and form one island
+	void addStacks(int columns, int height, btScalar spacing)
+	{
+		for (int x = 0; x < columns; x++)
+			for (int z = 0; z < columns; z++)
+				for (int y = 0; y < height; y++)
+					addBody(&m_box, 1, btVector3(btScalar(x) * spacing, 0.5f + btScalar(y) * 1.01f, btScalar(z) * spacing));
+	}
+
+	///a line of tanks: a chassis on 8 wheels turning on hinges, driven forward by the hinge motors
+	void addConvoy(int tanks)
+	{
+		for (int t = 0; t < tanks; t++)
+		{
+			const btVector3 center(btScalar(t % 4) * 5, 1.0f, btScalar(t / 4) * 7);
+			btRigidBody* chassis = addBody(&m_chassis, 20, center);
+			for (int w = 0; w < 8; w++)
+			{
+				const btScalar side = (w & 1) ? btScalar(1.9) : btScalar(-1.9);
+				const btScalar along = btScalar(w / 2) * btScalar(1.3) - btScalar(1.95);
+				btRigidBody* wheel = addBody(&m_wheel, 2, center + btVector3(side, -0.5f, along));
+				btHingeConstraint* hinge = new btHingeConstraint(*chassis, *wheel, btVector3(side, -0.5f, along), btVector3(0, 0, 0),
+																 btVector3(1, 0, 0), btVector3(1, 0, 0));
+				hinge->enableAngularMotor(true, 4, 50);
+				m_world.addConstraint(hinge, true);
+				m_constraints.push_back(hinge);
+			}
+		}
+	}
+};
+
+static void btRunRowBatchesBenchmark(const char* name, int stackColumns, int stackHeight, btScalar stackSpacing, int tanks)
+{
+	const int warmupSteps = 60;
+	const int timedSteps = 240;
+	double microsecondsPerIteration[2];
+	for (int batched = 0; batched < 2; batched++)
+	{
+		btRowBatchesBenchmarkScene scene(batched != 0);
+		scene.addStacks(stackColumns, stackHeight, stackSpacing);
+		scene.addConvoy(tanks);
+		for (int i = 0; i < warmupSteps; i++)
+			scene.m_world.stepSimulation(1.f / 60.f, 0);
+		scene.m_solver.m_iterationMicroseconds = 0;
+		scene.m_solver.m_iterations = 0;
+		scene.m_solver.m_rows = 0;
+		for (int i = 0; i < timedSteps; i++)
+			scene.m_world.stepSimulation(1.f / 60.f, 0);
+
+		microsecondsPerIteration[batched] = double(scene.m_solver.m_iterationMicroseconds) / btMax(scene.m_solver.m_iterations, 1);
+		printf("%s %s: %.1f us per iteration, %.1f rows per us\n", name, batched ? "batched " : "per row ",
+			   microsecondsPerIteration[batched],
+			   double(scene.m_solver.m_rows) / btMax(double(scene.m_solver.m_iterationMicroseconds), 1.0));
+	}
+	printf("%s speedup %.2fx\n", name, microsecondsPerIteration[0] / btMax(microsecondsPerIteration[1], 1e-9));
+}
+
+void btSolverRowBatches::benchmark()
+{
+	if (!isSupported())
+	{
+		printf("btSolverRowBatches benchmark: AVX2 and FMA3 are not available\n");
+		return;
+	}
+	btRunRowBatchesBenchmark("stacked boxes (8x8 columns of 10)", 8, 10, 1.5f, 0);
+	btRunRowBatchesBenchmark("stacked boxes (8x8 touching columns of 10)", 8, 10, 1.0f, 0);
+	btRunRowBatchesBenchmark("tank convoy (16 tanks)", 0, 0, 0, 16);
+}
+
+#endif  //BT_SOLVER_ROW_BATCHES_ENABLE_BENCHMARK
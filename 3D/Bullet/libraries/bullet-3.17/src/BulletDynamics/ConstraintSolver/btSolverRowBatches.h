@@ -0,0 +1,136 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SOLVER_ROW_BATCHES_H
+#define BT_SOLVER_ROW_BATCHES_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "btSolverBody.h"
+#include "btSolverConstraint.h"
+
+#ifndef BT_SOLVER_ROW_BATCHES_ENABLE_BENCHMARK
+#define BT_SOLVER_ROW_BATCHES_ENABLE_BENCHMARK 0
+#endif
+
+///btSolverRowBatches solves the contact and friction rows of btSequentialImpulseConstraintSolver eight at a time with AVX2.
+///build() packs the rows into lane groups where no two rows share a dynamic body. A row is never placed before an earlier
+///row of one of its bodies, so sweeping the groups in order gives the same Gauss Seidel update as sweeping the rows one by one.
+///The row data is copied once per solve into structure-of-arrays blocks. The velocities of the bodies are gathered
+///before each group and scattered back after it, so the bodies stay in the btSolverBody pool the other kernels use.
+///Only available for single precision builds on CPUs with AVX2 and FMA3, see isSupported().
+class btSolverRowBatches
+{
+public:
+	enum
+	{
+		LANE_COUNT = 8,
+		STATIC_BODY = -2
+	};
+
+	btSolverRowBatches();
+
+	///true when the CPU runs the AVX2 kernels and btScalar is float
+	static bool isSupported();
+
+	///packs the rows in the given solve order. Friction rows read the impulse of contacts[m_frictionIndex].
+	///The bodies must not be added or removed until the solve is over.
+	void build(btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& contacts, const int* contactOrder,
+			   const btConstraintArray& frictions, const int* frictionOrder);
+	void clear();
+
+	///one sweep over the contact rows, clamped at their lower limit. Returns the largest squared residual.
+	btScalar solveContactRows();
+	///one sweep over the friction rows, bounded by the current impulse of their contact. Returns the largest squared residual.
+	btScalar solveFrictionRows();
+	///copies the impulses and the friction limits back to the solver constraints
+	void writeBack(btConstraintArray& contacts, btConstraintArray& frictions) const;
+	///copies only the contact impulses, for rows solved by the per-row kernels that are bounded by them
+	void writeBackContactImpulses(btConstraintArray& contacts) const;
+
+	bool isEmpty() const
+	{
+		return m_contactBlocks.size() == 0 && m_frictionBlocks.size() == 0;
+	}
+
+	int getContactGroupCount() const
+	{
+		return m_contactBlocks.size();
+	}
+	int getFrictionGroupCount() const
+	{
+		return m_frictionBlocks.size();
+	}
+	///filled lanes divided by all lanes, 1 when every group is full
+	btScalar getLaneOccupancy() const;
+
+#if BT_SOLVER_ROW_BATCHES_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
+
+private:
+	///the rows of one lane group, one array entry per lane
+	struct btRowBlock
+	{
+		float m_contactNormal1[3][LANE_COUNT];
+		float m_relpos1CrossNormal[3][LANE_COUNT];
+		float m_contactNormal2[3][LANE_COUNT];
+		float m_relpos2CrossNormal[3][LANE_COUNT];
+		float m_linearComponentA[3][LANE_COUNT];  ///< m_contactNormal1 times the inverse mass of body A
+		float m_linearComponentB[3][LANE_COUNT];
+		float m_angularComponentA[3][LANE_COUNT];
+		float m_angularComponentB[3][LANE_COUNT];
+		float m_jacDiagABInv[LANE_COUNT];
+		float m_residualScale[LANE_COUNT];  ///< 1 / m_jacDiagABInv, 0 in empty lanes
+		float m_rhs[LANE_COUNT];
+		float m_cfm[LANE_COUNT];
+		float m_lowerLimit[LANE_COUNT];
+		float m_upperLimit[LANE_COUNT];
+		float m_appliedImpulse[LANE_COUNT];
+		float m_friction[LANE_COUNT];
+		int m_contactSlot[LANE_COUNT];  ///< friction rows: float index of the contact impulse, counted from the first contact block
+		int m_row[LANE_COUNT];          ///< index in the constraint pool, -1 in empty lanes
+		float* m_bodyA[LANE_COUNT];     ///< delta linear velocity of the body, followed by its delta angular velocity
+		float* m_bodyB[LANE_COUNT];
+	};
+
+	void packRows(const btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& rows, const int* order,
+				  btAlignedObjectArray<int>& rowGroup, btAlignedObjectArray<int>& rowLane);
+	void fillBlocks(btAlignedObjectArray<btSolverBody>& bodies, const btConstraintArray& rows,
+					const btAlignedObjectArray<int>& rowGroup, const btAlignedObjectArray<int>& rowLane,
+					btAlignedObjectArray<btRowBlock>& blocks);
+
+	btAlignedObjectArray<btRowBlock> m_contactBlocks;
+	btAlignedObjectArray<btRowBlock> m_frictionBlocks;
+
+	//scratch of build(), kept to avoid allocations every step
+	btAlignedObjectArray<int> m_contactGroup;
+	btAlignedObjectArray<int> m_contactLane;
+	btAlignedObjectArray<int> m_frictionGroup;
+	btAlignedObjectArray<int> m_frictionLane;
+	btAlignedObjectArray<int> m_bodyLastGroup;  ///< last group with a row of the body, -1 before the first, STATIC_BODY for bodies that never conflict
+	btAlignedObjectArray<int> m_groupSize;
+	btAlignedObjectArray<int> m_nextOpenGroup;
+	btAlignedObjectArray<int> m_laneRow;
+
+	int m_filledLanes;
+	btVector3 m_emptyLaneVelocity[2];  ///< target of the empty lanes, stays zero
+	btSolverConstraint m_emptyRow;     ///< source of the empty lanes, all zero
+};
+
+#endif  //BT_SOLVER_ROW_BATCHES_H
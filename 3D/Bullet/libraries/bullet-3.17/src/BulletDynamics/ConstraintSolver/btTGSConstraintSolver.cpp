@@ -0,0 +1,440 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btTGSConstraintSolver.h"
+#include "BulletCollision/NarrowPhaseCollision/btPersistentManifold.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btTransformUtil.h"
+
+btTGSConstraintSolver::btTGSConstraintSolver(int numSubsteps, int substepIterations)
+	: m_numSubsteps(btMax(numSubsteps, 1)),
+	  m_substepIterations(btMax(substepIterations, 1)),
+	  m_warmstartJointRows(false)
+{
+}
+
+void btTGSConstraintSolver::integrateBodies(btScalar timeStep)
+{
+	btTransform predictedTrans;
+	for (int i = 0; i < m_movedBodies.size(); i++)
+	{
+		btRigidBody* body = m_movedBodies[i];
+		body->predictIntegratedTransform(timeStep, predictedTrans);
+		body->setWorldTransform(predictedTrans);
+		body->updateInertiaTensor();
+	}
+}
+
+void btTGSConstraintSolver::moveToStepStart(btScalar timeStep)
+{
+	m_substepTransforms.resizeNoInitialize(m_movedBodies.size());
+	btTransform startTrans;
+	for (int i = 0; i < m_movedBodies.size(); i++)
+	{
+		btRigidBody* body = m_movedBodies[i];
+		m_substepTransforms[i] = body->getWorldTransform();
+		btTransformUtil::integrateTransformInverse(m_substepTransforms[i], body->getLinearVelocity(), body->getAngularVelocity(), timeStep, startTrans);
+		body->setWorldTransform(startTrans);
+		body->updateInertiaTensor();
+	}
+}
+
+void btTGSConstraintSolver::warmstartJointRows(int numConstraints, const btContactSolverInfo& infoGlobal)
+{
+	if (m_tmpConstraintSizesPool.size() != numConstraints || m_jointRowCounts.size() != numConstraints ||
+		m_jointRowImpulses.size() != m_tmpSolverNonContactConstraintPool.size())
+	{
+		return;
+	}
+	int row = 0;
+	for (int i = 0; i < numConstraints; i++)
+	{
+		const int numRows = m_tmpConstraintSizesPool[i].m_numConstraintRows;
+		if (numRows == m_jointRowCounts[i])
+		{
+			for (int j = row; j < row + numRows; j++)
+			{
+				btSolverConstraint& solverConstraint = m_tmpSolverNonContactConstraintPool[j];
+				btScalar impulse = m_jointRowImpulses[j] * infoGlobal.m_warmstartingFactor;
+				impulse = btMax(btScalar(solverConstraint.m_lowerLimit), btMin(btScalar(solverConstraint.m_upperLimit), impulse));
+				solverConstraint.m_appliedImpulse = impulse;
+				btSolverBody& bodyA = m_tmpSolverBodyPool[solverConstraint.m_solverBodyIdA];
+				btSolverBody& bodyB = m_tmpSolverBodyPool[solverConstraint.m_solverBodyIdB];
+				bodyA.internalApplyImpulse(solverConstraint.m_contactNormal1 * bodyA.internalGetInvMass(), solverConstraint.m_angularComponentA, impulse);
+				bodyB.internalApplyImpulse(solverConstraint.m_contactNormal2 * bodyB.internalGetInvMass(), solverConstraint.m_angularComponentB, impulse);
+			}
+		}
+		row += numRows;
+	}
+}
+
+btScalar btTGSConstraintSolver::solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer)
+{
+	btScalar val = btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
+	if (m_warmstartJointRows && (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING))
+	{
+		warmstartJointRows(numConstraints, infoGlobal);
+	}
+	return val;
+}
+
+btScalar btTGSConstraintSolver::solveGroupCacheFriendlyFinish(btCollisionObject** bodies, int numBodies, const btContactSolverInfo& infoGlobal)
+{
+	m_jointRowImpulses.resizeNoInitialize(m_tmpSolverNonContactConstraintPool.size());
+	for (int j = 0; j < m_tmpSolverNonContactConstraintPool.size(); j++)
+	{
+		m_jointRowImpulses[j] = m_tmpSolverNonContactConstraintPool[j].m_appliedImpulse;
+	}
+	m_jointRowCounts.resizeNoInitialize(m_tmpConstraintSizesPool.size());
+	for (int i = 0; i < m_tmpConstraintSizesPool.size(); i++)
+	{
+		m_jointRowCounts[i] = m_tmpConstraintSizesPool[i].m_numConstraintRows;
+	}
+	return btSequentialImpulseConstraintSolver::solveGroupCacheFriendlyFinish(bodies, numBodies, infoGlobal);
+}
+
+btScalar btTGSConstraintSolver::solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer, btDispatcher* dispatcher)
+{
+	BT_PROFILE("solveGroupTGS");
+	if (m_numSubsteps == 1)
+	{
+		return btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer, dispatcher);
+	}
+
+	btContactSolverInfo substepInfo = infoGlobal;
+	substepInfo.m_timeStep = infoGlobal.m_timeStep / btScalar(m_numSubsteps);
+	substepInfo.m_numIterations = m_substepIterations;
+	//each substep measures the penetration again, so m_erp2 per substep would recover far more of it per step
+	substepInfo.m_erp2 = btScalar(1) - btPow(btScalar(1) - infoGlobal.m_erp2, btScalar(1) / btScalar(m_numSubsteps));
+
+	m_movedBodies.resize(0);
+	for (int i = 0; i < numBodies; i++)
+	{
+		btRigidBody* body = btRigidBody::upcast(bodies[i]);
+		if (body && body->isActive() && !body->isStaticOrKinematicObject())
+		{
+			m_movedBodies.push_back(body);
+		}
+	}
+
+	//every substep adds its impulse divided by the substep to the joint feedback
+	m_feedbackAtStart.resizeNoInitialize(numConstraints);
+	for (int i = 0; i < numConstraints; i++)
+	{
+		if (constraints[i]->getJointFeedback())
+		{
+			m_feedbackAtStart[i] = *constraints[i]->getJointFeedback();
+		}
+	}
+
+	int iterationsUsed = 0;
+	for (int substep = 0; substep < m_numSubsteps; substep++)
+	{
+		if (substep)
+		{
+			BT_PROFILE("refreshContactPoints");
+			for (int i = 0; i < numManifolds; i++)
+			{
+				btPersistentManifold* manifold = manifoldPtr[i];
+				manifold->refreshContactPoints(manifold->getBody0()->getWorldTransform(), manifold->getBody1()->getWorldTransform());
+			}
+		}
+
+		btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies, manifoldPtr, numManifolds, constraints, numConstraints, substepInfo, debugDrawer, dispatcher);
+		iterationsUsed += m_analyticsData.m_numIterationsUsed;
+		m_warmstartJointRows = true;
+
+		integrateBodies(substepInfo.m_timeStep);
+	}
+	m_warmstartJointRows = false;
+	//the analytics of the step: the iterations of all the substeps, the residual of the last one
+	m_analyticsData.m_numIterationsUsed = iterationsUsed;
+
+	//the world integrates the whole step with the final velocities after the solve
+	moveToStepStart(infoGlobal.m_timeStep);
+
+	const btScalar feedbackScale = btScalar(1) / btScalar(m_numSubsteps);
+	for (int i = 0; i < numConstraints; i++)
+	{
+		btJointFeedback* feedback = constraints[i]->getJointFeedback();
+		if (feedback)
+		{
+			const btJointFeedback& start = m_feedbackAtStart[i];
+			feedback->m_appliedForceBodyA = start.m_appliedForceBodyA + (feedback->m_appliedForceBodyA - start.m_appliedForceBodyA) * feedbackScale;
+			feedback->m_appliedTorqueBodyA = start.m_appliedTorqueBodyA + (feedback->m_appliedTorqueBodyA - start.m_appliedTorqueBodyA) * feedbackScale;
+			feedback->m_appliedForceBodyB = start.m_appliedForceBodyB + (feedback->m_appliedForceBodyB - start.m_appliedForceBodyB) * feedbackScale;
+			feedback->m_appliedTorqueBodyB = start.m_appliedTorqueBodyB + (feedback->m_appliedTorqueBodyB - start.m_appliedTorqueBodyB) * feedbackScale;
+		}
+	}
+	return 0.f;
+}
+
+#if BT_TGS_CONSTRAINT_SOLVER_ENABLE_BENCHMARK
+
+#include "btNNCGConstraintSolver.h"
+#include "btHingeConstraint.h"
+#include "btFixedConstraint.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include "LinearMath/btDefaultMotionState.h"
+#include <stdio.h>
+
+///a row of the tanks of the demo standing on the ground, driven forward, firing like Tank::shoot every second: a projectile
+///placed against the cannon is pushed with 3000N for one step
+struct btJointDriftBenchmarkScene
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btDiscreteDynamicsWorld m_world;
+	btBoxShape m_ground;
+	btBoxShape m_chassis;
+	btBoxShape m_track;
+	btBoxShape m_turret;
+	btBoxShape m_cannon;
+	btSphereShape m_projectile;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<btRigidBody*> m_tracks;
+	btAlignedObjectArray<btRigidBody*> m_cannons;
+	btAlignedObjectArray<btRigidBody*> m_projectiles;
+
+	btJointDriftBenchmarkScene(btConstraintSolver* solver, int tanks, int numIterations)
+		: m_dispatcher(&m_configuration),
+		  m_world(&m_dispatcher, &m_broadphase, solver, &m_configuration),
+		  m_ground(btVector3(200, 1, 200)),
+		  m_chassis(btVector3(1.0, 0.2, 1.0)),
+		  m_track(btVector3(0.25, 0.25, 1.0)),
+		  m_turret(btVector3(0.5, 0.2, 0.35)),
+		  m_cannon(btVector3(0.2, 0.1, 0.5)),
+		  m_projectile(0.25)
+	{
+		m_world.setGravity(btVector3(0, -10, 0));
+		m_world.getSolverInfo().m_numIterations = numIterations;
+		m_world.getSolverInfo().m_linearSlop = 0.01f;
+		m_world.getSolverInfo().m_restitution = 0;
+		addBody(&m_ground, 0, btVector3(0, -1.26f, 0), 1, 6);
+		for (int t = 0; t < tanks; t++)
+		{
+			const btVector3 center(btScalar(t) * 6, 0, 0);
+			//tracks touch the ground, projectiles hit the ground and the cannon, the parts of one tank do not collide with each other
+			btRigidBody* chassis = addBody(&m_chassis, 1, center, 2, 0);
+			btRigidBody* leftTrack = addBody(&m_track, 1, center + btVector3(-1.2f, 0, 0), 2, 1);
+			btRigidBody* rightTrack = addBody(&m_track, 1, center + btVector3(1.2f, 0, 0), 2, 1);
+			btRigidBody* turret = addBody(&m_turret, 1, center + btVector3(0, 0.5f, 0), 2, 0);
+			btRigidBody* cannon = addBody(&m_cannon, 1, center + btVector3(0, 0.5f, -0.85f), 2, 4);
+			addConstraint(new btHingeConstraint(*chassis, *leftTrack, btVector3(-1.2f, 0, 0), btVector3(0, 0, 0), btVector3(0, 1, 0), btVector3(0, 1, 0)));
+			addConstraint(new btHingeConstraint(*chassis, *rightTrack, btVector3(1.2f, 0, 0), btVector3(0, 0, 0), btVector3(0, 1, 0), btVector3(0, 1, 0)));
+			btTransform frameInA = btTransform::getIdentity();
+			frameInA.setOrigin(btVector3(0, 0.5f, 0));
+			addConstraint(new btFixedConstraint(*chassis, *turret, frameInA, btTransform::getIdentity()));
+			frameInA.setOrigin(btVector3(0, 0, -0.85f));
+			addConstraint(new btFixedConstraint(*turret, *cannon, frameInA, btTransform::getIdentity()));
+			m_tracks.push_back(leftTrack);
+			m_tracks.push_back(rightTrack);
+			m_cannons.push_back(cannon);
+			m_projectiles.push_back(addBody(&m_projectile, 1, center + btVector3(0, 0, 150), 4, 3));
+		}
+	}
+
+	~btJointDriftBenchmarkScene()
+	{
+		for (int i = 0; i < m_constraints.size(); i++)
+		{
+			m_world.removeConstraint(m_constraints[i]);
+			delete m_constraints[i];
+		}
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeRigidBody(m_bodies[i]);
+			delete m_bodies[i]->getMotionState();
+			delete m_bodies[i];
+		}
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position, int group, int mask)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass != 0)
+			shape->calculateLocalInertia(mass, inertia);
+		btRigidBody* body = new btRigidBody(mass, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), position)), shape, inertia);
+		if (mass != 0)
+			body->setActivationState(DISABLE_DEACTIVATION);
+		m_world.addRigidBody(body, group, mask);
+		m_bodies.push_back(body);
+		return body;
+	}
+
+	void addConstraint(btTypedConstraint* constraint)
+	{
+		m_world.addConstraint(constraint, true);
+		m_constraints.push_back(constraint);
+	}
+
+	void step(int stepIndex)
+	{
+		for (int i = 0; i < m_tracks.size(); i++)
+			m_tracks[i]->applyCentralForce(btVector3(0, 0, -20));
+		if (stepIndex % 60 == 30)
+		{
+			for (int i = 0; i < m_cannons.size(); i++)
+			{
+				const btTransform& cannon = m_cannons[i]->getWorldTransform();
+				btRigidBody* projectile = m_projectiles[i];
+				projectile->setWorldTransform(btTransform(btQuaternion::getIdentity(), cannon * btVector3(0, 0, -0.5f)));
+				projectile->setLinearVelocity(btVector3(0, 0, 0));
+				projectile->setAngularVelocity(btVector3(0, 0, 0));
+				projectile->applyCentralForce(cannon.getBasis() * btVector3(0, 0, -3000));
+			}
+		}
+		m_world.stepSimulation(1.f / 60.f, 0);
+	}
+
+	///largest distance between the pivots of a joint and largest angle between its frames
+	void measureDrift(btScalar& maxDistance, btScalar& maxAngle)
+	{
+		maxDistance = 0;
+		maxAngle = 0;
+		for (int i = 0; i < m_constraints.size(); i++)
+		{
+			btTransform frameA, frameB;
+			if (m_constraints[i]->getConstraintType() == HINGE_CONSTRAINT_TYPE)
+			{
+				btHingeConstraint* hinge = static_cast<btHingeConstraint*>(m_constraints[i]);
+				frameA = hinge->getRigidBodyA().getCenterOfMassTransform() * hinge->getAFrame();
+				frameB = hinge->getRigidBodyB().getCenterOfMassTransform() * hinge->getBFrame();
+				//a hinge may turn about its axis
+				maxAngle = btMax(maxAngle, frameA.getBasis().getColumn(2).angle(frameB.getBasis().getColumn(2)));
+			}
+			else
+			{
+				btGeneric6DofSpring2Constraint* fixed = static_cast<btGeneric6DofSpring2Constraint*>(m_constraints[i]);
+				frameA = fixed->getRigidBodyA().getCenterOfMassTransform() * fixed->getFrameOffsetA();
+				frameB = fixed->getRigidBodyB().getCenterOfMassTransform() * fixed->getFrameOffsetB();
+				maxAngle = btMax(maxAngle, frameA.getRotation().angleShortestPath(frameB.getRotation()));
+			}
+			maxDistance = btMax(maxDistance, (frameA.getOrigin() - frameB.getOrigin()).length());
+		}
+	}
+};
+
+void btTGSConstraintSolver::benchmark()
+{
+	//a box spinning on the ground faster than the world's integration turns a body in one step: after each step the world
+	//must leave it at the pose the substeps moved it to
+	for (int useBodyIntegrator = 0; useBodyIntegrator < 2; useBodyIntegrator++)
+	{
+		btTGSConstraintSolver solver(4, 2);
+		btJointDriftBenchmarkScene scene(&solver, 0, 10);
+		scene.m_world.setUseBodyIntegrator(useBodyIntegrator != 0);
+		btRigidBody* box = scene.addBody(&scene.m_chassis, 1, btVector3(0, -0.05f, 0), 2, 1);
+		const btScalar spin = 100;  // turns 1.67 rad in a step, above ANGULAR_MOTION_THRESHOLD
+		btScalar maxDistance = 0, maxAngle = 0;
+		int checkedSteps = 0;
+		for (int i = 0; i < 120; i++)
+		{
+			box->setAngularVelocity(btVector3(0, spin, 0));
+			scene.step(i);
+			if (solver.m_movedBodies.size() == 1 && solver.m_movedBodies[0] == box)
+			{
+				const btTransform& substepTrans = solver.m_substepTransforms[0];
+				maxDistance = btMax(maxDistance, (box->getWorldTransform().getOrigin() - substepTrans.getOrigin()).length());
+				btQuaternion diff = box->getWorldTransform().getRotation().inverse() * substepTrans.getRotation();
+				maxAngle = btMax(maxAngle, 2 * btAtan2(btVector3(diff.x(), diff.y(), diff.z()).length(), btFabs(diff.w())));
+				checkedSteps++;
+			}
+		}
+		printf("fast spin%-11s %d steps, distance to the substepped pose max %g m, angle max %g deg\n", useBodyIntegrator ? " (blocks)" : "",
+			   checkedSteps, maxDistance, btDegrees(maxAngle));
+	}
+
+
+	const int tanks = 20;
+	const int steps = 600;
+	const int numRuns = 9;
+	const char* names[numRuns] = {"SI 10 iterations", "SI 20 iterations", "SI 40 iterations", "NNCG 10 iterations", "NNCG 20 iterations",
+								  "TGS 2 x 5", "TGS 4 x 2", "TGS 4 x 3", "TGS 8 x 1"};
+	for (int run = 0; run < numRuns; run++)
+	{
+		btSequentialImpulseConstraintSolver* solver;
+		int numIterations = 10;
+		switch (run)
+		{
+			case 0:
+			case 1:
+			case 2:
+				solver = new btSequentialImpulseConstraintSolver();
+				numIterations = run == 0 ? 10 : run == 1 ? 20 : 40;
+				break;
+			case 3:
+			case 4:
+				solver = new btNNCGConstraintSolver();
+				numIterations = run == 3 ? 10 : 20;
+				break;
+			case 5:
+				solver = new btTGSConstraintSolver(2, 5);
+				break;
+			case 6:
+				solver = new btTGSConstraintSolver(4, 2);
+				break;
+			case 7:
+				solver = new btTGSConstraintSolver(4, 3);
+				break;
+			default:
+				solver = new btTGSConstraintSolver(8, 1);
+				break;
+		}
+		btScalar sumDistance = 0, worstDistance = 0, worstAngle = 0;
+		unsigned long long microseconds = 0;
+		int divergedStep = -1;
+		{
+			btJointDriftBenchmarkScene scene(solver, tanks, numIterations);
+			btClock clock;
+			for (int i = 0; i < steps && divergedStep < 0; i++)
+			{
+				clock.reset();
+				scene.step(i);
+				microseconds += clock.getTimeMicroseconds();
+				btScalar distance, angle;
+				scene.measureDrift(distance, angle);
+				if (!(distance < BT_LARGE_FLOAT))
+				{
+					divergedStep = i;
+					break;
+				}
+				sumDistance += distance;
+				worstDistance = btMax(worstDistance, distance);
+				worstAngle = btMax(worstAngle, angle);
+			}
+		}
+		if (divergedStep >= 0)
+		{
+			printf("%-20s diverged at step %d\n", names[run], divergedStep);
+		}
+		else
+		{
+			printf("%-20s %6.3f ms/step  joint drift mean %7.2f mm, max %7.2f mm, max angle %6.2f deg\n", names[run],
+				   double(microseconds) / steps / 1000.0, sumDistance / steps * 1000, worstDistance * 1000, btDegrees(worstAngle));
+		}
+		delete solver;
+	}
+}
+
+#endif  //BT_TGS_CONSTRAINT_SOLVER_ENABLE_BENCHMARK
@@ -0,0 +1,105 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_TGS_CONSTRAINT_SOLVER_H
+#define BT_TGS_CONSTRAINT_SOLVER_H
+
+#include "btSequentialImpulseConstraintSolver.h"
+
+#ifndef BT_TGS_CONSTRAINT_SOLVER_ENABLE_BENCHMARK
+#define BT_TGS_CONSTRAINT_SOLVER_ENABLE_BENCHMARK 0
+#endif
+
+///btTGSConstraintSolver is a temporal Gauss Seidel variant of the sequential impulse solver: instead of many iterations
+///over one time step it splits the step into substeps with a few iterations each, and moves the bodies after every substep.
+///Joint rows are rebuilt from the moved bodies, so their position error is measured again instead of being extrapolated,
+///which keeps stiff chains such as fixed joints rigid with far fewer iterations in total. Within a step the joint rows
+///are warm started from the previous substep, like the contacts are from the previous step.
+///Collision detection still runs once per step: between substeps the contact points are refreshed from the moved bodies.
+///The contact error reduction is relaxed so the penetration recovered over a whole step stays the same as with m_erp2.
+///The world integrates the bodies after the solve, so the last substep leaves each body at a pose that the world's
+///integration with the final velocity takes to the pose reached by the substeps, like the split impulse correction.
+///Breaking impulse thresholds of the joints apply to the impulse of one substep.
+ATTRIBUTE_ALIGNED16(class)
+btTGSConstraintSolver : public btSequentialImpulseConstraintSolver
+{
+protected:
+	int m_numSubsteps;
+	int m_substepIterations;
+
+	//storage kept between steps to avoid allocations
+	btAlignedObjectArray<btRigidBody*> m_movedBodies;  ///< the bodies the world would integrate
+	btAlignedObjectArray<btTransform> m_substepTransforms;  ///< the poses the substeps moved m_movedBodies to
+	btAlignedObjectArray<btJointFeedback> m_feedbackAtStart;
+
+	//impulses of the joint rows in the previous substep, to warm start the next one
+	btAlignedObjectArray<btScalar> m_jointRowImpulses;
+	btAlignedObjectArray<int> m_jointRowCounts;
+	bool m_warmstartJointRows;
+
+	///moves m_movedBodies with their current velocities
+	void integrateBodies(btScalar timeStep);
+	///stores the poses of m_movedBodies in m_substepTransforms and moves each body back to the pose the world's
+	///integration over timeStep with its final velocities takes to that pose
+	void moveToStepStart(btScalar timeStep);
+	///starts the joint rows from the impulses of the previous substep, for joints that still have the same rows
+	void warmstartJointRows(int numConstraints, const btContactSolverInfo& infoGlobal);
+
+	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
+	virtual btScalar solveGroupCacheFriendlyFinish(btCollisionObject * *bodies, int numBodies, const btContactSolverInfo& infoGlobal);
+
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btTGSConstraintSolver(int numSubsteps = 4, int substepIterations = 2);
+
+	virtual btScalar solveGroup(btCollisionObject * *bodies, int numBodies, btPersistentManifold** manifold, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btDispatcher* dispatcher);
+
+	virtual btConstraintSolverType getSolverType() const
+	{
+		return BT_TGS_SOLVER;
+	}
+
+	///number of substeps per step, 1 makes this a plain sequential impulse solver
+	void setNumSubsteps(int numSubsteps)
+	{
+		m_numSubsteps = btMax(numSubsteps, 1);
+	}
+	int getNumSubsteps() const
+	{
+		return m_numSubsteps;
+	}
+
+	///iterations of each substep, used instead of btContactSolverInfo::m_numIterations
+	void setSubstepIterations(int iterations)
+	{
+		m_substepIterations = btMax(iterations, 1);
+	}
+	int getSubstepIterations() const
+	{
+		return m_substepIterations;
+	}
+
+	///drift of the tank joints against CPU time, compared with btSequentialImpulseConstraintSolver and btNNCGConstraintSolver
+#if BT_TGS_CONSTRAINT_SOLVER_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
+};
+
+#endif  //BT_TGS_CONSTRAINT_SOLVER_H
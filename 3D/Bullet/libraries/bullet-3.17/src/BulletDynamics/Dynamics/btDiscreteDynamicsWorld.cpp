@@ -26,6 +26,7 @@ subject to the following restrictions:
 
 //rigidbody & constraints
 #include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "BulletDynamics/Dynamics/btRigidBodyIntegrator.h"
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 #include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
@@ -75,6 +76,32 @@ public:
 	}
 };
 
+///an island kept back by InplaceSolverIslandCallback until all islands of the step are known
+struct btDeferredIsland
+{
+	int m_islandId;
+	int m_firstBody;
+	int m_numBodies;
+	int m_firstManifold;
+	int m_numManifolds;
+	int m_firstConstraint;
+	int m_numConstraints;
+};
+
+///orders the islands by their number of contact manifolds and constraints, smallest first
+class btSortDeferredIslandPredicate
+{
+public:
+	bool operator()(const btDeferredIsland& lhs, const btDeferredIsland& rhs) const
+	{
+		int lhsSize = lhs.m_numManifolds + lhs.m_numConstraints;
+		int rhsSize = rhs.m_numManifolds + rhs.m_numConstraints;
+		if (lhsSize != rhsSize)
+			return lhsSize < rhsSize;
+		return lhs.m_islandId < rhs.m_islandId;
+	}
+};
+
 struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCallback
 {
 	btContactSolverInfo* m_solverInfo;
@@ -87,6 +114,8 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 	btAlignedObjectArray<btCollisionObject*> m_bodies;
 	btAlignedObjectArray<btPersistentManifold*> m_manifolds;
 	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<btDeferredIsland> m_islands;
+	btAlignedObjectArray<btSolverAnalyticsData> m_islandAnalyticsData;
 
 	InplaceSolverIslandCallback(
 		btConstraintSolver* solver,
@@ -118,6 +147,19 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 		m_bodies.resize(0);
 		m_manifolds.resize(0);
 		m_constraints.resize(0);
+		m_islands.resize(0);
+		m_islandAnalyticsData.resize(0);
+	}
+
+	void reportAnalytics(int islandId)
+	{
+		const btSolverAnalyticsData* analyticsData = (m_solverInfo->m_reportSolverAnalytics & 1) ? m_solver->getAnalyticsData() : 0;
+		if (analyticsData)
+		{
+			btSolverAnalyticsData data = *analyticsData;
+			data.m_islandId = islandId;
+			m_islandAnalyticsData.push_back(data);
+		}
 	}
 
 	virtual void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId)
@@ -126,6 +168,7 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 		{
 			///we don't split islands, so all constraints/contact manifolds/bodies are passed into the solver regardless the island id
 			m_solver->solveGroup(bodies, numBodies, manifolds, numManifolds, &m_sortedConstraints[0], m_numConstraints, *m_solverInfo, m_debugDrawer, m_dispatcher);
+			reportAnalytics(islandId);
 		}
 		else
 		{
@@ -134,27 +177,50 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 			int numCurConstraints = 0;
 			int i;
 
-			//find the first constraint for this island
-			for (i = 0; i < m_numConstraints; i++)
+			//find the first constraint for this island, the constraints are sorted by island
+			int lo = 0;
+			int hi = m_numConstraints;
+			while (lo < hi)
 			{
-				if (btGetConstraintIslandId(m_sortedConstraints[i]) == islandId)
-				{
-					startConstraint = &m_sortedConstraints[i];
-					break;
-				}
+				int mid = (lo + hi) / 2;
+				if (btGetConstraintIslandId(m_sortedConstraints[mid]) < islandId)
+					lo = mid + 1;
+				else
+					hi = mid;
 			}
 			//count the number of constraints in this island
-			for (; i < m_numConstraints; i++)
+			for (i = lo; i < m_numConstraints && btGetConstraintIslandId(m_sortedConstraints[i]) == islandId; i++)
 			{
-				if (btGetConstraintIslandId(m_sortedConstraints[i]) == islandId)
-				{
-					numCurConstraints++;
-				}
+				numCurConstraints++;
+			}
+			if (numCurConstraints)
+			{
+				startConstraint = &m_sortedConstraints[lo];
 			}
 
-			if (m_solverInfo->m_minimumSolverBatchSize <= 1)
+			if (m_solverInfo->m_solverMode & SOLVER_ADAPTIVE_ISLAND_ITERATIONS)
+			{
+				//each island needs its own residual, so they are not combined. processConstraints solves them
+				//smallest first: the iterations the small islands leave over go to the large ones
+				btDeferredIsland& island = m_islands.expandNonInitializing();
+				island.m_islandId = islandId;
+				island.m_firstBody = m_bodies.size();
+				island.m_numBodies = numBodies;
+				island.m_firstManifold = m_manifolds.size();
+				island.m_numManifolds = numManifolds;
+				island.m_firstConstraint = m_constraints.size();
+				island.m_numConstraints = numCurConstraints;
+				for (i = 0; i < numBodies; i++)
+					m_bodies.push_back(bodies[i]);
+				for (i = 0; i < numManifolds; i++)
+					m_manifolds.push_back(manifolds[i]);
+				for (i = 0; i < numCurConstraints; i++)
+					m_constraints.push_back(startConstraint[i]);
+			}
+			else if (m_solverInfo->m_minimumSolverBatchSize <= 1)
 			{
 				m_solver->solveGroup(bodies, numBodies, manifolds, numManifolds, startConstraint, numCurConstraints, *m_solverInfo, m_debugDrawer, m_dispatcher);
+				reportAnalytics(islandId);
 			}
 			else
 			{
@@ -181,7 +247,26 @@ struct InplaceSolverIslandCallback : public btSimulationIslandManager::IslandCal
 		btPersistentManifold** manifold = m_manifolds.size() ? &m_manifolds[0] : 0;
 		btTypedConstraint** constraints = m_constraints.size() ? &m_constraints[0] : 0;
 
-		m_solver->solveGroup(bodies, m_bodies.size(), manifold, m_manifolds.size(), constraints, m_constraints.size(), *m_solverInfo, m_debugDrawer, m_dispatcher);
+		if (m_islands.size())
+		{
+			m_islands.quickSort(btSortDeferredIslandPredicate());
+			for (int i = 0; i < m_islands.size(); i++)
+			{
+				const btDeferredIsland& island = m_islands[i];
+				m_solver->solveGroup(bodies + island.m_firstBody, island.m_numBodies,
+									 island.m_numManifolds ? manifold + island.m_firstManifold : 0, island.m_numManifolds,
+									 island.m_numConstraints ? constraints + island.m_firstConstraint : 0, island.m_numConstraints,
+									 *m_solverInfo, m_debugDrawer, m_dispatcher);
+				reportAnalytics(island.m_islandId);
+			}
+			m_islands.resize(0);
+		}
+		else
+		{
+			m_solver->solveGroup(bodies, m_bodies.size(), manifold, m_manifolds.size(), constraints, m_constraints.size(), *m_solverInfo, m_debugDrawer, m_dispatcher);
+			if (m_bodies.size())
+				reportAnalytics(-1);  //several islands solved together
+		}
 		m_bodies.resize(0);
 		m_manifolds.resize(0);
 		m_constraints.resize(0);
@@ -199,7 +284,8 @@ btDiscreteDynamicsWorld::btDiscreteDynamicsWorld(btDispatcher* dispatcher, btBro
 	  m_synchronizeAllMotionStates(false),
 	  m_applySpeculativeContactRestitution(false),
 	  m_profileTimings(0),
-	  m_latencyMotionStateInterpolation(true)
+	  m_latencyMotionStateInterpolation(true),
+	  m_bodyIntegrator(NULL)
 
 {
 	if (!m_constraintSolver)
@@ -244,6 +330,22 @@ btDiscreteDynamicsWorld::~btDiscreteDynamicsWorld()
 		m_constraintSolver->~btConstraintSolver();
 		btAlignedFree(m_constraintSolver);
 	}
+	setUseBodyIntegrator(false);
+}
+
+void btDiscreteDynamicsWorld::setUseBodyIntegrator(bool useBodyIntegrator)
+{
+	if (useBodyIntegrator && !m_bodyIntegrator && btRigidBodyIntegrator::isSupported())
+	{
+		void* mem = btAlignedAlloc(sizeof(btRigidBodyIntegrator), 16);
+		m_bodyIntegrator = new (mem) btRigidBodyIntegrator();
+	}
+	else if (!useBodyIntegrator && m_bodyIntegrator)
+	{
+		m_bodyIntegrator->~btRigidBodyIntegrator();
+		btAlignedFree(m_bodyIntegrator);
+		m_bodyIntegrator = NULL;
+	}
 }
 
 void btDiscreteDynamicsWorld::saveKinematicState(btScalar timeStep)
@@ -382,6 +484,7 @@ void btDiscreteDynamicsWorld::synchronizeMotionStates()
 int btDiscreteDynamicsWorld::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep)
 {
 	startProfiling(timeStep);
+	m_continuousCollisionStats.reset();
 
 	int numSimulationSubSteps = 0;
 
@@ -848,6 +951,7 @@ int gNumClampedCcdMotions = 0;
 
 void btDiscreteDynamicsWorld::createPredictiveContactsInternal(btRigidBody** bodies, int numBodies, btScalar timeStep)
 {
+	btContinuousCollisionStats stats;
 	btTransform predictedTrans;
 	for (int i = 0; i < numBodies; i++)
 	{
@@ -866,6 +970,7 @@ void btDiscreteDynamicsWorld::createPredictiveContactsInternal(btRigidBody** bod
 				if (body->getCollisionShape()->isConvex())
 				{
 					gNumClampedCcdMotions++;
+					stats.m_numPredictiveSweeps++;
 #ifdef PREDICTIVE_CONTACT_USE_STATIC_ONLY
 					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
 					{
@@ -899,31 +1004,155 @@ void btDiscreteDynamicsWorld::createPredictiveContactsInternal(btRigidBody** bod
 					convexSweepTest(&tmpSphere, body->getWorldTransform(), modifiedPredictedTrans, sweepResults);
 					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
 					{
-						btVector3 distVec = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()) * sweepResults.m_closestHitFraction;
-						btScalar distance = distVec.dot(-sweepResults.m_hitNormalWorld);
-
-						btPersistentManifold* manifold = m_dispatcher1->getNewManifold(body, sweepResults.m_hitCollisionObject);
-						btMutexLock(&m_predictiveManifoldsMutex);
-						m_predictiveManifolds.push_back(manifold);
-						btMutexUnlock(&m_predictiveManifoldsMutex);
-
-						btVector3 worldPointB = body->getWorldTransform().getOrigin() + distVec;
-						btVector3 localPointB = sweepResults.m_hitCollisionObject->getWorldTransform().inverse() * worldPointB;
-
-						btManifoldPoint newPoint(btVector3(0, 0, 0), localPointB, sweepResults.m_hitNormalWorld, distance);
-
-						bool isPredictive = true;
-						int index = manifold->addManifoldPoint(newPoint, isPredictive);
-						btManifoldPoint& pt = manifold->getContactPoint(index);
-						pt.m_combinedRestitution = 0;
-						pt.m_combinedFriction = gCalculateCombinedFrictionCallback(body, sweepResults.m_hitCollisionObject);
-						pt.m_positionWorldOnA = body->getWorldTransform().getOrigin();
-						pt.m_positionWorldOnB = worldPointB;
+						stats.m_numPredictiveContacts++;
+						stats.addTimeOfImpact(sweepResults.m_closestHitFraction);
+						addPredictiveContact(body, predictedTrans.getOrigin() - body->getWorldTransform().getOrigin(), sweepResults.m_hitCollisionObject, sweepResults.m_hitNormalWorld, sweepResults.m_closestHitFraction);
 					}
 				}
 			}
 		}
 	}
+	addContinuousCollisionStats(stats);
+}
+
+void btDiscreteDynamicsWorld::addPredictiveContact(btRigidBody* body, const btVector3& motion, const btCollisionObject* hitObject, const btVector3& hitNormalWorld, btScalar hitFraction)
+{
+	btVector3 distVec = motion * hitFraction;
+	btScalar distance = distVec.dot(-hitNormalWorld);
+
+	btPersistentManifold* manifold = m_dispatcher1->getNewManifold(body, hitObject);
+	btMutexLock(&m_predictiveManifoldsMutex);
+	m_predictiveManifolds.push_back(manifold);
+	btMutexUnlock(&m_predictiveManifoldsMutex);
+
+	btVector3 worldPointB = body->getWorldTransform().getOrigin() + distVec;
+	btVector3 localPointB = hitObject->getWorldTransform().inverse() * worldPointB;
+
+	btManifoldPoint newPoint(btVector3(0, 0, 0), localPointB, hitNormalWorld, distance);
+
+	bool isPredictive = true;
+	int index = manifold->addManifoldPoint(newPoint, isPredictive);
+	btManifoldPoint& pt = manifold->getContactPoint(index);
+	pt.m_combinedRestitution = 0;
+	pt.m_combinedFriction = gCalculateCombinedFrictionCallback(body, hitObject);
+	pt.m_positionWorldOnA = body->getWorldTransform().getOrigin();
+	pt.m_positionWorldOnB = worldPointB;
+}
+
+void btDiscreteDynamicsWorld::addContinuousCollisionStats(const btContinuousCollisionStats& stats)
+{
+	if (stats.m_numPredictiveSweeps || stats.m_numMotionSweeps)
+	{
+		btMutexLock(&m_continuousCollisionStatsMutex);
+		m_continuousCollisionStats.add(stats);
+		btMutexUnlock(&m_continuousCollisionStatsMutex);
+	}
+}
+
+bool btDiscreteDynamicsWorld::addContinuousSweep(btRigidBody* body, const btTransform& predictedTrans)
+{
+	btScalar squareMotion = (predictedTrans.getOrigin() - body->getWorldTransform().getOrigin()).length2();
+	if (!getDispatchInfo().m_useContinuous || !body->getCcdSquareMotionThreshold() || body->getCcdSquareMotionThreshold() >= squareMotion || !body->getCollisionShape()->isConvex())
+	{
+		return false;
+	}
+	btContinuousSweep& sweep = m_continuousSweeps.expandNonInitializing();
+	sweep.m_body = body;
+	sweep.m_predictedTrans = predictedTrans;
+	return true;
+}
+
+///the sweep of integrateTransformsInternal: a sphere of the CCD radius of the body, moved without rotating.
+///It only reads the world, so the sweeps of different bodies can run in parallel
+static void btSweepContinuousBody(btDiscreteDynamicsWorld* world, btContinuousSweep& sweep)
+{
+	btRigidBody* body = sweep.m_body;
+	const btTransform& fromTrans = body->getWorldTransform();
+	btClosestNotMeConvexResultCallback sweepResults(body, fromTrans.getOrigin(), sweep.m_predictedTrans.getOrigin(), world->getBroadphase()->getOverlappingPairCache(), world->getDispatcher());
+	btSphereShape tmpSphere(body->getCcdSweptSphereRadius());
+	sweepResults.m_allowedPenetration = world->getDispatchInfo().m_allowedCcdPenetration;
+
+	sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
+	sweepResults.m_collisionFilterMask = body->getBroadphaseProxy()->m_collisionFilterMask;
+	btTransform modifiedPredictedTrans(fromTrans.getBasis(), sweep.m_predictedTrans.getOrigin());
+
+	world->convexSweepTest(&tmpSphere, fromTrans, modifiedPredictedTrans, sweepResults);
+	sweep.m_hitObject = NULL;
+	sweep.m_hitFraction = btScalar(1);
+	if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
+	{
+		sweep.m_hitObject = sweepResults.m_hitCollisionObject;
+		sweep.m_hitNormalWorld = sweepResults.m_hitNormalWorld;
+		sweep.m_hitFraction = sweepResults.m_closestHitFraction;
+	}
+}
+
+struct btContinuousSweepLoop : public btIParallelForBody
+{
+	btDiscreteDynamicsWorld* m_world;
+	btContinuousSweep* m_sweeps;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btSweepContinuousBody(m_world, m_sweeps[i]);
+		}
+	}
+};
+
+void btDiscreteDynamicsWorld::sweepContinuousBodies()
+{
+	BT_PROFILE("sweepContinuousBodies");
+	if (m_continuousSweeps.size() == 0)
+	{
+		return;
+	}
+	btContinuousSweepLoop loop;
+	loop.m_world = this;
+	loop.m_sweeps = &m_continuousSweeps[0];
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		int grainSize = 8;  // a sweep walks the broadphase and runs GJK, so few of them are enough for a task
+		btParallelFor(0, m_continuousSweeps.size(), grainSize, loop);
+		return;
+	}
+#endif
+	loop.forLoop(0, m_continuousSweeps.size());
+}
+
+void btDiscreteDynamicsWorld::createPredictiveContactsSwept(btRigidBody** bodies, int numBodies, btScalar timeStep)
+{
+	m_continuousSweeps.resize(0);
+	btTransform predictedTrans;
+	for (int i = 0; i < numBodies; i++)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
+			body->predictIntegratedTransform(timeStep, predictedTrans);
+			addContinuousSweep(body, predictedTrans);
+		}
+	}
+
+	sweepContinuousBodies();
+
+	btContinuousCollisionStats& stats = m_continuousCollisionStats;
+	for (int i = 0; i < m_continuousSweeps.size(); i++)
+	{
+		const btContinuousSweep& sweep = m_continuousSweeps[i];
+		gNumClampedCcdMotions++;
+		stats.m_numPredictiveSweeps++;
+		if (sweep.m_hitObject)
+		{
+			stats.m_numPredictiveContacts++;
+			stats.addTimeOfImpact(sweep.m_hitFraction);
+			addPredictiveContact(sweep.m_body, sweep.m_predictedTrans.getOrigin() - sweep.m_body->getWorldTransform().getOrigin(), sweep.m_hitObject, sweep.m_hitNormalWorld, sweep.m_hitFraction);
+		}
+	}
 }
 
 void btDiscreteDynamicsWorld::releasePredictiveContacts()
@@ -944,12 +1173,13 @@ void btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 	releasePredictiveContacts();
 	if (m_nonStaticRigidBodies.size() > 0)
 	{
-		createPredictiveContactsInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
+		createPredictiveContactsSwept(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
 	}
 }
 
 void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies, int numBodies, btScalar timeStep)
 {
+	btContinuousCollisionStats stats;
 	btTransform predictedTrans;
 	for (int i = 0; i < numBodies; i++)
 	{
@@ -968,6 +1198,7 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 				if (body->getCollisionShape()->isConvex())
 				{
 					gNumClampedCcdMotions++;
+					stats.m_numMotionSweeps++;
 #ifdef USE_STATIC_ONLY
 					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
 					{
@@ -1002,6 +1233,8 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
 					{
 						//printf("clamped integration to hit fraction = %f\n",fraction);
+						stats.m_numClampedMotions++;
+						stats.addTimeOfImpact(sweepResults.m_closestHitFraction);
 						body->setHitFraction(sweepResults.m_closestHitFraction);
 						body->predictIntegratedTransform(timeStep * body->getHitFraction(), predictedTrans);
 						body->setHitFraction(0.f);
@@ -1042,14 +1275,77 @@ void btDiscreteDynamicsWorld::integrateTransformsInternal(btRigidBody** bodies,
 			body->proceedToTransform(predictedTrans);
 		}
 	}
+	addContinuousCollisionStats(stats);
+}
+
+void btDiscreteDynamicsWorld::integrateTransformsSwept(btRigidBody** bodies, int numBodies, btScalar timeStep)
+{
+	m_continuousSweeps.resize(0);
+	btTransform predictedTrans;
+	for (int i = 0; i < numBodies; i++)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
+			body->predictIntegratedTransform(timeStep, predictedTrans);
+			if (!addContinuousSweep(body, predictedTrans))
+			{
+				body->proceedToTransform(predictedTrans);
+			}
+		}
+	}
+
+	sweepContinuousBodies();
+
+	btContinuousCollisionStats& stats = m_continuousCollisionStats;
+	for (int i = 0; i < m_continuousSweeps.size(); i++)
+	{
+		const btContinuousSweep& sweep = m_continuousSweeps[i];
+		btRigidBody* body = sweep.m_body;
+		gNumClampedCcdMotions++;
+		stats.m_numMotionSweeps++;
+		if (sweep.m_hitObject)
+		{
+			//don't apply the collision response right now, the predictive contact or the contact found next step handles it
+			stats.m_numClampedMotions++;
+			stats.addTimeOfImpact(sweep.m_hitFraction);
+			body->setHitFraction(sweep.m_hitFraction);
+			body->predictIntegratedTransform(timeStep * body->getHitFraction(), predictedTrans);
+			body->setHitFraction(0.f);
+			body->proceedToTransform(predictedTrans);
+		}
+		else
+		{
+			body->proceedToTransform(sweep.m_predictedTrans);
+		}
+	}
+}
+
+void btDiscreteDynamicsWorld::integrateTransformsInBlocks(btScalar timeStep)
+{
+	btRigidBody** bodies = m_nonStaticRigidBodies.size() ? &m_nonStaticRigidBodies[0] : NULL;
+	m_bodyIntegrator->integrate(bodies, m_nonStaticRigidBodies.size(), timeStep, getDispatchInfo().m_useContinuous);
+
+	// the sweeps read the transforms of the other bodies, so they run after all of them moved
+	btAlignedObjectArray<btRigidBody*>& deferredBodies = m_bodyIntegrator->getDeferredBodies();
+	if (deferredBodies.size() > 0)
+	{
+		integrateTransformsSwept(&deferredBodies[0], deferredBodies.size(), timeStep);
+	}
 }
 
 void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
-	if (m_nonStaticRigidBodies.size() > 0)
+	if (m_bodyIntegrator)
 	{
-		integrateTransformsInternal(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
+		integrateTransformsInBlocks(timeStep);
+	}
+	else if (m_nonStaticRigidBodies.size() > 0)
+	{
+		integrateTransformsSwept(&m_nonStaticRigidBodies[0], m_nonStaticRigidBodies.size(), timeStep);
 	}
 
 	///this should probably be switched on by default, but it is not well tested yet
@@ -1091,6 +1387,12 @@ void btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 void btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
+	if (m_bodyIntegrator)
+	{
+		btRigidBody** bodies = m_nonStaticRigidBodies.size() ? &m_nonStaticRigidBodies[0] : NULL;
+		m_bodyIntegrator->predictMotion(bodies, m_nonStaticRigidBodies.size(), timeStep);
+		return;
+	}
 	for (int i = 0; i < m_nonStaticRigidBodies.size(); i++)
 	{
 		btRigidBody* body = m_nonStaticRigidBodies[i];
@@ -1363,6 +1665,11 @@ btConstraintSolver* btDiscreteDynamicsWorld::getConstraintSolver()
 	return m_constraintSolver;
 }
 
+void btDiscreteDynamicsWorld::getAnalyticsData(btAlignedObjectArray<btSolverAnalyticsData>& islandAnalyticsData) const
+{
+	islandAnalyticsData = m_solverIslandCallback->m_islandAnalyticsData;
+}
+
 int btDiscreteDynamicsWorld::getNumConstraints() const
 {
 	return int(m_constraints.size());
@@ -1467,3 +1774,127 @@ void btDiscreteDynamicsWorld::serialize(btSerializer* serializer)
 
 	serializer->finishSerialization();
 }
+
+#if BT_DISCRETE_DYNAMICS_WORLD_ENABLE_BENCHMARK
+
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include <stdio.h>
+
+///a volley of 0.1 radius projectiles at 150 m/s, 2.5 units a step, shot at a wall 1 unit thick
+struct btProjectileBenchmarkScene
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btSequentialImpulseConstraintSolver m_solver;
+	btDiscreteDynamicsWorld m_world;
+	btBoxShape m_wall;
+	btSphereShape m_projectile;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+
+	btProjectileBenchmarkScene(int numProjectiles, bool continuous)
+		: m_dispatcher(&m_configuration),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+		  m_wall(btVector3(100, 100, 0.5)),
+		  m_projectile(0.1f)
+	{
+		m_world.setGravity(btVector3(0, 0, 0));
+		m_world.setUseBodyIntegrator(true);
+		addBody(&m_wall, 0, btVector3(0, 0, 0));
+		int columns = 64;
+		for (int p = 0; p < numProjectiles; p++)
+		{
+			btRigidBody* projectile = addBody(&m_projectile, 1, btVector3(btScalar(p % columns - columns / 2) * 0.3f, btScalar(p / columns) * 0.3f, -20));
+			projectile->setLinearVelocity(btVector3(0, 0, 150));
+			if (continuous)
+			{
+				projectile->setCcdMotionThreshold(0.1f);
+				projectile->setCcdSweptSphereRadius(0.1f);
+			}
+		}
+	}
+
+	~btProjectileBenchmarkScene()
+	{
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeRigidBody(m_bodies[i]);
+			delete m_bodies[i];
+		}
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass != 0)
+			shape->calculateLocalInertia(mass, inertia);
+		btRigidBody::btRigidBodyConstructionInfo info(mass, NULL, shape, inertia);
+		info.m_startWorldTransform.setOrigin(position);
+		btRigidBody* body = new btRigidBody(info);
+		if (mass != 0)
+			body->setActivationState(DISABLE_DEACTIVATION);
+		m_world.addRigidBody(body);
+		m_bodies.push_back(body);
+		return body;
+	}
+
+	int countTunneled() const
+	{
+		int tunneled = 0;
+		for (int i = 1; i < m_bodies.size(); i++)
+		{
+			if (m_bodies[i]->getWorldTransform().getOrigin().getZ() > btScalar(0.5))
+				tunneled++;
+		}
+		return tunneled;
+	}
+};
+
+void btDiscreteDynamicsWorld::benchmark()
+{
+	const int numSteps = 30;
+	int threadCounts[4] = {1, 1, 1, 1};
+	int numThreadCounts = 1;
+#if BT_THREADSAFE
+	btITaskScheduler* scheduler = btGetTaskScheduler();
+	if (scheduler)
+	{
+		for (int threads = 2; threads <= btMin(scheduler->getMaxNumThreads(), 4); threads *= 2)
+			threadCounts[numThreadCounts++] = threads;
+	}
+#endif
+	for (int numProjectiles = 1000; numProjectiles <= 16000; numProjectiles *= 4)
+	{
+		for (int t = -1; t < numThreadCounts; t++)
+		{
+			bool continuous = t >= 0;
+#if BT_THREADSAFE
+			if (scheduler)
+				scheduler->setNumThreads(continuous ? threadCounts[t] : 1);
+#endif
+			btProjectileBenchmarkScene scene(numProjectiles, continuous);
+			btContinuousCollisionStats stats;
+			btClock clock;
+			for (int i = 0; i < numSteps; i++)
+			{
+				scene.m_world.stepSimulation(1.f / 60.f, 0, 1.f / 60.f);
+				stats.add(scene.m_world.getContinuousCollisionStats());
+			}
+			double ms = double(clock.getTimeMicroseconds()) / numSteps / 1000.0;
+			if (continuous)
+			{
+				printf("%6d projectiles, CCD, %d thread(s): %8.3f ms/step, %5d tunneled, %6d predictive sweeps, %6d motion sweeps, %5d contacts, %5d clamped, time of impact min %.3f avg %.3f\n",
+					   numProjectiles, threadCounts[t], ms, scene.countTunneled(), stats.m_numPredictiveSweeps, stats.m_numMotionSweeps,
+					   stats.m_numPredictiveContacts, stats.m_numClampedMotions, stats.m_minTimeOfImpact, stats.getAverageTimeOfImpact());
+			}
+			else
+			{
+				printf("%6d projectiles, no CCD:      %8.3f ms/step, %5d tunneled\n", numProjectiles, ms, scene.countTunneled());
+			}
+		}
+	}
+}
+
+#endif  //BT_DISCRETE_DYNAMICS_WORLD_ENABLE_BENCHMARK
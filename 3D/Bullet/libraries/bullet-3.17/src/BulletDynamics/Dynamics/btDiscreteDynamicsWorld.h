@@ -25,12 +25,81 @@ class btTypedConstraint;
 class btActionInterface;
 class btPersistentManifold;
 class btIDebugDraw;
+class btRigidBodyIntegrator;
 
 struct InplaceSolverIslandCallback;
 
 #include "LinearMath/btAlignedObjectArray.h"
 #include "LinearMath/btThreads.h"
 
+#ifndef BT_DISCRETE_DYNAMICS_WORLD_ENABLE_BENCHMARK
+#define BT_DISCRETE_DYNAMICS_WORLD_ENABLE_BENCHMARK 0
+#endif
+
+///counts and times of impact of the CCD sweeps of one stepSimulation call, see btDiscreteDynamicsWorld::getContinuousCollisionStats
+struct btContinuousCollisionStats
+{
+	int m_numPredictiveSweeps;    ///< sweeps of createPredictiveContacts
+	int m_numPredictiveContacts;  ///< predictive contacts added for their hits
+	int m_numMotionSweeps;        ///< sweeps of integrateTransforms
+	int m_numClampedMotions;      ///< motions stopped at a time of impact by those sweeps
+	btScalar m_minTimeOfImpact;   ///< earliest time of impact of both kinds of sweeps, as a fraction of the motion, 1 without a hit
+	btScalar m_sumTimeOfImpact;   ///< sum over their hits, see getAverageTimeOfImpact()
+
+	btContinuousCollisionStats()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		m_numPredictiveSweeps = 0;
+		m_numPredictiveContacts = 0;
+		m_numMotionSweeps = 0;
+		m_numClampedMotions = 0;
+		m_minTimeOfImpact = btScalar(1);
+		m_sumTimeOfImpact = btScalar(0);
+	}
+
+	void add(const btContinuousCollisionStats& other)
+	{
+		m_numPredictiveSweeps += other.m_numPredictiveSweeps;
+		m_numPredictiveContacts += other.m_numPredictiveContacts;
+		m_numMotionSweeps += other.m_numMotionSweeps;
+		m_numClampedMotions += other.m_numClampedMotions;
+		m_minTimeOfImpact = btMin(m_minTimeOfImpact, other.m_minTimeOfImpact);
+		m_sumTimeOfImpact += other.m_sumTimeOfImpact;
+	}
+
+	void addTimeOfImpact(btScalar timeOfImpact)
+	{
+		m_minTimeOfImpact = btMin(m_minTimeOfImpact, timeOfImpact);
+		m_sumTimeOfImpact += timeOfImpact;
+	}
+
+	int getNumHits() const
+	{
+		return m_numPredictiveContacts + m_numClampedMotions;
+	}
+
+	btScalar getAverageTimeOfImpact() const
+	{
+		return getNumHits() ? m_sumTimeOfImpact / btScalar(getNumHits()) : btScalar(1);
+	}
+};
+
+///the CCD sweep of one body from its world transform to its predicted transform. The sweeps of a step are done in
+///parallel and applied afterwards in the order of the bodies
+ATTRIBUTE_ALIGNED16(struct)
+btContinuousSweep
+{
+	btTransform m_predictedTrans;
+	btVector3 m_hitNormalWorld;
+	btRigidBody* m_body;
+	const btCollisionObject* m_hitObject;  ///< NULL when nothing is hit before the end of the motion
+	btScalar m_hitFraction;
+};
+
 ///btDiscreteDynamicsWorld provides discrete rigid body simulation
 ///those classes replace the obsolete CcdPhysicsEnvironment/CcdPhysicsController
 ATTRIBUTE_ALIGNED16(class)
@@ -69,9 +138,20 @@ protected:
 	btAlignedObjectArray<btPersistentManifold*> m_predictiveManifolds;
 	btSpinMutex m_predictiveManifoldsMutex;  // used to synchronize threads creating predictive contacts
 
+	btRigidBodyIntegrator* m_bodyIntegrator;  // NULL unless setUseBodyIntegrator(true)
+
+	btAlignedObjectArray<btContinuousSweep> m_continuousSweeps;  // scratch of the batched CCD sweeps
+	btContinuousCollisionStats m_continuousCollisionStats;
+	btSpinMutex m_continuousCollisionStatsMutex;  // used to synchronize threads sweeping in the *Internal functions
+
 	virtual void predictUnconstraintMotion(btScalar timeStep);
 
 	void integrateTransformsInternal(btRigidBody * *bodies, int numBodies, btScalar timeStep);  // can be called in parallel
+	///moves the bodies without a CCD sweep first, then sweeps the others in parallel against those positions and moves
+	///them in the order of the bodies, so the result does not depend on the number of threads
+	void integrateTransformsSwept(btRigidBody * *bodies, int numBodies, btScalar timeStep);
+	///moves the bodies with m_bodyIntegrator, then the ones it deferred for a CCD sweep with integrateTransformsSwept
+	void integrateTransformsInBlocks(btScalar timeStep);
 	virtual void integrateTransforms(btScalar timeStep);
 
 	virtual void calculateSimulationIslands();
@@ -88,6 +168,15 @@ protected:
 
 	void releasePredictiveContacts();
 	void createPredictiveContactsInternal(btRigidBody * *bodies, int numBodies, btScalar timeStep);  // can be called in parallel
+	///sweeps the bodies in parallel, then adds their predictive contacts in the order of the bodies
+	void createPredictiveContactsSwept(btRigidBody * *bodies, int numBodies, btScalar timeStep);
+	void addPredictiveContact(btRigidBody * body, const btVector3& motion, const btCollisionObject* hitObject, const btVector3& hitNormalWorld, btScalar hitFraction);  // can be called in parallel
+
+	///queues a sweep in m_continuousSweeps when the motion of the body to predictedTrans is above its CCD threshold
+	bool addContinuousSweep(btRigidBody * body, const btTransform& predictedTrans);
+	///does the sweeps of m_continuousSweeps, in parallel when a task scheduler is set
+	void sweepContinuousBodies();
+	void addContinuousCollisionStats(const btContinuousCollisionStats& stats);  // can be called in parallel
 	virtual void createPredictiveContacts(btScalar timeStep);
 
 	virtual void saveKinematicState(btScalar timeStep);
@@ -160,6 +249,9 @@ public:
 
 	virtual btConstraintSolver* getConstraintSolver();
 
+	///per island iteration counts and residuals of the last step, filled when m_reportSolverAnalytics has bit 1 set
+	virtual void getAnalyticsData(btAlignedObjectArray<struct btSolverAnalyticsData> & islandAnalyticsData) const;
+
 	virtual int getNumConstraints() const;
 
 	virtual btTypedConstraint* getConstraint(int index);
@@ -229,6 +321,22 @@ public:
 	{
 		return m_latencyMotionStateInterpolation;
 	}
+
+	///Damp, predict and integrate the bodies with btRigidBodyIntegrator, four at a time with SSE and in parallel over the
+	///task scheduler. Bodies that need a CCD sweep are still moved by integrateTransformsSwept. Off by default, and
+	///ignored by builds without the SSE kernels.
+	void setUseBodyIntegrator(bool useBodyIntegrator);
+	bool getUseBodyIntegrator() const
+	{
+		return m_bodyIntegrator != 0;
+	}
+
+	///counts and times of impact of the CCD sweeps during the last stepSimulation call. A body is swept when it moves
+	///further than btRigidBody::setCcdMotionThreshold in a step, see setCcdSweptSphereRadius
+	const btContinuousCollisionStats& getContinuousCollisionStats() const
+	{
+		return m_continuousCollisionStats;
+	}
     
     btAlignedObjectArray<btRigidBody*>& getNonStaticRigidBodies()
     {
@@ -239,6 +347,15 @@ public:
     {
         return m_nonStaticRigidBodies;
     }
+
+	///thousands of fast projectiles shot at a thin wall, with and without CCD, and the cost of the sweeps
+#if BT_DISCRETE_DYNAMICS_WORLD_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
 };
 
 #endif  //BT_DISCRETE_DYNAMICS_WORLD_H
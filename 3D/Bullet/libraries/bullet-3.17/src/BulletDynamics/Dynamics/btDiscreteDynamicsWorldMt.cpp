@@ -125,6 +125,12 @@ btScalar btConstraintSolverPoolMt::solveGroup(btCollisionObject** bodies,
 											  btDispatcher* dispatcher)
 {
 	ThreadSolver* ts = getAndLockThreadSolver();
+	if (info.m_solverMode & SOLVER_DETERMINISTIC)
+	{
+		// which solver of the pool gets this group depends on the threads, so it must not carry
+		// anything over from the groups it solved before (random seed, iteration credit)
+		ts->solver->reset();
+	}
 	ts->solver->solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, info, debugDrawer, dispatcher);
 	ts->mutex.unlock();
 	return 0.0f;
@@ -212,7 +218,12 @@ struct UpdaterUnconstrainedMotion : public btIParallelForBody
 void btDiscreteDynamicsWorldMt::predictUnconstraintMotion(btScalar timeStep)
 {
 	BT_PROFILE("predictUnconstraintMotion");
-	if (m_nonStaticRigidBodies.size() > 0)
+	if (m_bodyIntegrator)
+	{
+		// the integrator runs its blocks over the task scheduler itself
+		btDiscreteDynamicsWorld::predictUnconstraintMotion(timeStep);
+	}
+	else if (m_nonStaticRigidBodies.size() > 0)
 	{
 		UpdaterUnconstrainedMotion update;
 		update.timeStep = timeStep;
@@ -222,6 +233,24 @@ void btDiscreteDynamicsWorldMt::predictUnconstraintMotion(btScalar timeStep)
 	}
 }
 
+void btDiscreteDynamicsWorldMt::splitSweepingBodies()
+{
+	m_sweepingBodies.resize(0);
+	m_otherBodies.resize(0);
+	for (int i = 0; i < m_nonStaticRigidBodies.size(); ++i)
+	{
+		btRigidBody* body = m_nonStaticRigidBodies[i];
+		if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() != btScalar(0))
+		{
+			m_sweepingBodies.push_back(body);
+		}
+		else
+		{
+			m_otherBodies.push_back(body);
+		}
+	}
+}
+
 void btDiscreteDynamicsWorldMt::createPredictiveContacts(btScalar timeStep)
 {
 	BT_PROFILE("createPredictiveContacts");
@@ -231,23 +260,63 @@ void btDiscreteDynamicsWorldMt::createPredictiveContacts(btScalar timeStep)
 		UpdaterCreatePredictiveContacts update;
 		update.world = this;
 		update.timeStep = timeStep;
-		update.rigidBodies = &m_nonStaticRigidBodies[0];
 		int grainSize = 50;  // num of iterations per task for task scheduler
-		btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
+		if (isDeterministic())
+		{
+			// the threads would add the predictive manifolds in the order they finish their sweeps, so only the sweeps
+			// themselves run in parallel
+			splitSweepingBodies();
+			if (m_otherBodies.size() > 0)
+			{
+				update.rigidBodies = &m_otherBodies[0];
+				btParallelFor(0, m_otherBodies.size(), grainSize, update);
+			}
+			if (m_sweepingBodies.size() > 0)
+			{
+				createPredictiveContactsSwept(&m_sweepingBodies[0], m_sweepingBodies.size(), timeStep);
+			}
+		}
+		else
+		{
+			update.rigidBodies = &m_nonStaticRigidBodies[0];
+			btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
+		}
 	}
 }
 
 void btDiscreteDynamicsWorldMt::integrateTransforms(btScalar timeStep)
 {
 	BT_PROFILE("integrateTransforms");
-	if (m_nonStaticRigidBodies.size() > 0)
+	if (m_bodyIntegrator)
+	{
+		// the bodies deferred for a CCD sweep are moved on this thread after their sweeps, so the result is deterministic as well
+		integrateTransformsInBlocks(timeStep);
+	}
+	else if (m_nonStaticRigidBodies.size() > 0)
 	{
 		UpdaterIntegrateTransforms update;
 		update.world = this;
 		update.timeStep = timeStep;
-		update.rigidBodies = &m_nonStaticRigidBodies[0];
 		int grainSize = 50;  // num of iterations per task for task scheduler
-		btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
+		if (isDeterministic())
+		{
+			// a CCD sweep reads the transforms of the bodies the other threads are moving
+			splitSweepingBodies();
+			if (m_otherBodies.size() > 0)
+			{
+				update.rigidBodies = &m_otherBodies[0];
+				btParallelFor(0, m_otherBodies.size(), grainSize, update);
+			}
+			if (m_sweepingBodies.size() > 0)
+			{
+				integrateTransformsSwept(&m_sweepingBodies[0], m_sweepingBodies.size(), timeStep);
+			}
+		}
+		else
+		{
+			update.rigidBodies = &m_nonStaticRigidBodies[0];
+			btParallelFor(0, m_nonStaticRigidBodies.size(), grainSize, update);
+		}
 	}
 }
 
@@ -261,3 +330,204 @@ int btDiscreteDynamicsWorldMt::stepSimulation(btScalar timeStep, int maxSubSteps
 	}
 	return numSubSteps;
 }
+
+void btDiscreteDynamicsWorldMt::setDeterministic(bool deterministic)
+{
+	getDispatchInfo().m_deterministicOverlappingPairs = deterministic;
+	if (deterministic)
+	{
+		m_solverInfo.m_solverMode |= SOLVER_DETERMINISTIC;
+	}
+	else
+	{
+		m_solverInfo.m_solverMode &= ~SOLVER_DETERMINISTIC;
+	}
+}
+
+static unsigned int btHashScalars(unsigned int hash, const btScalar* values, int count)
+{
+	// FNV-1a over the bytes of the values
+	for (int i = 0; i < count; ++i)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&values[i]);
+		for (unsigned int b = 0; b < sizeof(btScalar); ++b)
+		{
+			hash = (hash ^ bytes[b]) * 16777619u;
+		}
+	}
+	return hash;
+}
+
+unsigned int btDiscreteDynamicsWorldMt::calculateStateHash() const
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < m_nonStaticRigidBodies.size(); ++i)
+	{
+		// only the x, y and z of each vector, the fourth component is not always initialized
+		const btRigidBody* body = m_nonStaticRigidBodies[i];
+		const btTransform& transform = body->getWorldTransform();
+		for (int r = 0; r < 3; ++r)
+		{
+			hash = btHashScalars(hash, transform.getBasis()[r].m_floats, 3);
+		}
+		hash = btHashScalars(hash, transform.getOrigin().m_floats, 3);
+		hash = btHashScalars(hash, body->getLinearVelocity().m_floats, 3);
+		hash = btHashScalars(hash, body->getAngularVelocity().m_floats, 3);
+	}
+	return hash;
+}
+
+#if BT_DISCRETE_DYNAMICS_WORLD_MT_ENABLE_BENCHMARK
+
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "LinearMath/btDefaultMotionState.h"
+#include <stdio.h>
+
+///a wall of boxes large enough for the batched solver, many small stacks that the island manager merges into batches,
+///chains of spheres on point to point joints, and fast spheres with CCD shot at the wall
+struct btDiscreteDynamicsWorldMtBenchmarkScene
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcherMt m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btConstraintSolverPoolMt m_solverPool;
+	btSequentialImpulseConstraintSolverMt m_solverMt;
+	btDiscreteDynamicsWorldMt m_world;
+	btBoxShape m_ground;
+	btBoxShape m_box;
+	btSphereShape m_sphere;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+
+	btDiscreteDynamicsWorldMtBenchmarkScene(int numSolvers, bool deterministic)
+		: m_dispatcher(&m_configuration),
+		  m_solverPool(numSolvers),
+		  m_world(&m_dispatcher, &m_broadphase, &m_solverPool, &m_solverMt, &m_configuration),
+		  m_ground(btVector3(200, 1, 200)),
+		  m_box(btVector3(0.5, 0.5, 0.5)),
+		  m_sphere(0.25)
+	{
+		m_world.setGravity(btVector3(0, -10, 0));
+		m_world.getSolverInfo().m_leastSquaresResidualThreshold = btScalar(1e-5);
+		m_world.setDeterministic(deterministic);
+		addBody(&m_ground, 0, btVector3(0, -1, 0));
+		for (int y = 0; y < 12; y++)
+		{
+			for (int x = 0; x < 24; x++)
+			{
+				addBody(&m_box, 1, btVector3(btScalar(x) - 12 + btScalar(y % 2) * 0.5f, btScalar(y) + 0.5f, 0));
+			}
+		}
+		for (int s = 0; s < 150; s++)
+		{
+			for (int y = 0; y < 3; y++)
+			{
+				addBody(&m_box, 1, btVector3(btScalar(s % 15) * 3 - 21, btScalar(y) + 0.5f, btScalar(s / 15) * 3 + 6));
+			}
+		}
+		for (int c = 0; c < 8; c++)
+		{
+			btRigidBody* previous = addBody(&m_sphere, 0, btVector3(btScalar(c) * 4 - 14, 12, -8));
+			for (int l = 1; l < 6; l++)
+			{
+				btRigidBody* link = addBody(&m_sphere, 1, btVector3(btScalar(c) * 4 - 14 + btScalar(l) * 0.6f, 12, -8));
+				btTypedConstraint* joint = new btPoint2PointConstraint(*previous, *link, btVector3(0.3f, 0, 0), btVector3(-0.3f, 0, 0));
+				m_world.addConstraint(joint, true);
+				m_constraints.push_back(joint);
+				previous = link;
+			}
+		}
+		for (int p = 0; p < 32; p++)
+		{
+			btRigidBody* projectile = addBody(&m_sphere, 0.2f, btVector3(btScalar(p % 16) * 1.4f - 11, btScalar(p / 16) * 3 + 2, -20));
+			projectile->setLinearVelocity(btVector3(0, 0, 80));
+			projectile->setCcdMotionThreshold(0.1f);
+			projectile->setCcdSweptSphereRadius(0.2f);
+		}
+	}
+
+	~btDiscreteDynamicsWorldMtBenchmarkScene()
+	{
+		for (int i = 0; i < m_constraints.size(); i++)
+		{
+			m_world.removeConstraint(m_constraints[i]);
+			delete m_constraints[i];
+		}
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeRigidBody(m_bodies[i]);
+			delete m_bodies[i]->getMotionState();
+			delete m_bodies[i];
+		}
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass != 0)
+			shape->calculateLocalInertia(mass, inertia);
+		btRigidBody* body = new btRigidBody(mass, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), position)), shape, inertia);
+		if (mass != 0)
+			body->setActivationState(DISABLE_DEACTIVATION);
+		m_world.addRigidBody(body);
+		m_bodies.push_back(body);
+		return body;
+	}
+};
+
+void btDiscreteDynamicsWorldMt::benchmark()
+{
+	//runs on the scheduler set with btSetTaskScheduler, or on the default one
+	btITaskScheduler* previousScheduler = btGetTaskScheduler();
+	btITaskScheduler* createdScheduler = NULL;
+	btITaskScheduler* scheduler = previousScheduler;
+	if (scheduler == NULL || scheduler == btGetSequentialTaskScheduler())
+	{
+		createdScheduler = btCreateDefaultTaskScheduler();
+		scheduler = createdScheduler ? createdScheduler : btGetSequentialTaskScheduler();
+	}
+	btSetTaskScheduler(scheduler);
+	const int maxThreads = btMin(scheduler->getMaxNumThreads(), 4);
+	const int steps = 240;
+
+	btAlignedObjectArray<unsigned int> referenceHashes;
+	btAlignedObjectArray<unsigned int> hashes;
+	referenceHashes.resize(steps);
+	hashes.resize(steps);
+	for (int deterministic = 0; deterministic < 2; deterministic++)
+	{
+		for (int threads = 1; threads <= maxThreads; threads *= 2)
+		{
+			scheduler->setNumThreads(threads);
+			unsigned long long microseconds = 0;
+			{
+				btDiscreteDynamicsWorldMtBenchmarkScene scene(scheduler->getMaxNumThreads(), deterministic != 0);
+				btClock clock;
+				for (int i = 0; i < steps; i++)
+				{
+					clock.reset();
+					scene.m_world.stepSimulation(1.f / 60.f, 0, 1.f / 60.f);
+					microseconds += clock.getTimeMicroseconds();
+					hashes[i] = scene.m_world.calculateStateHash();
+				}
+			}
+			if (threads == 1)
+				referenceHashes = hashes;
+			int matching = 0;
+			while (matching < steps && hashes[matching] == referenceHashes[matching])
+				matching++;
+			printf("%s, %d threads (%s): %8.3f ms/step, final hash %08x, first %3d/%d steps equal to 1 thread\n",
+				   deterministic ? "deterministic" : "default      ", threads, scheduler->getName(),
+				   double(microseconds) / steps / 1000.0, hashes[steps - 1], matching, steps);
+		}
+	}
+
+	btSetTaskScheduler(previousScheduler);
+	delete createdScheduler;
+}
+
+#endif  //BT_DISCRETE_DYNAMICS_WORLD_MT_ENABLE_BENCHMARK
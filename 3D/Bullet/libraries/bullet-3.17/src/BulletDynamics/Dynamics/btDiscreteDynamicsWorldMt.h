@@ -20,6 +20,10 @@ subject to the following restrictions:
 #include "btSimulationIslandManagerMt.h"
 #include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
 
+#ifndef BT_DISCRETE_DYNAMICS_WORLD_MT_ENABLE_BENCHMARK
+#define BT_DISCRETE_DYNAMICS_WORLD_MT_ENABLE_BENCHMARK 0
+#endif
+
 ///
 /// btConstraintSolverPoolMt - masquerades as a constraint solver, but really it is a threadsafe pool of them.
 ///
@@ -79,12 +83,20 @@ private:
 ///     - integrateTransforms
 ///     - createPredictiveContacts
 ///
+///  setDeterministic makes the results independent of the number of threads and their timing, see SOLVER_DETERMINISTIC.
+///
 ATTRIBUTE_ALIGNED16(class)
 btDiscreteDynamicsWorldMt : public btDiscreteDynamicsWorld
 {
 protected:
 	btConstraintSolver* m_constraintSolverMt;
 
+	//deterministic mode: the bodies that can do a CCD sweep are moved on the calling thread after the others, once all
+	//their sweeps are done
+	btAlignedObjectArray<btRigidBody*> m_sweepingBodies;
+	btAlignedObjectArray<btRigidBody*> m_otherBodies;
+	void splitSweepingBodies();
+
 	virtual void solveConstraints(btContactSolverInfo & solverInfo) BT_OVERRIDE;
 
 	virtual void predictUnconstraintMotion(btScalar timeStep) BT_OVERRIDE;
@@ -126,6 +138,25 @@ public:
 	virtual ~btDiscreteDynamicsWorldMt();
 
 	virtual int stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep) BT_OVERRIDE;
+
+	///sets SOLVER_DETERMINISTIC and btDispatcherInfo::m_deterministicOverlappingPairs, for replays and lockstep networking
+	void setDeterministic(bool deterministic);
+	bool isDeterministic() const
+	{
+		return (m_solverInfo.m_solverMode & SOLVER_DETERMINISTIC) != 0;
+	}
+
+	///hash of the transforms and velocities of the rigid bodies, to check that two runs went exactly the same way
+	unsigned int calculateStateHash() const;
+
+	///per-step state hashes with 1..4 threads and the cost of the deterministic mode
+#if BT_DISCRETE_DYNAMICS_WORLD_MT_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
 };
 
 #endif  //BT_DISCRETE_DYNAMICS_WORLD_H
@@ -223,6 +223,16 @@ void btRigidBody::proceedToTransform(const btTransform& newTrans)
 	setCenterOfMassTransform(newTrans);
 }
 
+void btRigidBody::proceedToTransform(const btTransform& newTrans, const btMatrix3x3& invInertiaTensorWorld)
+{
+	btAssert(!isKinematicObject());
+	m_interpolationWorldTransform = newTrans;
+	m_interpolationLinearVelocity = m_linearVelocity;
+	m_interpolationAngularVelocity = m_angularVelocity;
+	m_worldTransform = newTrans;
+	m_invInertiaTensorWorld = invInertiaTensorWorld;
+}
+
 void btRigidBody::setMassProps(btScalar mass, const btVector3& inertia)
 {
 	if (mass == btScalar(0.))
@@ -184,6 +184,9 @@ protected:
 public:
 	void proceedToTransform(const btTransform& newTrans);
 
+	///proceedToTransform with the world inverse inertia tensor of newTrans already computed, used by btRigidBodyIntegrator
+	void proceedToTransform(const btTransform& newTrans, const btMatrix3x3& invInertiaTensorWorld);
+
 	///to keep collision detection and dynamics separate we don't store a rigidbody pointer
 	///but a rigidbody is derived from btCollisionObject, so we can safely perform an upcast
 	static const btRigidBody* upcast(const btCollisionObject* colObj)
@@ -239,6 +242,20 @@ public:
 
 	void applyDamping(btScalar timeStep);
 
+	///the additional damping of applyDamping depends on the velocities, btRigidBodyIntegrator leaves those bodies to applyDamping
+	bool hasAdditionalDamping() const
+	{
+		return m_additionalDamping;
+	}
+
+	///stores the damped velocities and the predicted transform that btRigidBodyIntegrator computed for this body
+	void setPredictedMotion(const btVector3& linearVelocity, const btVector3& angularVelocity, const btTransform& predictedTransform)
+	{
+		m_linearVelocity = linearVelocity;
+		m_angularVelocity = angularVelocity;
+		m_interpolationWorldTransform = predictedTransform;
+	}
+
 	SIMD_FORCE_INLINE const btCollisionShape* getCollisionShape() const
 	{
 		return m_collisionShape;
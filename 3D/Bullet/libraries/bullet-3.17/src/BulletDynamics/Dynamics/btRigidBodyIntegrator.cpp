@@ -0,0 +1,721 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btRigidBodyIntegrator.h"
+#include "btRigidBody.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btTransformUtil.h"
+#include "LinearMath/btQuickprof.h"
+
+// The kernels need SSE and a float btScalar. Other builds run the per body loops of the world.
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+#define BT_USE_BODY_BLOCKS 1
+#include <emmintrin.h>
+#else
+#define BT_USE_BODY_BLOCKS 0
+#endif
+
+btRigidBodyIntegrator::btRigidBodyIntegrator()
+{
+}
+
+bool btRigidBodyIntegrator::isSupported()
+{
+	return BT_USE_BODY_BLOCKS != 0;
+}
+
+void btRigidBodyIntegrator::clear()
+{
+	m_blocks.resize(0);
+	m_deferredBodies.resize(0);
+}
+
+void btRigidBodyIntegrator::resizeBlocks(int numBodies)
+{
+	int numBlocks = (numBodies + LANE_COUNT - 1) / LANE_COUNT;
+	int oldNumBlocks = m_blocks.size();
+	m_blocks.resize(numBlocks);
+	for (int i = oldNumBlocks; i < numBlocks; i++)
+	{
+		for (int lane = 0; lane < LANE_COUNT; lane++)
+		{
+			m_blocks[i].m_bodies[lane] = NULL;
+		}
+	}
+}
+
+#if BT_USE_BODY_BLOCKS
+
+typedef btRigidBodyIntegrator::btBodyBlock btBodyBlock;
+
+///applyDamping without the additional damping, remembers the factor of the last damping coefficient
+struct btDampingFactorCache
+{
+	btScalar m_damping;
+	btScalar m_factor;
+
+	btDampingFactorCache() : m_damping(-1), m_factor(1) {}
+
+	btScalar getFactor(btScalar damping, btScalar timeStep)
+	{
+		if (damping != m_damping)
+		{
+			m_damping = damping;
+#ifdef BT_USE_OLD_DAMPING_METHOD
+			m_factor = btMax((btScalar(1.0) - timeStep * damping), btScalar(0.0));
+#else
+			m_factor = btPow(btScalar(1) - damping, timeStep);
+#endif
+		}
+		return m_factor;
+	}
+};
+
+static SIMD_FORCE_INLINE __m128 btSelectLanes(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+///all bits set in the lanes whose bit is set in lanes
+static SIMD_FORCE_INLINE __m128 btLaneMask(int lanes)
+{
+	return _mm_castsi128_ps(_mm_setr_epi32(-(lanes & 1), -((lanes >> 1) & 1), -((lanes >> 2) & 1), -((lanes >> 3) & 1)));
+}
+
+static SIMD_FORCE_INLINE btVector3 btMakeVector3(__m128 v)
+{
+	btVector3 result;
+	result.set128(v);
+	return result;
+}
+
+///the x, y and z arrays of four btVector3, one transpose instead of twelve scalar copies
+static SIMD_FORCE_INLINE void btTransposeVectors(const btVector3& v0, const btVector3& v1, const btVector3& v2, const btVector3& v3, __m128& x, __m128& y, __m128& z)
+{
+	__m128 w = v3.get128();
+	x = v0.get128();
+	y = v1.get128();
+	z = v2.get128();
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+///the four btVector3 of the x, y and z arrays, the inverse of btTransposeVectors
+static SIMD_FORCE_INLINE void btTransposeLanes(__m128 x, __m128 y, __m128 z, __m128 vectors[btRigidBodyIntegrator::LANE_COUNT])
+{
+	__m128 w = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	vectors[0] = x;
+	vectors[1] = y;
+	vectors[2] = z;
+	vectors[3] = w;
+}
+
+///copies the state of four bodies into a block, a NULL body fills its lane with a resting body at the origin.
+///The orientation of a lane is only rebuilt from the basis when the basis is not the one the block wrote,
+///or the lane mirrored another body before.
+static void btGatherBlock(btBodyBlock& block, btRigidBody* const laneBodies[btRigidBodyIntegrator::LANE_COUNT])
+{
+	const btTransform& resting = btTransform::getIdentity();
+	const btTransform* xform[btRigidBodyIntegrator::LANE_COUNT];
+	const btVector3* linVel[btRigidBodyIntegrator::LANE_COUNT];
+	const btVector3* angVel[btRigidBodyIntegrator::LANE_COUNT];
+	const btVector3* invInertia[btRigidBodyIntegrator::LANE_COUNT];
+	for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+	{
+		const btRigidBody* body = laneBodies[lane];
+		xform[lane] = body ? &body->getWorldTransform() : &resting;
+		linVel[lane] = body ? &body->getLinearVelocity() : &resting.getOrigin();
+		angVel[lane] = body ? &body->getAngularVelocity() : &resting.getOrigin();
+		invInertia[lane] = body ? &body->getInvInertiaDiagLocal() : &resting.getOrigin();
+	}
+
+	__m128 x, y, z;
+	btTransposeVectors(xform[0]->getOrigin(), xform[1]->getOrigin(), xform[2]->getOrigin(), xform[3]->getOrigin(), x, y, z);
+	_mm_store_ps(block.m_origin[0], x);
+	_mm_store_ps(block.m_origin[1], y);
+	_mm_store_ps(block.m_origin[2], z);
+	btTransposeVectors(*linVel[0], *linVel[1], *linVel[2], *linVel[3], x, y, z);
+	_mm_store_ps(block.m_linearVelocity[0], x);
+	_mm_store_ps(block.m_linearVelocity[1], y);
+	_mm_store_ps(block.m_linearVelocity[2], z);
+	btTransposeVectors(*angVel[0], *angVel[1], *angVel[2], *angVel[3], x, y, z);
+	_mm_store_ps(block.m_angularVelocity[0], x);
+	_mm_store_ps(block.m_angularVelocity[1], y);
+	_mm_store_ps(block.m_angularVelocity[2], z);
+	btTransposeVectors(*invInertia[0], *invInertia[1], *invInertia[2], *invInertia[3], x, y, z);
+	_mm_store_ps(block.m_invInertiaLocal[0], x);
+	_mm_store_ps(block.m_invInertiaLocal[1], y);
+	_mm_store_ps(block.m_invInertiaLocal[2], z);
+
+	__m128 sameBasis = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (int row = 0; row < 3; row++)
+	{
+		btTransposeVectors(xform[0]->getBasis()[row], xform[1]->getBasis()[row], xform[2]->getBasis()[row], xform[3]->getBasis()[row], x, y, z);
+		sameBasis = _mm_and_ps(sameBasis, _mm_cmpeq_ps(x, _mm_load_ps(block.m_basis[row * 3])));
+		sameBasis = _mm_and_ps(sameBasis, _mm_cmpeq_ps(y, _mm_load_ps(block.m_basis[row * 3 + 1])));
+		sameBasis = _mm_and_ps(sameBasis, _mm_cmpeq_ps(z, _mm_load_ps(block.m_basis[row * 3 + 2])));
+		_mm_store_ps(block.m_basis[row * 3], x);
+		_mm_store_ps(block.m_basis[row * 3 + 1], y);
+		_mm_store_ps(block.m_basis[row * 3 + 2], z);
+	}
+	int sameLanes = _mm_movemask_ps(sameBasis);
+	for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+	{
+		if ((sameLanes & (1 << lane)) && block.m_bodies[lane] == laneBodies[lane])
+			continue;
+		btQuaternion orn;
+		xform[lane]->getBasis().getRotation(orn);
+		for (int k = 0; k < 4; k++)
+			block.m_orientation[k][lane] = orn[k];
+		block.m_bodies[lane] = laneBodies[lane];
+	}
+}
+
+///the transforms the kernel computed for the lanes of a block
+struct btLaneTransforms
+{
+	__m128 m_origin[3];
+	__m128 m_orientation[4];
+	__m128 m_basis[9];
+	__m128 m_invInertiaWorld[6];  ///< xx xy xz yy yz zz
+
+	///the world transform of each lane
+	void getTransforms(btTransform transforms[btRigidBodyIntegrator::LANE_COUNT]) const
+	{
+		__m128 origins[btRigidBodyIntegrator::LANE_COUNT], rows[3][btRigidBodyIntegrator::LANE_COUNT];
+		btTransposeLanes(m_origin[0], m_origin[1], m_origin[2], origins);
+		for (int row = 0; row < 3; row++)
+			btTransposeLanes(m_basis[row * 3], m_basis[row * 3 + 1], m_basis[row * 3 + 2], rows[row]);
+		for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+		{
+			transforms[lane].setBasis(btMatrix3x3(btMakeVector3(rows[0][lane]), btMakeVector3(rows[1][lane]), btMakeVector3(rows[2][lane])));
+			transforms[lane].setOrigin(btMakeVector3(origins[lane]));
+		}
+	}
+	///the world inverse inertia tensor of each lane
+	void getInvInertiaWorld(btMatrix3x3 tensors[btRigidBodyIntegrator::LANE_COUNT]) const
+	{
+		__m128 rows[3][btRigidBodyIntegrator::LANE_COUNT];
+		btTransposeLanes(m_invInertiaWorld[0], m_invInertiaWorld[1], m_invInertiaWorld[2], rows[0]);
+		btTransposeLanes(m_invInertiaWorld[1], m_invInertiaWorld[3], m_invInertiaWorld[4], rows[1]);
+		btTransposeLanes(m_invInertiaWorld[2], m_invInertiaWorld[4], m_invInertiaWorld[5], rows[2]);
+		for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+			tensors[lane] = btMatrix3x3(btMakeVector3(rows[0][lane]), btMakeVector3(rows[1][lane]), btMakeVector3(rows[2][lane]));
+	}
+	///makes the given lanes the state the block mirrors
+	void storeLanes(btBodyBlock& block, int lanes) const
+	{
+		__m128 mask = btLaneMask(lanes);
+		for (int k = 0; k < 4; k++)
+			_mm_store_ps(block.m_orientation[k], btSelectLanes(mask, m_orientation[k], _mm_load_ps(block.m_orientation[k])));
+		for (int k = 0; k < 9; k++)
+			_mm_store_ps(block.m_basis[k], btSelectLanes(mask, m_basis[k], _mm_load_ps(block.m_basis[k])));
+	}
+};
+
+///btTransformUtil::integrateTransform for the four lanes of a block, without a square root or a division.
+///The rotation of a step turns by angle = |angvel| * timeStep, clamped to ANGULAR_MOTION_THRESHOLD. The exponential map
+///needs cos(angle / 2) and sin(angle / 2) / |angvel|, and both are series in (angle / 2)^2. The half angle is at most
+///ANGULAR_MOTION_THRESHOLD / 2, where five terms are exact in single precision; the first two terms of the second
+///series are the Taylor expansion integrateTransform uses for small angles.
+static void btIntegrateLanes(const btBodyBlock& block, btScalar timeStep, bool computeInertia, btLaneTransforms& out)
+{
+	const __m128 dt = _mm_set1_ps(timeStep);
+	const __m128 one = _mm_set1_ps(1.f);
+	__m128 angVel[3];
+	for (int k = 0; k < 3; k++)
+	{
+		angVel[k] = _mm_load_ps(block.m_angularVelocity[k]);
+		out.m_origin[k] = _mm_add_ps(_mm_load_ps(block.m_origin[k]), _mm_mul_ps(_mm_load_ps(block.m_linearVelocity[k]), dt));
+	}
+
+	//exponential map, see btTransformUtil::integrateTransform
+	__m128 angle2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(angVel[0], angVel[0]), _mm_mul_ps(angVel[1], angVel[1])), _mm_mul_ps(angVel[2], angVel[2]));
+	const btScalar maxHalfAngle = btScalar(0.5) * ANGULAR_MOTION_THRESHOLD;
+	__m128 h2 = _mm_min_ps(_mm_mul_ps(angle2, _mm_set1_ps(btScalar(0.25) * timeStep * timeStep)), _mm_set1_ps(maxHalfAngle * maxHalfAngle));
+	__m128 sinc = _mm_add_ps(_mm_set1_ps(-1.f / 5040.f), _mm_mul_ps(h2, _mm_set1_ps(1.f / 362880.f)));
+	sinc = _mm_add_ps(_mm_set1_ps(1.f / 120.f), _mm_mul_ps(h2, sinc));
+	sinc = _mm_add_ps(_mm_set1_ps(-1.f / 6.f), _mm_mul_ps(h2, sinc));
+	sinc = _mm_add_ps(one, _mm_mul_ps(h2, sinc));
+	__m128 cosH = _mm_add_ps(_mm_set1_ps(-1.f / 720.f), _mm_mul_ps(h2, _mm_set1_ps(1.f / 40320.f)));
+	cosH = _mm_add_ps(_mm_set1_ps(1.f / 24.f), _mm_mul_ps(h2, cosH));
+	cosH = _mm_add_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(h2, cosH));
+	cosH = _mm_add_ps(one, _mm_mul_ps(h2, cosH));
+
+	//sin(h) / |angvel| = sin(h) / h * timeStep / 2
+	__m128 axisScale = _mm_mul_ps(sinc, _mm_set1_ps(btScalar(0.5) * timeStep));
+	__m128 x1 = _mm_mul_ps(angVel[0], axisScale);
+	__m128 y1 = _mm_mul_ps(angVel[1], axisScale);
+	__m128 z1 = _mm_mul_ps(angVel[2], axisScale);
+	__m128 w1 = cosH;
+
+	//dorn * orn0
+	__m128 x2 = _mm_load_ps(block.m_orientation[0]);
+	__m128 y2 = _mm_load_ps(block.m_orientation[1]);
+	__m128 z2 = _mm_load_ps(block.m_orientation[2]);
+	__m128 w2 = _mm_load_ps(block.m_orientation[3]);
+	__m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, x2), _mm_mul_ps(x1, w2)), _mm_mul_ps(y1, z2)), _mm_mul_ps(z1, y2));
+	__m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, y2), _mm_mul_ps(y1, w2)), _mm_mul_ps(z1, x2)), _mm_mul_ps(x1, z2));
+	__m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, z2), _mm_mul_ps(z1, w2)), _mm_mul_ps(x1, y2)), _mm_mul_ps(y1, x2));
+	__m128 w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(w1, w2), _mm_mul_ps(x1, x2)), _mm_mul_ps(y1, y2)), _mm_mul_ps(z1, z2));
+
+	//safeNormalize, a degenerate rotation keeps the old basis
+	__m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+	__m128 valid = _mm_cmpgt_ps(length2, _mm_set1_ps(SIMD_EPSILON));
+	//one Newton step on the estimate of 1 / sqrt(length2) gives full single precision
+	__m128 estimate = _mm_rsqrt_ps(btSelectLanes(valid, length2, one));
+	__m128 invLength = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.f), _mm_mul_ps(_mm_mul_ps(length2, estimate), estimate)));
+	x = btSelectLanes(valid, _mm_mul_ps(x, invLength), x2);
+	y = btSelectLanes(valid, _mm_mul_ps(y, invLength), y2);
+	z = btSelectLanes(valid, _mm_mul_ps(z, invLength), z2);
+	w = btSelectLanes(valid, _mm_mul_ps(w, invLength), w2);
+	out.m_orientation[0] = x;
+	out.m_orientation[1] = y;
+	out.m_orientation[2] = z;
+	out.m_orientation[3] = w;
+
+	//btMatrix3x3::setRotation
+	//s = 2 / length2 for the normalized quaternion, 2 * (2 - length2) is exact to the rounding of length2 around 1
+	__m128 s = _mm_sub_ps(_mm_set1_ps(4.f), _mm_mul_ps(_mm_set1_ps(2.f), _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)))));
+	__m128 xs = _mm_mul_ps(x, s), ys = _mm_mul_ps(y, s), zs = _mm_mul_ps(z, s);
+	__m128 wx = _mm_mul_ps(w, xs), wy = _mm_mul_ps(w, ys), wz = _mm_mul_ps(w, zs);
+	__m128 xx = _mm_mul_ps(x, xs), xy = _mm_mul_ps(x, ys), xz = _mm_mul_ps(x, zs);
+	__m128 yy = _mm_mul_ps(y, ys), yz = _mm_mul_ps(y, zs), zz = _mm_mul_ps(z, zs);
+	__m128* basis = out.m_basis;
+	basis[0] = _mm_sub_ps(one, _mm_add_ps(yy, zz));
+	basis[1] = _mm_sub_ps(xy, wz);
+	basis[2] = _mm_add_ps(xz, wy);
+	basis[3] = _mm_add_ps(xy, wz);
+	basis[4] = _mm_sub_ps(one, _mm_add_ps(xx, zz));
+	basis[5] = _mm_sub_ps(yz, wx);
+	basis[6] = _mm_sub_ps(xz, wy);
+	basis[7] = _mm_add_ps(yz, wx);
+	basis[8] = _mm_sub_ps(one, _mm_add_ps(xx, yy));
+	for (int k = 0; k < 9; k++)
+	{
+		basis[k] = btSelectLanes(valid, basis[k], _mm_load_ps(block.m_basis[k]));
+	}
+
+	if (computeInertia)
+	{
+		//btRigidBody::updateInertiaTensor, basis.scaled(invInertiaLocal) * basis.transpose()
+		__m128 invInertia[3];
+		for (int k = 0; k < 3; k++)
+			invInertia[k] = _mm_load_ps(block.m_invInertiaLocal[k]);
+		int element = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			__m128 scaled[3];
+			for (int k = 0; k < 3; k++)
+				scaled[k] = _mm_mul_ps(basis[i * 3 + k], invInertia[k]);
+			for (int j = i; j < 3; j++)
+			{
+				out.m_invInertiaWorld[element++] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(scaled[0], basis[j * 3]), _mm_mul_ps(scaled[1], basis[j * 3 + 1])), _mm_mul_ps(scaled[2], basis[j * 3 + 2]));
+			}
+		}
+	}
+}
+
+///starts loading the bodies of a later block. With many bodies the loops wait on memory, and the fields the
+///integrator reads and writes are spread over most of each btRigidBody.
+static SIMD_FORCE_INLINE void btPrefetchBodies(btRigidBody** bodies, int numBodies, int blockIndex)
+{
+	int end = btMin((blockIndex + 1) * int(btRigidBodyIntegrator::LANE_COUNT), numBodies);
+	for (int index = blockIndex * btRigidBodyIntegrator::LANE_COUNT; index < end; index++)
+	{
+		const char* body = (const char*)bodies[index];
+		for (int offset = 0; offset < int(sizeof(btRigidBody)); offset += 64)
+			_mm_prefetch(body + offset, _MM_HINT_T0);
+	}
+}
+
+///the bodies of a block, NULL past the end of the body array
+static SIMD_FORCE_INLINE void btGetLaneBodies(btRigidBody** bodies, int numBodies, int blockIndex, btRigidBody* laneBodies[btRigidBodyIntegrator::LANE_COUNT])
+{
+	for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+	{
+		int index = blockIndex * btRigidBodyIntegrator::LANE_COUNT + lane;
+		laneBodies[lane] = (index < numBodies) ? bodies[index] : NULL;
+	}
+}
+
+enum
+{
+	BT_PREFETCH_DISTANCE = 2  ///< blocks
+};
+
+struct btPredictMotionLoop : public btIParallelForBody
+{
+	btBodyBlock* m_blocks;
+	btRigidBody** m_bodies;
+	int m_numBodies;
+	btScalar m_timeStep;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		btDampingFactorCache linearDamping, angularDamping;
+		btLaneTransforms predicted;
+		btTransform transforms[btRigidBodyIntegrator::LANE_COUNT];
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btBodyBlock& block = m_blocks[i];
+			btRigidBody* laneBodies[btRigidBodyIntegrator::LANE_COUNT];
+			btGetLaneBodies(m_bodies, m_numBodies, i, laneBodies);
+			btPrefetchBodies(m_bodies, m_numBodies, i + BT_PREFETCH_DISTANCE);
+
+			int movedLanes = 0;
+			btScalar linearFactor[btRigidBodyIntegrator::LANE_COUNT], angularFactor[btRigidBodyIntegrator::LANE_COUNT];
+			for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+			{
+				btRigidBody* body = laneBodies[lane];
+				linearFactor[lane] = angularFactor[lane] = 1;
+				if (body && !body->isStaticOrKinematicObject())
+				{
+					movedLanes |= 1 << lane;
+					if (body->hasAdditionalDamping())
+					{
+						body->applyDamping(m_timeStep);
+					}
+					else
+					{
+						linearFactor[lane] = linearDamping.getFactor(body->getLinearDamping(), m_timeStep);
+						angularFactor[lane] = angularDamping.getFactor(body->getAngularDamping(), m_timeStep);
+					}
+				}
+			}
+			btGatherBlock(block, laneBodies);
+			if (movedLanes == 0)
+				continue;
+
+			__m128 linear = _mm_setr_ps(linearFactor[0], linearFactor[1], linearFactor[2], linearFactor[3]);
+			__m128 angular = _mm_setr_ps(angularFactor[0], angularFactor[1], angularFactor[2], angularFactor[3]);
+			__m128 linVel[3], angVel[3];
+			for (int k = 0; k < 3; k++)
+			{
+				linVel[k] = _mm_mul_ps(_mm_load_ps(block.m_linearVelocity[k]), linear);
+				angVel[k] = _mm_mul_ps(_mm_load_ps(block.m_angularVelocity[k]), angular);
+				_mm_store_ps(block.m_linearVelocity[k], linVel[k]);
+				_mm_store_ps(block.m_angularVelocity[k], angVel[k]);
+			}
+			btIntegrateLanes(block, m_timeStep, false, predicted);
+
+			__m128 linVels[btRigidBodyIntegrator::LANE_COUNT], angVels[btRigidBodyIntegrator::LANE_COUNT];
+			btTransposeLanes(linVel[0], linVel[1], linVel[2], linVels);
+			btTransposeLanes(angVel[0], angVel[1], angVel[2], angVels);
+			predicted.getTransforms(transforms);
+			for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+			{
+				if (movedLanes & (1 << lane))
+					laneBodies[lane]->setPredictedMotion(btMakeVector3(linVels[lane]), btMakeVector3(angVels[lane]), transforms[lane]);
+			}
+		}
+	}
+};
+
+struct btIntegrateTransformsLoop : public btIParallelForBody
+{
+	btBodyBlock* m_blocks;
+	btRigidBody** m_bodies;
+	int m_numBodies;
+	btScalar m_timeStep;
+	bool m_useContinuous;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		btLaneTransforms integrated;
+		btTransform transforms[btRigidBodyIntegrator::LANE_COUNT];
+		btMatrix3x3 invInertiaWorld[btRigidBodyIntegrator::LANE_COUNT];
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btBodyBlock& block = m_blocks[i];
+			btRigidBody* laneBodies[btRigidBodyIntegrator::LANE_COUNT];
+			btGetLaneBodies(m_bodies, m_numBodies, i, laneBodies);
+			btPrefetchBodies(m_bodies, m_numBodies, i + BT_PREFETCH_DISTANCE);
+
+			block.m_deferredLanes = 0;
+			int movedLanes = 0;
+			btScalar ccdThreshold[btRigidBodyIntegrator::LANE_COUNT];
+			for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+			{
+				btRigidBody* body = laneBodies[lane];
+				ccdThreshold[lane] = 0;
+				if (body == NULL)
+					continue;
+				body->setHitFraction(1.f);
+				if (body->isActive() && !body->isStaticOrKinematicObject())
+				{
+					movedLanes |= 1 << lane;
+					if (m_useContinuous)
+						ccdThreshold[lane] = body->getCcdSquareMotionThreshold();
+				}
+			}
+			btGatherBlock(block, laneBodies);
+			if (movedLanes == 0)
+				continue;
+
+			btIntegrateLanes(block, m_timeStep, true, integrated);
+
+			if (m_useContinuous)
+			{
+				//the bodies that move further than their CCD threshold need the sweep of integrateTransformsSwept
+				__m128 motion2 = _mm_setzero_ps();
+				for (int k = 0; k < 3; k++)
+				{
+					__m128 d = _mm_sub_ps(integrated.m_origin[k], _mm_load_ps(block.m_origin[k]));
+					motion2 = _mm_add_ps(motion2, _mm_mul_ps(d, d));
+				}
+				__m128 threshold = _mm_setr_ps(ccdThreshold[0], ccdThreshold[1], ccdThreshold[2], ccdThreshold[3]);
+				__m128 sweep = _mm_and_ps(_mm_cmpneq_ps(threshold, _mm_setzero_ps()), _mm_cmplt_ps(threshold, motion2));
+				block.m_deferredLanes = _mm_movemask_ps(sweep) & movedLanes;
+				movedLanes &= ~block.m_deferredLanes;
+			}
+
+			integrated.getTransforms(transforms);
+			integrated.getInvInertiaWorld(invInertiaWorld);
+			for (int lane = 0; lane < btRigidBodyIntegrator::LANE_COUNT; lane++)
+			{
+				if (movedLanes & (1 << lane))
+					laneBodies[lane]->proceedToTransform(transforms[lane], invInertiaWorld[lane]);
+			}
+			integrated.storeLanes(block, movedLanes);
+		}
+	}
+};
+
+static void btForEachBlock(int numBlocks, const btIParallelForBody& loop)
+{
+#if BT_THREADSAFE
+	if (btGetTaskScheduler())
+	{
+		int grainSize = 64;  // blocks per task
+		btParallelFor(0, numBlocks, grainSize, loop);
+		return;
+	}
+#endif
+	loop.forLoop(0, numBlocks);
+}
+
+void btRigidBodyIntegrator::predictMotion(btRigidBody** bodies, int numBodies, btScalar timeStep)
+{
+	BT_PROFILE("btRigidBodyIntegrator::predictMotion");
+	resizeBlocks(numBodies);
+	if (numBodies == 0)
+		return;
+	btPredictMotionLoop loop;
+	loop.m_blocks = &m_blocks[0];
+	loop.m_bodies = bodies;
+	loop.m_numBodies = numBodies;
+	loop.m_timeStep = timeStep;
+	btForEachBlock(m_blocks.size(), loop);
+}
+
+void btRigidBodyIntegrator::integrate(btRigidBody** bodies, int numBodies, btScalar timeStep, bool useContinuous)
+{
+	BT_PROFILE("btRigidBodyIntegrator::integrate");
+	resizeBlocks(numBodies);
+	m_deferredBodies.resize(0);
+	if (numBodies == 0)
+		return;
+	btIntegrateTransformsLoop loop;
+	loop.m_blocks = &m_blocks[0];
+	loop.m_bodies = bodies;
+	loop.m_numBodies = numBodies;
+	loop.m_timeStep = timeStep;
+	loop.m_useContinuous = useContinuous;
+	btForEachBlock(m_blocks.size(), loop);
+
+	if (useContinuous)
+	{
+		for (int i = 0; i < m_blocks.size(); i++)
+		{
+			const btBodyBlock& block = m_blocks[i];
+			for (int lane = 0; lane < LANE_COUNT; lane++)
+			{
+				if (block.m_deferredLanes & (1 << lane))
+					m_deferredBodies.push_back(block.m_bodies[lane]);
+			}
+		}
+	}
+}
+
+#else  //BT_USE_BODY_BLOCKS
+
+static bool btNeedsSweep(const btRigidBody* body, const btVector3& newOrigin, bool useContinuous)
+{
+	if (!useContinuous || body->getCcdSquareMotionThreshold() == btScalar(0))
+		return false;
+	btScalar squareMotion = (newOrigin - body->getWorldTransform().getOrigin()).length2();
+	return body->getCcdSquareMotionThreshold() < squareMotion;
+}
+
+void btRigidBodyIntegrator::predictMotion(btRigidBody** bodies, int numBodies, btScalar timeStep)
+{
+	for (int i = 0; i < numBodies; i++)
+	{
+		btRigidBody* body = bodies[i];
+		if (!body->isStaticOrKinematicObject())
+		{
+			body->applyDamping(timeStep);
+			body->predictIntegratedTransform(timeStep, body->getInterpolationWorldTransform());
+		}
+	}
+}
+
+void btRigidBodyIntegrator::integrate(btRigidBody** bodies, int numBodies, btScalar timeStep, bool useContinuous)
+{
+	m_deferredBodies.resize(0);
+	btTransform predictedTrans;
+	for (int i = 0; i < numBodies; i++)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+		if (body->isActive() && !body->isStaticOrKinematicObject())
+		{
+			body->predictIntegratedTransform(timeStep, predictedTrans);
+			if (btNeedsSweep(body, predictedTrans.getOrigin(), useContinuous))
+				m_deferredBodies.push_back(body);
+			else
+				body->proceedToTransform(predictedTrans);
+		}
+	}
+}
+
+#endif  //BT_USE_BODY_BLOCKS
+
+#if BT_RIGID_BODY_INTEGRATOR_ENABLE_BENCHMARK
+
+#include "BulletCollision/CollisionShapes/btSphereShape.h"
+#include <stdio.h>
+
+///free flying projectiles, the bodies the per body loops and the blocks both move
+struct btIntegratorBenchmarkBodies
+{
+	btSphereShape m_shape;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+
+	btIntegratorBenchmarkBodies(int numBodies) : m_shape(btScalar(0.1))
+	{
+		btVector3 inertia;
+		m_shape.calculateLocalInertia(1, inertia);
+		btRigidBody::btRigidBodyConstructionInfo info(1, NULL, &m_shape, inertia);
+		info.m_linearDamping = btScalar(0.05);
+		info.m_angularDamping = btScalar(0.1);
+		unsigned int seed = 1;
+		for (int i = 0; i < numBodies; i++)
+		{
+			btScalar r[9];
+			for (int k = 0; k < 9; k++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				r[k] = btScalar(seed >> 8) / btScalar(1 << 24) - btScalar(0.5);
+			}
+			info.m_startWorldTransform.setOrigin(btVector3(r[0], r[1], r[2]) * 100);
+			info.m_startWorldTransform.setRotation(btQuaternion(btVector3(r[3], r[4], r[5]) + btVector3(0, 0, 1), r[6] * 6));
+			void* mem = btAlignedAlloc(sizeof(btRigidBody), 16);
+			btRigidBody* body = new (mem) btRigidBody(info);
+			body->setLinearVelocity(btVector3(r[7], 1, r[8]) * 300);
+			body->setAngularVelocity(btVector3(r[3], r[4], r[5]) * 40);
+			m_bodies.push_back(body);
+		}
+	}
+	~btIntegratorBenchmarkBodies()
+	{
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_bodies[i]->~btRigidBody();
+			btAlignedFree(m_bodies[i]);
+		}
+	}
+
+	///predictUnconstraintMotion and integrateTransformsInternal of btDiscreteDynamicsWorld, without CCD
+	void stepPerBody(btScalar timeStep)
+	{
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_bodies[i]->applyDamping(timeStep);
+			m_bodies[i]->predictIntegratedTransform(timeStep, m_bodies[i]->getInterpolationWorldTransform());
+		}
+		btTransform predictedTrans;
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_bodies[i]->setHitFraction(1.f);
+			m_bodies[i]->predictIntegratedTransform(timeStep, predictedTrans);
+			m_bodies[i]->proceedToTransform(predictedTrans);
+		}
+	}
+};
+
+static double btTimeSteps(btIntegratorBenchmarkBodies& bodies, btRigidBodyIntegrator* integrator, int numSteps)
+{
+	const btScalar timeStep = btScalar(1.) / btScalar(60.);
+	btClock clock;
+	for (int step = 0; step < numSteps; step++)
+	{
+		if (integrator)
+		{
+			integrator->predictMotion(&bodies.m_bodies[0], bodies.m_bodies.size(), timeStep);
+			integrator->integrate(&bodies.m_bodies[0], bodies.m_bodies.size(), timeStep, false);
+		}
+		else
+		{
+			bodies.stepPerBody(timeStep);
+		}
+	}
+	return clock.getTimeMicroseconds() / 1000.0 / numSteps;
+}
+
+void btRigidBodyIntegrator::benchmark()
+{
+	const int numSteps = 60;
+	int threadCounts[4] = {1, 1, 1, 1};
+	int numThreadCounts = 1;
+#if BT_THREADSAFE
+	btITaskScheduler* scheduler = btGetTaskScheduler();
+	if (scheduler)
+	{
+		for (int threads = 2; threads <= btMin(scheduler->getMaxNumThreads(), 4); threads *= 2)
+			threadCounts[numThreadCounts++] = threads;
+	}
+#endif
+	for (int numBodies = 1000; numBodies <= 100000; numBodies *= 10)
+	{
+		btIntegratorBenchmarkBodies perBody(numBodies);
+		double perBodyMs = btTimeSteps(perBody, NULL, numSteps);
+		for (int t = 0; t < numThreadCounts; t++)
+		{
+#if BT_THREADSAFE
+			if (scheduler)
+				scheduler->setNumThreads(threadCounts[t]);
+#endif
+			btIntegratorBenchmarkBodies blocks(numBodies);
+			btRigidBodyIntegrator integrator;
+			double blocksMs = btTimeSteps(blocks, &integrator, numSteps);
+
+			btScalar maxOriginError = 0, maxBasisError = 0;
+			for (int i = 0; i < numBodies; i++)
+			{
+				const btTransform& a = perBody.m_bodies[i]->getWorldTransform();
+				const btTransform& b = blocks.m_bodies[i]->getWorldTransform();
+				maxOriginError = btMax(maxOriginError, (a.getOrigin() - b.getOrigin()).length());
+				for (int r = 0; r < 3; r++)
+					maxBasisError = btMax(maxBasisError, (a.getBasis()[r] - b.getBasis()[r]).length());
+			}
+			printf("%6d bodies: per body %8.3f ms/step, blocks %d thread(s) %8.3f ms/step (%.2fx), after %d steps origin error %g, basis error %g\n",
+				   numBodies, perBodyMs, threadCounts[t], blocksMs, perBodyMs / blocksMs, numSteps, maxOriginError, maxBasisError);
+		}
+	}
+}
+
+#endif  //BT_RIGID_BODY_INTEGRATOR_ENABLE_BENCHMARK
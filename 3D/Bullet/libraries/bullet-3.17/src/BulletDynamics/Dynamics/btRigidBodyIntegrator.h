@@ -0,0 +1,98 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_RIGID_BODY_INTEGRATOR_H
+#define BT_RIGID_BODY_INTEGRATOR_H
+
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btScalar.h"
+
+class btRigidBody;
+
+#ifndef BT_RIGID_BODY_INTEGRATOR_ENABLE_BENCHMARK
+#define BT_RIGID_BODY_INTEGRATOR_ENABLE_BENCHMARK 0
+#endif
+
+///btRigidBodyIntegrator does the per body work of btDiscreteDynamicsWorld::predictUnconstraintMotion and integrateTransforms
+///with SSE, four bodies at a time. The bodies are mirrored in structure-of-arrays blocks in the order of the body array,
+///the kinematic state is gathered into them, integrated and written back to each body once, and the blocks run in parallel.
+///The blocks keep the orientation of each body as a quaternion, so the rotation is only rebuilt from the basis when
+///something other than the integrator moved the body. The results match btTransformUtil::integrateTransform up to rounding.
+///Bodies with additional damping are damped by btRigidBody::applyDamping, and bodies that need a CCD sweep are deferred
+///to the caller, see getDeferredBodies(). Only available for single precision builds with SSE, see isSupported().
+class btRigidBodyIntegrator
+{
+public:
+	enum
+	{
+		LANE_COUNT = 4
+	};
+
+	btRigidBodyIntegrator();
+
+	///true when btScalar is float and the SSE kernels are compiled in
+	static bool isSupported();
+
+	///damps the velocities and predicts the interpolation transform of the bodies that are not static or kinematic
+	void predictMotion(btRigidBody** bodies, int numBodies, btScalar timeStep);
+
+	///moves the active dynamic bodies to their integrated transform. With useContinuous, the bodies whose motion is
+	///above their CCD threshold are not moved but deferred, they need btDiscreteDynamicsWorld::integrateTransformsSwept.
+	void integrate(btRigidBody** bodies, int numBodies, btScalar timeStep, bool useContinuous);
+
+	///the bodies the last integrate() left to the caller, in the order of the body array
+	const btAlignedObjectArray<btRigidBody*>& getDeferredBodies() const
+	{
+		return m_deferredBodies;
+	}
+	btAlignedObjectArray<btRigidBody*>& getDeferredBodies()
+	{
+		return m_deferredBodies;
+	}
+
+	///forgets the mirrored state, the next step gathers the orientation of every body again
+	void clear();
+
+	///bodies handled per second by the blocks against the per body loops, for 1k to 100k projectiles
+#if BT_RIGID_BODY_INTEGRATOR_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
+
+	///the mirrored state of LANE_COUNT consecutive bodies, each array holds one component for all lanes
+	ATTRIBUTE_ALIGNED16(struct)
+	btBodyBlock
+	{
+		btScalar m_origin[3][LANE_COUNT];
+		btScalar m_orientation[4][LANE_COUNT];
+		btScalar m_basis[9][LANE_COUNT];  ///< the basis m_orientation belongs to, row major
+		btScalar m_linearVelocity[3][LANE_COUNT];
+		btScalar m_angularVelocity[3][LANE_COUNT];
+		btScalar m_invInertiaLocal[3][LANE_COUNT];
+		btRigidBody* m_bodies[LANE_COUNT];  ///< the body each lane mirrors, NULL past the end of the body array
+		int m_deferredLanes;                 ///< bit per lane, set for the bodies integrate() left to the caller
+	};
+
+private:
+	btAlignedObjectArray<btBodyBlock> m_blocks;
+	btAlignedObjectArray<btRigidBody*> m_deferredBodies;
+
+	void resizeBlocks(int numBodies);
+};
+
+#endif  //BT_RIGID_BODY_INTEGRATOR_H
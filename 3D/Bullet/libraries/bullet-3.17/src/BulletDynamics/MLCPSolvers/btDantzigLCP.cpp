@@ -112,8 +112,6 @@ rows/columns and manipulate C.
 
 #include <string.h>  //memcpy
 
-bool s_error = false;
-
 //***************************************************************************
 // code generation parameters
 
@@ -131,6 +129,11 @@ bool s_error = false;
 
 #define BTNUB_OPTIMIZATIONS
 
+// the 4 row blocks of btSolveL1 and btSolveL1T use SSE for their inner loops
+#if defined(BT_USE_SSE) && !defined(BT_USE_DOUBLE_PRECISION)
+#define BT_DANTZIG_USE_SSE
+#endif
+
 /* solve L*X=B, with B containing 1 right hand sides.
  * L is an n*n lower triangular matrix with ones on the diagonal.
  * L is stored by rows and its leading dimension is lskip.
@@ -533,7 +536,7 @@ void btFactorLDLT(btScalar *A, btScalar *d, int n, int nskip1)
 void btSolveL1(const btScalar *L, btScalar *B, int n, int lskip1)
 {
 	/* declare variables - Z matrix, p and q vectors, etc */
-	btScalar Z11, Z21, Z31, Z41, p1, q1, p2, p3, p4, *ex;
+	btScalar Z11, Z21, Z31, Z41, p1, q1, p2, p3, *ex;
 	const btScalar *ell;
 	int lskip2, lskip3, i, j;
 	/* compute lskip values */
@@ -550,6 +553,33 @@ void btSolveL1(const btScalar *L, btScalar *B, int n, int lskip1)
 		Z41 = 0;
 		ell = L + i * lskip1;
 		ex = B;
+#ifdef BT_DANTZIG_USE_SSE
+		{
+			/* i is a multiple of 4: the 4 rows of L are dotted with X 4 columns at a time */
+			__m128 z1 = _mm_setzero_ps();
+			__m128 z2 = _mm_setzero_ps();
+			__m128 z3 = _mm_setzero_ps();
+			__m128 z4 = _mm_setzero_ps();
+			for (j = 0; j < i; j += 4)
+			{
+				const __m128 q = _mm_loadu_ps(ex + j);
+				z1 = _mm_add_ps(z1, _mm_mul_ps(_mm_loadu_ps(ell + j), q));
+				z2 = _mm_add_ps(z2, _mm_mul_ps(_mm_loadu_ps(ell + lskip1 + j), q));
+				z3 = _mm_add_ps(z3, _mm_mul_ps(_mm_loadu_ps(ell + lskip2 + j), q));
+				z4 = _mm_add_ps(z4, _mm_mul_ps(_mm_loadu_ps(ell + lskip3 + j), q));
+			}
+			_MM_TRANSPOSE4_PS(z1, z2, z3, z4);
+			btScalar Z[4];
+			_mm_storeu_ps(Z, _mm_add_ps(_mm_add_ps(z1, z2), _mm_add_ps(z3, z4)));
+			Z11 = Z[0];
+			Z21 = Z[1];
+			Z31 = Z[2];
+			Z41 = Z[3];
+			ell += i;
+			ex += i;
+		}
+#else
+		btScalar p4;
 		/* the inner loop that computes outer products and adds them to Z */
 		for (j = i - 12; j >= 0; j -= 12)
 		{
@@ -709,6 +739,7 @@ void btSolveL1(const btScalar *L, btScalar *B, int n, int lskip1)
 			ell += 1;
 			ex += 1;
 		}
+#endif
 		/* finish computing the X(i) block */
 		Z11 = ex[0] - Z11;
 		ex[0] = Z11;
@@ -832,7 +863,7 @@ void btSolveL1(const btScalar *L, btScalar *B, int n, int lskip1)
 void btSolveL1T(const btScalar *L, btScalar *B, int n, int lskip1)
 {
 	/* declare variables - Z matrix, p and q vectors, etc */
-	btScalar Z11, m11, Z21, m21, Z31, m31, Z41, m41, p1, q1, p2, p3, p4, *ex;
+	btScalar Z11, m11, Z21, Z31, Z41, p1, q1, p2, p3, *ex;
 	const btScalar *ell;
 	int lskip2, i, j;
 	//  int lskip3;
@@ -854,6 +885,25 @@ void btSolveL1T(const btScalar *L, btScalar *B, int n, int lskip1)
 		Z41 = 0;
 		ell = L - i;
 		ex = B;
+#ifdef BT_DANTZIG_USE_SSE
+		{
+			/* the 4 entries of a row of L that multiply the same value of X are contiguous */
+			__m128 z = _mm_setzero_ps();
+			for (j = 0; j < i; j++)
+			{
+				z = _mm_add_ps(z, _mm_mul_ps(_mm_loadu_ps(ell - 3), _mm_set1_ps(ex[0])));
+				ell += lskip1;
+				ex -= 1;
+			}
+			btScalar Z[4];
+			_mm_storeu_ps(Z, z);
+			Z11 = Z[3];
+			Z21 = Z[2];
+			Z31 = Z[1];
+			Z41 = Z[0];
+		}
+#else
+		btScalar m21, m31, m41, p4;
 		/* the inner loop that computes outer products and adds them to Z */
 		for (j = i - 4; j >= 0; j -= 4)
 		{
@@ -946,6 +996,7 @@ void btSolveL1T(const btScalar *L, btScalar *B, int n, int lskip1)
 			Z31 += m31;
 			Z41 += m41;
 		}
+#endif
 		/* finish computing the X(i) block */
 		Z11 = ex[0] - Z11;
 		ex[0] = Z11;
@@ -1838,7 +1889,8 @@ void btLCP::unpermute()
 bool btSolveDantzigLCP(int n, btScalar *A, btScalar *x, btScalar *b,
 					   btScalar *outer_w, int nub, btScalar *lo, btScalar *hi, int *findex, btDantzigScratchMemory &scratchMem)
 {
-	s_error = false;
+	//local, the solver may run several LCPs at the same time, see btDantzigSolver::canSolveConcurrently
+	bool error = false;
 
 	//	printf("btSolveDantzigLCP n=%d\n",n);
 	btAssert(n > 0 && A && x && b && lo && hi && nub >= 0 && nub <= n);
@@ -1861,7 +1913,7 @@ bool btSolveDantzigLCP(int n, btScalar *A, btScalar *x, btScalar *b,
 		btSolveLDLT(A, outer_w, b, n, nskip);
 		memcpy(x, b, n * sizeof(btScalar));
 
-		return !s_error;
+		return !error;
 	}
 
 	const int nskip = (n);
@@ -1898,7 +1950,7 @@ bool btSolveDantzigLCP(int n, btScalar *A, btScalar *x, btScalar *b,
 	bool hit_first_friction_index = false;
 	for (int i = adj_nub; i < n; ++i)
 	{
-		s_error = false;
+		error = false;
 		// the index i is the driving index and indexes i+1..n-1 are "dont care",
 		// i.e. when we make changes to the system those x's will be zero and we
 		// don't care what happens to those w's. in other words, we only consider
@@ -2096,7 +2148,7 @@ bool btSolveDantzigLCP(int n, btScalar *A, btScalar *x, btScalar *b,
 						btSetZero(x + i, n - i);
 						btSetZero(w + i, n - i);
 					}
-					s_error = true;
+					error = true;
 					break;
 				}
 
@@ -2146,7 +2198,7 @@ bool btSolveDantzigLCP(int n, btScalar *A, btScalar *x, btScalar *b,
 			}  // for (;;)
 		}      // else
 
-		if (s_error)
+		if (error)
 		{
 			break;
 		}
@@ -2154,5 +2206,5 @@ bool btSolveDantzigLCP(int n, btScalar *A, btScalar *x, btScalar *b,
 
 	lcp.unpermute();
 
-	return !s_error;
+	return !error;
 }
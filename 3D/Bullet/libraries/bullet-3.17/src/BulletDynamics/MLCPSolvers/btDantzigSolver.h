@@ -19,6 +19,7 @@ subject to the following restrictions:
 
 #include "btMLCPSolverInterface.h"
 #include "btDantzigLCP.h"
+#include "LinearMath/btThreads.h"
 
 class btDantzigSolver : public btMLCPSolverInterface
 {
@@ -27,18 +28,55 @@ protected:
 
 	btAlignedObjectArray<char> m_tempBuffer;
 
-	btAlignedObjectArray<btScalar> m_A;
-	btAlignedObjectArray<btScalar> m_b;
-	btAlignedObjectArray<btScalar> m_x;
-	btAlignedObjectArray<btScalar> m_lo;
-	btAlignedObjectArray<btScalar> m_hi;
-	btAlignedObjectArray<int> m_dependencies;
-	btDantzigScratchMemory m_scratchMemory;
+	///copy of the problem that btSolveDantzigLCP works on, with its scratch memory
+	struct btDantzigThreadData
+	{
+		btAlignedObjectArray<btScalar> m_A;
+		btAlignedObjectArray<btScalar> m_b;
+		btAlignedObjectArray<btScalar> m_x;
+		btAlignedObjectArray<btScalar> m_w;
+		btAlignedObjectArray<btScalar> m_lo;
+		btAlignedObjectArray<btScalar> m_hi;
+		btAlignedObjectArray<int> m_dependencies;
+		btDantzigScratchMemory m_scratchMemory;
+	};
+	///one per thread, created the first time that thread solves, so independent MLCPs can be solved concurrently
+	btAlignedObjectArray<btDantzigThreadData*> m_threadData;
+
+	btDantzigThreadData& getThreadData()
+	{
+		int threadIndex = int(btGetCurrentThreadIndex());
+		btDantzigThreadData*& data = m_threadData[threadIndex];
+		if (!data)
+		{
+			void* mem = btAlignedAlloc(sizeof(btDantzigThreadData), 16);
+			data = new (mem) btDantzigThreadData;
+		}
+		return *data;
+	}
 
 public:
 	btDantzigSolver()
 		: m_acceptableUpperLimitSolution(btScalar(1000))
 	{
+		m_threadData.resize(BT_MAX_THREAD_COUNT, 0);
+	}
+
+	virtual ~btDantzigSolver()
+	{
+		for (int i = 0; i < m_threadData.size(); i++)
+		{
+			if (m_threadData[i])
+			{
+				m_threadData[i]->~btDantzigThreadData();
+				btAlignedFree(m_threadData[i]);
+			}
+		}
+	}
+
+	virtual bool canSolveConcurrently() const
+	{
+		return true;
 	}
 
 	virtual bool solveMLCP(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependency, int numIterations, bool useSparsity = true)
@@ -48,39 +86,39 @@ public:
 		if (n)
 		{
 			int nub = 0;
-			btAlignedObjectArray<btScalar> ww;
-			ww.resize(n);
+			btDantzigThreadData& data = getThreadData();
+			data.m_w.resize(n);
 
 			const btScalar* Aptr = A.getBufferPointer();
-			m_A.resize(n * n);
+			data.m_A.resize(n * n);
 			for (int i = 0; i < n * n; i++)
 			{
-				m_A[i] = Aptr[i];
+				data.m_A[i] = Aptr[i];
 			}
 
-			m_b.resize(n);
-			m_x.resize(n);
-			m_lo.resize(n);
-			m_hi.resize(n);
-			m_dependencies.resize(n);
+			data.m_b.resize(n);
+			data.m_x.resize(n);
+			data.m_lo.resize(n);
+			data.m_hi.resize(n);
+			data.m_dependencies.resize(n);
 			for (int i = 0; i < n; i++)
 			{
-				m_lo[i] = lo[i];
-				m_hi[i] = hi[i];
-				m_b[i] = b[i];
-				m_x[i] = x[i];
-				m_dependencies[i] = limitDependency[i];
+				data.m_lo[i] = lo[i];
+				data.m_hi[i] = hi[i];
+				data.m_b[i] = b[i];
+				data.m_x[i] = x[i];
+				data.m_dependencies[i] = limitDependency[i];
 			}
 
-			result = btSolveDantzigLCP(n, &m_A[0], &m_x[0], &m_b[0], &ww[0], nub, &m_lo[0], &m_hi[0], &m_dependencies[0], m_scratchMemory);
+			result = btSolveDantzigLCP(n, &data.m_A[0], &data.m_x[0], &data.m_b[0], &data.m_w[0], nub, &data.m_lo[0], &data.m_hi[0], &data.m_dependencies[0], data.m_scratchMemory);
 			if (!result)
 				return result;
 
 			//			printf("numAllocas = %d\n",numAllocas);
 			for (int i = 0; i < n; i++)
 			{
-				volatile btScalar xx = m_x[i];
-				if (xx != m_x[i])
+				volatile btScalar xx = data.m_x[i];
+				if (xx != data.m_x[i])
 					return false;
 				if (x[i] >= m_acceptableUpperLimitSolution)
 				{
@@ -95,7 +133,7 @@ public:
 
 			for (int i = 0; i < n; i++)
 			{
-				x[i] = m_x[i];
+				x[i] = data.m_x[i];
 			}
 		}
 
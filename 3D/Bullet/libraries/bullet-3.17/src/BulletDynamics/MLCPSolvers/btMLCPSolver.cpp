@@ -18,15 +18,23 @@ subject to the following restrictions:
 #include "LinearMath/btMatrixX.h"
 #include "LinearMath/btQuickprof.h"
 #include "btSolveProjectedGaussSeidel.h"
+#include "LinearMath/btThreads.h"
 
 btMLCPSolver::btMLCPSolver(btMLCPSolverInterface* solver)
 	: m_solver(solver),
-	  m_fallback(0)
+	  m_fallback(0),
+	  m_numBlocks(0),
+	  m_useBlocks(true)
 {
 }
 
 btMLCPSolver::~btMLCPSolver()
 {
+	for (int i = 0; i < m_blocks.size(); i++)
+	{
+		m_blocks[i]->~btMLCPBlock();
+		btAlignedFree(m_blocks[i]);
+	}
 }
 
 bool gUseMatrixMultiply = false;
@@ -36,6 +44,8 @@ btScalar btMLCPSolver::solveGroupCacheFriendlySetup(btCollisionObject** bodies,
 {
 	btSequentialImpulseConstraintSolver::solveGroupCacheFriendlySetup(bodies, numBodiesUnUsed, manifoldPtr, numManifolds, constraints, numConstraints, infoGlobal, debugDrawer);
 
+	m_numBlocks = 0;
+
 	{
 		BT_PROFILE("gather constraint data");
 
@@ -117,6 +127,9 @@ bool btMLCPSolver::solveMLCP(const btContactSolverInfo& infoGlobal)
 {
 	bool result = true;
 
+	if (m_numBlocks)
+		return solveMLCPBlocks(infoGlobal);
+
 	if (m_A.rows() == 0)
 		return true;
 
@@ -147,6 +160,13 @@ struct btJointNode
 
 void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
 {
+	if (m_useBlocks)
+	{
+		BT_PROFILE("createMLCPBlocks");
+		createMLCPBlocks(infoGlobal);
+		return;
+	}
+
 	int numContactRows = interleaveContactAndFriction ? 3 : 1;
 
 	int numConstraintRows = m_allConstraintPtrArray.size();
@@ -455,6 +475,263 @@ void btMLCPSolver::createMLCPFast(const btContactSolverInfo& infoGlobal)
 	}
 }
 
+static SIMD_FORCE_INLINE bool btIsDynamicSolverBody(const btSolverBody& body)
+{
+	return body.m_originalBody && body.m_originalBody->getInvMass() != btScalar(0);
+}
+
+void btMLCPSolver::createMLCPBlocks(const btContactSolverInfo& infoGlobal)
+{
+	int numRows = m_allConstraintPtrArray.size();
+	int numBodies = m_tmpSolverBodyPool.size();
+
+	{
+		BT_PROFILE("find blocks");
+
+		//rows couple the bodies they act on, unless the body is static or kinematic
+		m_scratchBodySets.reset(numBodies);
+		for (int i = 0; i < numRows; i++)
+		{
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			if (btIsDynamicSolverBody(m_tmpSolverBodyPool[c.m_solverBodyIdA]) && btIsDynamicSolverBody(m_tmpSolverBodyPool[c.m_solverBodyIdB]))
+				m_scratchBodySets.unite(c.m_solverBodyIdA, c.m_solverBodyIdB);
+		}
+
+		//a block per set of bodies, with its rows in the order of m_allConstraintPtrArray
+		m_scratchBlockOfSet.resize(0);
+		m_scratchBlockOfSet.resize(numBodies, -1);
+		m_scratchRowBlock.resizeNoInitialize(numRows);
+		m_scratchBlockRow.resizeNoInitialize(numRows);
+		for (int i = 0; i < numRows; i++)
+		{
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			int body = btIsDynamicSolverBody(m_tmpSolverBodyPool[c.m_solverBodyIdA]) ? c.m_solverBodyIdA : c.m_solverBodyIdB;
+			int& blockIndex = m_scratchBlockOfSet[m_scratchBodySets.find(body)];
+			if (blockIndex < 0)
+			{
+				blockIndex = m_numBlocks++;
+				if (blockIndex == m_blocks.size())
+				{
+					void* mem = btAlignedAlloc(sizeof(btMLCPBlock), 16);
+					m_blocks.push_back(new (mem) btMLCPBlock);
+				}
+				m_blocks[blockIndex]->m_rows.resize(0);
+			}
+			m_scratchRowBlock[i] = blockIndex;
+			m_scratchBlockRow[i] = m_blocks[blockIndex]->m_rows.size();
+			m_blocks[blockIndex]->m_rows.push_back(i);
+		}
+	}
+
+	{
+		BT_PROFILE("init blocks");
+		bool warmstart = (infoGlobal.m_solverMode & SOLVER_USE_WARMSTARTING) != 0;
+		btScalar cfm = infoGlobal.m_globalCfm / infoGlobal.m_timeStep;
+
+		for (int k = 0; k < m_numBlocks; k++)
+		{
+			btMLCPBlock& block = *m_blocks[k];
+			int n = block.m_rows.size();
+
+			block.m_A.resize(n, n);
+			btSetZero(block.m_A.getBufferPointerWritable(), n * n);
+			block.m_b.resize(n);
+			block.m_bSplit.resize(n);
+			block.m_x.resize(n);
+			block.m_xSplit.resize(n);
+			block.m_lo.resize(n);
+			block.m_hi.resize(n);
+			block.m_limitDependencies.resizeNoInitialize(n);
+
+			for (int i = 0; i < n; i++)
+			{
+				int row = block.m_rows[i];
+				const btSolverConstraint& c = *m_allConstraintPtrArray[row];
+
+				btScalar jacDiag = c.m_jacDiagABInv;
+				block.m_b[i] = btFuzzyZero(jacDiag) ? btScalar(0) : c.m_rhs / jacDiag;
+				block.m_bSplit[i] = btFuzzyZero(jacDiag) ? btScalar(0) : c.m_rhsPenetration / jacDiag;
+				block.m_x[i] = warmstart ? btScalar(c.m_appliedImpulse) : btScalar(0);
+				block.m_xSplit[i] = warmstart ? btScalar(c.m_appliedPushImpulse) : btScalar(0);
+				block.m_lo[i] = c.m_lowerLimit;
+				block.m_hi[i] = c.m_upperLimit;
+
+				//a friction row depends on its contact, which acts on the same bodies and so is in the same block
+				int dependency = m_limitDependencies[row];
+				btAssert(dependency < 0 || m_scratchRowBlock[dependency] == k);
+				block.m_limitDependencies[i] = dependency >= 0 ? m_scratchBlockRow[dependency] : -1;
+
+				block.m_A.getBufferPointerWritable()[i * n + i] = cfm;
+			}
+		}
+
+		m_x.resize(numRows);
+		m_xSplit.resize(numRows);
+	}
+
+	//J and J*invM of every row, 8 values per body (linear and angular part, each padded to 4)
+	btMatrixXu& J3 = m_scratchJ3;
+	btMatrixXu& JinvM3 = m_scratchJInvM3;
+	{
+		BT_PROFILE("Compute J and JinvM");
+		J3.resize(2 * numRows, 8);
+		JinvM3.resize(2 * numRows, 8);
+		btScalar* J = J3.getBufferPointerWritable();
+		btScalar* JinvM = JinvM3.getBufferPointerWritable();
+
+		//the rows of each dynamic body, as 2*row plus 0 for body A or 1 for body B, in row order
+		m_scratchBodyRowStart.resize(0);
+		m_scratchBodyRowStart.resize(numBodies + 1, 0);
+		for (int i = 0; i < numRows; i++)
+		{
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			if (btIsDynamicSolverBody(m_tmpSolverBodyPool[c.m_solverBodyIdA]))
+				m_scratchBodyRowStart[c.m_solverBodyIdA + 1]++;
+			if (btIsDynamicSolverBody(m_tmpSolverBodyPool[c.m_solverBodyIdB]))
+				m_scratchBodyRowStart[c.m_solverBodyIdB + 1]++;
+		}
+		for (int b = 0; b < numBodies; b++)
+		{
+			m_scratchBodyRowStart[b + 1] += m_scratchBodyRowStart[b];
+		}
+		m_scratchBodyRows.resizeNoInitialize(m_scratchBodyRowStart[numBodies]);
+		m_scratchOfs.resize(0);
+		for (int b = 0; b < numBodies; b++)
+		{
+			m_scratchOfs.push_back(m_scratchBodyRowStart[b]);
+		}
+
+		for (int i = 0; i < numRows; i++)
+		{
+			const btSolverConstraint& c = *m_allConstraintPtrArray[i];
+			for (int side = 0; side < 2; side++)
+			{
+				int sb = side ? c.m_solverBodyIdB : c.m_solverBodyIdA;
+				if (!btIsDynamicSolverBody(m_tmpSolverBodyPool[sb]))
+					continue;
+				const btRigidBody* body = m_tmpSolverBodyPool[sb].m_originalBody;
+				const btVector3& normal = side ? c.m_contactNormal2 : c.m_contactNormal1;
+				const btVector3& relPosCrossNormal = side ? c.m_relpos2CrossNormal : c.m_relpos1CrossNormal;
+				btVector3 normalInvMass = normal * body->getInvMass();
+				btVector3 relPosCrossNormalInvInertia = relPosCrossNormal * body->getInvInertiaTensorWorld();
+
+				btScalar* j = J + 8 * (2 * i + side);
+				btScalar* jInvM = JinvM + 8 * (2 * i + side);
+				for (int r = 0; r < 3; r++)
+				{
+					j[r] = normal[r];
+					j[r + 4] = relPosCrossNormal[r];
+					jInvM[r] = normalInvMass[r];
+					jInvM[r + 4] = relPosCrossNormalInvInertia[r];
+				}
+				j[3] = j[7] = jInvM[3] = jInvM[7] = 0;
+
+				m_scratchBodyRows[m_scratchOfs[sb]++] = 2 * i + side;
+			}
+		}
+	}
+
+	{
+		BT_PROFILE("Compute A");
+		const btScalar* J = J3.getBufferPointer();
+		const btScalar* JinvM = JinvM3.getBufferPointer();
+
+		//A = J*invM*J^T only couples rows that act on a common body: add the part of every body
+		//to the pairs of its rows, lower triangle only
+		for (int b = 0; b < numBodies; b++)
+		{
+			int begin = m_scratchBodyRowStart[b];
+			int end = m_scratchBodyRowStart[b + 1];
+			if (begin == end)
+				continue;
+
+			btMLCPBlock& block = *m_blocks[m_scratchRowBlock[m_scratchBodyRows[begin] >> 1]];
+			int n = block.m_rows.size();
+			btScalar* A = block.m_A.getBufferPointerWritable();
+
+			for (int u = begin; u < end; u++)
+			{
+				int entryU = m_scratchBodyRows[u];
+				const btScalar* jInvM = JinvM + 8 * entryU;
+				btScalar* Arow = A + m_scratchBlockRow[entryU >> 1] * n;
+
+				//rows are in increasing order, so the columns up to and including u are on or below the diagonal
+				for (int v = begin; v <= u; v++)
+				{
+					int entryV = m_scratchBodyRows[v];
+					const btScalar* j = J + 8 * entryV;
+					Arow[m_scratchBlockRow[entryV >> 1]] +=
+						jInvM[0] * j[0] + jInvM[1] * j[1] + jInvM[2] * j[2] +
+						jInvM[4] * j[4] + jInvM[5] * j[5] + jInvM[6] * j[6];
+				}
+			}
+		}
+
+		///fill the upper triangle of the matrices, to make them symmetric
+		for (int k = 0; k < m_numBlocks; k++)
+		{
+			btMLCPBlock& block = *m_blocks[k];
+			int n = block.m_rows.size();
+			btScalar* A = block.m_A.getBufferPointerWritable();
+			for (int row = 1; row < n; row++)
+			{
+				for (int col = 0; col < row; col++)
+				{
+					A[col * n + row] = A[row * n + col];
+				}
+			}
+		}
+	}
+}
+
+struct btMLCPBlockSolveLoop : public btIParallelForBody
+{
+	btMLCPSolverInterface* m_solver;
+	btMLCPBlock* const* m_blocks;
+	const btContactSolverInfo* m_infoGlobal;
+
+	void forLoop(int iBegin, int iEnd) const BT_OVERRIDE
+	{
+		for (int i = iBegin; i < iEnd; i++)
+		{
+			btMLCPBlock& block = *m_blocks[i];
+			block.m_solved = m_solver->solveMLCP(block.m_A, block.m_b, block.m_x, block.m_lo, block.m_hi, block.m_limitDependencies, m_infoGlobal->m_numIterations);
+
+			//if using split impulse, we solve 2 separate (M)LCPs
+			if (block.m_solved && m_infoGlobal->m_splitImpulse)
+				block.m_solved = m_solver->solveMLCP(block.m_A, block.m_bSplit, block.m_xSplit, block.m_lo, block.m_hi, block.m_limitDependencies, m_infoGlobal->m_numIterations);
+		}
+	}
+};
+
+bool btMLCPSolver::solveMLCPBlocks(const btContactSolverInfo& infoGlobal)
+{
+	btMLCPBlockSolveLoop loop;
+	loop.m_solver = m_solver;
+	loop.m_blocks = &m_blocks[0];
+	loop.m_infoGlobal = &infoGlobal;
+
+	if (m_solver->canSolveConcurrently())
+		btParallelFor(0, m_numBlocks, 1, loop);
+	else
+		loop.forLoop(0, m_numBlocks);
+
+	//like the single MLCP, the whole group falls back to the sequential impulse iterations if a block fails
+	for (int k = 0; k < m_numBlocks; k++)
+	{
+		const btMLCPBlock& block = *m_blocks[k];
+		if (!block.m_solved)
+			return false;
+		for (int i = 0; i < block.m_rows.size(); i++)
+		{
+			m_x[block.m_rows[i]] = block.m_x[i];
+			if (infoGlobal.m_splitImpulse)
+				m_xSplit[block.m_rows[i]] = block.m_xSplit[i];
+		}
+	}
+	return true;
+}
+
 void btMLCPSolver::createMLCP(const btContactSolverInfo& infoGlobal)
 {
 	int numBodies = this->m_tmpSolverBodyPool.size();
@@ -608,6 +885,14 @@ btScalar btMLCPSolver::solveGroupCacheFriendlyIterations(btCollisionObject** bod
 				}
 			}
 		}
+
+		//solved directly: no iterations, and the residual is not measured
+		m_analyticsData.m_numSolverCalls++;
+		m_analyticsData.m_numIterationsUsed = 0;
+		m_analyticsData.m_islandId = numBodies > 0 ? bodies[0]->getCompanionId() : -2;
+		m_analyticsData.m_numBodies = numBodies;
+		m_analyticsData.m_numContactManifolds = numManifolds;
+		m_analyticsData.m_remainingLeastSquaresResidual = -1;
 	}
 	else
 	{
@@ -618,3 +903,151 @@ btScalar btMLCPSolver::solveGroupCacheFriendlyIterations(btCollisionObject** bod
 
 	return 0.f;
 }
+
+#if BT_MLCP_SOLVER_ENABLE_BENCHMARK
+
+#include "btDantzigSolver.h"
+#include "BulletDynamics/ConstraintSolver/btHingeConstraint.h"
+#include "BulletDynamics/ConstraintSolver/btFixedConstraint.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "BulletCollision/CollisionShapes/btBoxShape.h"
+#include "LinearMath/btDefaultMotionState.h"
+#include <stdio.h>
+
+///the tanks of the demo side by side on the ground, driven forward: an island of five bodies, four joints and the
+///contacts of the tracks per tank, which the world batches into larger groups for the solver
+struct btMLCPBenchmarkScene
+{
+	btDefaultCollisionConfiguration m_configuration;
+	btCollisionDispatcher m_dispatcher;
+	btDbvtBroadphase m_broadphase;
+	btDiscreteDynamicsWorld m_world;
+	btBoxShape m_ground;
+	btBoxShape m_chassis;
+	btBoxShape m_track;
+	btBoxShape m_turret;
+	btBoxShape m_cannon;
+	btAlignedObjectArray<btRigidBody*> m_bodies;
+	btAlignedObjectArray<btTypedConstraint*> m_constraints;
+	btAlignedObjectArray<btRigidBody*> m_tracks;
+
+	btMLCPBenchmarkScene(btConstraintSolver* solver, int tanks)
+		: m_dispatcher(&m_configuration),
+		  m_world(&m_dispatcher, &m_broadphase, solver, &m_configuration),
+		  m_ground(btVector3(400, 1, 400)),
+		  m_chassis(btVector3(1.0, 0.2, 1.0)),
+		  m_track(btVector3(0.25, 0.25, 1.0)),
+		  m_turret(btVector3(0.5, 0.2, 0.35)),
+		  m_cannon(btVector3(0.2, 0.1, 0.5))
+	{
+		m_world.setGravity(btVector3(0, -10, 0));
+		m_world.getSolverInfo().m_linearSlop = 0.01f;
+		m_world.getSolverInfo().m_restitution = 0;
+		//the four contacts of a track on the ground are redundant, a little cfm keeps A invertible
+		m_world.getSolverInfo().m_globalCfm = btScalar(1e-5);
+		addBody(&m_ground, 0, btVector3(0, -1.26f, 0), 1, 2);
+		for (int t = 0; t < tanks; t++)
+		{
+			const btVector3 center(btScalar(t % 10) * 6, 0, btScalar(t / 10) * 6);
+			//only the tracks touch the ground, the parts of one tank do not collide with each other
+			btRigidBody* chassis = addBody(&m_chassis, 1, center, 2, 0);
+			btRigidBody* leftTrack = addBody(&m_track, 1, center + btVector3(-1.2f, 0, 0), 2, 1);
+			btRigidBody* rightTrack = addBody(&m_track, 1, center + btVector3(1.2f, 0, 0), 2, 1);
+			btRigidBody* turret = addBody(&m_turret, 1, center + btVector3(0, 0.5f, 0), 2, 0);
+			btRigidBody* cannon = addBody(&m_cannon, 1, center + btVector3(0, 0.5f, -0.85f), 2, 0);
+			addConstraint(new btHingeConstraint(*chassis, *leftTrack, btVector3(-1.2f, 0, 0), btVector3(0, 0, 0), btVector3(0, 1, 0), btVector3(0, 1, 0)));
+			addConstraint(new btHingeConstraint(*chassis, *rightTrack, btVector3(1.2f, 0, 0), btVector3(0, 0, 0), btVector3(0, 1, 0), btVector3(0, 1, 0)));
+			btTransform frameInA = btTransform::getIdentity();
+			frameInA.setOrigin(btVector3(0, 0.5f, 0));
+			addConstraint(new btFixedConstraint(*chassis, *turret, frameInA, btTransform::getIdentity()));
+			frameInA.setOrigin(btVector3(0, 0, -0.85f));
+			addConstraint(new btFixedConstraint(*turret, *cannon, frameInA, btTransform::getIdentity()));
+			m_tracks.push_back(leftTrack);
+			m_tracks.push_back(rightTrack);
+		}
+	}
+
+	~btMLCPBenchmarkScene()
+	{
+		for (int i = 0; i < m_constraints.size(); i++)
+		{
+			m_world.removeConstraint(m_constraints[i]);
+			delete m_constraints[i];
+		}
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world.removeRigidBody(m_bodies[i]);
+			delete m_bodies[i]->getMotionState();
+			delete m_bodies[i];
+		}
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position, int group, int mask)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass != 0)
+			shape->calculateLocalInertia(mass, inertia);
+		btRigidBody* body = new btRigidBody(mass, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), position)), shape, inertia);
+		if (mass != 0)
+			body->setActivationState(DISABLE_DEACTIVATION);
+		m_world.addRigidBody(body, group, mask);
+		m_bodies.push_back(body);
+		return body;
+	}
+
+	void addConstraint(btTypedConstraint* constraint)
+	{
+		m_world.addConstraint(constraint, true);
+		m_constraints.push_back(constraint);
+	}
+
+	void step()
+	{
+		for (int i = 0; i < m_tracks.size(); i++)
+			m_tracks[i]->applyCentralForce(btVector3(0, 0, -20));
+		m_world.stepSimulation(1.f / 60.f, 0);
+	}
+};
+
+void btMLCPSolver::benchmark()
+{
+	const int numCounts = 4;
+	const int tankCounts[numCounts] = {1, 4, 16, 64};
+	const int maxDenseTanks = 16;  //the dense matrix of 64 tanks takes minutes per step
+	const int steps = 120;
+
+	btDantzigSolver dantzig;
+	for (int c = 0; c < numCounts; c++)
+	{
+		for (int blocks = 0; blocks < 2; blocks++)
+		{
+			if (!blocks && tankCounts[c] > maxDenseTanks)
+			{
+				printf("%3d tanks, dense:   skipped\n", tankCounts[c]);
+				continue;
+			}
+			btMLCPSolver solver(&dantzig);
+			solver.setUseBlocks(blocks != 0);
+			unsigned long long microseconds = 0;
+			int maxBlocks = 0;
+			{
+				btMLCPBenchmarkScene scene(&solver, tankCounts[c]);
+				btClock clock;
+				for (int i = 0; i < steps; i++)
+				{
+					clock.reset();
+					scene.step();
+					microseconds += clock.getTimeMicroseconds();
+					maxBlocks = btMax(maxBlocks, solver.getNumBlocks());
+				}
+			}
+			printf("%3d tanks, %s %9.3f ms/step, %d fallbacks, up to %d blocks per group\n", tankCounts[c], blocks ? "blocked:" : "dense:  ",
+				   double(microseconds) / steps / 1000.0, solver.getNumFallbacks(), maxBlocks);
+		}
+	}
+}
+
+#endif  //BT_MLCP_SOLVER_ENABLE_BENCHMARK
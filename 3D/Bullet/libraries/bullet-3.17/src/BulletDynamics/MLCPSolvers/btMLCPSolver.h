@@ -20,6 +20,27 @@ subject to the following restrictions:
 #include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
 #include "LinearMath/btMatrixX.h"
 #include "BulletDynamics/MLCPSolvers/btMLCPSolverInterface.h"
+#include "BulletCollision/CollisionDispatch/btUnionFind.h"
+
+#ifndef BT_MLCP_SOLVER_ENABLE_BENCHMARK
+#define BT_MLCP_SOLVER_ENABLE_BENCHMARK 0
+#endif
+
+///rows of the MLCP that share no dynamic body with the other rows. The A matrix is block diagonal,
+///so every block is a separate MLCP, of the size of one island instead of the whole group.
+struct btMLCPBlock
+{
+	btAlignedObjectArray<int> m_rows;  ///< index of each row in btMLCPSolver::m_allConstraintPtrArray
+	btAlignedObjectArray<int> m_limitDependencies;
+	btMatrixXu m_A;
+	btVectorXu m_b;
+	btVectorXu m_x;
+	btVectorXu m_lo;
+	btVectorXu m_hi;
+	btVectorXu m_bSplit;
+	btVectorXu m_xSplit;
+	bool m_solved;
+};
 
 class btMLCPSolver : public btSequentialImpulseConstraintSolver
 {
@@ -52,14 +73,29 @@ protected:
 	btMatrixXu m_scratchJTranspose;
 	btMatrixXu m_scratchTmp;
 
+	///the blocks of the MLCP, only the first m_numBlocks are in use, the others keep their storage for later steps
+	btAlignedObjectArray<btMLCPBlock*> m_blocks;
+	int m_numBlocks;
+	bool m_useBlocks;
+
+	btUnionFind m_scratchBodySets;
+	btAlignedObjectArray<int> m_scratchBlockOfSet;
+	btAlignedObjectArray<int> m_scratchRowBlock;
+	btAlignedObjectArray<int> m_scratchBlockRow;
+	btAlignedObjectArray<int> m_scratchBodyRowStart;
+	btAlignedObjectArray<int> m_scratchBodyRows;
+
 	virtual btScalar solveGroupCacheFriendlySetup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
 	virtual btScalar solveGroupCacheFriendlyIterations(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifoldPtr, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& infoGlobal, btIDebugDraw* debugDrawer);
 
 	virtual void createMLCP(const btContactSolverInfo& infoGlobal);
 	virtual void createMLCPFast(const btContactSolverInfo& infoGlobal);
+	///builds one A matrix per block, from the rows of each dynamic body, instead of one dense matrix
+	virtual void createMLCPBlocks(const btContactSolverInfo& infoGlobal);
 
 	//return true is it solves the problem successfully
 	virtual bool solveMLCP(const btContactSolverInfo& infoGlobal);
+	virtual bool solveMLCPBlocks(const btContactSolverInfo& infoGlobal);
 
 public:
 	btMLCPSolver(btMLCPSolverInterface* solver);
@@ -79,10 +115,35 @@ public:
 		m_fallback = num;
 	}
 
+	///split the MLCP into independent blocks, solved in parallel when the MLCP solver allows it (the default).
+	///Otherwise the fast path builds one dense A matrix for the whole group.
+	void setUseBlocks(bool useBlocks)
+	{
+		m_useBlocks = useBlocks;
+	}
+	bool getUseBlocks() const
+	{
+		return m_useBlocks;
+	}
+	///number of blocks of the last MLCP, 0 when it was built as one matrix
+	int getNumBlocks() const
+	{
+		return m_numBlocks;
+	}
+
 	virtual btConstraintSolverType getSolverType() const
 	{
 		return BT_MLCP_SOLVER;
 	}
+
+	///step cost of many tanks with the dense and the blocked MLCP
+#if BT_MLCP_SOLVER_ENABLE_BENCHMARK
+	static void benchmark();
+#else
+	static void benchmark()
+	{
+	}
+#endif
 };
 
 #endif  //BT_MLCP_SOLVER_H
@@ -28,6 +28,12 @@ public:
 
 	//return true is it solves the problem successfully
 	virtual bool solveMLCP(const btMatrixXu& A, const btVectorXu& b, btVectorXu& x, const btVectorXu& lo, const btVectorXu& hi, const btAlignedObjectArray<int>& limitDependency, int numIterations, bool useSparsity = true) = 0;
+
+	///true if solveMLCP can run on several threads at once, so btMLCPSolver can solve independent blocks in parallel
+	virtual bool canSolveConcurrently() const
+	{
+		return false;
+	}
 };
 
 #endif  //BT_MLCP_SOLVER_INTERFACE_H
@@ -38,6 +38,12 @@ subject to the following restrictions:
 #include <new>  //for placement new
 #endif          //BT_USE_PLACEMENT_NEW
 
+///With a C++11 compiler the array can be moved, and growing it moves the elements to the new storage instead of copying them
+#if defined(BT_USE_PLACEMENT_NEW) && ((defined(__cplusplus) && __cplusplus >= 201103L) || (defined(_MSC_VER) && _MSC_VER >= 1900))
+#define BT_USE_MOVE_SEMANTICS 1
+#include <utility>  //for std::move
+#endif
+
 ///The btAlignedObjectArray template class uses a subset of the stl::vector interface for its methods
 ///It is developed to replace stl::vector to avoid portability issues, including STL alignment issues to add SIMD/SSE data
 template <typename T>
@@ -79,6 +85,17 @@ protected:
 			dest[i] = m_data[i];
 #endif  //BT_USE_PLACEMENT_NEW
 	}
+	///like copy, but the elements may be moved out of this array. Used when the storage is reallocated.
+	SIMD_FORCE_INLINE void relocate(int start, int end, T* dest)
+	{
+#ifdef BT_USE_MOVE_SEMANTICS
+		int i;
+		for (i = start; i < end; ++i)
+			new (&dest[i]) T(std::move(m_data[i]));
+#else
+		copy(start, end, dest);
+#endif  //BT_USE_MOVE_SEMANTICS
+	}
 
 	SIMD_FORCE_INLINE void init()
 	{
@@ -110,9 +127,7 @@ protected:
 		{
 			//PCK: enclosed the deallocation in this block
 			if (m_ownsMemory)
-			{
 				m_allocator.deallocate(m_data);
-			}
 			m_data = 0;
 		}
 	}
@@ -134,9 +149,28 @@ public:
 		init();
 
 		int otherSize = otherArray.size();
-		resize(otherSize);
+		reserve(otherSize);
 		otherArray.copy(0, otherSize, m_data);
+		m_size = otherSize;
+	}
+
+#ifdef BT_USE_MOVE_SEMANTICS
+	///Takes the storage of otherArray when it owns it, otherwise moves its elements. otherArray is left empty.
+	btAlignedObjectArray(btAlignedObjectArray&& otherArray)
+	{
+		init();
+		moveFromArray(otherArray);
+	}
+
+	btAlignedObjectArray<T>& operator=(btAlignedObjectArray<T>&& otherArray)
+	{
+		if (this != &otherArray)
+		{
+			moveFromArray(otherArray);
+		}
+		return *this;
 	}
+#endif  //BT_USE_MOVE_SEMANTICS
 
 	/// return the number of elements in the array
 	SIMD_FORCE_INLINE int size() const
@@ -271,6 +305,21 @@ public:
 		m_size++;
 	}
 
+#ifdef BT_USE_MOVE_SEMANTICS
+	SIMD_FORCE_INLINE void push_back(T&& _Val)
+	{
+		const int sz = size();
+		if (sz == capacity())
+		{
+			reserve(allocSize(size()));
+		}
+
+		new (&m_data[m_size]) T(std::move(_Val));
+
+		m_size++;
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+
 	/// return the pre-allocated (reserved) elements, this is at least as large as the total number of elements,see size() and reserve()
 	SIMD_FORCE_INLINE int capacity() const
 	{
@@ -283,7 +332,7 @@ public:
 		{  // not enough room, reallocate
 			T* s = (T*)allocate(_Count);
 
-			copy(0, size(), s);
+			relocate(0, size(), s);
 
 			destroy(0, size());
 
@@ -386,6 +435,10 @@ public:
 		memcpy(temp, &m_data[index0], sizeof(T));
 		memcpy(&m_data[index0], &m_data[index1], sizeof(T));
 		memcpy(&m_data[index1], temp, sizeof(T));
+#elif defined(BT_USE_MOVE_SEMANTICS)
+		T temp = std::move(m_data[index0]);
+		m_data[index0] = std::move(m_data[index1]);
+		m_data[index1] = std::move(temp);
 #else
 		T temp = m_data[index0];
 		m_data[index0] = m_data[index1];
@@ -493,11 +546,118 @@ public:
 		m_capacity = capacity;
 	}
 
+	///destroys the current elements and copy-constructs those of otherArray
 	void copyFromArray(const btAlignedObjectArray& otherArray)
 	{
+		if (this == &otherArray)
+			return;
 		int otherSize = otherArray.size();
-		resize(otherSize);
+		destroy(0, size());
+		m_size = 0;
+		reserve(otherSize);
 		otherArray.copy(0, otherSize, m_data);
+		m_size = otherSize;
+	}
+
+#ifdef BT_USE_MOVE_SEMANTICS
+	///Takes the storage of otherArray if it owns it, otherwise moves its elements
+	///into this array's storage, which keeps a buffer given to initializeFromBuffer. otherArray is left empty.
+	void moveFromArray(btAlignedObjectArray& otherArray)
+	{
+		if (otherArray.m_ownsMemory && otherArray.m_data)
+		{
+			clear();
+			m_data = otherArray.m_data;
+			m_size = otherArray.m_size;
+			m_capacity = otherArray.m_capacity;
+			otherArray.init();
+		}
+		else
+		{
+			destroy(0, size());
+			m_size = 0;
+			reserve(otherArray.size());
+			otherArray.relocate(0, otherArray.size(), m_data);
+			m_size = otherArray.size();
+			otherArray.destroy(0, otherArray.size());
+			otherArray.m_size = 0;
+		}
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+};
+
+///btSmallObjectArray keeps up to N elements in a buffer inside the array itself, and only allocates when it grows beyond them.
+///Meant for short-lived arrays that usually stay small, such as the vertices of a clipped face.
+///clear() through a btAlignedObjectArray reference drops the inline buffer, later growth then uses the heap.
+template <typename T, int N>
+class btSmallObjectArray : public btAlignedObjectArray<T>
+{
+	union btInlineStorage
+	{
+		char m_bytes[sizeof(T) * N];
+		btScalar m_alignScalar;
+		void* m_alignPointer;
+	};
+	ATTRIBUTE_ALIGNED16(btInlineStorage m_inlineStorage);
+
+	void useInlineStorage()
+	{
+		this->initializeFromBuffer(m_inlineStorage.m_bytes, 0, N);
+	}
+
+public:
+	btSmallObjectArray()
+	{
+		useInlineStorage();
+	}
+
+	btSmallObjectArray(const btSmallObjectArray& otherArray)
+		: btAlignedObjectArray<T>()
+	{
+		useInlineStorage();
+		this->copyFromArray(otherArray);
+	}
+
+	~btSmallObjectArray()
+	{
+		this->clear();
+	}
+
+	btSmallObjectArray& operator=(const btAlignedObjectArray<T>& otherArray)
+	{
+		this->copyFromArray(otherArray);
+		return *this;
+	}
+
+	btSmallObjectArray& operator=(const btSmallObjectArray& otherArray)
+	{
+		this->copyFromArray(otherArray);
+		return *this;
+	}
+
+#ifdef BT_USE_MOVE_SEMANTICS
+	btSmallObjectArray(btSmallObjectArray&& otherArray)
+		: btAlignedObjectArray<T>()
+	{
+		useInlineStorage();
+		this->moveFromArray(otherArray);
+	}
+
+	btSmallObjectArray& operator=(btSmallObjectArray&& otherArray)
+	{
+		if (this != &otherArray)
+		{
+			this->moveFromArray(otherArray);
+		}
+		return *this;
+	}
+#endif  //BT_USE_MOVE_SEMANTICS
+
+	///destroys the elements and frees any heap storage, going back to the inline buffer
+	void clear()
+	{
+		btAlignedObjectArray<T>::clear();
+		useInlineStorage();
 	}
 };
 
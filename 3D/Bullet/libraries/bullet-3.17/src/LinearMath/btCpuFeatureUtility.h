@@ -7,10 +7,15 @@
 #include <string.h>  //memset
 #ifdef USE_SIMD
 #include <emmintrin.h>
+#endif  //USE_SIMD
+
 #ifdef BT_ALLOW_SSE4
+#ifdef _MSC_VER
 #include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 #endif  //BT_ALLOW_SSE4
-#endif  //USE_SIMD
 
 #if defined BT_USE_NEON
 #define ARM_NEON_GCC_COMPATIBILITY 1
@@ -19,7 +24,7 @@
 #include <sys/sysctl.h>  //for sysctlbyname
 #endif                   //BT_USE_NEON
 
-///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, NEON_HPFP)
+///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3/AVX2/AVX-512, NEON_HPFP)
 ///We assume SSE2 in case BT_USE_SSE2 is defined in LinearMath/btScalar.h
 class btCpuFeatureUtility
 {
@@ -28,7 +33,9 @@ public:
 	{
 		CPU_FEATURE_FMA3 = 1,
 		CPU_FEATURE_SSE4_1 = 2,
-		CPU_FEATURE_NEON_HPFP = 4
+		CPU_FEATURE_NEON_HPFP = 4,
+		CPU_FEATURE_AVX2 = 8,
+		CPU_FEATURE_AVX512F = 16
 	};
 
 	static int getCpuFeatures()
@@ -55,14 +62,14 @@ public:
 			int cpuInfo[4];
 			memset(cpuInfo, 0, sizeof(cpuInfo));
 			unsigned long long sseExt = 0;
-			__cpuid(cpuInfo, 1);
+			cpuid(cpuInfo, 1);
 
 			bool osUsesXSAVE_XRSTORE = cpuInfo[2] & (1 << 27) || false;
 			bool cpuAVXSuport = cpuInfo[2] & (1 << 28) || false;
 
 			if (osUsesXSAVE_XRSTORE && cpuAVXSuport)
 			{
-				sseExt = _xgetbv(0);
+				sseExt = xgetbv();
 			}
 			const int OSXSAVEFlag = (1UL << 27);
 			const int AVXFlag = ((1UL << 28) | OSXSAVEFlag);
@@ -77,12 +84,64 @@ public:
 			{
 				capabilities |= btCpuFeatureUtility::CPU_FEATURE_SSE4_1;
 			}
+
+			//AVX2 is reported in leaf 7, and also needs the OS to save the YMM registers
+			int maxLeaf[4];
+			cpuid(maxLeaf, 0);
+			if (maxLeaf[0] >= 7 && (sseExt & 6) == 6)
+			{
+				int extendedInfo[4];
+				memset(extendedInfo, 0, sizeof(extendedInfo));
+				cpuid(extendedInfo, 7);
+				const int AVX2Flag = (1 << 5);
+				if (extendedInfo[1] & AVX2Flag)
+				{
+					capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX2;
+				}
+				//AVX-512 also needs the opmask and upper ZMM state enabled
+				const int AVX512FFlag = (1 << 16);
+				if ((extendedInfo[1] & AVX512FFlag) && (sseExt & 0xe6) == 0xe6)
+				{
+					capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX512F;
+				}
+			}
 		}
 #endif  //BT_ALLOW_SSE4
 
 		testedCapabilities = true;
 		return capabilities;
 	}
+
+#ifdef BT_ALLOW_SSE4
+private:
+	///__cpuid and _xgetbv are MSVC intrinsics, use cpuid.h and inline assembly with GCC and Clang
+	static void cpuid(int cpuInfo[4], int leaf)
+	{
+#ifdef _MSC_VER
+		__cpuidex(cpuInfo, leaf, 0);
+#else
+		unsigned int eax, ebx, ecx, edx;
+		__cpuid_count(leaf, 0, eax, ebx, ecx, edx);
+		cpuInfo[0] = int(eax);
+		cpuInfo[1] = int(ebx);
+		cpuInfo[2] = int(ecx);
+		cpuInfo[3] = int(edx);
+#endif
+	}
+
+	static unsigned long long xgetbv()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ __volatile__("xgetbv"
+							 : "=a"(eax), "=d"(edx)
+							 : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+#endif  //BT_ALLOW_SSE4
 };
 
 #endif  //BT_CPU_UTILITY_H
@@ -213,60 +213,261 @@ public:
 	}
 };
 
+///btHashIndexSlot is one entry of a btHashIndexTable: the full hash of a key and the index of the key in a dense array.
+struct btHashIndexSlot
+{
+	unsigned int m_hash;
+	int m_index;
+};
+
+///btHashIndexTable maps hashes to indices into a dense array of keys, with open addressing and Robin Hood linear probing.
+///Each slot stores the full hash next to the index, so a probe compares hashes without touching the keys, and growing
+///the table never rehashes a key. Slots are 8 bytes, so the probe of a lookup usually stays in one cache line: Robin Hood
+///insertion keeps probe sequences short, a lookup stops as soon as it reaches a slot closer to its home than the key
+///would be, and removal shifts the following slots back instead of leaving tombstones.
+///The table does not own the keys: lookups take a functor that compares the searched key with the key at an index.
+class btHashIndexTable
+{
+	btAlignedObjectArray<btHashIndexSlot> m_slots;
+	int m_count;
+
+	SIMD_FORCE_INLINE unsigned int getMask() const
+	{
+		return (unsigned int)m_slots.size() - 1;
+	}
+
+	///number of slots between the home slot of the hash and the slot at position pos
+	SIMD_FORCE_INLINE unsigned int probeDistance(unsigned int pos, unsigned int hash) const
+	{
+		return (pos - hash) & getMask();
+	}
+
+	void insertSlot(btHashIndexSlot slot)
+	{
+		const unsigned int mask = getMask();
+		unsigned int pos = slot.m_hash & mask;
+		unsigned int distance = 0;
+		for (;;)
+		{
+			btHashIndexSlot& current = m_slots[pos];
+			if (current.m_index == BT_HASH_NULL)
+			{
+				current = slot;
+				return;
+			}
+			//take the slot from entries that are closer to their home
+			unsigned int currentDistance = probeDistance(pos, current.m_hash);
+			if (currentDistance < distance)
+			{
+				btSwap(current, slot);
+				distance = currentDistance;
+			}
+			pos = (pos + 1) & mask;
+			distance++;
+		}
+	}
+
+	void rehash(int newSize)
+	{
+		btAlignedObjectArray<btHashIndexSlot> oldSlots(m_slots);
+
+		m_slots.resize(newSize);
+		for (int i = 0; i < newSize; i++)
+		{
+			m_slots[i].m_hash = 0;
+			m_slots[i].m_index = BT_HASH_NULL;
+		}
+
+		for (int i = 0; i < oldSlots.size(); i++)
+		{
+			if (oldSlots[i].m_index != BT_HASH_NULL)
+			{
+				insertSlot(oldSlots[i]);
+			}
+		}
+	}
+
+	int findSlotOfIndex(unsigned int hash, int index) const
+	{
+		const unsigned int mask = getMask();
+		unsigned int pos = hash & mask;
+		while (m_slots[pos].m_index != index)
+		{
+			btAssert(m_slots[pos].m_index != BT_HASH_NULL);
+			pos = (pos + 1) & mask;
+		}
+		return int(pos);
+	}
+
+public:
+	btHashIndexTable()
+		: m_count(0)
+	{
+	}
+
+	///makes room for count entries without growing the table again
+	void reserve(int count)
+	{
+		//keep the load factor at or below 3/4
+		int newSize = 8;
+		while (newSize * 3 < count * 4)
+		{
+			newSize *= 2;
+		}
+		if (newSize > m_slots.size())
+		{
+			rehash(newSize);
+		}
+	}
+
+	///returns the index of the entry with this hash for which equals(index) is true, or BT_HASH_NULL
+	template <typename Equals>
+	SIMD_FORCE_INLINE int findIndex(unsigned int hash, const Equals& equals) const
+	{
+		if (m_count == 0)
+		{
+			return BT_HASH_NULL;
+		}
+		const unsigned int mask = getMask();
+		unsigned int pos = hash & mask;
+		unsigned int distance = 0;
+		for (;;)
+		{
+			const btHashIndexSlot& slot = m_slots[pos];
+			if (slot.m_index == BT_HASH_NULL || probeDistance(pos, slot.m_hash) < distance)
+			{
+				return BT_HASH_NULL;
+			}
+			if (slot.m_hash == hash && equals(slot.m_index))
+			{
+				return slot.m_index;
+			}
+			pos = (pos + 1) & mask;
+			distance++;
+		}
+	}
+
+	///adds an entry; the caller makes sure that no entry with an equal key is in the table
+	void insert(unsigned int hash, int index)
+	{
+		if ((m_count + 1) * 4 > m_slots.size() * 3)
+		{
+			reserve(2 * m_count + 1);
+		}
+		btHashIndexSlot slot;
+		slot.m_hash = hash;
+		slot.m_index = index;
+		insertSlot(slot);
+		m_count++;
+	}
+
+	///removes the entry that refers to index, which must be in the table with this hash
+	void remove(unsigned int hash, int index)
+	{
+		const unsigned int mask = getMask();
+		unsigned int pos = (unsigned int)findSlotOfIndex(hash, index);
+		//shift the following entries back until one is at its home or the run ends
+		unsigned int next = (pos + 1) & mask;
+		while (m_slots[next].m_index != BT_HASH_NULL && probeDistance(next, m_slots[next].m_hash) != 0)
+		{
+			m_slots[pos] = m_slots[next];
+			pos = next;
+			next = (next + 1) & mask;
+		}
+		m_slots[pos].m_index = BT_HASH_NULL;
+		m_count--;
+	}
+
+	///updates the entry that refers to oldIndex after the key moved to newIndex in the dense array
+	void replaceIndex(unsigned int hash, int oldIndex, int newIndex)
+	{
+		m_slots[findSlotOfIndex(hash, oldIndex)].m_index = newIndex;
+	}
+
+	int size() const
+	{
+		return m_count;
+	}
+
+	void clear()
+	{
+		m_slots.clear();
+		m_count = 0;
+	}
+};
+
 ///The btHashMap template class implements a generic and lightweight hashmap.
 ///A basic sample of how to use btHashMap is located in Demos\BasicDemo\main.cpp
+///Keys and values are kept in insertion order in dense arrays, which getAtIndex and getKeyAtIndex expose. Removing an
+///entry moves the last entry into its place. The hashes are looked up in a btHashIndexTable.
 template <class Key, class Value>
 class btHashMap
 {
 protected:
-	btAlignedObjectArray<int> m_hashTable;
-	btAlignedObjectArray<int> m_next;
+	btHashIndexTable m_indexTable;
 
 	btAlignedObjectArray<Value> m_valueArray;
 	btAlignedObjectArray<Key> m_keyArray;
 
-	void growTables(const Key& /*key*/)
+	struct KeyEquals
 	{
-		int newCapacity = m_valueArray.capacity();
+		const Key& m_key;
+		const btAlignedObjectArray<Key>& m_keyArray;
 
-		if (m_hashTable.size() < newCapacity)
+		KeyEquals(const Key& key, const btAlignedObjectArray<Key>& keyArray)
+			: m_key(key),
+			  m_keyArray(keyArray)
 		{
-			//grow hashtable and next table
-			int curHashtableSize = m_hashTable.size();
-
-			m_hashTable.resize(newCapacity);
-			m_next.resize(newCapacity);
-
-			int i;
+		}
 
-			for (i = 0; i < newCapacity; ++i)
-			{
-				m_hashTable[i] = BT_HASH_NULL;
-			}
-			for (i = 0; i < newCapacity; ++i)
-			{
-				m_next[i] = BT_HASH_NULL;
-			}
+		bool operator()(int index) const
+		{
+			return m_key.equals(m_keyArray[index]);
+		}
+	};
 
-			for (i = 0; i < curHashtableSize; i++)
-			{
-				//const Value& value = m_valueArray[i];
-				//const Key& key = m_keyArray[i];
+	///rebuilds the index table after the key array was filled in directly
+	void rebuildIndexTable()
+	{
+		m_indexTable.clear();
+		m_indexTable.reserve(m_keyArray.size());
+		for (int i = 0; i < m_keyArray.size(); i++)
+		{
+			m_indexTable.insert(m_keyArray[i].getHash(), i);
+		}
+	}
 
-				int hashValue = m_keyArray[i].getHash() & (m_valueArray.capacity() - 1);  // New hash value with new mask
-				m_next[i] = m_hashTable[hashValue];
-				m_hashTable[hashValue] = i;
-			}
+	///fills the separate chaining tables of the earlier btHashMap layout, which serialized data still stores
+	void buildChainedTables(btAlignedObjectArray<int>& hashTable, btAlignedObjectArray<int>& next) const
+	{
+		int tableSize = m_keyArray.size() ? 1 : 0;
+		while (tableSize < m_keyArray.size())
+		{
+			tableSize *= 2;
+		}
+		hashTable.resize(tableSize);
+		next.resize(tableSize);
+		int i;
+		for (i = 0; i < tableSize; i++)
+		{
+			hashTable[i] = BT_HASH_NULL;
+			next[i] = BT_HASH_NULL;
+		}
+		for (i = 0; i < m_keyArray.size(); i++)
+		{
+			int hashValue = m_keyArray[i].getHash() & (tableSize - 1);
+			next[i] = hashTable[hashValue];
+			hashTable[hashValue] = i;
 		}
 	}
 
 public:
 	void insert(const Key& key, const Value& value)
 	{
-		int hash = key.getHash() & (m_valueArray.capacity() - 1);
+		unsigned int hash = key.getHash();
 
 		//replace value if the key is already there
-		int index = findIndex(key);
+		int index = m_indexTable.findIndex(hash, KeyEquals(key, m_keyArray));
 		if (index != BT_HASH_NULL)
 		{
 			m_valueArray[index] = value;
@@ -274,56 +475,26 @@ public:
 		}
 
 		int count = m_valueArray.size();
-		int oldCapacity = m_valueArray.capacity();
 		m_valueArray.push_back(value);
 		m_keyArray.push_back(key);
-
-		int newCapacity = m_valueArray.capacity();
-		if (oldCapacity < newCapacity)
-		{
-			growTables(key);
-			//hash with new capacity
-			hash = key.getHash() & (m_valueArray.capacity() - 1);
-		}
-		m_next[count] = m_hashTable[hash];
-		m_hashTable[hash] = count;
+		m_indexTable.insert(hash, count);
 	}
 
 	void remove(const Key& key)
 	{
-		int hash = key.getHash() & (m_valueArray.capacity() - 1);
+		unsigned int hash = key.getHash();
 
-		int pairIndex = findIndex(key);
+		int pairIndex = m_indexTable.findIndex(hash, KeyEquals(key, m_keyArray));
 
 		if (pairIndex == BT_HASH_NULL)
 		{
 			return;
 		}
 
-		// Remove the pair from the hash table.
-		int index = m_hashTable[hash];
-		btAssert(index != BT_HASH_NULL);
-
-		int previous = BT_HASH_NULL;
-		while (index != pairIndex)
-		{
-			previous = index;
-			index = m_next[index];
-		}
-
-		if (previous != BT_HASH_NULL)
-		{
-			btAssert(m_next[previous] == pairIndex);
-			m_next[previous] = m_next[pairIndex];
-		}
-		else
-		{
-			m_hashTable[hash] = m_next[pairIndex];
-		}
+		m_indexTable.remove(hash, pairIndex);
 
 		// We now move the last pair into spot of the
-		// pair being removed. We need to fix the hash
-		// table indices to support the move.
+		// pair being removed, and point its table entry there.
 
 		int lastPairIndex = m_valueArray.size() - 1;
 
@@ -335,41 +506,24 @@ public:
 			return;
 		}
 
-		// Remove the last pair from the hash table.
-		int lastHash = m_keyArray[lastPairIndex].getHash() & (m_valueArray.capacity() - 1);
-
-		index = m_hashTable[lastHash];
-		btAssert(index != BT_HASH_NULL);
-
-		previous = BT_HASH_NULL;
-		while (index != lastPairIndex)
-		{
-			previous = index;
-			index = m_next[index];
-		}
-
-		if (previous != BT_HASH_NULL)
-		{
-			btAssert(m_next[previous] == lastPairIndex);
-			m_next[previous] = m_next[lastPairIndex];
-		}
-		else
-		{
-			m_hashTable[lastHash] = m_next[lastPairIndex];
-		}
+		m_indexTable.replaceIndex(m_keyArray[lastPairIndex].getHash(), lastPairIndex, pairIndex);
 
 		// Copy the last pair into the remove pair's spot.
 		m_valueArray[pairIndex] = m_valueArray[lastPairIndex];
 		m_keyArray[pairIndex] = m_keyArray[lastPairIndex];
 
-		// Insert the last pair into the hash table
-		m_next[pairIndex] = m_hashTable[lastHash];
-		m_hashTable[lastHash] = pairIndex;
-
 		m_valueArray.pop_back();
 		m_keyArray.pop_back();
 	}
 
+	///makes room for count entries
+	void reserve(int count)
+	{
+		m_valueArray.reserve(count);
+		m_keyArray.reserve(count);
+		m_indexTable.reserve(count);
+	}
+
 	int size() const
 	{
 		return m_valueArray.size();
@@ -443,25 +597,12 @@ public:
 
 	int findIndex(const Key& key) const
 	{
-		unsigned int hash = key.getHash() & (m_valueArray.capacity() - 1);
-
-		if (hash >= (unsigned int)m_hashTable.size())
-		{
-			return BT_HASH_NULL;
-		}
-
-		int index = m_hashTable[hash];
-		while ((index != BT_HASH_NULL) && key.equals(m_keyArray[index]) == false)
-		{
-			index = m_next[index];
-		}
-		return index;
+		return m_indexTable.findIndex(key.getHash(), KeyEquals(key, m_keyArray));
 	}
 
 	void clear()
 	{
-		m_hashTable.clear();
-		m_next.clear();
+		m_indexTable.clear();
 		m_valueArray.clear();
 		m_keyArray.clear();
 	}
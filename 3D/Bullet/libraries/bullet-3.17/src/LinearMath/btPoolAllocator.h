@@ -20,78 +20,368 @@ subject to the following restrictions:
 #include "btThreads.h"
 
 ///The btPoolAllocator class allows to efficiently allocate a large pool of objects, instead of dynamically allocating them separately.
+///A growable pool that runs out of elements adds a slab as large as all its previous slabs together, so elements never move
+///and there are only a few slabs to search in validPtr. A pool that cannot grow returns 0 when it is full.
+///With BT_THREADSAFE every thread keeps a small magazine of free elements in front of the shared free list. A magazine is a
+///work stealing deque (Chase and Lev): its thread pushes and pops elements at the bottom without a lock, and only takes the
+///mutex to move half a magazine from or to the shared list. The pool only counts as full when the shared list and every
+///magazine are empty: a thread that finds nothing in the shared list first takes the elements of the other magazines from
+///their top with a compare-exchange, and only then grows the pool or returns 0.
+///validPtr does not lock either: slabs are only added, and the slab count is published after the new slab.
 class btPoolAllocator
 {
+public:
+	enum
+	{
+		MAX_SLABS = 24,
+		MAGAZINE_SIZE = 16
+	};
+
+private:
+	struct btPoolMagazine
+	{
+		int m_top;     ///< first element, taken by other threads draining the magazine with a compare-exchange
+		int m_bottom;  ///< one past the last element, only written by the thread of the magazine
+		void* m_elements[MAGAZINE_SIZE];
+	};
+
 	int m_elemSize;
-	int m_maxElements;
-	int m_freeCount;
+	int m_maxElements;  ///< capacity of all the slabs
+	int m_freeCount;    ///< elements in the shared free list
 	void* m_firstFree;
 	unsigned char* m_pool;
-	btSpinMutex m_mutex;  // only used if BT_THREADSAFE
+	unsigned char* m_slabs[MAX_SLABS];
+	int m_slabSizes[MAX_SLABS];
+	int m_slabCount;  ///< only written under the mutex, validPtr reads it without
+	bool m_growable;
+	int m_highWaterMark;
+	int m_overflowCount;
+	btSpinMutex m_mutex;  // guards the shared free list and the slabs, only used if BT_THREADSAFE
+#if BT_THREADSAFE
+	unsigned char* m_magazines;  ///< BT_MAX_THREAD_COUNT magazines, each on its own cache lines
+#endif
 
-public:
-	btPoolAllocator(int elemSize, int maxElements)
-		: m_elemSize(elemSize),
-		  m_maxElements(maxElements)
+	void addSlab(int numElements)
 	{
-		m_pool = (unsigned char*)btAlignedAlloc(static_cast<unsigned int>(m_elemSize * m_maxElements), 16);
+		unsigned char* slab = (unsigned char*)btAlignedAlloc(static_cast<unsigned int>(m_elemSize * numElements), 16);
 
-		unsigned char* p = m_pool;
-		m_firstFree = p;
-		m_freeCount = m_maxElements;
-		int count = m_maxElements;
+		unsigned char* p = slab;
+		int count = numElements;
 		while (--count)
 		{
 			*(void**)p = (p + m_elemSize);
 			p += m_elemSize;
 		}
-		*(void**)p = 0;
+		*(void**)p = m_firstFree;
+		m_firstFree = slab;
+		m_freeCount += numElements;
+		m_maxElements += numElements;
+
+		m_slabs[m_slabCount] = slab;
+		m_slabSizes[m_slabCount] = m_elemSize * numElements;
+		btAtomicStore(&m_slabCount, m_slabCount + 1);
+	}
+
+	///pops an element from the shared free list, 0 when it is empty. Needs the mutex.
+	void* takeShared()
+	{
+		if (NULL == m_firstFree)
+		{
+			return 0;
+		}
+		void* result = m_firstFree;
+		m_firstFree = *(void**)m_firstFree;
+		--m_freeCount;
+		if (m_maxElements - m_freeCount > m_highWaterMark)
+		{
+			m_highWaterMark = m_maxElements - m_freeCount;
+		}
+		return result;
+	}
+
+	///pushes an element on the shared free list. Needs the mutex.
+	void giveShared(void* ptr)
+	{
+		*(void**)ptr = m_firstFree;
+		m_firstFree = ptr;
+		++m_freeCount;
+	}
+
+	///called when no free element is left anywhere: adds a slab if the pool may grow. Needs the mutex.
+	void overflow()
+	{
+		m_overflowCount++;
+		if (m_growable && m_slabCount < MAX_SLABS)
+		{
+			addSlab(m_maxElements);
+		}
+	}
+
+#if BT_THREADSAFE
+	static int getMagazineStride()
+	{
+		return (int(sizeof(btPoolMagazine)) + 63) & ~63;
+	}
+
+	btPoolMagazine* getMagazine(unsigned int threadIndex) const
+	{
+		btAssert(threadIndex < BT_MAX_THREAD_COUNT);
+		return (btPoolMagazine*)(m_magazines + threadIndex * getMagazineStride());
+	}
+
+	///number of elements between top and bottom, the indices wrap around
+	static int getMagazineCount(int top, int bottom)
+	{
+		return int((unsigned int)bottom - (unsigned int)top);
+	}
+
+	static int offsetIndex(int index, int offset)
+	{
+		return int((unsigned int)index + (unsigned int)offset);
+	}
+
+	///pushes an element on the magazine of the calling thread, false when it is full
+	bool pushOwn(btPoolMagazine* magazine, void* element)
+	{
+		const int bottom = magazine->m_bottom;
+		if (getMagazineCount(btAtomicLoad(&magazine->m_top), bottom) >= MAGAZINE_SIZE)
+		{
+			return false;
+		}
+		btAtomicStorePointer(&magazine->m_elements[bottom & (MAGAZINE_SIZE - 1)], element);
+		btAtomicStore(&magazine->m_bottom, offsetIndex(bottom, 1));
+		return true;
+	}
+
+	///pops the last element of the magazine of the calling thread, 0 when it is empty
+	void* popOwn(btPoolMagazine* magazine)
+	{
+		const int bottom = offsetIndex(magazine->m_bottom, -1);
+		//a sequentially consistent exchange: a thread draining the magazine either sees the new bottom, or takes the
+		//top before the load below
+		btAtomicExchange(&magazine->m_bottom, bottom);
+		const int top = btAtomicLoad(&magazine->m_top);
+		const int remaining = getMagazineCount(top, bottom);
+		if (remaining < 0)
+		{
+			btAtomicStore(&magazine->m_bottom, offsetIndex(bottom, 1));
+			return 0;
+		}
+		void* element = btAtomicLoadPointer(&magazine->m_elements[bottom & (MAGAZINE_SIZE - 1)]);
+		if (remaining == 0)
+		{
+			//the last element, a draining thread may take it at the same time
+			if (!btAtomicCompareExchange(&magazine->m_top, top, offsetIndex(top, 1)))
+			{
+				element = 0;
+			}
+			btAtomicStore(&magazine->m_bottom, offsetIndex(bottom, 1));
+		}
+		return element;
+	}
+
+	///takes the first element of the magazine of any thread, 0 when it is empty
+	void* steal(btPoolMagazine* magazine)
+	{
+		for (;;)
+		{
+			const int top = btAtomicLoad(&magazine->m_top);
+			const int bottom = btAtomicLoad(&magazine->m_bottom);
+			if (getMagazineCount(top, bottom) <= 0)
+			{
+				return 0;
+			}
+			void* element = btAtomicLoadPointer(&magazine->m_elements[top & (MAGAZINE_SIZE - 1)]);
+			if (btAtomicCompareExchange(&magazine->m_top, top, offsetIndex(top, 1)))
+			{
+				return element;
+			}
+		}
+	}
+
+	///moves up to half a magazine from the shared free list to the magazine of the calling thread. Takes the mutex.
+	void refillMagazine(btPoolMagazine* magazine, bool mayOverflow)
+	{
+		btMutexLock(&m_mutex);
+		if (mayOverflow && NULL == m_firstFree)
+		{
+			overflow();
+		}
+		for (int i = 0; i < MAGAZINE_SIZE / 2 && m_firstFree; i++)
+		{
+			if (!pushOwn(magazine, m_firstFree))
+			{
+				break;
+			}
+			takeShared();
+		}
+		btMutexUnlock(&m_mutex);
+	}
+
+	///moves the elements cached by all the threads to the shared free list
+	void drainMagazines()
+	{
+		void* elements[MAGAZINE_SIZE];
+		for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+		{
+			btPoolMagazine* magazine = getMagazine(i);
+			int count = 0;
+			while (count < MAGAZINE_SIZE && (elements[count] = steal(magazine)) != NULL)
+			{
+				count++;
+			}
+			if (count)
+			{
+				btMutexLock(&m_mutex);
+				while (count)
+				{
+					giveShared(elements[--count]);
+				}
+				btMutexUnlock(&m_mutex);
+			}
+		}
+	}
+#endif
+
+public:
+	btPoolAllocator(int elemSize, int maxElements, bool growable = false)
+		: m_elemSize(elemSize),
+		  m_maxElements(0),
+		  m_freeCount(0),
+		  m_firstFree(0),
+		  m_slabCount(0),
+		  m_growable(growable),
+		  m_highWaterMark(0),
+		  m_overflowCount(0)
+	{
+		btAssert(m_elemSize >= int(sizeof(void*)) && maxElements > 0);
+		addSlab(maxElements);
+		m_pool = m_slabs[0];
+
+#if BT_THREADSAFE
+		m_magazines = (unsigned char*)btAlignedAlloc(BT_MAX_THREAD_COUNT * getMagazineStride(), 64);
+		for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+		{
+			getMagazine(i)->m_top = 0;
+			getMagazine(i)->m_bottom = 0;
+		}
+#endif
 	}
 
 	~btPoolAllocator()
 	{
-		btAlignedFree(m_pool);
+#if BT_THREADSAFE
+		btAlignedFree(m_magazines);
+#endif
+		for (int i = 0; i < m_slabCount; i++)
+		{
+			btAlignedFree(m_slabs[i]);
+		}
 	}
 
+	///number of free elements, including the ones cached by the threads. Only exact while no other thread uses the pool.
 	int getFreeCount() const
 	{
-		return m_freeCount;
+		int freeCount = m_freeCount;
+#if BT_THREADSAFE
+		for (unsigned int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+		{
+			const btPoolMagazine* magazine = getMagazine(i);
+			const int count = getMagazineCount(btAtomicLoad(&magazine->m_top), btAtomicLoad(&magazine->m_bottom));
+			if (count > 0)
+			{
+				freeCount += count;
+			}
+		}
+#endif
+		return freeCount;
 	}
 
 	int getUsedCount() const
 	{
-		return m_maxElements - m_freeCount;
+		return m_maxElements - getFreeCount();
 	}
 
+	///number of elements in all the slabs
 	int getMaxCount() const
 	{
 		return m_maxElements;
 	}
 
+	///largest number of elements that were out of the shared free list at once. It counts the elements cached by the threads as used.
+	int getHighWaterMark() const
+	{
+		return m_highWaterMark;
+	}
+
+	///number of times an allocation found no free element, in the shared list or cached by a thread, whether it then grew or failed
+	int getOverflowCount() const
+	{
+		return m_overflowCount;
+	}
+
+	int getSlabCount() const
+	{
+		return btAtomicLoad(&m_slabCount);
+	}
+
+	bool isGrowable() const
+	{
+		return m_growable;
+	}
+
+	void setGrowable(bool growable)
+	{
+		m_growable = growable;
+	}
+
 	void* allocate(int size)
 	{
 		// release mode fix
 		(void)size;
-		btMutexLock(&m_mutex);
 		btAssert(!size || size <= m_elemSize);
 		//btAssert(m_freeCount>0);  // should return null if all full
-		void* result = m_firstFree;
-		if (NULL != m_firstFree)
+#if BT_THREADSAFE
+		btPoolMagazine* magazine = getMagazine(btGetCurrentThreadIndex());
+		void* result = popOwn(magazine);
+		if (NULL == result)
+		{
+			refillMagazine(magazine, false);
+			result = popOwn(magazine);
+			if (NULL == result)
+			{
+				//the other threads may still cache free elements
+				drainMagazines();
+				refillMagazine(magazine, true);
+				result = popOwn(magazine);
+			}
+		}
+		return result;
+#else
+		btMutexLock(&m_mutex);
+		void* result = takeShared();
+		if (NULL == result)
 		{
-			m_firstFree = *(void**)m_firstFree;
-			--m_freeCount;
+			overflow();
+			result = takeShared();
 		}
 		btMutexUnlock(&m_mutex);
 		return result;
+#endif
 	}
 
 	bool validPtr(void* ptr)
 	{
 		if (ptr)
 		{
-			if (((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize))
+			//a slab is written before the slab count that publishes it, and never changes after
+			const int slabCount = btAtomicLoad(&m_slabCount);
+			for (int i = 0; i < slabCount; i++)
 			{
-				return true;
+				if ((unsigned char*)ptr >= m_slabs[i] && (unsigned char*)ptr < m_slabs[i] + m_slabSizes[i])
+				{
+					return true;
+				}
 			}
 		}
 		return false;
@@ -101,13 +391,31 @@ public:
 	{
 		if (ptr)
 		{
-			btAssert((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize);
+			btAssert(validPtr(ptr));
 
+#if BT_THREADSAFE
+			btPoolMagazine* magazine = getMagazine(btGetCurrentThreadIndex());
+			if (!pushOwn(magazine, ptr))
+			{
+				//full: move the element and half the magazine to the shared free list
+				btMutexLock(&m_mutex);
+				giveShared(ptr);
+				for (int i = 0; i < MAGAZINE_SIZE / 2; i++)
+				{
+					void* element = popOwn(magazine);
+					if (NULL == element)
+					{
+						break;
+					}
+					giveShared(element);
+				}
+				btMutexUnlock(&m_mutex);
+			}
+#else
 			btMutexLock(&m_mutex);
-			*(void**)ptr = m_firstFree;
-			m_firstFree = ptr;
-			++m_freeCount;
+			giveShared(ptr);
 			btMutexUnlock(&m_mutex);
+#endif
 		}
 	}
 
@@ -116,6 +424,7 @@ public:
 		return m_elemSize;
 	}
 
+	///address of the first slab
 	unsigned char* getPoolAddress()
 	{
 		return m_pool;
@@ -277,6 +277,28 @@ inline int btIsDoublePrecision()
 
 			#else//__APPLE__
 
+				#if defined (BT_USE_SSE4_1) && defined (__x86_64__) && (!defined (BT_USE_DOUBLE_PRECISION)) && (!defined (__BT_DISABLE_SSE__))
+					//GCC and Clang on x86-64: the SSE code paths are a build option (USE_SSE4_1 in CMake), so every translation unit
+					//of the libraries and the application sees the same classes, like with BT_USE_DOUBLE_PRECISION.
+					//not on 32-bit x86, where malloc only returns 8-byte aligned memory
+					#ifndef __SSE4_1__
+						#error "BT_USE_SSE4_1 needs the SSE4.1 instruction set, compile with -msse4.1"
+					#endif
+					#define BT_USE_SIMD_VECTOR3
+					#define BT_USE_SSE
+					//BT_USE_SSE_IN_API is enabled like on Mac OSX, because malloc and new return 16-byte aligned memory on x86-64 Linux
+					//define BT_NO_SSE_IN_API if embedding Bullet structs in your own classes runs into alignment issues
+					#ifndef BT_NO_SSE_IN_API
+						#define BT_USE_SSE_IN_API
+					#endif
+					//the SSE4.1/FMA3 solver kernels are built with a target attribute and chosen at run time by btCpuFeatureUtility
+					#define BT_ALLOW_SSE4
+					#include <smmintrin.h>
+					#define SIMD_FORCE_INLINE inline __attribute__ ((always_inline))
+					#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
+					#define ATTRIBUTE_ALIGNED64(a) a __attribute__ ((aligned (64)))
+					#define ATTRIBUTE_ALIGNED128(a) a __attribute__ ((aligned (128)))
+				#else
 				#define SIMD_FORCE_INLINE inline
 				///@todo: check out alignment methods for other platforms/compilers
 				///#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
@@ -285,6 +307,7 @@ inline int btIsDoublePrecision()
 				#define ATTRIBUTE_ALIGNED16(a) a
 				#define ATTRIBUTE_ALIGNED64(a) a
 				#define ATTRIBUTE_ALIGNED128(a) a
+				#endif
 				#ifndef assert
 				#include <assert.h>
 				#endif
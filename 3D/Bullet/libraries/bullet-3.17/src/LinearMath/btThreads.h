@@ -95,6 +95,110 @@ SIMD_FORCE_INLINE bool btMutexTryLock(btSpinMutex* mutex)
 #endif  // #if BT_THREADSAFE
 }
 
+//
+// btAtomic* -- loads, stores, exchange and compare-exchange of an int or a pointer that other threads use at the same
+//              time, for the few lock-free paths of Bullet. Stores release, pointer loads acquire, all the other
+//              operations are sequentially consistent. Plain memory accesses if BT_THREADSAFE is undefined or 0.
+//
+#if BT_THREADSAFE
+#if __cplusplus >= 201103L
+#include <atomic>
+#define BT_USE_CPP11_ATOMICS 1
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define BT_USE_MSVC_ATOMICS 1  // volatile accesses are acquire and release with the default /volatile:ms
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+#define BT_USE_GCC_ATOMICS 1
+#else
+#error "no atomic operations defined -- unknown platform"
+#endif
+#endif  // #if BT_THREADSAFE
+
+SIMD_FORCE_INLINE int btAtomicLoad(const int* src)
+{
+#if BT_USE_CPP11_ATOMICS
+	return std::atomic_load_explicit(reinterpret_cast<const std::atomic<int>*>(src), std::memory_order_seq_cst);
+#elif BT_USE_MSVC_ATOMICS
+	return *reinterpret_cast<const volatile long*>(src);
+#elif BT_USE_GCC_ATOMICS
+	return __atomic_load_n(src, __ATOMIC_SEQ_CST);
+#else
+	return *src;
+#endif
+}
+
+SIMD_FORCE_INLINE void btAtomicStore(int* dest, int value)
+{
+#if BT_USE_CPP11_ATOMICS
+	std::atomic_store_explicit(reinterpret_cast<std::atomic<int>*>(dest), value, std::memory_order_release);
+#elif BT_USE_MSVC_ATOMICS
+	*reinterpret_cast<volatile long*>(dest) = value;
+#elif BT_USE_GCC_ATOMICS
+	__atomic_store_n(dest, value, __ATOMIC_RELEASE);
+#else
+	*dest = value;
+#endif
+}
+
+///sets *dest to value and returns the value it had
+SIMD_FORCE_INLINE int btAtomicExchange(int* dest, int value)
+{
+#if BT_USE_CPP11_ATOMICS
+	return std::atomic_exchange(reinterpret_cast<std::atomic<int>*>(dest), value);
+#elif BT_USE_MSVC_ATOMICS
+	return _InterlockedExchange(reinterpret_cast<volatile long*>(dest), value);
+#elif BT_USE_GCC_ATOMICS
+	return __atomic_exchange_n(dest, value, __ATOMIC_SEQ_CST);
+#else
+	int previous = *dest;
+	*dest = value;
+	return previous;
+#endif
+}
+
+///sets *dest to desired if it is expected, returns whether it did
+SIMD_FORCE_INLINE bool btAtomicCompareExchange(int* dest, int expected, int desired)
+{
+#if BT_USE_CPP11_ATOMICS
+	return std::atomic_compare_exchange_strong(reinterpret_cast<std::atomic<int>*>(dest), &expected, desired);
+#elif BT_USE_MSVC_ATOMICS
+	return _InterlockedCompareExchange(reinterpret_cast<volatile long*>(dest), desired, expected) == expected;
+#elif BT_USE_GCC_ATOMICS
+	return __atomic_compare_exchange_n(dest, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#else
+	if (*dest != expected)
+		return false;
+	*dest = desired;
+	return true;
+#endif
+}
+
+SIMD_FORCE_INLINE void* btAtomicLoadPointer(void* const* src)
+{
+#if BT_USE_CPP11_ATOMICS
+	return std::atomic_load_explicit(reinterpret_cast<const std::atomic<void*>*>(src), std::memory_order_acquire);
+#elif BT_USE_MSVC_ATOMICS
+	return *reinterpret_cast<void* const volatile*>(src);
+#elif BT_USE_GCC_ATOMICS
+	return __atomic_load_n(src, __ATOMIC_ACQUIRE);
+#else
+	return *src;
+#endif
+}
+
+SIMD_FORCE_INLINE void btAtomicStorePointer(void** dest, void* value)
+{
+#if BT_USE_CPP11_ATOMICS
+	std::atomic_store_explicit(reinterpret_cast<std::atomic<void*>*>(dest), value, std::memory_order_release);
+#elif BT_USE_MSVC_ATOMICS
+	*reinterpret_cast<void* volatile*>(dest) = value;
+#elif BT_USE_GCC_ATOMICS
+	__atomic_store_n(dest, value, __ATOMIC_RELEASE);
+#else
+	*dest = value;
+#endif
+}
+
 //
 // btIParallelForBody -- subclass this to express work that can be done in parallel
 //
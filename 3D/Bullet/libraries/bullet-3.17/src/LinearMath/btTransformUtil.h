@@ -38,6 +38,26 @@ public:
 		predictedOrn += (angvel * predictedOrn) * (timeStep * btScalar(0.5));
 		predictedOrn.safeNormalize();
 #else
+		btQuaternion dorn = calculateIntegratedRotation(angvel, timeStep);
+		btQuaternion orn0 = curTrans.getRotation();
+
+		btQuaternion predictedOrn = dorn * orn0;
+		predictedOrn.safeNormalize();
+#endif
+		if (predictedOrn.length2() > SIMD_EPSILON)
+		{
+			predictedTransform.setRotation(predictedOrn);
+		}
+		else
+		{
+			predictedTransform.setBasis(curTrans.getBasis());
+		}
+	}
+
+	///the rotation integrateTransform applies in one step, before the result is normalized. It is not a unit quaternion
+	///when the angular motion is limited.
+	static btQuaternion calculateIntegratedRotation(const btVector3& angvel, btScalar timeStep)
+	{
 		//Exponential map
 		//google for "Practical Parameterization of Rotations Using the Exponential Map", F. Sebastian Grassia
 
@@ -65,20 +85,20 @@ public:
 			// sync(fAngle) = sin(c*fAngle)/t
 			axis = angvel * (btSin(btScalar(0.5) * fAngle * timeStep) / fAngle);
 		}
-		btQuaternion dorn(axis.x(), axis.y(), axis.z(), btCos(fAngle * timeStep * btScalar(0.5)));
-		btQuaternion orn0 = curTrans.getRotation();
+		return btQuaternion(axis.x(), axis.y(), axis.z(), btCos(fAngle * timeStep * btScalar(0.5)));
+	}
 
-		btQuaternion predictedOrn = dorn * orn0;
-		predictedOrn.safeNormalize();
-#endif
-		if (predictedOrn.length2() > SIMD_EPSILON)
-		{
-			predictedTransform.setRotation(predictedOrn);
-		}
-		else
-		{
-			predictedTransform.setBasis(curTrans.getBasis());
-		}
+	///the transform that integrateTransform moves to predictedTransform with the same velocities and a positive time step.
+	///Integrating with -timeStep is no inverse, the angular motion is only limited for positive time steps.
+	static void integrateTransformInverse(const btTransform& predictedTransform, const btVector3& linvel, const btVector3& angvel, btScalar timeStep, btTransform& curTrans)
+	{
+		curTrans.setOrigin(predictedTransform.getOrigin() - linvel * timeStep);
+		//integrateTransform normalizes dorn * orn0, which is the normalized dorn times the unit orn0
+		btQuaternion dorn = calculateIntegratedRotation(angvel, timeStep);
+		dorn.normalize();
+		btQuaternion orn0 = dorn.inverse() * predictedTransform.getRotation();
+		orn0.normalize();
+		curTrans.setRotation(orn0);
 	}
 
 	static void calculateVelocityQuaternion(const btVector3& pos0, const btVector3& pos1, const btQuaternion& orn0, const btQuaternion& orn1, btScalar timeStep, btVector3& linVel, btVector3& angVel)
@@ -42,8 +42,283 @@ typedef float float4 __attribute__((vector_size(16)));
 
 #include <emmintrin.h>
 
+// With SSE4 allowed on x86-64, large queries may go to AVX2 or AVX-512 kernels, chosen at run time with btCpuFeatureUtility
+#if defined(BT_ALLOW_SSE4) && (defined(__x86_64__) || defined(_M_X64))
+#define BT_USE_WIDE_DOT 1
+#include "btCpuFeatureUtility.h"
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define BT_TARGET_AVX2
+#define BT_TARGET_AVX512
+#define BT_USE_AVX512_DOT (_MSC_VER >= 1920)
+#else
+#define BT_TARGET_AVX2 __attribute__((target("avx2")))
+#define BT_TARGET_AVX512 __attribute__((target("avx512f")))
+#define BT_USE_AVX512_DOT 1
+#endif
+#else
+#define BT_USE_WIDE_DOT 0
+#endif
+
+static long _maxdot_large_sse(const float *vv, const float *vec, unsigned long count, float *dotResult);
+static long _mindot_large_sse(const float *vv, const float *vec, unsigned long count, float *dotResult);
+
+#if BT_USE_WIDE_DOT
+
+// Queries with fewer vertices stay on the SSE kernels
+#define WIDE_DOT_MIN_COUNT 64
+
+// Dot products of 8 vertices, computed as (x*vx + y*vy) + z*vz like the SSE kernels.
+// The 4x4 transposes work within each 128-bit lane, so lane k holds vertices {k, 2+k, 4+k, 6+k}.
+BT_TARGET_AVX2 static inline __m256 btDot8(const float *vertices, __m256 vx, __m256 vy, __m256 vz)
+{
+	__m256 p0 = _mm256_loadu_ps(vertices);
+	__m256 p1 = _mm256_loadu_ps(vertices + 8);
+	__m256 p2 = _mm256_loadu_ps(vertices + 16);
+	__m256 p3 = _mm256_loadu_ps(vertices + 24);
+
+	__m256 t0 = _mm256_unpacklo_ps(p0, p1);  // x x y y
+	__m256 t1 = _mm256_unpacklo_ps(p2, p3);
+	__m256 t2 = _mm256_unpackhi_ps(p0, p1);  // z z w w, w is never used
+	__m256 t3 = _mm256_unpackhi_ps(p2, p3);
+
+	__m256 x = _mm256_mul_ps(_mm256_shuffle_ps(t0, t1, 0x44), vx);
+	__m256 y = _mm256_mul_ps(_mm256_shuffle_ps(t0, t1, 0xee), vy);
+	__m256 z = _mm256_mul_ps(_mm256_shuffle_ps(t2, t3, 0x44), vz);
+	return _mm256_add_ps(_mm256_add_ps(x, y), z);
+}
+
+// Keeps, per lane, the largest dot and the index where it first appeared. count must be at least 8.
+BT_TARGET_AVX2 static long _maxdot_large_avx2(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	const __m256 vx = _mm256_set1_ps(vec[0]);
+	const __m256 vy = _mm256_set1_ps(vec[1]);
+	const __m256 vz = _mm256_set1_ps(vec[2]);
+	const __m256i step = _mm256_set1_epi32(8);
+
+	__m256i index = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	__m256 best = btDot8(vv, vx, vy, vz);
+	__m256i bestIndex = index;
+
+	unsigned long i = 8;
+	for (; i + 8 <= count; i += 8)
+	{
+		index = _mm256_add_epi32(index, step);
+		__m256 dots = btDot8(vv + 4 * i, vx, vy, vz);
+		__m256 greater = _mm256_cmp_ps(dots, best, _CMP_GT_OQ);  // false for NaN, so best never becomes NaN
+		best = _mm256_blendv_ps(best, dots, greater);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), greater));
+	}
+
+	if (i < count)
+	{  // pad the last group with copies of the last vertex; their larger indices lose every tie
+		ATTRIBUTE_ALIGNED16(float tail[8 * 4]);
+		unsigned long remaining = count - i;
+		for (unsigned long j = 0; j < 8; j++)
+		{
+			const float *source = vv + 4 * (i + (j < remaining ? j : remaining - 1));
+			tail[4 * j + 0] = source[0];
+			tail[4 * j + 1] = source[1];
+			tail[4 * j + 2] = source[2];
+			tail[4 * j + 3] = 0.f;
+		}
+		index = _mm256_add_epi32(index, step);
+		__m256 dots = btDot8(tail, vx, vy, vz);
+		__m256 greater = _mm256_cmp_ps(dots, best, _CMP_GT_OQ);
+		best = _mm256_blendv_ps(best, dots, greater);
+		bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), greater));
+	}
+
+	ATTRIBUTE_ALIGNED16(float bestDots[8]);
+	ATTRIBUTE_ALIGNED16(int bestIndices[8]);
+	_mm256_storeu_ps(bestDots, best);
+	_mm256_storeu_si256((__m256i *)bestIndices, bestIndex);
+
+	float maxDot = bestDots[0];
+	long maxIndex = bestIndices[0];
+	for (int lane = 1; lane < 8; lane++)
+	{
+		if (bestDots[lane] > maxDot || (bestDots[lane] == maxDot && bestIndices[lane] < maxIndex))
+		{
+			maxDot = bestDots[lane];
+			maxIndex = bestIndices[lane];
+		}
+	}
+
+	*dotResult = maxDot;
+	return maxIndex;
+}
+
+#if BT_USE_AVX512_DOT
+
+// Dot products of 16 vertices. Lane k holds vertices {k, 4+k, 8+k, 12+k}.
+// The shuffles use the masked forms with all lanes set: the plain ones pass _mm512_undefined_ps() to the builtin,
+// which GCC 12 reports as used uninitialized. The full mask makes them the same instructions.
+BT_TARGET_AVX512 static inline __m512 btDot16(const float *vertices, __m512 vx, __m512 vy, __m512 vz)
+{
+	const __m512 zero = _mm512_setzero_ps();
+	const __mmask16 all = 0xffff;
+	__m512 p0 = _mm512_loadu_ps(vertices);
+	__m512 p1 = _mm512_loadu_ps(vertices + 16);
+	__m512 p2 = _mm512_loadu_ps(vertices + 32);
+	__m512 p3 = _mm512_loadu_ps(vertices + 48);
+
+	__m512 t0 = _mm512_mask_unpacklo_ps(zero, all, p0, p1);
+	__m512 t1 = _mm512_mask_unpacklo_ps(zero, all, p2, p3);
+	__m512 t2 = _mm512_mask_unpackhi_ps(zero, all, p0, p1);
+	__m512 t3 = _mm512_mask_unpackhi_ps(zero, all, p2, p3);
+
+	__m512 x = _mm512_mul_ps(_mm512_mask_shuffle_ps(zero, all, t0, t1, 0x44), vx);
+	__m512 y = _mm512_mul_ps(_mm512_mask_shuffle_ps(zero, all, t0, t1, 0xee), vy);
+	__m512 z = _mm512_mul_ps(_mm512_mask_shuffle_ps(zero, all, t2, t3, 0x44), vz);
+	return _mm512_add_ps(_mm512_add_ps(x, y), z);
+}
+
+// Same as _maxdot_large_avx2 with 16 lanes. count must be at least 16.
+BT_TARGET_AVX512 static long _maxdot_large_avx512(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	const __m512 vx = _mm512_set1_ps(vec[0]);
+	const __m512 vy = _mm512_set1_ps(vec[1]);
+	const __m512 vz = _mm512_set1_ps(vec[2]);
+	const __m512i step = _mm512_set1_epi32(16);
+
+	__m512i index = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	__m512 best = btDot16(vv, vx, vy, vz);
+	__m512i bestIndex = index;
+
+	unsigned long i = 16;
+	for (; i + 16 <= count; i += 16)
+	{
+		index = _mm512_add_epi32(index, step);
+		__m512 dots = btDot16(vv + 4 * i, vx, vy, vz);
+		__mmask16 greater = _mm512_cmp_ps_mask(dots, best, _CMP_GT_OQ);
+		best = _mm512_mask_blend_ps(greater, best, dots);
+		bestIndex = _mm512_mask_blend_epi32(greater, bestIndex, index);
+	}
+
+	if (i < count)
+	{
+		ATTRIBUTE_ALIGNED16(float tail[16 * 4]);
+		unsigned long remaining = count - i;
+		for (unsigned long j = 0; j < 16; j++)
+		{
+			const float *source = vv + 4 * (i + (j < remaining ? j : remaining - 1));
+			tail[4 * j + 0] = source[0];
+			tail[4 * j + 1] = source[1];
+			tail[4 * j + 2] = source[2];
+			tail[4 * j + 3] = 0.f;
+		}
+		index = _mm512_add_epi32(index, step);
+		__m512 dots = btDot16(tail, vx, vy, vz);
+		__mmask16 greater = _mm512_cmp_ps_mask(dots, best, _CMP_GT_OQ);
+		best = _mm512_mask_blend_ps(greater, best, dots);
+		bestIndex = _mm512_mask_blend_epi32(greater, bestIndex, index);
+	}
+
+	ATTRIBUTE_ALIGNED16(float bestDots[16]);
+	ATTRIBUTE_ALIGNED16(int bestIndices[16]);
+	_mm512_storeu_ps(bestDots, best);
+	_mm512_storeu_si512(bestIndices, bestIndex);
+
+	float maxDot = bestDots[0];
+	long maxIndex = bestIndices[0];
+	for (int lane = 1; lane < 16; lane++)
+	{
+		if (bestDots[lane] > maxDot || (bestDots[lane] == maxDot && bestIndices[lane] < maxIndex))
+		{
+			maxDot = bestDots[lane];
+			maxIndex = bestIndices[lane];
+		}
+	}
+
+	*dotResult = maxDot;
+	return maxIndex;
+}
+
+#endif  //BT_USE_AVX512_DOT
+
+// The minimum is the maximum along the opposite direction. Negating is exact, so the dots are the same up to sign.
+static long _mindot_from_maxdot(long (*maxdot)(const float *, const float *, unsigned long, float *), const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	const float negated[4] = {-vec[0], -vec[1], -vec[2], 0.f};
+	long minIndex = maxdot(vv, negated, count, dotResult);
+	*dotResult = -*dotResult;
+	return minIndex;
+}
+
+BT_TARGET_AVX2 static long _mindot_large_avx2(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	return _mindot_from_maxdot(_maxdot_large_avx2, vv, vec, count, dotResult);
+}
+
+#if BT_USE_AVX512_DOT
+BT_TARGET_AVX512 static long _mindot_large_avx512(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	return _mindot_from_maxdot(_maxdot_large_avx512, vv, vec, count, dotResult);
+}
+#endif  //BT_USE_AVX512_DOT
+
+static long _maxdot_large_sel(const float *vv, const float *vec, unsigned long count, float *dotResult);
+static long _mindot_large_sel(const float *vv, const float *vec, unsigned long count, float *dotResult);
+
+static long (*_maxdot_large_wide)(const float *vv, const float *vec, unsigned long count, float *dotResult) = _maxdot_large_sel;
+static long (*_mindot_large_wide)(const float *vv, const float *vec, unsigned long count, float *dotResult) = _mindot_large_sel;
+
+static long _maxdot_large_sel(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	int cpuFeatures = btCpuFeatureUtility::getCpuFeatures();
+#if BT_USE_AVX512_DOT
+	if (cpuFeatures & btCpuFeatureUtility::CPU_FEATURE_AVX512F)
+		_maxdot_large_wide = _maxdot_large_avx512;
+	else
+#endif
+		if (cpuFeatures & btCpuFeatureUtility::CPU_FEATURE_AVX2)
+		_maxdot_large_wide = _maxdot_large_avx2;
+	else
+		_maxdot_large_wide = _maxdot_large_sse;
+
+	return _maxdot_large_wide(vv, vec, count, dotResult);
+}
+
+static long _mindot_large_sel(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+	int cpuFeatures = btCpuFeatureUtility::getCpuFeatures();
+#if BT_USE_AVX512_DOT
+	if (cpuFeatures & btCpuFeatureUtility::CPU_FEATURE_AVX512F)
+		_mindot_large_wide = _mindot_large_avx512;
+	else
+#endif
+		if (cpuFeatures & btCpuFeatureUtility::CPU_FEATURE_AVX2)
+		_mindot_large_wide = _mindot_large_avx2;
+	else
+		_mindot_large_wide = _mindot_large_sse;
+
+	return _mindot_large_wide(vv, vec, count, dotResult);
+}
+
+#endif  //BT_USE_WIDE_DOT
+
 long _maxdot_large(const float *vv, const float *vec, unsigned long count, float *dotResult);
 long _maxdot_large(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+#if BT_USE_WIDE_DOT
+	if (count >= WIDE_DOT_MIN_COUNT)
+		return _maxdot_large_wide(vv, vec, count, dotResult);
+#endif
+	return _maxdot_large_sse(vv, vec, count, dotResult);
+}
+
+long _mindot_large(const float *vv, const float *vec, unsigned long count, float *dotResult);
+long _mindot_large(const float *vv, const float *vec, unsigned long count, float *dotResult)
+{
+#if BT_USE_WIDE_DOT
+	if (count >= WIDE_DOT_MIN_COUNT)
+		return _mindot_large_wide(vv, vec, count, dotResult);
+#endif
+	return _mindot_large_sse(vv, vec, count, dotResult);
+}
+
+static long _maxdot_large_sse(const float *vv, const float *vec, unsigned long count, float *dotResult)
 {
 	const float4 *vertices = (const float4 *)vv;
 	static const unsigned char indexTable[16] = {(unsigned char)-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
@@ -434,9 +709,7 @@ long _maxdot_large(const float *vv, const float *vec, unsigned long count, float
 	return maxIndex;
 }
 
-long _mindot_large(const float *vv, const float *vec, unsigned long count, float *dotResult);
-
-long _mindot_large(const float *vv, const float *vec, unsigned long count, float *dotResult)
+static long _mindot_large_sse(const float *vv, const float *vec, unsigned long count, float *dotResult)
 {
 	const float4 *vertices = (const float4 *)vv;
 	static const unsigned char indexTable[16] = {(unsigned char)-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
@@ -1662,3 +1935,319 @@ long _mindot_large_v1(const float *vv, const float *vec, unsigned long count, fl
 #endif
 
 #endif /* __APPLE__ */
+
+#if BT_VECTOR3_ENABLE_BENCHMARK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "btQuickprof.h"
+#include "btAlignedObjectArray.h"
+
+typedef long (*btDotKernel)(const btVector3 &direction, const btVector3 *array, long count, btScalar &dotOut);
+
+static long btMaxDotScalar(const btVector3 &direction, const btVector3 *array, long count, btScalar &dotOut)
+{
+	long index = -1;
+	dotOut = -SIMD_INFINITY;
+	for (long i = 0; i < count; i++)
+	{
+		btScalar dot = array[i].dot(direction);
+		if (dot > dotOut)
+		{
+			dotOut = dot;
+			index = i;
+		}
+	}
+	return index;
+}
+
+static long btMaxDotDefault(const btVector3 &direction, const btVector3 *array, long count, btScalar &dotOut)
+{
+	return direction.maxDot(array, count, dotOut);
+}
+
+static long btMinDotDefault(const btVector3 &direction, const btVector3 *array, long count, btScalar &dotOut)
+{
+	return direction.minDot(array, count, dotOut);
+}
+
+#if defined(BT_USE_SSE) && BT_USE_WIDE_DOT
+static long btMaxDotSse(const btVector3 &direction, const btVector3 *array, long count, btScalar &dotOut)
+{
+	return _maxdot_large_sse((const float *)array, (const float *)&direction, count, &dotOut);
+}
+#endif
+
+static double btTimeDotKernel(btDotKernel kernel, const btAlignedObjectArray<btVector3> &vertices, const btAlignedObjectArray<btVector3> &directions, long &checksum)
+{
+	const int repetitions = 1 + 2000000 / vertices.size();
+	btClock clock;
+	for (int r = 0; r < repetitions; r++)
+	{
+		for (int d = 0; d < directions.size(); d++)
+		{
+			btScalar dot;
+			checksum += kernel(directions[d], &vertices[0], vertices.size(), dot);
+		}
+	}
+	return double(clock.getTimeNanoseconds()) / (double(repetitions) * directions.size());
+}
+
+void btVector3::benchmarkDot()
+{
+#if BT_USE_WIDE_DOT
+	int cpuFeatures = btCpuFeatureUtility::getCpuFeatures();
+	printf("maxDot/minDot benchmark, AVX2 %s, AVX-512 %s\n",
+		   (cpuFeatures & btCpuFeatureUtility::CPU_FEATURE_AVX2) ? "yes" : "no",
+		   (cpuFeatures & btCpuFeatureUtility::CPU_FEATURE_AVX512F) ? "yes" : "no");
+#endif
+	printf("%8s %12s %12s %12s %12s  (ns per query)\n", "vertices", "scalar", "sse", "maxDot", "minDot");
+
+	btAlignedObjectArray<btVector3> directions;
+	for (int d = 0; d < 64; d++)
+	{
+		directions.push_back(btVector3(btScalar(rand()) / RAND_MAX - btScalar(0.5), btScalar(rand()) / RAND_MAX - btScalar(0.5), btScalar(rand()) / RAND_MAX - btScalar(0.5)));
+	}
+
+	long checksum = 0;
+	for (int count = 8; count <= 4096; count *= 2)
+	{
+		btAlignedObjectArray<btVector3> vertices;
+		for (int i = 0; i < count; i++)
+		{
+			vertices.push_back(btVector3(btScalar(rand()) / RAND_MAX, btScalar(rand()) / RAND_MAX, btScalar(rand()) / RAND_MAX) * btScalar(2) - btVector3(1, 1, 1));
+		}
+
+		double scalarTime = btTimeDotKernel(btMaxDotScalar, vertices, directions, checksum);
+#if defined(BT_USE_SSE) && BT_USE_WIDE_DOT
+		double sseTime = btTimeDotKernel(btMaxDotSse, vertices, directions, checksum);
+#else
+		double sseTime = 0;
+#endif
+		double maxTime = btTimeDotKernel(btMaxDotDefault, vertices, directions, checksum);
+		double minTime = btTimeDotKernel(btMinDotDefault, vertices, directions, checksum);
+		printf("%8d %12.1f %12.1f %12.1f %12.1f\n", count, scalarTime, sseTime, maxTime, minTime);
+	}
+	printf("(checksum %ld)\n", checksum);
+}
+
+#endif  //BT_VECTOR3_ENABLE_BENCHMARK
+
+#if BT_VECTOR3_ENABLE_PARITY_CHECK
+
+#include "btMatrix3x3.h"
+#include <stdio.h>
+
+struct btParityCheck
+{
+	unsigned int m_seed;
+	int m_numChecks;
+	int m_numMismatches;
+	btScalar m_maxError;
+
+	btParityCheck() : m_seed(1), m_numChecks(0), m_numMismatches(0), m_maxError(0) {}
+
+	btScalar random()
+	{
+		m_seed = m_seed * 1664525u + 1013904223u;
+		return btScalar(m_seed >> 8) / btScalar(1 << 24) * btScalar(2) - btScalar(1);
+	}
+
+	btVector3 randomVector(btScalar scale)
+	{
+		btScalar x = random(), y = random(), z = random();
+		return btVector3(x, y, z) * scale;
+	}
+
+	btQuaternion randomRotation()
+	{
+		btScalar x = random(), y = random(), z = random(), w = random();
+		btScalar length = btSqrt(x * x + y * y + z * z + w * w);
+		return btQuaternion(x / length, y / length, z / length, w / length);
+	}
+
+	///the error relative to the size of the reference, so large and small values both need about single precision
+	void compare(const char* what, btScalar value, btScalar reference, btScalar scale)
+	{
+		const btScalar tolerance = btScalar(4e-6);
+		btScalar error = btFabs(value - reference) / btMax(btScalar(1), scale);
+		m_numChecks++;
+		m_maxError = btMax(m_maxError, error);
+		if (!(error <= tolerance))
+		{
+			if (m_numMismatches < 10)
+				printf("%s: %g instead of %g\n", what, value, reference);
+			m_numMismatches++;
+		}
+	}
+
+	void compare(const char* what, const btVector3& value, const btScalar* reference, btScalar scale)
+	{
+		for (int k = 0; k < 3; k++)
+			compare(what, value[k], reference[k], scale);
+	}
+
+	void compare(const char* what, const btMatrix3x3& value, const btScalar reference[3][3], btScalar scale)
+	{
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				compare(what, value[i][j], reference[i][j], scale);
+	}
+
+	void compare(const char* what, const btQuaternion& value, const btScalar* reference)
+	{
+		compare(what, value.x(), reference[0], 1);
+		compare(what, value.y(), reference[1], 1);
+		compare(what, value.z(), reference[2], 1);
+		compare(what, value.w(), reference[3], 1);
+	}
+};
+
+static void btParityMultiply(const btScalar a[3][3], const btScalar b[3][3], btScalar out[3][3])
+{
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			out[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+}
+
+static void btParityQuaternionMultiply(const btScalar* a, const btScalar* b, btScalar* out)
+{
+	out[0] = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+	out[1] = a[3] * b[1] + a[1] * b[3] + a[2] * b[0] - a[0] * b[2];
+	out[2] = a[3] * b[2] + a[2] * b[3] + a[0] * b[1] - a[1] * b[0];
+	out[3] = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+}
+
+int btVector3::checkParity()
+{
+	btParityCheck check;
+	for (int iteration = 0; iteration < 10000; iteration++)
+	{
+		const btScalar scale = btPow(btScalar(10), btScalar(iteration % 7 - 3));
+		btVector3 a = check.randomVector(scale);
+		btVector3 b = check.randomVector(scale);
+		const btScalar pa[3] = {a.x(), a.y(), a.z()};
+		const btScalar pb[3] = {b.x(), b.y(), b.z()};
+		const btScalar product = scale * scale;
+
+		//btVector3
+		check.compare("dot", a.dot(b), pa[0] * pb[0] + pa[1] * pb[1] + pa[2] * pb[2], product);
+		const btScalar cross[3] = {pa[1] * pb[2] - pa[2] * pb[1], pa[2] * pb[0] - pa[0] * pb[2], pa[0] * pb[1] - pa[1] * pb[0]};
+		check.compare("cross", a.cross(b), cross, product);
+		const btScalar sum[3] = {pa[0] + pb[0], pa[1] + pb[1], pa[2] + pb[2]};
+		check.compare("add", a + b, sum, scale);
+		const btScalar scaled[3] = {pa[0] * btScalar(0.375), pa[1] * btScalar(0.375), pa[2] * btScalar(0.375)};
+		check.compare("scale", a * btScalar(0.375), scaled, scale);
+		const btScalar length = btSqrt(pa[0] * pa[0] + pa[1] * pa[1] + pa[2] * pa[2]);
+		check.compare("length", a.length(), length, scale);
+		const btScalar unit[3] = {pa[0] / length, pa[1] / length, pa[2] / length};
+		check.compare("normalized", a.normalized(), unit, 1);
+		const btScalar lerp[3] = {pa[0] + (pb[0] - pa[0]) * btScalar(0.25), pa[1] + (pb[1] - pa[1]) * btScalar(0.25), pa[2] + (pb[2] - pa[2]) * btScalar(0.25)};
+		check.compare("lerp", a.lerp(b, btScalar(0.25)), lerp, scale);
+
+		//btQuaternion
+		btQuaternion q = check.randomRotation();
+		btQuaternion r = check.randomRotation();
+		const btScalar pq[4] = {q.x(), q.y(), q.z(), q.w()};
+		const btScalar pr[4] = {r.x(), r.y(), r.z(), r.w()};
+		btScalar qr[4];
+		btParityQuaternionMultiply(pq, pr, qr);
+		check.compare("quaternion multiply", q * r, qr);
+		const btScalar inverse[4] = {-pq[0], -pq[1], -pq[2], pq[3]};
+		check.compare("quaternion inverse", q.inverse(), inverse);
+		check.compare("quaternion dot", q.dot(r), pq[0] * pr[0] + pq[1] * pr[1] + pq[2] * pr[2] + pq[3] * pr[3], 1);
+		//q * a * q^-1
+		const btScalar va[4] = {pa[0], pa[1], pa[2], 0};
+		btScalar qa[4], rotated[4];
+		btParityQuaternionMultiply(pq, va, qa);
+		btParityQuaternionMultiply(qa, inverse, rotated);
+		check.compare("quatRotate", quatRotate(q, a), rotated, scale);
+
+		//btMatrix3x3
+		btScalar pm[3][3];
+		pm[0][0] = 1 - 2 * (pq[1] * pq[1] + pq[2] * pq[2]);
+		pm[0][1] = 2 * (pq[0] * pq[1] - pq[3] * pq[2]);
+		pm[0][2] = 2 * (pq[0] * pq[2] + pq[3] * pq[1]);
+		pm[1][0] = 2 * (pq[0] * pq[1] + pq[3] * pq[2]);
+		pm[1][1] = 1 - 2 * (pq[0] * pq[0] + pq[2] * pq[2]);
+		pm[1][2] = 2 * (pq[1] * pq[2] - pq[3] * pq[0]);
+		pm[2][0] = 2 * (pq[0] * pq[2] - pq[3] * pq[1]);
+		pm[2][1] = 2 * (pq[1] * pq[2] + pq[3] * pq[0]);
+		pm[2][2] = 1 - 2 * (pq[0] * pq[0] + pq[1] * pq[1]);
+		btMatrix3x3 m(q);
+		check.compare("setRotation", m, pm, 1);
+		btQuaternion back;
+		m.getRotation(back);
+		if (back.dot(q) < 0)
+			back = -back;
+		check.compare("getRotation", back, pq);
+
+		//a general matrix, with the scale of the vectors in its rows
+		btMatrix3x3 n(a.x(), a.y(), a.z(), b.x(), b.y(), b.z(), pb[1], pa[2], pa[0] + pb[2]);
+		btScalar pn[3][3] = {{pa[0], pa[1], pa[2]}, {pb[0], pb[1], pb[2]}, {pb[1], pa[2], pa[0] + pb[2]}};
+		btScalar pt[3][3], pmt[3][3], pnm[3][3], pmn[3][3], pnt[3][3];
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+			{
+				pt[i][j] = pn[j][i];
+				pmt[i][j] = pm[j][i];
+			}
+		check.compare("transpose", n.transpose(), pt, scale);
+		btParityMultiply(pm, pn, pmn);
+		check.compare("matrix multiply", m * n, pmn, scale);
+		btParityMultiply(pmt, pn, pnm);
+		check.compare("transposeTimes", m.transposeTimes(n), pnm, scale);
+		btParityMultiply(pm, pt, pnt);
+		check.compare("timesTranspose", m.timesTranspose(n), pnt, scale);
+		const btScalar mb[3] = {pm[0][0] * pb[0] + pm[0][1] * pb[1] + pm[0][2] * pb[2], pm[1][0] * pb[0] + pm[1][1] * pb[1] + pm[1][2] * pb[2], pm[2][0] * pb[0] + pm[2][1] * pb[1] + pm[2][2] * pb[2]};
+		check.compare("matrix * vector", m * b, mb, scale);
+		const btScalar bm[3] = {pb[0] * pm[0][0] + pb[1] * pm[1][0] + pb[2] * pm[2][0], pb[0] * pm[0][1] + pb[1] * pm[1][1] + pb[2] * pm[2][1], pb[0] * pm[0][2] + pb[1] * pm[1][2] + pb[2] * pm[2][2]};
+		check.compare("vector * matrix", b * m, bm, scale);
+		//the inverse of a rotation is its transpose
+		check.compare("inverse", m.inverse(), pmt, 1);
+	}
+
+	//maxDot and minDot over every size, up to the wide kernels
+	btAlignedObjectArray<btVector3> vertices;
+	for (int count = 1; count <= 300; count++)
+	{
+		vertices.resize(0);
+		for (int i = 0; i < count; i++)
+			vertices.push_back(check.randomVector(1));
+		btVector3 direction = check.randomVector(1);
+		long maxIndex = 0, minIndex = 0;
+		btScalar maxDot = direction.dot(vertices[0]), minDot = maxDot;
+		for (int i = 1; i < count; i++)
+		{
+			btScalar dot = vertices[i].x() * direction.x() + vertices[i].y() * direction.y() + vertices[i].z() * direction.z();
+			if (dot > maxDot)
+			{
+				maxDot = dot;
+				maxIndex = i;
+			}
+			if (dot < minDot)
+			{
+				minDot = dot;
+				minIndex = i;
+			}
+		}
+		btScalar dot;
+		long index = direction.maxDot(&vertices[0], count, dot);
+		check.compare("maxDot", dot, maxDot, 1);
+		check.compare("maxDot index", btScalar(index), btScalar(maxIndex), 1);
+		index = direction.minDot(&vertices[0], count, dot);
+		check.compare("minDot", dot, minDot, 1);
+		check.compare("minDot index", btScalar(index), btScalar(minIndex), 1);
+	}
+
+#ifdef BT_USE_SSE
+	const char* paths = "SSE";
+#else
+	const char* paths = "scalar";
+#endif
+	printf("btVector3 parity, %s paths: %d checks, %d mismatches, largest relative error %g\n", paths, check.m_numChecks,
+		   check.m_numMismatches, check.m_maxError);
+	return check.m_numMismatches;
+}
+
+#endif  //BT_VECTOR3_ENABLE_PARITY_CHECK
@@ -20,6 +20,16 @@ subject to the following restrictions:
 #include "btMinMax.h"
 #include "btAlignedAllocator.h"
 
+// Enable the maxDot/minDot benchmark
+#ifndef BT_VECTOR3_ENABLE_BENCHMARK
+#define BT_VECTOR3_ENABLE_BENCHMARK 0
+#endif
+
+// Enable the check of the vector, matrix and quaternion math against plain scalar formulas
+#ifndef BT_VECTOR3_ENABLE_PARITY_CHECK
+#define BT_VECTOR3_ENABLE_PARITY_CHECK 0
+#endif
+
 #ifdef BT_USE_DOUBLE_PRECISION
 #define btVector3Data btVector3DoubleData
 #define btVector3DataName "btVector3DoubleData"
@@ -716,6 +726,27 @@ public:
          * @param dotOut The minimum dot product */
 	SIMD_FORCE_INLINE long minDot(const btVector3* array, long array_count, btScalar& dotOut) const;
 
+	/**@brief times maxDot and minDot over arrays of 8 to 4096 vectors, for each kernel available on this CPU */
+#if BT_VECTOR3_ENABLE_BENCHMARK
+	static void benchmarkDot();
+#else
+	static void benchmarkDot()
+	{
+	}
+#endif
+
+	/**@brief compares btVector3, btMatrix3x3, btQuaternion and maxDot/minDot with plain scalar formulas on random
+	 * inputs and returns the number of results that differ by more than rounding. Run in a build with and one without
+	 * BT_USE_SSE4_1 to check that the SSE paths agree with the scalar ones. */
+#if BT_VECTOR3_ENABLE_PARITY_CHECK
+	static int checkParity();
+#else
+	static int checkParity()
+	{
+		return 0;
+	}
+#endif
+
 	/* create a vector as  btVector3( this->dot( btVector3 v0 ), this->dot( btVector3 v1), this->dot( btVector3 v2 ))  */
 	SIMD_FORCE_INLINE btVector3 dot3(const btVector3& v0, const btVector3& v1, const btVector3& v2) const
 	{
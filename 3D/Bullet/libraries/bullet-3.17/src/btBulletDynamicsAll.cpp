@@ -1,5 +1,6 @@
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.cpp"
 #include "BulletDynamics/Dynamics/btRigidBody.cpp"
+#include "BulletDynamics/Dynamics/btRigidBodyIntegrator.cpp"
 #include "BulletDynamics/Dynamics/btSimulationIslandManagerMt.cpp"
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.cpp"
 #include "BulletDynamics/Dynamics/btSimpleDynamicsWorld.cpp"
@@ -10,11 +11,13 @@
 #include "BulletDynamics/ConstraintSolver/btContactConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btHinge2Constraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btSolve2LinearConstraint.cpp"
+#include "BulletDynamics/ConstraintSolver/btSolverRowBatches.cpp"
 #include "BulletDynamics/ConstraintSolver/btFixedConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btHingeConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btTypedConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btGearConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btNNCGConstraintSolver.cpp"
+#include "BulletDynamics/ConstraintSolver/btTGSConstraintSolver.cpp"
 #include "BulletDynamics/ConstraintSolver/btUniversalConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btGeneric6DofConstraint.cpp"
 #include "BulletDynamics/ConstraintSolver/btPoint2PointConstraint.cpp"